@@ -0,0 +1,380 @@
+// pulse-audio-bench: Micro-benchmark for the portable audio core.
+// Drives RingBuffer and IOEngine the same way coreaudiod drives the HAL plugin
+// (one WriteMix followed by one ReadInput per period), so the hot path can be
+// measured on any platform, including Linux CI containers.
+//
+// Usage:
+//   pulse-audio-bench [periods] [frames-per-period]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <unistd.h>
+#include "downmix.h"
+#include "gain.h"
+#include "io-engine.h"
+#include "ring-buffer.h"
+#include "sample-convert.h"
+#include "shm-ring.h"
+#include "signal-level.h"
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+// Keep the optimizer from discarding the benchmark's output
+static volatile float gSink = 0.0f;
+
+static void PrintResult(const char* name, UInt32 periods, UInt32 framesPerPeriod, double seconds) {
+    double nsPerPeriod = seconds * 1e9 / periods;
+    double nsPerFrame  = nsPerPeriod / framesPerPeriod;
+    double realtimeX   = ((double)periods * framesPerPeriod / kDefaultSampleRate) / seconds;
+    printf("  %-28s %10.1f ns/period  %7.3f ns/frame  %10.0fx realtime\n",
+           name, nsPerPeriod, nsPerFrame, realtimeX);
+}
+
+// Cycle counter for per-frame cost. x86_64 has the TSC; arm64 exposes no
+// user-space cycle counter, so only ns/frame is reported there.
+static bool ReadCycles(UInt64* outCycles) {
+#if defined(__x86_64__)
+    *outCycles = __rdtsc();
+    return true;
+#else
+    *outCycles = 0;
+    return false;
+#endif
+}
+
+// ============================================================================
+// Gain kernels
+// ============================================================================
+
+static void BenchGainKernels(UInt32 channels, UInt32 periods, UInt32 framesPerPeriod) {
+    std::vector<float> src(framesPerPeriod * channels, 0.25f);
+    std::vector<float> dst(framesPerPeriod * channels, 0.0f);
+
+    UInt32 count = 0;
+    const GainKernel* kernels = GetGainKernels(&count);
+
+    for (UInt32 k = 0; k < count; k++) {
+        // Constant, ramp, and constant with metering
+        static const char* kModes[] = { "constant", "ramp", "metered" };
+        for (int mode = 0; mode < 3; mode++) {
+            Float32 step = (mode == 1) ? (-0.5f / (Float32)framesPerPeriod) : 0.0f;
+            ChannelLevels levels = {};
+
+            UInt64 startCycles = 0, endCycles = 0;
+            bool haveCycles = ReadCycles(&startCycles);
+            Clock::time_point start = Clock::now();
+            for (UInt32 i = 0; i < periods; i++) {
+                if (mode == 2) {
+                    kernels[k].rampMeter(dst.data(), src.data(), framesPerPeriod, channels, 1.0f, step, &levels);
+                } else {
+                    kernels[k].ramp(dst.data(), src.data(), framesPerPeriod, channels, 1.0f, step);
+                }
+            }
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            ReadCycles(&endCycles);
+            gSink = gSink + dst[1] + levels.peak[0];
+
+            double frames = (double)periods * framesPerPeriod;
+            char name[64];
+            snprintf(name, sizeof(name), "gain %s %uch %s", kernels[k].name, (unsigned)channels, kModes[mode]);
+            if (haveCycles) {
+                printf("  %-28s %7.3f ns/frame  %7.3f cycles/frame\n",
+                       name, seconds * 1e9 / frames, (double)(endCycles - startCycles) / frames);
+            } else {
+                printf("  %-28s %7.3f ns/frame\n", name, seconds * 1e9 / frames);
+            }
+        }
+    }
+}
+
+// ============================================================================
+// Float → Int16 conversion kernels
+// ============================================================================
+
+static void BenchConvertKernels(UInt32 periods, UInt32 framesPerPeriod) {
+    const UInt32 numSamples = framesPerPeriod * kDefaultNumChannels;
+    std::vector<float>  src(numSamples);
+    std::vector<SInt16> dst(numSamples, 0);
+    for (UInt32 i = 0; i < numSamples; i++) {
+        src[i] = (Float32)((i * 37) % 200) / 100.0f - 1.0f;
+    }
+
+    UInt32 count = 0;
+    const Int16ConvertKernel* kernels = GetInt16ConvertKernels(&count);
+
+    for (UInt32 k = 0; k < count; k++) {
+        for (int dithered = 0; dithered < 2; dithered++) {
+            DitherState dither;
+            InitDitherState(&dither, 1);
+
+            Clock::time_point start = Clock::now();
+            for (UInt32 i = 0; i < periods; i++) {
+                kernels[k].convert(dst.data(), src.data(), numSamples, dithered ? &dither : nullptr);
+            }
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            gSink = gSink + dst[1];
+
+            char name[64];
+            snprintf(name, sizeof(name), "int16 %s %s", kernels[k].name, dithered ? "dither" : "round");
+            printf("  %-28s %7.3f ns/frame\n", name, seconds * 1e9 / ((double)periods * framesPerPeriod));
+        }
+    }
+}
+
+// ============================================================================
+// Mono downmix kernels
+// ============================================================================
+
+static void BenchDownmixKernels(UInt32 channels, UInt32 periods, UInt32 framesPerPeriod) {
+    std::vector<float> src(framesPerPeriod * channels, 0.25f);
+    std::vector<float> dst(framesPerPeriod, 0.0f);
+
+    UInt32 count = 0;
+    const DownmixKernel* kernels = GetDownmixKernels(&count);
+
+    for (UInt32 k = 0; k < count; k++) {
+        Clock::time_point start = Clock::now();
+        for (UInt32 i = 0; i < periods; i++) {
+            kernels[k].downmix(dst.data(), src.data(), framesPerPeriod, channels);
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        gSink = gSink + dst[1];
+
+        char name[64];
+        snprintf(name, sizeof(name), "downmix %s %uch", kernels[k].name, (unsigned)channels);
+        printf("  %-28s %7.3f ns/frame\n", name, seconds * 1e9 / ((double)periods * framesPerPeriod));
+    }
+}
+
+// ============================================================================
+// Peak level kernels
+// ============================================================================
+
+static void BenchLevelKernels(UInt32 periods, UInt32 framesPerPeriod) {
+    UInt32 samples = framesPerPeriod * kDefaultNumChannels;
+    std::vector<float> src(samples, 0.25f);
+
+    UInt32 count = 0;
+    const LevelKernel* kernels = GetLevelKernels(&count);
+
+    for (UInt32 k = 0; k < count; k++) {
+        Float32 peak = 0.0f;
+        Clock::time_point start = Clock::now();
+        for (UInt32 i = 0; i < periods; i++) {
+            peak += kernels[k].peak(src.data(), samples);
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        gSink = gSink + peak;
+
+        char name[64];
+        snprintf(name, sizeof(name), "peak %s", kernels[k].name);
+        printf("  %-28s %7.3f ns/frame\n", name, seconds * 1e9 / ((double)periods * framesPerPeriod));
+    }
+}
+
+// ============================================================================
+// RingBuffer::Store / Fetch
+// ============================================================================
+
+static void BenchRingBuffer(const char* name, bool powerOfTwo, UInt32 periods, UInt32 framesPerPeriod) {
+    RingBuffer ring;
+    ring.Initialize(kRingBufferFrameCapacity, BytesPerFrame(kDefaultNumChannels), powerOfTwo);
+
+    std::vector<float> src(framesPerPeriod * kDefaultNumChannels, 0.25f);
+    std::vector<float> dst(framesPerPeriod * kDefaultNumChannels, 0.0f);
+
+    Clock::time_point start = Clock::now();
+    for (UInt32 i = 0; i < periods; i++) {
+        ring.Store(src.data(), framesPerPeriod);
+        ring.Fetch(dst.data(), framesPerPeriod);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    gSink = gSink + dst[0];
+    PrintResult(name, periods, framesPerPeriod, seconds);
+}
+
+// ============================================================================
+// IOEngine::DoIOOperation (WriteMix + ReadInput)
+// ============================================================================
+
+static void BenchEngine(const char* name, Float32 mixLevel, Float32 volume, UInt32 channels,
+                        UInt32 inputFormat, UInt32 inputChannelMode, UInt32 periods, UInt32 framesPerPeriod) {
+    IOEngine engine;
+    engine.SetVolume(volume);
+    engine.SetChannelCount(channels);
+    engine.SetInputSampleFormat(inputFormat);
+    engine.SetInputChannelMode(inputChannelMode);
+    engine.StartIO();
+
+    std::vector<float> mix(framesPerPeriod * channels, mixLevel);
+    std::vector<float> input(framesPerPeriod * channels, 0.0f);  // big enough for either format
+
+    AudioBufferList mixList;
+    mixList.mNumberBuffers              = 1;
+    mixList.mBuffers[0].mNumberChannels = channels;
+    mixList.mBuffers[0].mDataByteSize   = framesPerPeriod * BytesPerFrame(channels);
+    mixList.mBuffers[0].mData           = mix.data();
+
+    AudioBufferList inputList = mixList;
+    inputList.mBuffers[0].mData = input.data();
+    UInt32 inputChannels = engine.GetInputChannelCount();
+    inputList.mBuffers[0].mNumberChannels = inputChannels;
+    inputList.mBuffers[0].mDataByteSize   = framesPerPeriod * (inputFormat == kInputSampleFormat_Int16
+        ? Int16BytesPerFrame(inputChannels) : BytesPerFrame(inputChannels));
+
+    Clock::time_point start = Clock::now();
+    for (UInt32 i = 0; i < periods; i++) {
+        engine.DoIOOperation(kAudioServerPlugInIOOperationWriteMix, 0, framesPerPeriod, &mixList);
+        engine.DoIOOperation(kAudioServerPlugInIOOperationReadInput, 0, framesPerPeriod, &inputList);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    engine.StopIO();
+    gSink = gSink + input[0];
+    PrintResult(name, periods, framesPerPeriod, seconds);
+
+    IOStats stats = engine.GetStats();
+    printf("  %-34s overrun %llu  underrun %llu  silent %llu  high-water %u\n", "",
+           (unsigned long long)stats.overrunFrames,
+           (unsigned long long)stats.underrunFrames,
+           (unsigned long long)stats.silentFrames,
+           (unsigned)stats.highWaterFrames);
+
+#if PULSE_AUDIO_IO_HISTOGRAMS
+    const IOEngine::IOTiming& writeMix  = engine.GetWriteMixTiming();
+    const IOEngine::IOTiming& readInput = engine.GetReadInputTiming();
+    printf("  %-34s WriteMix p50 <%llu ns  p99 <%llu ns  ReadInput p50 <%llu ns  p99 <%llu ns\n", "",
+           (unsigned long long)writeMix.duration.PercentileNanos(0.50),
+           (unsigned long long)writeMix.duration.PercentileNanos(0.99),
+           (unsigned long long)readInput.duration.PercentileNanos(0.50),
+           (unsigned long long)readInput.duration.PercentileNanos(0.99));
+#endif
+}
+
+// ============================================================================
+// IOEngine WriteMix + shared-memory reader
+// ============================================================================
+
+// The capture path a native reader takes instead of ReadInput: WriteMix also
+// fills the shared-memory ring, and the reader copies straight out of it
+static void BenchSharedMemory(const char* name, UInt32 periods, UInt32 framesPerPeriod) {
+    char shmName[kShmRingMaxNameLength + 1];
+    snprintf(shmName, sizeof(shmName), "/pulse-bench-%d", (int)getpid());
+
+    IOEngine engine;
+    if (engine.SetSharedMemoryName(shmName) != kAudioHardwareNoError) {
+        printf("  %-34s skipped: can't create %s\n", name, shmName);
+        return;
+    }
+    engine.StartIO();
+
+    ShmRingReader reader;
+    if (!reader.Open(shmName)) {
+        printf("  %-34s skipped: can't open %s\n", name, shmName);
+        return;
+    }
+
+    UInt32 channels = engine.GetChannelCount();
+    std::vector<float> mix(framesPerPeriod * channels, 0.25f);
+    std::vector<float> input(framesPerPeriod * channels, 0.0f);
+
+    AudioBufferList mixList;
+    mixList.mNumberBuffers              = 1;
+    mixList.mBuffers[0].mNumberChannels = channels;
+    mixList.mBuffers[0].mDataByteSize   = framesPerPeriod * BytesPerFrame(channels);
+    mixList.mBuffers[0].mData           = mix.data();
+
+    UInt64 received = 0;
+    Clock::time_point start = Clock::now();
+    for (UInt32 i = 0; i < periods; i++) {
+        engine.DoIOOperation(kAudioServerPlugInIOOperationWriteMix, 0, framesPerPeriod, &mixList);
+        received += reader.Read(input.data(), framesPerPeriod);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    engine.StopIO();
+    gSink = gSink + input[0];
+    PrintResult(name, periods, framesPerPeriod, seconds);
+    printf("  %-34s received %llu  dropped %llu\n", "",
+           (unsigned long long)received,
+           (unsigned long long)reader.Header()->droppedFrames.load(std::memory_order_relaxed));
+}
+
+// ============================================================================
+// IOEngine::GetZeroTimeStamp
+// ============================================================================
+
+static void BenchZeroTimeStamp(UInt32 iterations) {
+    IOEngine engine;
+    engine.StartIO();
+
+    Float64 sampleTime = 0;
+    UInt64 hostTime = 0, seed = 0;
+
+    Clock::time_point start = Clock::now();
+    for (UInt32 i = 0; i < iterations; i++) {
+        engine.GetZeroTimeStamp(&sampleTime, &hostTime, &seed);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    engine.StopIO();
+    gSink = gSink + (float)sampleTime;
+    printf("  %-28s %10.1f ns/call\n", "GetZeroTimeStamp", seconds * 1e9 / iterations);
+}
+
+// ============================================================================
+// main
+// ============================================================================
+
+int main(int argc, char* argv[]) {
+    UInt32 periods         = (argc >= 2) ? (UInt32)atoi(argv[1]) : 200000;
+    UInt32 framesPerPeriod = (argc >= 3) ? (UInt32)atoi(argv[2]) : kFramesPerPeriod;
+
+    if (periods == 0 || framesPerPeriod == 0 || framesPerPeriod > kRingBufferFrameCapacity) {
+        fprintf(stderr, "Usage: pulse-audio-bench [periods] [frames-per-period]\n");
+        return 1;
+    }
+
+    printf("pulse-audio-bench: %u periods x %u frames, %u channels\n",
+           (unsigned)periods, (unsigned)framesPerPeriod, (unsigned)kDefaultNumChannels);
+
+    for (UInt32 i = 0; i < kNumSupportedChannelCounts; i++) {
+        BenchGainKernels(kSupportedChannelCounts[i], periods, framesPerPeriod);
+    }
+    BenchConvertKernels(periods, framesPerPeriod);
+    BenchLevelKernels(periods, framesPerPeriod);
+    for (UInt32 i = 0; i < kNumSupportedChannelCounts; i++) {
+        if (kSupportedChannelCounts[i] > 1) {
+            BenchDownmixKernels(kSupportedChannelCounts[i], periods, framesPerPeriod);
+        }
+    }
+    BenchRingBuffer("RingBuffer modulo", false, periods, framesPerPeriod);
+    BenchRingBuffer("RingBuffer power-of-two", true, periods, framesPerPeriod);
+    BenchEngine("IOEngine unity gain", 0.25f, 1.0f, kDefaultNumChannels, kInputSampleFormat_Float32,
+                kInputChannelMode_Mirror, periods, framesPerPeriod);
+    BenchEngine("IOEngine scaled gain", 0.25f, 0.5f, kDefaultNumChannels, kInputSampleFormat_Float32,
+                kInputChannelMode_Mirror, periods, framesPerPeriod);
+    BenchEngine("IOEngine 5.1 scaled gain", 0.25f, 0.5f, 6, kInputSampleFormat_Float32,
+                kInputChannelMode_Mirror, periods, framesPerPeriod);
+    BenchEngine("IOEngine Int16 capture", 0.25f, 1.0f, kDefaultNumChannels, kInputSampleFormat_Int16,
+                kInputChannelMode_Mirror, periods, framesPerPeriod);
+    BenchEngine("IOEngine mono voice capture", 0.25f, 1.0f, kDefaultNumChannels, kInputSampleFormat_Float32,
+                kInputChannelMode_Mono, periods, framesPerPeriod);
+    BenchEngine("IOEngine 5.1 to mono Int16", 0.25f, 1.0f, 6, kInputSampleFormat_Int16,
+                kInputChannelMode_Mono, periods, framesPerPeriod);
+    BenchEngine("IOEngine silent mix", 0.0f, 1.0f, kDefaultNumChannels, kInputSampleFormat_Float32,
+                kInputChannelMode_Mirror, periods, framesPerPeriod);
+    BenchEngine("IOEngine silent mix Int16", 0.0f, 1.0f, kDefaultNumChannels, kInputSampleFormat_Int16,
+                kInputChannelMode_Mirror, periods, framesPerPeriod);
+    BenchSharedMemory("IOEngine shm capture", periods, framesPerPeriod);
+    BenchZeroTimeStamp(periods);
+
+    return 0;
+}
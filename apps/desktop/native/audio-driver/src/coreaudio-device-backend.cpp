@@ -0,0 +1,285 @@
+#include "coreaudio-device-backend.h"
+#include <Block.h>
+#include <CoreFoundation/CoreFoundation.h>
+#include <cstdio>
+
+static const AudioObjectPropertyAddress kDevicesAddress = {
+    kAudioHardwarePropertyDevices,
+    kAudioObjectPropertyScopeGlobal,
+    kAudioObjectPropertyElementMain
+};
+
+static const AudioObjectPropertyAddress kDefaultOutputAddress = {
+    kAudioHardwarePropertyDefaultOutputDevice,
+    kAudioObjectPropertyScopeGlobal,
+    kAudioObjectPropertyElementMain
+};
+
+static const AudioObjectPropertyAddress kIsAliveAddress = {
+    kAudioDevicePropertyDeviceIsAlive,
+    kAudioObjectPropertyScopeGlobal,
+    kAudioObjectPropertyElementMain
+};
+
+static CFStringRef ToCFString(const std::string& str) {
+    return CFStringCreateWithCString(kCFAllocatorDefault, str.c_str(), kCFStringEncodingUTF8);
+}
+
+// UTF-8 copy of a CFString property, "" if it can't be read
+static std::string GetStringProperty(AudioObjectID objectId, AudioObjectPropertySelector selector) {
+    AudioObjectPropertyAddress prop = {
+        selector,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+
+    CFStringRef value = nullptr;
+    UInt32 size = sizeof(CFStringRef);
+    OSStatus err = AudioObjectGetPropertyData(objectId, &prop, 0, nullptr, &size, &value);
+    if (err != noErr || !value) return std::string();
+
+    std::string result;
+    CFIndex length = CFStringGetMaximumSizeForEncoding(CFStringGetLength(value), kCFStringEncodingUTF8) + 1;
+    std::vector<char> buffer((size_t)length);
+    if (CFStringGetCString(value, buffer.data(), length, kCFStringEncodingUTF8)) {
+        result = buffer.data();
+    }
+    CFRelease(value);
+    return result;
+}
+
+static UInt32 GetStreamCount(AudioObjectID deviceId, AudioObjectPropertyScope scope) {
+    AudioObjectPropertyAddress prop = {
+        kAudioDevicePropertyStreams,
+        scope,
+        kAudioObjectPropertyElementMain
+    };
+    UInt32 size = 0;
+    AudioObjectGetPropertyDataSize(deviceId, &prop, 0, nullptr, &size);
+    return size / sizeof(AudioObjectID);
+}
+
+CoreAudioDeviceBackend::CoreAudioDeviceBackend()
+    : mGeneration(1)
+    , mListenerQueue(dispatch_queue_create("com.pulse.audio.helper.listener", DISPATCH_QUEUE_SERIAL))
+    , mDevicesListener(nullptr)
+    , mNotifyListener(nullptr)
+    , mDefaultOutputWatched(false)
+    , mAliveWatched(kAudioObjectUnknown)
+{
+    // Let the HAL deliver notifications on its own thread; the helper has
+    // no run loop of its own
+    CFRunLoopRef runLoop = nullptr;
+    AudioObjectPropertyAddress runLoopProp = {
+        kAudioHardwarePropertyRunLoop,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+    AudioObjectSetPropertyData(kAudioObjectSystemObject, &runLoopProp, 0, nullptr, sizeof(runLoop), &runLoop);
+
+    std::atomic<UInt64>* generation = &mGeneration;
+    DeviceEvents*        events     = &mEvents;
+    mDevicesListener = Block_copy(^(UInt32 numAddresses, const AudioObjectPropertyAddress* addresses) {
+        (void)numAddresses;
+        (void)addresses;
+        generation->fetch_add(1, std::memory_order_acq_rel);
+        events->Notify();
+    });
+    OSStatus err = AudioObjectAddPropertyListenerBlock(kAudioObjectSystemObject, &kDevicesAddress,
+                                                       mListenerQueue, mDevicesListener);
+    if (err != noErr) {
+        // Without the listener the table can't know when it's stale; every
+        // lookup then sees a new generation and re-enumerates
+        fprintf(stderr, "Failed to listen for device changes: %d\n", (int)err);
+        Block_release(mDevicesListener);
+        mDevicesListener = nullptr;
+    }
+
+    // Waits still poll without these, just slower
+    mNotifyListener = Block_copy(^(UInt32 numAddresses, const AudioObjectPropertyAddress* addresses) {
+        (void)numAddresses;
+        (void)addresses;
+        events->Notify();
+    });
+    err = AudioObjectAddPropertyListenerBlock(kAudioObjectSystemObject, &kDefaultOutputAddress,
+                                              mListenerQueue, mNotifyListener);
+    if (err == noErr) {
+        mDefaultOutputWatched = true;
+    } else {
+        fprintf(stderr, "Failed to listen for default output changes: %d\n", (int)err);
+    }
+}
+
+CoreAudioDeviceBackend::~CoreAudioDeviceBackend()
+{
+    UnwatchAlive();
+    if (mDefaultOutputWatched) {
+        AudioObjectRemovePropertyListenerBlock(kAudioObjectSystemObject, &kDefaultOutputAddress,
+                                               mListenerQueue, mNotifyListener);
+    }
+    Block_release(mNotifyListener);
+    if (mDevicesListener) {
+        AudioObjectRemovePropertyListenerBlock(kAudioObjectSystemObject, &kDevicesAddress,
+                                               mListenerQueue, mDevicesListener);
+        Block_release(mDevicesListener);
+    }
+    // Let notifications already queued finish; they touch this object
+    dispatch_sync(mListenerQueue, ^{});
+    dispatch_release(mListenerQueue);
+}
+
+void CoreAudioDeviceBackend::WatchAlive(AudioObjectID deviceId)
+{
+    UnwatchAlive();
+    OSStatus err = AudioObjectAddPropertyListenerBlock(deviceId, &kIsAliveAddress,
+                                                       mListenerQueue, mNotifyListener);
+    if (err == noErr) mAliveWatched = deviceId;
+}
+
+void CoreAudioDeviceBackend::UnwatchAlive()
+{
+    if (mAliveWatched == kAudioObjectUnknown) return;
+    // Fails harmlessly once the device is gone
+    AudioObjectRemovePropertyListenerBlock(mAliveWatched, &kIsAliveAddress, mListenerQueue, mNotifyListener);
+    mAliveWatched = kAudioObjectUnknown;
+}
+
+OSStatus CoreAudioDeviceBackend::ListDevices(std::vector<AudioDeviceInfo>* outDevices)
+{
+    outDevices->clear();
+
+    // No listener: make every generation read look new
+    if (!mDevicesListener) mGeneration.fetch_add(1, std::memory_order_acq_rel);
+
+    UInt32 dataSize = 0;
+    OSStatus err = AudioObjectGetPropertyDataSize(kAudioObjectSystemObject, &kDevicesAddress, 0, nullptr, &dataSize);
+    if (err != noErr) return err;
+
+    std::vector<AudioObjectID> devices(dataSize / sizeof(AudioObjectID));
+    err = AudioObjectGetPropertyData(kAudioObjectSystemObject, &kDevicesAddress, 0, nullptr, &dataSize, devices.data());
+    if (err != noErr) return err;
+    devices.resize(dataSize / sizeof(AudioObjectID));
+
+    AudioObjectPropertyAddress transportProp = {
+        kAudioDevicePropertyTransportType,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+
+    for (AudioObjectID deviceId : devices) {
+        AudioDeviceInfo info;
+        info.id            = deviceId;
+        info.uid           = GetStringProperty(deviceId, kAudioDevicePropertyDeviceUID);
+        info.name          = GetStringProperty(deviceId, kAudioObjectPropertyName);
+        info.outputStreams = GetStreamCount(deviceId, kAudioObjectPropertyScopeOutput);
+        info.inputStreams  = GetStreamCount(deviceId, kAudioObjectPropertyScopeInput);
+        info.transportType = 0;
+        UInt32 size = sizeof(info.transportType);
+        AudioObjectGetPropertyData(deviceId, &transportProp, 0, nullptr, &size, &info.transportType);
+        outDevices->push_back(info);
+    }
+    return noErr;
+}
+
+OSStatus CoreAudioDeviceBackend::TranslateUIDToDevice(const std::string& uid, AudioObjectID* outDeviceId)
+{
+    AudioObjectPropertyAddress translateProp = {
+        kAudioHardwarePropertyTranslateUIDToDevice,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+
+    CFStringRef uidString = ToCFString(uid);
+    AudioObjectID deviceId = kAudioObjectUnknown;
+    UInt32 size = sizeof(deviceId);
+    OSStatus err = AudioObjectGetPropertyData(kAudioObjectSystemObject, &translateProp,
+                                              sizeof(uidString), &uidString, &size, &deviceId);
+    CFRelease(uidString);
+    if (err != noErr) return err;
+
+    *outDeviceId = deviceId;
+    return noErr;
+}
+
+OSStatus CoreAudioDeviceBackend::GetDefaultOutput(AudioObjectID* outDeviceId)
+{
+    UInt32 size = sizeof(*outDeviceId);
+    return AudioObjectGetPropertyData(kAudioObjectSystemObject, &kDefaultOutputAddress, 0, nullptr, &size, outDeviceId);
+}
+
+OSStatus CoreAudioDeviceBackend::SetDefaultOutput(AudioObjectID deviceId)
+{
+    return AudioObjectSetPropertyData(
+        kAudioObjectSystemObject, &kDefaultOutputAddress, 0, nullptr, sizeof(deviceId), &deviceId);
+}
+
+bool CoreAudioDeviceBackend::IsDeviceAlive(AudioObjectID deviceId)
+{
+    UInt32 alive = 0;
+    UInt32 size = sizeof(alive);
+    OSStatus err = AudioObjectGetPropertyData(deviceId, &kIsAliveAddress, 0, nullptr, &size, &alive);
+    return err == noErr && alive != 0;
+}
+
+OSStatus CoreAudioDeviceBackend::CreateAggregate(const std::string& uid,
+                                                 const std::string& name,
+                                                 const std::vector<std::string>& subDeviceUIDs,
+                                                 const std::string& mainSubDeviceUID,
+                                                 AudioObjectID* outDeviceId)
+{
+    CFStringRef aggUID  = ToCFString(uid);
+    CFStringRef aggName = ToCFString(name);
+    CFStringRef mainUID = ToCFString(mainSubDeviceUID);
+
+    // Build sub-device list
+    CFMutableArrayRef subDevices = CFArrayCreateMutable(kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks);
+    for (const std::string& subUID : subDeviceUIDs) {
+        CFStringRef subUIDString = ToCFString(subUID);
+        CFMutableDictionaryRef subDict = CFDictionaryCreateMutable(kCFAllocatorDefault, 0,
+            &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+        CFDictionarySetValue(subDict, CFSTR(kAudioSubDeviceUIDKey), subUIDString);
+        CFArrayAppendValue(subDevices, subDict);
+        CFRelease(subDict);
+        CFRelease(subUIDString);
+    }
+
+    // Aggregate device description
+    CFMutableDictionaryRef desc = CFDictionaryCreateMutable(kCFAllocatorDefault, 0,
+        &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+
+    CFDictionarySetValue(desc, CFSTR(kAudioAggregateDeviceUIDKey), aggUID);
+    CFDictionarySetValue(desc, CFSTR(kAudioAggregateDeviceNameKey), aggName);
+    CFDictionarySetValue(desc, CFSTR(kAudioAggregateDeviceSubDeviceListKey), subDevices);
+    CFDictionarySetValue(desc, CFSTR(kAudioAggregateDeviceMainSubDeviceKey), mainUID);
+
+    // Multi-output mode (NOT stacked, NOT private).
+    // Multi-output routes audio to all sub-devices simultaneously — audio plays
+    // through the real speakers AND gets sent to the Pulse virtual device for capture.
+
+    // Create the aggregate device
+    AudioObjectID aggregateId = 0;
+    OSStatus err = AudioHardwareCreateAggregateDevice(desc, &aggregateId);
+
+    CFRelease(desc);
+    CFRelease(subDevices);
+    CFRelease(aggUID);
+    CFRelease(aggName);
+    CFRelease(mainUID);
+
+    if (err != noErr) {
+        fprintf(stderr, "Failed to create aggregate device: %d\n", (int)err);
+        return err;
+    }
+
+    // HelperService waits for it to come alive
+    WatchAlive(aggregateId);
+
+    *outDeviceId = aggregateId;
+    return noErr;
+}
+
+OSStatus CoreAudioDeviceBackend::DestroyAggregate(AudioObjectID deviceId)
+{
+    if (deviceId == mAliveWatched) UnwatchAlive();
+    return AudioHardwareDestroyAggregateDevice(deviceId);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <CoreAudio/CoreAudio.h>
+#include <dispatch/dispatch.h>
+#include "device-backend.h"
+
+// DeviceBackend over the CoreAudio HAL (macOS only). A listener on
+// kAudioHardwarePropertyDevices bumps the generation, so a long-running
+// helper re-enumerates only after devices come or go. That listener, one
+// on the default output and one on the IsAlive of the aggregate created
+// last notify Events(), which HelperService waits on.
+class CoreAudioDeviceBackend : public DeviceBackend {
+public:
+    CoreAudioDeviceBackend();
+    ~CoreAudioDeviceBackend() override;
+
+    OSStatus ListDevices(std::vector<AudioDeviceInfo>* outDevices) override;
+    UInt64   DeviceListGeneration() const override { return mGeneration.load(std::memory_order_acquire); }
+    OSStatus TranslateUIDToDevice(const std::string& uid, AudioObjectID* outDeviceId) override;
+    OSStatus GetDefaultOutput(AudioObjectID* outDeviceId) override;
+    OSStatus SetDefaultOutput(AudioObjectID deviceId) override;
+    bool     IsDeviceAlive(AudioObjectID deviceId) override;
+    OSStatus CreateAggregate(const std::string& uid,
+                             const std::string& name,
+                             const std::vector<std::string>& subDeviceUIDs,
+                             const std::string& mainSubDeviceUID,
+                             AudioObjectID* outDeviceId) override;
+    OSStatus DestroyAggregate(AudioObjectID deviceId) override;
+
+private:
+    void     WatchAlive(AudioObjectID deviceId);
+    void     UnwatchAlive();
+
+    std::atomic<UInt64>              mGeneration;
+    dispatch_queue_t                 mListenerQueue;
+    // Heap copies, so they can be removed
+    AudioObjectPropertyListenerBlock mDevicesListener;
+    AudioObjectPropertyListenerBlock mNotifyListener;    // default output and IsAlive
+    bool                             mDefaultOutputWatched;
+    AudioObjectID                    mAliveWatched;      // kAudioObjectUnknown if none
+};
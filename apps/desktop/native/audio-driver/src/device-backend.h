@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "device-events.h"
+#include "platform.h"
+
+// One audio device as pulse-audio-helper sees it
+struct AudioDeviceInfo {
+    AudioObjectID id;
+    std::string   uid;
+    std::string   name;
+    UInt32        outputStreams;
+    UInt32        inputStreams;
+    UInt32        transportType;   // four-char code, 0 if unknown
+};
+
+// The system audio operations pulse-audio-helper needs. The helper's
+// command logic (HelperService) only talks to this, so it runs against
+// CoreAudio on macOS and against MockDeviceBackend in the Linux tests.
+// Errors are CoreAudio status codes.
+//
+// Changes are requests: like the HAL, a backend may apply them after it
+// returns. It calls Events().Notify() as devices come and go, the default
+// output changes or a device's IsAlive flips, so HelperService can wait
+// for the result instead of sleeping.
+class DeviceBackend {
+public:
+    virtual ~DeviceBackend() {}
+
+    // Every device in the system
+    virtual OSStatus ListDevices(std::vector<AudioDeviceInfo>* outDevices) = 0;
+
+    // Bumped whenever devices may have been added or removed, so callers
+    // can keep a cached ListDevices() table
+    virtual UInt64   DeviceListGeneration() const = 0;
+
+    // ID of the device with this UID without enumerating; kAudioObjectUnknown
+    // (and no error) if there is none
+    virtual OSStatus TranslateUIDToDevice(const std::string& uid, AudioObjectID* outDeviceId) = 0;
+
+    virtual OSStatus GetDefaultOutput(AudioObjectID* outDeviceId) = 0;
+    virtual OSStatus SetDefaultOutput(AudioObjectID deviceId) = 0;
+
+    // Whether deviceId exists and is running; false once it's gone
+    virtual bool     IsDeviceAlive(AudioObjectID deviceId) = 0;
+
+    // Create a public multi-output aggregate over subDeviceUIDs, clocked by
+    // mainSubDeviceUID. The ID is valid on return; the device may not be
+    // alive yet.
+    virtual OSStatus CreateAggregate(const std::string& uid,
+                                     const std::string& name,
+                                     const std::vector<std::string>& subDeviceUIDs,
+                                     const std::string& mainSubDeviceUID,
+                                     AudioObjectID* outDeviceId) = 0;
+    virtual OSStatus DestroyAggregate(AudioObjectID deviceId) = 0;
+
+    DeviceEvents&    Events() { return mEvents; }
+
+protected:
+    DeviceEvents     mEvents;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include "platform.h"
+
+// Wakes threads waiting for the system's audio devices to settle. A
+// backend calls Notify() from its property listeners (device list, default
+// output, IsAlive); WaitUntil() re-checks its condition after each
+// notification and gives up at the deadline.
+//
+// The condition is always read from the system, never inferred from the
+// notification, so a coalesced or missed notification only costs time.
+// As a backstop for a listener that couldn't be registered, waiters also
+// re-check every kPollInterval.
+class DeviceEvents {
+public:
+    static constexpr std::chrono::milliseconds kPollInterval{50};
+
+    DeviceEvents() : mCount(0) {}
+
+    void Notify()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mCount++;
+        }
+        mCond.notify_all();
+    }
+
+    // Wait until ready() returns true or timeout passes; returns the last
+    // ready(). ready() runs without the lock held, so it may call into the
+    // backend, which may Notify().
+    template <typename Predicate>
+    bool WaitUntil(std::chrono::milliseconds timeout, Predicate ready)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        for (;;) {
+            // Sample the count before checking, so a change that lands
+            // between the check and the wait still wakes us
+            UInt64 seen;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                seen = mCount;
+            }
+            if (ready()) return true;
+
+            auto now = std::chrono::steady_clock::now();
+            if (now >= deadline) return false;
+
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCond.wait_until(lock, std::min(deadline, now + kPollInterval),
+                             [&] { return mCount != seen; });
+        }
+    }
+
+private:
+    std::mutex              mMutex;
+    std::condition_variable mCond;
+    UInt64                  mCount;
+};
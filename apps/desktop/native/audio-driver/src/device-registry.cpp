@@ -0,0 +1,61 @@
+#include "device-registry.h"
+
+DeviceRegistry::DeviceRegistry(DeviceBackend& backend)
+    : mBackend(backend)
+    , mGeneration(0)
+    , mValid(false)
+{
+}
+
+const std::vector<AudioDeviceInfo>* DeviceRegistry::Devices(OSStatus* outStatus)
+{
+    if (outStatus) *outStatus = kAudioHardwareNoError;
+    if (IsCurrent()) return &mDevices;
+
+    // Sample the generation first, so a change while listing forces another rebuild
+    UInt64 generation = mBackend.DeviceListGeneration();
+    mByUID.clear();
+    mByID.clear();
+    OSStatus err = mBackend.ListDevices(&mDevices);
+    if (err != kAudioHardwareNoError) {
+        mDevices.clear();
+        mValid = false;
+        if (outStatus) *outStatus = err;
+        return nullptr;
+    }
+
+    for (size_t i = 0; i < mDevices.size(); i++) {
+        // An empty UID (property unreadable) can't be looked up
+        if (!mDevices[i].uid.empty()) mByUID.emplace(mDevices[i].uid, i);
+        mByID.emplace(mDevices[i].id, i);
+    }
+    mGeneration = generation;
+    mValid      = true;
+    return &mDevices;
+}
+
+const AudioDeviceInfo* DeviceRegistry::Find(const std::string& uid)
+{
+    if (!Devices()) return nullptr;
+    std::unordered_map<std::string, size_t>::const_iterator it = mByUID.find(uid);
+    return it != mByUID.end() ? &mDevices[it->second] : nullptr;
+}
+
+const AudioDeviceInfo* DeviceRegistry::Find(AudioObjectID deviceId)
+{
+    if (!Devices()) return nullptr;
+    std::unordered_map<AudioObjectID, size_t>::const_iterator it = mByID.find(deviceId);
+    return it != mByID.end() ? &mDevices[it->second] : nullptr;
+}
+
+AudioObjectID DeviceRegistry::TranslateUID(const std::string& uid)
+{
+    if (IsCurrent()) {
+        std::unordered_map<std::string, size_t>::const_iterator it = mByUID.find(uid);
+        return it != mByUID.end() ? mDevices[it->second].id : kAudioObjectUnknown;
+    }
+
+    AudioObjectID deviceId = kAudioObjectUnknown;
+    if (mBackend.TranslateUIDToDevice(uid, &deviceId) != kAudioHardwareNoError) return kAudioObjectUnknown;
+    return deviceId;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "device-backend.h"
+
+// Cached view of the system's devices over a DeviceBackend: the full
+// table with UID and name/transport metadata, plus hash indexes by UID and
+// by ID. It's rebuilt only when the backend's device list generation moves
+// (on CoreAudio, when the kAudioHardwarePropertyDevices listener fires) or
+// after Invalidate().
+//
+// TranslateUID() is for callers that only need an ID: with a current table
+// it's an index hit, otherwise one backend lookup
+// (kAudioHardwarePropertyTranslateUIDToDevice) instead of enumerating and
+// fetching every device's UID.
+//
+// Not thread-safe; pointers stay valid until the next rebuild.
+class DeviceRegistry {
+public:
+    explicit DeviceRegistry(DeviceBackend& backend);
+
+    // The table, rebuilt if stale; nullptr if enumeration failed
+    const std::vector<AudioDeviceInfo>* Devices(OSStatus* outStatus = nullptr);
+    const AudioDeviceInfo* Find(const std::string& uid);
+    const AudioDeviceInfo* Find(AudioObjectID deviceId);
+
+    // ID for uid, kAudioObjectUnknown if no such device. Never rebuilds.
+    AudioObjectID TranslateUID(const std::string& uid);
+
+    bool     IsCurrent() const { return mValid && mBackend.DeviceListGeneration() == mGeneration; }
+    void     Invalidate() { mValid = false; }
+
+private:
+    DeviceBackend&                                 mBackend;
+    std::vector<AudioDeviceInfo>                   mDevices;
+    std::unordered_map<std::string, size_t>        mByUID;
+    std::unordered_map<AudioObjectID, size_t>      mByID;
+    UInt64                                         mGeneration;
+    bool                                           mValid;
+};
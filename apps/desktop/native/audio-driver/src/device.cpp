@@ -1,41 +1,395 @@
 #include "device.h"
-#include <mach/mach_time.h>
 #include <cmath>
+#include "plugin.h"
+#include "property-table.h"
+
+// Custom properties advertised through kAudioObjectPropertyCustomPropertyInfoList
+static const AudioServerPlugInCustomPropertyInfo kCustomDeviceProperties[] = {
+    { kPulseDevicePropertyBufferConfig,
+      kAudioServerPlugInCustomPropertyDataTypeCFPropertyList,
+      kAudioServerPlugInCustomPropertyDataTypeNone },
+    { kPulseDevicePropertyStats,
+      kAudioServerPlugInCustomPropertyDataTypeCFPropertyList,
+      kAudioServerPlugInCustomPropertyDataTypeNone },
+    { kPulseDevicePropertyInt16Dither,
+      kAudioServerPlugInCustomPropertyDataTypeCFPropertyList,
+      kAudioServerPlugInCustomPropertyDataTypeNone },
+    { kPulseDevicePropertyVoiceCapture,
+      kAudioServerPlugInCustomPropertyDataTypeCFPropertyList,
+      kAudioServerPlugInCustomPropertyDataTypeNone },
+    { kPulseDevicePropertyMeter,
+      kAudioServerPlugInCustomPropertyDataTypeCFPropertyList,
+      kAudioServerPlugInCustomPropertyDataTypeNone },
+    { kPulseDevicePropertySharedMemory,
+      kAudioServerPlugInCustomPropertyDataTypeCFString,
+      kAudioServerPlugInCustomPropertyDataTypeNone },
+};
+static const UInt32 kNumCustomDeviceProperties =
+    sizeof(kCustomDeviceProperties) / sizeof(kCustomDeviceProperties[0]);
+
+// Custom properties of the input stream
+static const AudioServerPlugInCustomPropertyInfo kCustomInputStreamProperties[] = {
+    { kPulseStreamPropertyActive,
+      kAudioServerPlugInCustomPropertyDataTypeCFPropertyList,
+      kAudioServerPlugInCustomPropertyDataTypeNone },
+};
+static const UInt32 kNumCustomInputStreamProperties =
+    sizeof(kCustomInputStreamProperties) / sizeof(kCustomInputStreamProperties[0]);
+
+static void SetDictionaryUInt32(CFMutableDictionaryRef dict, CFStringRef key, UInt32 value)
+{
+    SInt64 wide = value;
+    CFNumberRef number = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt64Type, &wide);
+    CFDictionarySetValue(dict, key, number);
+    CFRelease(number);
+}
+
+static void SetDictionaryUInt64(CFMutableDictionaryRef dict, CFStringRef key, UInt64 value)
+{
+    SInt64 wide = (SInt64)value;
+    CFNumberRef number = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt64Type, &wide);
+    CFDictionarySetValue(dict, key, number);
+    CFRelease(number);
+}
 
-// Helper to convert mach_absolute_time to nanoseconds
-static UInt64 HostTimeToNanos(UInt64 hostTime)
+static void SetDictionaryFloat64(CFMutableDictionaryRef dict, CFStringRef key, Float64 value)
 {
-    static mach_timebase_info_data_t sTimebase = { 0, 0 };
-    if (sTimebase.denom == 0) {
-        mach_timebase_info(&sTimebase);
+    CFNumberRef number = CFNumberCreate(kCFAllocatorDefault, kCFNumberFloat64Type, &value);
+    CFDictionarySetValue(dict, key, number);
+    CFRelease(number);
+}
+
+// Store the first count values as an array of floats
+static void SetDictionaryFloat32Array(CFMutableDictionaryRef dict, CFStringRef key,
+                                      const Float32* values, UInt32 count)
+{
+    CFMutableArrayRef array = CFArrayCreateMutable(kCFAllocatorDefault, count, &kCFTypeArrayCallBacks);
+    for (UInt32 i = 0; i < count; i++) {
+        Float64 value = values[i];
+        CFNumberRef number = CFNumberCreate(kCFAllocatorDefault, kCFNumberFloat64Type, &value);
+        CFArrayAppendValue(array, number);
+        CFRelease(number);
     }
-    return (hostTime * sTimebase.numer) / sTimebase.denom;
+    CFDictionarySetValue(dict, key, array);
+    CFRelease(array);
 }
 
-static UInt64 NanosToHostTime(UInt64 nanos)
+#if PULSE_AUDIO_IO_HISTOGRAMS
+// Store a histogram as an array of bucket counts (see IOHistogram for the bucket bounds)
+static void SetDictionaryHistogram(CFMutableDictionaryRef dict, CFStringRef key,
+                                   const IOHistogram& histogram)
 {
-    static mach_timebase_info_data_t sTimebase = { 0, 0 };
-    if (sTimebase.denom == 0) {
-        mach_timebase_info(&sTimebase);
+    CFMutableArrayRef array = CFArrayCreateMutable(kCFAllocatorDefault, IOHistogram::kNumBuckets,
+                                                   &kCFTypeArrayCallBacks);
+    for (UInt32 i = 0; i < IOHistogram::kNumBuckets; i++) {
+        SInt64 count = (SInt64)histogram.BucketCount(i);
+        CFNumberRef number = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt64Type, &count);
+        CFArrayAppendValue(array, number);
+        CFRelease(number);
     }
-    return (nanos * sTimebase.denom) / sTimebase.numer;
+    CFDictionarySetValue(dict, key, array);
+    CFRelease(array);
 }
+#endif
 
-PulseDevice::PulseDevice()
-    : mSampleRate(kDefaultSampleRate)
-    , mVolume(kDefaultVolume)
-    , mMuted(false)
-    , mIORunning(false)
-    , mIOStartCount(0)
-    , mIOAnchorHostTime(0)
-    , mIOAnchorSampleTime(0)
-    , mTimestampSeed(0)
+static bool GetDictionaryUInt32(CFDictionaryRef dict, CFStringRef key, UInt32* outValue)
 {
-    mRingBuffer.Initialize(kRingBufferFrameCapacity, kBytesPerFrame);
+    CFTypeRef value = CFDictionaryGetValue(dict, key);
+    if (!value || CFGetTypeID(value) != CFNumberGetTypeID()) return false;
+
+    SInt64 wide = 0;
+    if (!CFNumberGetValue((CFNumberRef)value, kCFNumberSInt64Type, &wide)) return false;
+    if (wide < 0 || wide > 0xFFFFFFFFll) return false;
+    *outValue = (UInt32)wide;
+    return true;
+}
+
+PulseDevice::PulseDevice(AudioServerPlugInHostRef host, UInt32 slot, CFStringRef uid, CFStringRef name)
+    : mHost(host)
+    , mDeviceID(DeviceObjectID(slot, kObjectOffset_Device))
+    , mOutputStreamID(DeviceObjectID(slot, kObjectOffset_Stream_Output))
+    , mInputStreamID(DeviceObjectID(slot, kObjectOffset_Stream_Input))
+    , mVolumeID(DeviceObjectID(slot, kObjectOffset_Volume))
+    , mUID((CFStringRef)CFRetain(uid))
+    , mName((CFStringRef)CFRetain(name))
+    , mReportedInputActive(false)
+    , mNotifiedInputActive(false)
+    , mActivityQueue(dispatch_queue_create("com.pulse.audio.device.activity", DISPATCH_QUEUE_SERIAL))
+    , mActivitySource(dispatch_source_create(DISPATCH_SOURCE_TYPE_DATA_OR, 0, 0, mActivityQueue))
+{
+    dispatch_source_set_event_handler(mActivitySource, ^{
+        ReportInputActivity();
+    });
+    dispatch_resume(mActivitySource);
 }
 
 PulseDevice::~PulseDevice()
 {
+    // No handler starts after the cancel; wait out one that already has
+    dispatch_source_cancel(mActivitySource);
+    dispatch_sync(mActivityQueue, ^{});
+    dispatch_release(mActivitySource);
+    dispatch_release(mActivityQueue);
+
+    CFRelease(mUID);
+    CFRelease(mName);
+}
+
+// Linear PCM description for one of the stream sample formats
+static void FillStreamFormat(AudioStreamBasicDescription* desc, Float64 sampleRate,
+                             UInt32 channels, UInt32 sampleFormat)
+{
+    bool int16 = (sampleFormat == kInputSampleFormat_Int16);
+    desc->mSampleRate       = sampleRate;
+    desc->mFormatID         = kAudioFormatLinearPCM;
+    desc->mFormatFlags      = (int16 ? kAudioFormatFlagIsSignedInteger : kAudioFormatFlagIsFloat)
+                            | kAudioFormatFlagIsPacked;
+    desc->mFramesPerPacket  = 1;
+    desc->mChannelsPerFrame = channels;
+    desc->mBitsPerChannel   = int16 ? kInt16BitsPerChannel : kBitsPerChannel;
+    desc->mBytesPerFrame    = int16 ? Int16BytesPerFrame(channels) : BytesPerFrame(channels);
+    desc->mBytesPerPacket   = desc->mBytesPerFrame;
+}
+
+// ============================================================================
+// Property tables
+// ============================================================================
+
+typedef PropertyDescriptor<PulseDevice> Row;
+
+// Store a property value; for getters whose whole job is one value
+template <typename T>
+static inline OSStatus WriteProperty(void* outData, T value)
+{
+    *(T*)outData = value;
+    return kAudioHardwareNoError;
+}
+
+// Property rows of the device, its two streams and its volume control, one
+// row per selector. A friend of PulseDevice so the callbacks reach its state.
+// Callbacks longer than a line or two are defined with the other properties
+// of their object below.
+struct PulseDeviceProperties {
+    // Table for the kind of object objectID is; empty for an unknown kind
+    static PropertyTable<PulseDevice> For(AudioObjectID objectID);
+
+    // Device
+    static UInt32   StreamsInScope(const PulseDevice& device, const PropertyQuery& query, AudioObjectID* outIDs);
+    static OSStatus GetBufferConfig(PulseDevice& device, const PropertyQuery& query, UInt32* ioDataSize, void* outData);
+    static OSStatus SetBufferConfig(PulseDevice& device, const PropertyQuery& query, const void* inData);
+    static OSStatus GetStats(PulseDevice& device, const PropertyQuery& query, UInt32* ioDataSize, void* outData);
+    static OSStatus SetInt16Dither(PulseDevice& device, const PropertyQuery& query, const void* inData);
+    static OSStatus GetVoiceCapture(PulseDevice& device, const PropertyQuery& query, UInt32* ioDataSize, void* outData);
+    static OSStatus SetVoiceCapture(PulseDevice& device, const PropertyQuery& query, const void* inData);
+    static OSStatus GetMeter(PulseDevice& device, const PropertyQuery& query, UInt32* ioDataSize, void* outData);
+    static OSStatus GetSharedMemory(PulseDevice& device, const PropertyQuery& query, UInt32* ioDataSize, void* outData);
+    static OSStatus SetSharedMemory(PulseDevice& device, const PropertyQuery& query, const void* inData);
+
+    // Streams
+    static bool     IsInputStream(const PulseDevice& device, const PropertyQuery& query);
+    static OSStatus GetStreamFormat(PulseDevice& device, const PropertyQuery& query, UInt32* ioDataSize, void* outData);
+    static OSStatus SetStreamFormat(PulseDevice& device, const PropertyQuery& query, const void* inData);
+    static UInt32   SizeOfAvailableFormats(const PulseDevice& device, const PropertyQuery& query);
+    static OSStatus GetAvailableFormats(PulseDevice& device, const PropertyQuery& query, UInt32* ioDataSize, void* outData);
+
+    // Volume control
+    static OSStatus SetScalarVolume(PulseDevice& device, const PropertyQuery& query, const void* inData);
+    static OSStatus GetDecibelVolume(PulseDevice& device, const PropertyQuery& query, UInt32* ioDataSize, void* outData);
+    static OSStatus SetDecibelVolume(PulseDevice& device, const PropertyQuery& query, const void* inData);
+
+    static constexpr auto kDevice = MakePropertyRows<PulseDevice>({
+        Row::Constant<AudioClassID, kAudioObjectClassID>(kAudioObjectPropertyBaseClass),
+        Row::Constant<AudioClassID, kAudioDeviceClassID>(kAudioObjectPropertyClass),
+        Row::Constant<AudioObjectID, kObjectID_Plugin>(kAudioObjectPropertyOwner),
+        Row::Of<CFStringRef>(kAudioObjectPropertyName,
+            [](PulseDevice& device, const PropertyQuery&, UInt32*, void* outData) {
+                return WriteProperty(outData, (CFStringRef)CFRetain(device.mName));
+            }),
+        Row::Of<CFStringRef>(kAudioObjectPropertyManufacturer,
+            [](PulseDevice&, const PropertyQuery&, UInt32*, void* outData) {
+                return WriteProperty(outData, (CFStringRef)CFRetain(PluginStrings().manufacturer));
+            }),
+        Row::Variable(kAudioObjectPropertyOwnedObjects,
+            [](const PulseDevice&, const PropertyQuery&) -> UInt32 { return 3 * sizeof(AudioObjectID); },
+            [](PulseDevice& device, const PropertyQuery& query, UInt32* ioDataSize, void* outData) {
+                // Output stream + Input stream + Volume control
+                const AudioObjectID ids[] = { device.mOutputStreamID, device.mInputStreamID, device.mVolumeID };
+                return CopyPropertyArray(query, ids, 3, ioDataSize, outData);
+            }),
+        Row::Of<CFStringRef>(kAudioDevicePropertyDeviceUID,
+            [](PulseDevice& device, const PropertyQuery&, UInt32*, void* outData) {
+                return WriteProperty(outData, (CFStringRef)CFRetain(device.mUID));
+            }),
+        Row::Of<CFStringRef>(kAudioDevicePropertyModelUID,
+            [](PulseDevice&, const PropertyQuery&, UInt32*, void* outData) {
+                return WriteProperty(outData, (CFStringRef)CFRetain(kDeviceModelUID));
+            }),
+        Row::Constant<UInt32, kAudioDeviceTransportTypeVirtual>(kAudioDevicePropertyTransportType),
+        Row::Of<AudioObjectID>(kAudioDevicePropertyRelatedDevices,
+            [](PulseDevice& device, const PropertyQuery&, UInt32*, void* outData) {
+                return WriteProperty(outData, device.mDeviceID);
+            }),
+        Row::Constant<UInt32, 0>(kAudioDevicePropertyClockDomain),
+        Row::Constant<UInt32, 1>(kAudioDevicePropertyDeviceIsAlive),
+        Row::Of<UInt32>(kAudioDevicePropertyDeviceIsRunning,
+            [](PulseDevice& device, const PropertyQuery&, UInt32*, void* outData) {
+                return WriteProperty<UInt32>(outData, device.mEngine.IsIORunning() ? 1 : 0);
+            }),
+        Row::Constant<UInt32, 1>(kAudioDevicePropertyDeviceCanBeDefaultDevice),
+        Row::Constant<UInt32, 0>(kAudioDevicePropertyDeviceCanBeDefaultSystemDevice), // Don't hijack system sounds
+        Row::Constant<UInt32, kDeviceLatencyFrames>(kAudioDevicePropertyLatency),
+        Row::Variable(kAudioDevicePropertyStreams,
+            [](const PulseDevice& device, const PropertyQuery& query) -> UInt32 {
+                AudioObjectID ids[2];
+                return StreamsInScope(device, query, ids) * sizeof(AudioObjectID);
+            },
+            [](PulseDevice& device, const PropertyQuery& query, UInt32* ioDataSize, void* outData) {
+                AudioObjectID ids[2];
+                return CopyPropertyArray(query, ids, StreamsInScope(device, query, ids), ioDataSize, outData);
+            }),
+        Row::Of<AudioObjectID>(kAudioObjectPropertyControlList,
+            [](PulseDevice& device, const PropertyQuery&, UInt32*, void* outData) {
+                return WriteProperty(outData, device.mVolumeID);
+            }),
+        Row::Of<Float64>(kAudioDevicePropertyNominalSampleRate,
+            [](PulseDevice& device, const PropertyQuery&, UInt32*, void* outData) {
+                return WriteProperty(outData, device.mEngine.GetSampleRate());
+            },
+            [](PulseDevice& device, const PropertyQuery&, const void* inData) {
+                return device.RequestFormat(*(const Float64*)inData, 0, 0, 0);
+            }),
+        Row::Variable(kAudioDevicePropertyAvailableNominalSampleRates,
+            [](const PulseDevice&, const PropertyQuery&) -> UInt32 {
+                return kNumSupportedSampleRates * sizeof(AudioValueRange);
+            },
+            [](PulseDevice&, const PropertyQuery& query, UInt32* ioDataSize, void* outData) {
+                AudioValueRange ranges[kNumSupportedSampleRates];
+                for (UInt32 i = 0; i < kNumSupportedSampleRates; i++) {
+                    ranges[i].mMinimum = kSupportedSampleRates[i];
+                    ranges[i].mMaximum = kSupportedSampleRates[i];
+                }
+                return CopyPropertyArray(query, ranges, kNumSupportedSampleRates, ioDataSize, outData);
+            }),
+        Row::Of<UInt32>(kAudioDevicePropertyZeroTimeStampPeriod,
+            [](PulseDevice& device, const PropertyQuery&, UInt32*, void* outData) {
+                return WriteProperty(outData, device.mEngine.GetFramesPerPeriod());
+            }),
+        Row::Constant<CFURLRef, nullptr>(kAudioDevicePropertyIcon),
+        Row::Constant<UInt32, 0>(kAudioDevicePropertyIsHidden), // Not hidden — visible in Audio MIDI Setup
+        Row::Constant<UInt32, kSafetyOffsetFrames>(kAudioDevicePropertySafetyOffset),
+        Row::Variable(kAudioObjectPropertyCustomPropertyInfoList,
+            [](const PulseDevice&, const PropertyQuery&) -> UInt32 {
+                return kNumCustomDeviceProperties * sizeof(AudioServerPlugInCustomPropertyInfo);
+            },
+            [](PulseDevice&, const PropertyQuery& query, UInt32* ioDataSize, void* outData) {
+                return CopyPropertyArray(query, kCustomDeviceProperties, kNumCustomDeviceProperties,
+                                         ioDataSize, outData);
+            }),
+        Row::Of<CFPropertyListRef>(kPulseDevicePropertyBufferConfig, &GetBufferConfig, &SetBufferConfig),
+        Row::Of<CFPropertyListRef>(kPulseDevicePropertyStats, &GetStats),
+        Row::Of<CFPropertyListRef>(kPulseDevicePropertyInt16Dither,
+            [](PulseDevice& device, const PropertyQuery&, UInt32*, void* outData) {
+                return WriteProperty(outData, CFRetain(device.mEngine.IsInputDitherEnabled() ? kCFBooleanTrue
+                                                                                             : kCFBooleanFalse));
+            },
+            &SetInt16Dither),
+        Row::Of<CFPropertyListRef>(kPulseDevicePropertyVoiceCapture, &GetVoiceCapture, &SetVoiceCapture),
+        Row::Of<CFPropertyListRef>(kPulseDevicePropertyMeter, &GetMeter),
+        Row::Of<CFStringRef>(kPulseDevicePropertySharedMemory, &GetSharedMemory, &SetSharedMemory),
+    });
+
+    static constexpr auto kStream = MakePropertyRows<PulseDevice>({
+        Row::Constant<AudioClassID, kAudioObjectClassID>(kAudioObjectPropertyBaseClass),
+        Row::Constant<AudioClassID, kAudioStreamClassID>(kAudioObjectPropertyClass),
+        Row::Of<AudioObjectID>(kAudioObjectPropertyOwner,
+            [](PulseDevice& device, const PropertyQuery&, UInt32*, void* outData) {
+                return WriteProperty(outData, device.mDeviceID);
+            }),
+        Row::Constant<UInt32, 1>(kAudioStreamPropertyIsActive),
+        Row::Of<UInt32>(kAudioStreamPropertyDirection,
+            [](PulseDevice& device, const PropertyQuery& query, UInt32*, void* outData) {
+                // 0 = output (apps write to it), 1 = input (apps read from it)
+                return WriteProperty<UInt32>(outData, query.objectID == device.mOutputStreamID ? 0 : 1);
+            }),
+        Row::Of<UInt32>(kAudioStreamPropertyTerminalType,
+            [](PulseDevice& device, const PropertyQuery& query, UInt32*, void* outData) {
+                return WriteProperty<UInt32>(outData, query.objectID == device.mOutputStreamID
+                    ? kAudioStreamTerminalTypeLine
+                    : kAudioStreamTerminalTypeMicrophone);
+            }),
+        Row::Constant<UInt32, 1>(kAudioStreamPropertyStartingChannel),
+        Row::Constant<UInt32, kStreamLatencyFrames>(kAudioStreamPropertyLatency),
+        Row::Of<AudioStreamBasicDescription>(kAudioStreamPropertyVirtualFormat, &GetStreamFormat, &SetStreamFormat),
+        Row::Of<AudioStreamBasicDescription>(kAudioStreamPropertyPhysicalFormat, &GetStreamFormat, &SetStreamFormat),
+        Row::Variable(kAudioStreamPropertyAvailableVirtualFormats, &SizeOfAvailableFormats, &GetAvailableFormats),
+        Row::Variable(kAudioStreamPropertyAvailablePhysicalFormats, &SizeOfAvailableFormats, &GetAvailableFormats),
+        Row::Variable(kAudioObjectPropertyCustomPropertyInfoList,
+            [](const PulseDevice&, const PropertyQuery&) -> UInt32 {
+                return kNumCustomInputStreamProperties * sizeof(AudioServerPlugInCustomPropertyInfo);
+            },
+            [](PulseDevice&, const PropertyQuery& query, UInt32* ioDataSize, void* outData) {
+                return CopyPropertyArray(query, kCustomInputStreamProperties, kNumCustomInputStreamProperties,
+                                         ioDataSize, outData);
+            }).When(&IsInputStream),
+        Row::Of<CFPropertyListRef>(kPulseStreamPropertyActive,
+            [](PulseDevice& device, const PropertyQuery&, UInt32*, void* outData) {
+                return WriteProperty(outData, CFRetain(device.mEngine.IsInputActive() ? kCFBooleanTrue
+                                                                                      : kCFBooleanFalse));
+            }).When(&IsInputStream),
+    });
+
+    static constexpr auto kVolume = MakePropertyRows<PulseDevice>({
+        Row::Constant<AudioClassID, kAudioObjectClassID>(kAudioObjectPropertyBaseClass),
+        Row::Constant<AudioClassID, kAudioVolumeControlClassID>(kAudioObjectPropertyClass),
+        Row::Of<AudioObjectID>(kAudioObjectPropertyOwner,
+            [](PulseDevice& device, const PropertyQuery&, UInt32*, void* outData) {
+                return WriteProperty(outData, device.mDeviceID);
+            }),
+        Row::Of<CFStringRef>(kAudioObjectPropertyElementName,
+            [](PulseDevice&, const PropertyQuery&, UInt32*, void* outData) {
+                return WriteProperty(outData, (CFStringRef)CFRetain(PluginStrings().volumeName));
+            }),
+        Row::Constant<UInt32, kAudioObjectPropertyScopeOutput>(kAudioControlPropertyScope),
+        Row::Constant<UInt32, kAudioObjectPropertyElementMain>(kAudioControlPropertyElement),
+        Row::Of<Float32>(kAudioLevelControlPropertyScalarValue,
+            [](PulseDevice& device, const PropertyQuery&, UInt32*, void* outData) {
+                return WriteProperty(outData, device.mEngine.GetVolume());
+            },
+            &SetScalarVolume),
+        Row::Of<Float32>(kAudioLevelControlPropertyDecibelValue, &GetDecibelVolume, &SetDecibelVolume),
+        Row::Of<AudioValueRange>(kAudioLevelControlPropertyDecibelRange,
+            [](PulseDevice&, const PropertyQuery&, UInt32*, void* outData) {
+                AudioValueRange range = { -96.0, 0.0 };
+                return WriteProperty(outData, range);
+            }),
+        Row::Of<UInt32>(kAudioBooleanControlPropertyValue,
+            [](PulseDevice& device, const PropertyQuery&, UInt32*, void* outData) {
+                return WriteProperty<UInt32>(outData, device.mEngine.IsMuted() ? 1 : 0);
+            },
+            [](PulseDevice& device, const PropertyQuery&, const void* inData) -> OSStatus {
+                device.mEngine.SetMuted((*(const UInt32*)inData) != 0);
+                return kAudioHardwareNoError;
+            }),
+    });
+
+    static_assert(kDevice.IsValid(), "device property rows: duplicate selector or bad row");
+    static_assert(kStream.IsValid(), "stream property rows: duplicate selector or bad row");
+    static_assert(kVolume.IsValid(), "volume property rows: duplicate selector or bad row");
+};
+
+PropertyTable<PulseDevice> PulseDeviceProperties::For(AudioObjectID objectID)
+{
+    switch (DeviceObjectOffsetOf(objectID)) {
+        case kObjectOffset_Device:
+            return kDevice.Table();
+        case kObjectOffset_Stream_Output:
+        case kObjectOffset_Stream_Input:
+            return kStream.Table();
+        case kObjectOffset_Volume:
+            return kVolume.Table();
+        default:
+            return PropertyTable<PulseDevice>();
+    }
 }
 
 // ============================================================================
@@ -45,91 +399,49 @@ PulseDevice::~PulseDevice()
 Boolean PulseDevice::HasProperty(AudioObjectID objectID,
                                  const AudioObjectPropertyAddress* address)
 {
-    switch (objectID) {
-        case kObjectID_Device:
-            return HasDeviceProperty(address);
-        case kObjectID_Stream_Output:
-        case kObjectID_Stream_Input:
-            return HasStreamProperty(objectID, address);
-        case kObjectID_Volume:
-            return HasVolumeProperty(address);
-        default:
-            return false;
-    }
+    PropertyQuery query = { objectID, address, 0, nullptr, 0 };
+    return PulseDeviceProperties::For(objectID).Has(*this, query);
 }
 
 OSStatus PulseDevice::IsPropertySettable(AudioObjectID objectID,
                                          const AudioObjectPropertyAddress* address,
                                          Boolean* outIsSettable)
 {
-    switch (objectID) {
-        case kObjectID_Device:
-            return IsDevicePropertySettable(address, outIsSettable);
-        case kObjectID_Stream_Output:
-        case kObjectID_Stream_Input:
-            return IsStreamPropertySettable(address, outIsSettable);
-        case kObjectID_Volume:
-            return IsVolumePropertySettable(address, outIsSettable);
-        default:
-            return kAudioHardwareUnknownPropertyError;
-    }
+    PropertyQuery query = { objectID, address, 0, nullptr, 0 };
+    return PulseDeviceProperties::For(objectID).IsSettable(*this, query, outIsSettable);
 }
 
 OSStatus PulseDevice::GetPropertyDataSize(AudioObjectID objectID,
                                            const AudioObjectPropertyAddress* address,
-                                           UInt32 /*qualifierDataSize*/,
-                                           const void* /*qualifierData*/,
+                                           UInt32 qualifierDataSize,
+                                           const void* qualifierData,
                                            UInt32* outDataSize)
 {
-    switch (objectID) {
-        case kObjectID_Device:
-            return GetDevicePropertyDataSize(address, outDataSize);
-        case kObjectID_Stream_Output:
-        case kObjectID_Stream_Input:
-            return GetStreamPropertyDataSize(objectID, address, outDataSize);
-        case kObjectID_Volume:
-            return GetVolumePropertyDataSize(address, outDataSize);
-        default:
-            return kAudioHardwareUnknownPropertyError;
-    }
+    PropertyQuery query = { objectID, address, qualifierDataSize, qualifierData, 0 };
+    return PulseDeviceProperties::For(objectID).GetSize(*this, query, outDataSize);
 }
 
 OSStatus PulseDevice::GetPropertyData(AudioObjectID objectID,
                                        const AudioObjectPropertyAddress* address,
-                                       UInt32 /*qualifierDataSize*/,
-                                       const void* /*qualifierData*/,
+                                       UInt32 qualifierDataSize,
+                                       const void* qualifierData,
                                        UInt32 inDataSize,
                                        UInt32* outDataSize,
                                        void* outData)
 {
-    switch (objectID) {
-        case kObjectID_Device:
-            return GetDevicePropertyData(address, inDataSize, outDataSize, outData);
-        case kObjectID_Stream_Output:
-        case kObjectID_Stream_Input:
-            return GetStreamPropertyData(objectID, address, inDataSize, outDataSize, outData);
-        case kObjectID_Volume:
-            return GetVolumePropertyData(address, inDataSize, outDataSize, outData);
-        default:
-            return kAudioHardwareUnknownPropertyError;
-    }
+    PropertyQuery query = { objectID, address, qualifierDataSize, qualifierData, inDataSize };
+    return PulseDeviceProperties::For(objectID).Get(*this, query, outDataSize, outData);
 }
 
 OSStatus PulseDevice::SetPropertyData(AudioObjectID objectID,
                                        const AudioObjectPropertyAddress* address,
-                                       UInt32 /*qualifierDataSize*/,
-                                       const void* /*qualifierData*/,
+                                       UInt32 qualifierDataSize,
+                                       const void* qualifierData,
                                        UInt32 inDataSize,
                                        const void* inData)
 {
-    switch (objectID) {
-        case kObjectID_Device:
-            return SetDevicePropertyData(address, inDataSize, inData);
-        case kObjectID_Volume:
-            return SetVolumePropertyData(address, inDataSize, inData);
-        default:
-            return kAudioHardwareUnknownPropertyError;
-    }
+    PropertyQuery query = { objectID, address, qualifierDataSize, qualifierData, inDataSize };
+    return PulseDeviceProperties::For(objectID).Set(*this, query, inData);
 }
 
 // ============================================================================
@@ -138,756 +450,426 @@ OSStatus PulseDevice::SetPropertyData(AudioObjectID objectID,
 
 OSStatus PulseDevice::StartIO()
 {
-    std::lock_guard<std::mutex> lock(mIOMutex);
-
-    if (mIOStartCount == 0) {
-        mRingBuffer.Reset();
-        mIOAnchorHostTime   = mach_absolute_time();
-        mIOAnchorSampleTime = 0;
-        mTimestampSeed++;
-        mIORunning = true;
-    }
-
-    mIOStartCount++;
-    return kAudioHardwareNoError;
+    return mEngine.StartIO();
 }
 
 OSStatus PulseDevice::StopIO()
 {
-    std::lock_guard<std::mutex> lock(mIOMutex);
-
-    if (mIOStartCount == 0) {
-        return kAudioHardwareNotRunningError;
-    }
-
-    mIOStartCount--;
-    if (mIOStartCount == 0) {
-        mIORunning = false;
-    }
-
-    return kAudioHardwareNoError;
+    return mEngine.StopIO();
 }
 
 void PulseDevice::GetZeroTimeStamp(Float64* outSampleTime,
                                    UInt64* outHostTime,
                                    UInt64* outSeed)
 {
-    // Calculate the current zero timestamp based on the IO anchor
-    UInt64 currentHostTime = mach_absolute_time();
-    UInt64 elapsedNanos    = HostTimeToNanos(currentHostTime - mIOAnchorHostTime);
-    Float64 elapsedSeconds = (Float64)elapsedNanos / 1000000000.0;
-    Float64 elapsedSamples = elapsedSeconds * mSampleRate;
-
-    // Align to period boundaries
-    UInt64 periodsElapsed  = (UInt64)(elapsedSamples / kFramesPerPeriod);
-    Float64 sampleTime     = (Float64)(periodsElapsed * kFramesPerPeriod);
-    Float64 periodSeconds  = (Float64)(periodsElapsed * kFramesPerPeriod) / mSampleRate;
-    UInt64  periodNanos    = (UInt64)(periodSeconds * 1000000000.0);
-
-    *outSampleTime = sampleTime;
-    *outHostTime   = mIOAnchorHostTime + NanosToHostTime(periodNanos);
-    *outSeed       = mTimestampSeed;
+    mEngine.GetZeroTimeStamp(outSampleTime, outHostTime, outSeed);
 }
 
 OSStatus PulseDevice::DoIOOperation(AudioObjectID streamID,
+                                     UInt32 clientID,
                                      UInt32 operationID,
                                      UInt32 ioBufferFrameSize,
                                      AudioBufferList* ioMainBuffer,
                                      AudioBufferList* /*ioSecondaryBuffer*/)
 {
-    if (!ioMainBuffer || ioMainBuffer->mNumberBuffers == 0) {
-        return kAudioHardwareNoError;
-    }
-
-    float* buffer = (float*)ioMainBuffer->mBuffers[0].mData;
-    if (!buffer) return kAudioHardwareNoError;
-
     switch (operationID) {
         case kAudioServerPlugInIOOperationWriteMix:
-            // Output stream: apps writing audio → store in ring buffer
-            if (streamID == kObjectID_Stream_Output) {
-                // Apply volume
-                if (mMuted || mVolume <= 0.0f) {
-                    // Don't store silence, just skip
-                } else if (mVolume < 1.0f) {
-                    // Scale in-place then store
-                    UInt32 totalSamples = ioBufferFrameSize * kNumChannels;
-                    for (UInt32 i = 0; i < totalSamples; i++) {
-                        buffer[i] *= mVolume;
-                    }
-                    mRingBuffer.Store(buffer, ioBufferFrameSize);
-                } else {
-                    mRingBuffer.Store(buffer, ioBufferFrameSize);
-                }
-            }
+            // Output stream: apps writing audio
+            if (streamID != mOutputStreamID) return kAudioHardwareNoError;
             break;
 
         case kAudioServerPlugInIOOperationReadInput:
-            // Input stream: Electron reading audio → fetch from ring buffer
-            if (streamID == kObjectID_Stream_Input) {
-                mRingBuffer.Fetch(buffer, ioBufferFrameSize);
-            }
+            // Input stream: Electron reading audio
+            if (streamID != mInputStreamID) return kAudioHardwareNoError;
             break;
 
         default:
-            break;
+            return kAudioHardwareNoError;
     }
 
-    return kAudioHardwareNoError;
-}
-
-// ============================================================================
-// Device Properties
-// ============================================================================
+    OSStatus status = mEngine.DoIOOperation(operationID, clientID, ioBufferFrameSize, ioMainBuffer);
 
-Boolean PulseDevice::HasDeviceProperty(const AudioObjectPropertyAddress* address)
-{
-    switch (address->mSelector) {
-        case kAudioObjectPropertyBaseClass:
-        case kAudioObjectPropertyClass:
-        case kAudioObjectPropertyOwner:
-        case kAudioObjectPropertyName:
-        case kAudioObjectPropertyManufacturer:
-        case kAudioObjectPropertyOwnedObjects:
-        case kAudioDevicePropertyDeviceUID:
-        case kAudioDevicePropertyModelUID:
-        case kAudioDevicePropertyTransportType:
-        case kAudioDevicePropertyRelatedDevices:
-        case kAudioDevicePropertyClockDomain:
-        case kAudioDevicePropertyDeviceIsAlive:
-        case kAudioDevicePropertyDeviceIsRunning:
-        case kAudioDevicePropertyDeviceCanBeDefaultDevice:
-        case kAudioDevicePropertyDeviceCanBeDefaultSystemDevice:
-        case kAudioDevicePropertyLatency:
-        case kAudioDevicePropertyStreams:
-        case kAudioObjectPropertyControlList:
-        case kAudioDevicePropertyNominalSampleRate:
-        case kAudioDevicePropertyAvailableNominalSampleRates:
-        case kAudioDevicePropertyZeroTimeStampPeriod:
-        case kAudioDevicePropertyIcon:
-        case kAudioDevicePropertyIsHidden:
-        case kAudioDevicePropertySafetyOffset:
-            return true;
-        default:
-            return false;
+    // WriteMix decides activity; only report transitions
+    if (operationID == kAudioServerPlugInIOOperationWriteMix &&
+        mEngine.IsInputActive() != mReportedInputActive) {
+        mReportedInputActive = !mReportedInputActive;
+        NotifyInputActivity();
     }
+    return status;
 }
 
-OSStatus PulseDevice::IsDevicePropertySettable(const AudioObjectPropertyAddress* address,
-                                               Boolean* outIsSettable)
+void PulseDevice::NotifyInputActivity()
 {
-    switch (address->mSelector) {
-        case kAudioDevicePropertyNominalSampleRate:
-            *outIsSettable = true;
-            return kAudioHardwareNoError;
-        default:
-            *outIsSettable = false;
-            return kAudioHardwareNoError;
-    }
+    // Only an atomic OR and a queue wakeup; transitions that pile up before
+    // the handler runs coalesce into one
+    dispatch_source_merge_data(mActivitySource, 1);
 }
 
-OSStatus PulseDevice::GetDevicePropertyDataSize(const AudioObjectPropertyAddress* address,
-                                                UInt32* outDataSize)
+void PulseDevice::ReportInputActivity()
 {
-    switch (address->mSelector) {
-        case kAudioObjectPropertyBaseClass:
-        case kAudioObjectPropertyClass:
-            *outDataSize = sizeof(AudioClassID);
-            return kAudioHardwareNoError;
-
-        case kAudioObjectPropertyOwner:
-            *outDataSize = sizeof(AudioObjectID);
-            return kAudioHardwareNoError;
-
-        case kAudioObjectPropertyName:
-        case kAudioObjectPropertyManufacturer:
-        case kAudioDevicePropertyDeviceUID:
-        case kAudioDevicePropertyModelUID:
-            *outDataSize = sizeof(CFStringRef);
-            return kAudioHardwareNoError;
-
-        case kAudioDevicePropertyTransportType:
-        case kAudioDevicePropertyClockDomain:
-            *outDataSize = sizeof(UInt32);
-            return kAudioHardwareNoError;
-
-        case kAudioDevicePropertyRelatedDevices:
-            *outDataSize = sizeof(AudioObjectID);
-            return kAudioHardwareNoError;
-
-        case kAudioDevicePropertyDeviceIsAlive:
-        case kAudioDevicePropertyDeviceIsRunning:
-        case kAudioDevicePropertyDeviceCanBeDefaultDevice:
-        case kAudioDevicePropertyDeviceCanBeDefaultSystemDevice:
-        case kAudioDevicePropertyIsHidden:
-            *outDataSize = sizeof(UInt32);
-            return kAudioHardwareNoError;
-
-        case kAudioDevicePropertyLatency:
-        case kAudioDevicePropertySafetyOffset:
-        case kAudioDevicePropertyZeroTimeStampPeriod:
-            *outDataSize = sizeof(UInt32);
-            return kAudioHardwareNoError;
-
-        case kAudioDevicePropertyStreams: {
-            // One stream per direction
-            UInt32 count = 0;
-            if (address->mScope == kAudioObjectPropertyScopeGlobal ||
-                address->mScope == kAudioObjectPropertyScopeOutput) {
-                count++;
-            }
-            if (address->mScope == kAudioObjectPropertyScopeGlobal ||
-                address->mScope == kAudioObjectPropertyScopeInput) {
-                count++;
-            }
-            *outDataSize = count * sizeof(AudioObjectID);
-            return kAudioHardwareNoError;
-        }
+    // PropertiesChanged may block. Listeners re-read 'pact', so a change
+    // that flipped back before this ran needs no notification.
+    bool active = mEngine.IsInputActive();
+    if (!mHost || active == mNotifiedInputActive) return;
+    mNotifiedInputActive = active;
+
+    const AudioObjectPropertyAddress address = {
+        kPulseStreamPropertyActive, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain
+    };
+    mHost->PropertiesChanged(mHost, mInputStreamID, 1, &address);
+}
 
-        case kAudioObjectPropertyOwnedObjects: {
-            // Output stream + Input stream + Volume control
-            *outDataSize = 3 * sizeof(AudioObjectID);
-            return kAudioHardwareNoError;
-        }
+OSStatus PulseDevice::AddClient(const AudioServerPlugInClientInfo* clientInfo)
+{
+    if (!clientInfo) return kAudioHardwareIllegalOperationError;
 
-        case kAudioObjectPropertyControlList:
-            *outDataSize = sizeof(AudioObjectID);
-            return kAudioHardwareNoError;
+    // Past the reader limit a client still works, on the shared reader
+    mEngine.AddClient(clientInfo->mClientID);
+    return kAudioHardwareNoError;
+}
 
-        case kAudioDevicePropertyNominalSampleRate:
-            *outDataSize = sizeof(Float64);
-            return kAudioHardwareNoError;
+OSStatus PulseDevice::RemoveClient(const AudioServerPlugInClientInfo* clientInfo)
+{
+    if (!clientInfo) return kAudioHardwareIllegalOperationError;
 
-        case kAudioDevicePropertyAvailableNominalSampleRates:
-            *outDataSize = kNumSupportedSampleRates * sizeof(AudioValueRange);
-            return kAudioHardwareNoError;
+    mEngine.RemoveClient(clientInfo->mClientID);
+    return kAudioHardwareNoError;
+}
 
-        case kAudioDevicePropertyIcon:
-            *outDataSize = sizeof(CFURLRef);
-            return kAudioHardwareNoError;
+// ============================================================================
+// Device Properties
+// ============================================================================
 
-        default:
-            return kAudioHardwareUnknownPropertyError;
+// IDs of the streams in the address's scope: one stream per direction
+UInt32 PulseDeviceProperties::StreamsInScope(const PulseDevice& device, const PropertyQuery& query,
+                                             AudioObjectID* outIDs)
+{
+    AudioObjectPropertyScope scope = query.address->mScope;
+    UInt32 count = 0;
+    if (scope == kAudioObjectPropertyScopeGlobal || scope == kAudioObjectPropertyScopeOutput) {
+        outIDs[count++] = device.mOutputStreamID;
+    }
+    if (scope == kAudioObjectPropertyScopeGlobal || scope == kAudioObjectPropertyScopeInput) {
+        outIDs[count++] = device.mInputStreamID;
     }
+    return count;
 }
 
-OSStatus PulseDevice::GetDevicePropertyData(const AudioObjectPropertyAddress* address,
-                                            UInt32 /*inDataSize*/,
-                                            UInt32* outDataSize,
-                                            void* outData)
+OSStatus PulseDeviceProperties::GetBufferConfig(PulseDevice& device, const PropertyQuery& /*query*/,
+                                                UInt32* /*ioDataSize*/, void* outData)
 {
-    switch (address->mSelector) {
-        case kAudioObjectPropertyBaseClass:
-            *outDataSize = sizeof(AudioClassID);
-            *(AudioClassID*)outData = kAudioObjectClassID;
-            return kAudioHardwareNoError;
-
-        case kAudioObjectPropertyClass:
-            *outDataSize = sizeof(AudioClassID);
-            *(AudioClassID*)outData = kAudioDeviceClassID;
-            return kAudioHardwareNoError;
-
-        case kAudioObjectPropertyOwner:
-            *outDataSize = sizeof(AudioObjectID);
-            *(AudioObjectID*)outData = kObjectID_Plugin;
-            return kAudioHardwareNoError;
-
-        case kAudioObjectPropertyName:
-            *outDataSize = sizeof(CFStringRef);
-            *(CFStringRef*)outData = CFStringCreateWithCString(kCFAllocatorDefault,
-                kDeviceName, kCFStringEncodingUTF8);
-            return kAudioHardwareNoError;
-
-        case kAudioObjectPropertyManufacturer:
-            *outDataSize = sizeof(CFStringRef);
-            *(CFStringRef*)outData = CFStringCreateWithCString(kCFAllocatorDefault,
-                kDeviceManufacturer, kCFStringEncodingUTF8);
-            return kAudioHardwareNoError;
-
-        case kAudioDevicePropertyDeviceUID:
-            *outDataSize = sizeof(CFStringRef);
-            *(CFStringRef*)outData = CFStringCreateCopy(kCFAllocatorDefault, kDeviceUID);
-            return kAudioHardwareNoError;
-
-        case kAudioDevicePropertyModelUID:
-            *outDataSize = sizeof(CFStringRef);
-            *(CFStringRef*)outData = CFStringCreateCopy(kCFAllocatorDefault, kDeviceModelUID);
-            return kAudioHardwareNoError;
-
-        case kAudioDevicePropertyTransportType:
-            *outDataSize = sizeof(UInt32);
-            *(UInt32*)outData = kAudioDeviceTransportTypeVirtual;
-            return kAudioHardwareNoError;
-
-        case kAudioDevicePropertyRelatedDevices:
-            *outDataSize = sizeof(AudioObjectID);
-            *(AudioObjectID*)outData = kObjectID_Device;
-            return kAudioHardwareNoError;
-
-        case kAudioDevicePropertyClockDomain:
-            *outDataSize = sizeof(UInt32);
-            *(UInt32*)outData = 0;
-            return kAudioHardwareNoError;
-
-        case kAudioDevicePropertyDeviceIsAlive:
-            *outDataSize = sizeof(UInt32);
-            *(UInt32*)outData = 1;
-            return kAudioHardwareNoError;
-
-        case kAudioDevicePropertyDeviceIsRunning:
-            *outDataSize = sizeof(UInt32);
-            *(UInt32*)outData = mIORunning ? 1 : 0;
-            return kAudioHardwareNoError;
-
-        case kAudioDevicePropertyDeviceCanBeDefaultDevice:
-            *outDataSize = sizeof(UInt32);
-            *(UInt32*)outData = 1;
-            return kAudioHardwareNoError;
-
-        case kAudioDevicePropertyDeviceCanBeDefaultSystemDevice:
-            *outDataSize = sizeof(UInt32);
-            *(UInt32*)outData = 0; // Don't hijack system sounds
-            return kAudioHardwareNoError;
-
-        case kAudioDevicePropertyIsHidden:
-            *outDataSize = sizeof(UInt32);
-            *(UInt32*)outData = 0; // Not hidden — visible in Audio MIDI Setup
-            return kAudioHardwareNoError;
-
-        case kAudioDevicePropertyLatency:
-            *outDataSize = sizeof(UInt32);
-            *(UInt32*)outData = kDeviceLatencyFrames;
-            return kAudioHardwareNoError;
+    CFMutableDictionaryRef dict = CFDictionaryCreateMutable(kCFAllocatorDefault, 0,
+        &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+    SetDictionaryUInt32(dict, kBufferConfigCapacityKey, device.mEngine.GetCapacityFrames());
+    SetDictionaryUInt32(dict, kBufferConfigTargetFillKey, device.mEngine.GetTargetFillFrames());
+    *(CFPropertyListRef*)outData = dict;
+    return kAudioHardwareNoError;
+}
 
-        case kAudioDevicePropertySafetyOffset:
-            *outDataSize = sizeof(UInt32);
-            *(UInt32*)outData = kSafetyOffsetFrames;
-            return kAudioHardwareNoError;
+OSStatus PulseDeviceProperties::SetBufferConfig(PulseDevice& device, const PropertyQuery& /*query*/,
+                                                const void* inData)
+{
+    CFPropertyListRef plist = *(const CFPropertyListRef*)inData;
+    if (!plist || CFGetTypeID(plist) != CFDictionaryGetTypeID()) {
+        return kAudioHardwareIllegalOperationError;
+    }
 
-        case kAudioDevicePropertyZeroTimeStampPeriod:
-            *outDataSize = sizeof(UInt32);
-            *(UInt32*)outData = kFramesPerPeriod;
-            return kAudioHardwareNoError;
+    // Missing keys keep their current value
+    CFDictionaryRef dict = (CFDictionaryRef)plist;
+    UInt32 capacityFrames   = device.mEngine.GetCapacityFrames();
+    UInt32 targetFillFrames = device.mEngine.GetTargetFillFrames();
+    GetDictionaryUInt32(dict, kBufferConfigCapacityKey, &capacityFrames);
+    GetDictionaryUInt32(dict, kBufferConfigTargetFillKey, &targetFillFrames);
+    return device.mEngine.SetBufferConfig(capacityFrames, targetFillFrames);
+}
 
-        case kAudioDevicePropertyStreams: {
-            AudioObjectID* ids = (AudioObjectID*)outData;
-            UInt32 count = 0;
-            if (address->mScope == kAudioObjectPropertyScopeGlobal ||
-                address->mScope == kAudioObjectPropertyScopeOutput) {
-                ids[count++] = kObjectID_Stream_Output;
-            }
-            if (address->mScope == kAudioObjectPropertyScopeGlobal ||
-                address->mScope == kAudioObjectPropertyScopeInput) {
-                ids[count++] = kObjectID_Stream_Input;
-            }
-            *outDataSize = count * sizeof(AudioObjectID);
-            return kAudioHardwareNoError;
-        }
+OSStatus PulseDeviceProperties::GetStats(PulseDevice& device, const PropertyQuery& /*query*/,
+                                         UInt32* /*ioDataSize*/, void* outData)
+{
+    const IOEngine& engine = device.mEngine;
+    IOStats stats = engine.GetStats();
+    CFMutableDictionaryRef dict = CFDictionaryCreateMutable(kCFAllocatorDefault, 0,
+        &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+    SetDictionaryUInt64(dict, CFSTR("writeMixCycles"),    stats.writeMixCycles);
+    SetDictionaryUInt64(dict, CFSTR("readInputCycles"),   stats.readInputCycles);
+    SetDictionaryUInt64(dict, CFSTR("overrunFrames"),     stats.overrunFrames);
+    SetDictionaryUInt64(dict, CFSTR("underrunFrames"),    stats.underrunFrames);
+    SetDictionaryUInt64(dict, CFSTR("fillDroppedFrames"), stats.fillDroppedFrames);
+    SetDictionaryUInt64(dict, CFSTR("silentFrames"),      stats.silentFrames);
+    SetDictionaryFloat64(dict, CFSTR("resampleRatio"),    stats.resampleRatio);
+    SetDictionaryUInt32(dict, CFSTR("fillFrames"),        stats.fillFrames);
+    SetDictionaryUInt32(dict, CFSTR("highWaterFrames"),   stats.highWaterFrames);
+    SetDictionaryUInt32(dict, CFSTR("capacityFrames"),    stats.capacityFrames);
+    SetDictionaryUInt32(dict, CFSTR("allocatedFrames"),   stats.allocatedFrames);
+    SetDictionaryUInt32(dict, CFSTR("readers"),           stats.readers);
+#if PULSE_AUDIO_IO_HISTOGRAMS
+    SetDictionaryHistogram(dict, CFSTR("writeMixDurationNs"),  engine.GetWriteMixTiming().duration);
+    SetDictionaryHistogram(dict, CFSTR("writeMixIntervalNs"),  engine.GetWriteMixTiming().interval);
+    SetDictionaryHistogram(dict, CFSTR("readInputDurationNs"), engine.GetReadInputTiming().duration);
+    SetDictionaryHistogram(dict, CFSTR("readInputIntervalNs"), engine.GetReadInputTiming().interval);
+#endif
+    *(CFPropertyListRef*)outData = dict;
+    return kAudioHardwareNoError;
+}
 
-        case kAudioObjectPropertyOwnedObjects: {
-            AudioObjectID* ids = (AudioObjectID*)outData;
-            ids[0] = kObjectID_Stream_Output;
-            ids[1] = kObjectID_Stream_Input;
-            ids[2] = kObjectID_Volume;
-            *outDataSize = 3 * sizeof(AudioObjectID);
-            return kAudioHardwareNoError;
-        }
+OSStatus PulseDeviceProperties::SetInt16Dither(PulseDevice& device, const PropertyQuery& /*query*/,
+                                               const void* inData)
+{
+    CFPropertyListRef plist = *(const CFPropertyListRef*)inData;
+    if (!plist || CFGetTypeID(plist) != CFBooleanGetTypeID()) {
+        return kAudioHardwareIllegalOperationError;
+    }
+    // Takes effect on the next ReadInput; no configuration change needed
+    device.mEngine.SetInputDitherEnabled(CFBooleanGetValue((CFBooleanRef)plist));
+    return kAudioHardwareNoError;
+}
 
-        case kAudioObjectPropertyControlList: {
-            *outDataSize = sizeof(AudioObjectID);
-            *(AudioObjectID*)outData = kObjectID_Volume;
-            return kAudioHardwareNoError;
-        }
+OSStatus PulseDeviceProperties::GetVoiceCapture(PulseDevice& device, const PropertyQuery& /*query*/,
+                                                UInt32* /*ioDataSize*/, void* outData)
+{
+    SInt64 rate = (device.mEngine.GetInputChannelMode() == kInputChannelMode_Mono)
+        ? (SInt64)lround(device.mEngine.GetSampleRate()) : 0;
+    *(CFPropertyListRef*)outData = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt64Type, &rate);
+    return kAudioHardwareNoError;
+}
 
-        case kAudioDevicePropertyNominalSampleRate:
-            *outDataSize = sizeof(Float64);
-            *(Float64*)outData = mSampleRate;
-            return kAudioHardwareNoError;
+OSStatus PulseDeviceProperties::SetVoiceCapture(PulseDevice& device, const PropertyQuery& /*query*/,
+                                                const void* inData)
+{
+    CFPropertyListRef plist = *(const CFPropertyListRef*)inData;
+    SInt64 rate = 0;
+    if (!plist || CFGetTypeID(plist) != CFNumberGetTypeID() ||
+        !CFNumberGetValue((CFNumberRef)plist, kCFNumberSInt64Type, &rate)) {
+        return kAudioHardwareIllegalOperationError;
+    }
 
-        case kAudioDevicePropertyAvailableNominalSampleRates: {
-            AudioValueRange* ranges = (AudioValueRange*)outData;
-            for (UInt32 i = 0; i < kNumSupportedSampleRates; i++) {
-                ranges[i].mMinimum = kSupportedSampleRates[i];
-                ranges[i].mMaximum = kSupportedSampleRates[i];
-            }
-            *outDataSize = kNumSupportedSampleRates * sizeof(AudioValueRange);
-            return kAudioHardwareNoError;
-        }
+    // Rate and layout change together, in one configuration change
+    if (rate == 0) {
+        return device.RequestFormat(0, 0, 0, kInputChannelMode_Mirror);
+    }
+    if (rate != 48000 && rate != 16000) return kAudioHardwareIllegalOperationError;
+    return device.RequestFormat((Float64)rate, 0, 0, kInputChannelMode_Mono);
+}
 
-        case kAudioDevicePropertyIcon:
-            *outDataSize = sizeof(CFURLRef);
-            *(CFURLRef*)outData = nullptr;
-            return kAudioHardwareNoError;
+OSStatus PulseDeviceProperties::GetMeter(PulseDevice& device, const PropertyQuery& /*query*/,
+                                         UInt32* /*ioDataSize*/, void* outData)
+{
+    MeterLevels levels = device.mEngine.ReadMeter();
+    CFMutableDictionaryRef dict = CFDictionaryCreateMutable(kCFAllocatorDefault, 0,
+        &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+    SetDictionaryUInt64(dict, kMeterPeriodsKey, levels.periods);
+    SetDictionaryUInt64(dict, kMeterFramesKey, levels.frames);
+    SetDictionaryFloat32Array(dict, kMeterPeakKey, levels.peak, levels.channels);
+    SetDictionaryFloat32Array(dict, kMeterRMSKey, levels.rms, levels.channels);
+    *(CFPropertyListRef*)outData = dict;
+    return kAudioHardwareNoError;
+}
 
-        default:
-            return kAudioHardwareUnknownPropertyError;
-    }
+OSStatus PulseDeviceProperties::GetSharedMemory(PulseDevice& device, const PropertyQuery& /*query*/,
+                                                UInt32* /*ioDataSize*/, void* outData)
+{
+    std::string name = device.mEngine.GetSharedMemoryName();
+    *(CFStringRef*)outData = CFStringCreateWithCString(kCFAllocatorDefault, name.c_str(),
+                                                       kCFStringEncodingUTF8);
+    return kAudioHardwareNoError;
 }
 
-OSStatus PulseDevice::SetDevicePropertyData(const AudioObjectPropertyAddress* address,
-                                            UInt32 /*inDataSize*/,
-                                            const void* inData)
+OSStatus PulseDeviceProperties::SetSharedMemory(PulseDevice& device, const PropertyQuery& /*query*/,
+                                                const void* inData)
 {
-    switch (address->mSelector) {
-        case kAudioDevicePropertyNominalSampleRate: {
-            Float64 newRate = *(const Float64*)inData;
-            bool valid = false;
-            for (UInt32 i = 0; i < kNumSupportedSampleRates; i++) {
-                if (fabs(newRate - kSupportedSampleRates[i]) < 0.1) {
-                    valid = true;
-                    break;
-                }
-            }
-            if (!valid) return kAudioHardwareIllegalOperationError;
-            mSampleRate = newRate;
-            mRingBuffer.Reset();
-            return kAudioHardwareNoError;
-        }
-        default:
-            return kAudioHardwareUnknownPropertyError;
+    CFStringRef string = *(const CFStringRef*)inData;
+    char name[kShmRingMaxNameLength + 1];
+    if (!string || CFGetTypeID(string) != CFStringGetTypeID() ||
+        !CFStringGetCString(string, name, sizeof(name), kCFStringEncodingUTF8)) {
+        return kAudioHardwareIllegalOperationError;
     }
+    // Not a format change: the writer is swapped outside IO, so no
+    // configuration change request is needed
+    return device.mEngine.SetSharedMemoryName(name);
 }
 
 // ============================================================================
 // Stream Properties
 // ============================================================================
 
-Boolean PulseDevice::HasStreamProperty(AudioObjectID /*streamID*/,
-                                       const AudioObjectPropertyAddress* address)
-{
-    switch (address->mSelector) {
-        case kAudioObjectPropertyBaseClass:
-        case kAudioObjectPropertyClass:
-        case kAudioObjectPropertyOwner:
-        case kAudioStreamPropertyIsActive:
-        case kAudioStreamPropertyDirection:
-        case kAudioStreamPropertyTerminalType:
-        case kAudioStreamPropertyStartingChannel:
-        case kAudioStreamPropertyLatency:
-        case kAudioStreamPropertyVirtualFormat:
-        case kAudioStreamPropertyPhysicalFormat:
-        case kAudioStreamPropertyAvailableVirtualFormats:
-        case kAudioStreamPropertyAvailablePhysicalFormats:
-            return true;
-        default:
-            return false;
-    }
+// The input stream carries the custom properties
+bool PulseDeviceProperties::IsInputStream(const PulseDevice& device, const PropertyQuery& query)
+{
+    return query.objectID == device.mInputStreamID;
 }
 
-OSStatus PulseDevice::IsStreamPropertySettable(const AudioObjectPropertyAddress* address,
-                                               Boolean* outIsSettable)
+OSStatus PulseDeviceProperties::GetStreamFormat(PulseDevice& device, const PropertyQuery& query,
+                                                UInt32* /*ioDataSize*/, void* outData)
 {
-    switch (address->mSelector) {
-        case kAudioStreamPropertyVirtualFormat:
-        case kAudioStreamPropertyPhysicalFormat:
-            *outIsSettable = true;
-            return kAudioHardwareNoError;
-        default:
-            *outIsSettable = false;
-            return kAudioHardwareNoError;
-    }
+    bool input = IsInputStream(device, query);
+    FillStreamFormat((AudioStreamBasicDescription*)outData, device.mEngine.GetSampleRate(),
+                     input ? device.mEngine.GetInputChannelCount() : device.mEngine.GetChannelCount(),
+                     input ? device.mEngine.GetInputSampleFormat() : kInputSampleFormat_Float32);
+    return kAudioHardwareNoError;
 }
 
-OSStatus PulseDevice::GetStreamPropertyDataSize(AudioObjectID /*streamID*/,
-                                                const AudioObjectPropertyAddress* address,
-                                                UInt32* outDataSize)
+OSStatus PulseDeviceProperties::SetStreamFormat(PulseDevice& device, const PropertyQuery& query,
+                                                const void* inData)
 {
-    switch (address->mSelector) {
-        case kAudioObjectPropertyBaseClass:
-        case kAudioObjectPropertyClass:
-            *outDataSize = sizeof(AudioClassID);
-            return kAudioHardwareNoError;
-
-        case kAudioObjectPropertyOwner:
-            *outDataSize = sizeof(AudioObjectID);
-            return kAudioHardwareNoError;
-
-        case kAudioStreamPropertyIsActive:
-        case kAudioStreamPropertyDirection:
-        case kAudioStreamPropertyTerminalType:
-        case kAudioStreamPropertyStartingChannel:
-        case kAudioStreamPropertyLatency:
-            *outDataSize = sizeof(UInt32);
-            return kAudioHardwareNoError;
-
-        case kAudioStreamPropertyVirtualFormat:
-        case kAudioStreamPropertyPhysicalFormat:
-            *outDataSize = sizeof(AudioStreamBasicDescription);
-            return kAudioHardwareNoError;
+    // Both streams share the rate. The output stream sets the ring's
+    // channel count, which the input mirrors unless it asks for mono
+    // (a downmix). The sample format is the input stream's own.
+    const AudioStreamBasicDescription* desc = (const AudioStreamBasicDescription*)inData;
+    if (desc->mFormatID != kAudioFormatLinearPCM ||
+        !IOEngine::IsSupportedChannelCount(desc->mChannelsPerFrame)) {
+        return kAudioDeviceUnsupportedFormatError;
+    }
 
-        case kAudioStreamPropertyAvailableVirtualFormats:
-        case kAudioStreamPropertyAvailablePhysicalFormats:
-            *outDataSize = kNumSupportedSampleRates * sizeof(AudioStreamRangedDescription);
-            return kAudioHardwareNoError;
+    bool input = IsInputStream(device, query);
+    UInt32 sampleFormat;
+    if ((desc->mFormatFlags & kAudioFormatFlagIsFloat) != 0 &&
+        desc->mBitsPerChannel == kBitsPerChannel) {
+        sampleFormat = kInputSampleFormat_Float32;
+    } else if ((desc->mFormatFlags & kAudioFormatFlagIsSignedInteger) != 0 &&
+               desc->mBitsPerChannel == kInt16BitsPerChannel && input) {
+        sampleFormat = kInputSampleFormat_Int16;
+    } else {
+        return kAudioDeviceUnsupportedFormatError;
+    }
 
-        default:
-            return kAudioHardwareUnknownPropertyError;
+    if (!input) {
+        return device.RequestFormat(desc->mSampleRate, desc->mChannelsPerFrame, 0, 0);
     }
+    if (desc->mChannelsPerFrame == 1 && device.mEngine.GetChannelCount() != 1) {
+        return device.RequestFormat(desc->mSampleRate, 0, sampleFormat, kInputChannelMode_Mono);
+    }
+    return device.RequestFormat(desc->mSampleRate, desc->mChannelsPerFrame, sampleFormat,
+                                kInputChannelMode_Mirror);
 }
 
-OSStatus PulseDevice::GetStreamPropertyData(AudioObjectID streamID,
-                                            const AudioObjectPropertyAddress* address,
-                                            UInt32 /*inDataSize*/,
-                                            UInt32* outDataSize,
-                                            void* outData)
+UInt32 PulseDeviceProperties::SizeOfAvailableFormats(const PulseDevice& device, const PropertyQuery& query)
 {
-    switch (address->mSelector) {
-        case kAudioObjectPropertyBaseClass:
-            *outDataSize = sizeof(AudioClassID);
-            *(AudioClassID*)outData = kAudioObjectClassID;
-            return kAudioHardwareNoError;
-
-        case kAudioObjectPropertyClass:
-            *outDataSize = sizeof(AudioClassID);
-            *(AudioClassID*)outData = kAudioStreamClassID;
-            return kAudioHardwareNoError;
-
-        case kAudioObjectPropertyOwner:
-            *outDataSize = sizeof(AudioObjectID);
-            *(AudioObjectID*)outData = kObjectID_Device;
-            return kAudioHardwareNoError;
-
-        case kAudioStreamPropertyIsActive:
-            *outDataSize = sizeof(UInt32);
-            *(UInt32*)outData = 1;
-            return kAudioHardwareNoError;
-
-        case kAudioStreamPropertyDirection:
-            *outDataSize = sizeof(UInt32);
-            // 0 = output (apps write to it), 1 = input (apps read from it)
-            *(UInt32*)outData = (streamID == kObjectID_Stream_Output) ? 0 : 1;
-            return kAudioHardwareNoError;
-
-        case kAudioStreamPropertyTerminalType:
-            *outDataSize = sizeof(UInt32);
-            *(UInt32*)outData = (streamID == kObjectID_Stream_Output)
-                ? kAudioStreamTerminalTypeLine
-                : kAudioStreamTerminalTypeMicrophone;
-            return kAudioHardwareNoError;
-
-        case kAudioStreamPropertyStartingChannel:
-            *outDataSize = sizeof(UInt32);
-            *(UInt32*)outData = 1;
-            return kAudioHardwareNoError;
-
-        case kAudioStreamPropertyLatency:
-            *outDataSize = sizeof(UInt32);
-            *(UInt32*)outData = kStreamLatencyFrames;
-            return kAudioHardwareNoError;
-
-        case kAudioStreamPropertyVirtualFormat:
-        case kAudioStreamPropertyPhysicalFormat: {
-            AudioStreamBasicDescription* desc = (AudioStreamBasicDescription*)outData;
-            desc->mSampleRate       = mSampleRate;
-            desc->mFormatID         = kAudioFormatLinearPCM;
-            desc->mFormatFlags      = kAudioFormatFlagIsFloat
-                                    | kAudioFormatFlagIsPacked;
-            desc->mFramesPerPacket  = 1;
-            desc->mChannelsPerFrame = kNumChannels;
-            desc->mBitsPerChannel   = kBitsPerChannel;
-            desc->mBytesPerFrame    = kBytesPerFrame;
-            desc->mBytesPerPacket   = kBytesPerFrame;
-            *outDataSize = sizeof(AudioStreamBasicDescription);
-            return kAudioHardwareNoError;
-        }
+    return device.NumAvailableStreamFormats(query.objectID) * sizeof(AudioStreamRangedDescription);
+}
 
-        case kAudioStreamPropertyAvailableVirtualFormats:
-        case kAudioStreamPropertyAvailablePhysicalFormats: {
-            AudioStreamRangedDescription* descs = (AudioStreamRangedDescription*)outData;
-            for (UInt32 i = 0; i < kNumSupportedSampleRates; i++) {
-                descs[i].mFormat.mSampleRate       = kSupportedSampleRates[i];
-                descs[i].mFormat.mFormatID         = kAudioFormatLinearPCM;
-                descs[i].mFormat.mFormatFlags      = kAudioFormatFlagIsFloat
-                                                   | kAudioFormatFlagIsPacked;
-                descs[i].mFormat.mFramesPerPacket  = 1;
-                descs[i].mFormat.mChannelsPerFrame = kNumChannels;
-                descs[i].mFormat.mBitsPerChannel   = kBitsPerChannel;
-                descs[i].mFormat.mBytesPerFrame    = kBytesPerFrame;
-                descs[i].mFormat.mBytesPerPacket   = kBytesPerFrame;
-                descs[i].mSampleRateRange.mMinimum = kSupportedSampleRates[i];
-                descs[i].mSampleRateRange.mMaximum = kSupportedSampleRates[i];
+OSStatus PulseDeviceProperties::GetAvailableFormats(PulseDevice& device, const PropertyQuery& query,
+                                                    UInt32* ioDataSize, void* outData)
+{
+    // Every supported channel count at every supported rate, in
+    // Float32 and, on the input stream only, Int16 as well
+    AudioStreamRangedDescription* descs = (AudioStreamRangedDescription*)outData;
+    UInt32 numSampleFormats = IsInputStream(device, query) ? 2 : 1;
+    UInt32 maxCount = query.inDataSize / sizeof(AudioStreamRangedDescription);
+    UInt32 count = 0;
+    for (UInt32 f = 0; f < numSampleFormats; f++) {
+        UInt32 sampleFormat = (f == 0) ? kInputSampleFormat_Float32 : kInputSampleFormat_Int16;
+        for (UInt32 c = 0; c < kNumSupportedChannelCounts; c++) {
+            for (UInt32 i = 0; i < kNumSupportedSampleRates && count < maxCount; i++, count++) {
+                FillStreamFormat(&descs[count].mFormat, kSupportedSampleRates[i],
+                                 kSupportedChannelCounts[c], sampleFormat);
+                descs[count].mSampleRateRange.mMinimum = kSupportedSampleRates[i];
+                descs[count].mSampleRateRange.mMaximum = kSupportedSampleRates[i];
             }
-            *outDataSize = kNumSupportedSampleRates * sizeof(AudioStreamRangedDescription);
-            return kAudioHardwareNoError;
         }
-
-        default:
-            return kAudioHardwareUnknownPropertyError;
     }
+    *ioDataSize = count * sizeof(AudioStreamRangedDescription);
+    return kAudioHardwareNoError;
 }
 
 // ============================================================================
-// Volume Control Properties
+// Configuration changes
 // ============================================================================
 
-Boolean PulseDevice::HasVolumeProperty(const AudioObjectPropertyAddress* address)
-{
-    switch (address->mSelector) {
-        case kAudioObjectPropertyBaseClass:
-        case kAudioObjectPropertyClass:
-        case kAudioObjectPropertyOwner:
-        case kAudioObjectPropertyElementName:
-        case kAudioControlPropertyScope:
-        case kAudioControlPropertyElement:
-        case kAudioLevelControlPropertyScalarValue:
-        case kAudioLevelControlPropertyDecibelValue:
-        case kAudioLevelControlPropertyDecibelRange:
-        case kAudioBooleanControlPropertyValue:
-            return true;
-        default:
-            return false;
-    }
-}
-
-OSStatus PulseDevice::IsVolumePropertySettable(const AudioObjectPropertyAddress* address,
-                                               Boolean* outIsSettable)
+// A change action carries the new nominal rate in its low 32 bits, the
+// channel count in the next 16, then the input sample format and the input
+// channel mode in 8 bits each. Zero means that part doesn't change, so
+// queued requests for different parts don't undo each other.
+static UInt64 MakeFormatChangeAction(UInt32 sampleRate, UInt32 channels, UInt32 inputFormat,
+                                     UInt32 inputChannelMode)
 {
-    switch (address->mSelector) {
-        case kAudioLevelControlPropertyScalarValue:
-        case kAudioLevelControlPropertyDecibelValue:
-        case kAudioBooleanControlPropertyValue:
-            *outIsSettable = true;
-            return kAudioHardwareNoError;
-        default:
-            *outIsSettable = false;
-            return kAudioHardwareNoError;
-    }
+    return (UInt64)sampleRate
+         | ((UInt64)(channels & 0xFFFFu) << 32)
+         | ((UInt64)(inputFormat & 0xFFu) << 48)
+         | ((UInt64)(inputChannelMode & 0xFFu) << 56);
 }
 
-OSStatus PulseDevice::GetVolumePropertyDataSize(const AudioObjectPropertyAddress* address,
-                                                UInt32* outDataSize)
+OSStatus PulseDevice::RequestFormat(Float64 sampleRate, UInt32 channels, UInt32 inputFormat,
+                                    UInt32 inputChannelMode)
 {
-    switch (address->mSelector) {
-        case kAudioObjectPropertyBaseClass:
-        case kAudioObjectPropertyClass:
-            *outDataSize = sizeof(AudioClassID);
-            return kAudioHardwareNoError;
-
-        case kAudioObjectPropertyOwner:
-            *outDataSize = sizeof(AudioObjectID);
-            return kAudioHardwareNoError;
-
-        case kAudioObjectPropertyElementName:
-            *outDataSize = sizeof(CFStringRef);
-            return kAudioHardwareNoError;
-
-        case kAudioControlPropertyScope:
-        case kAudioControlPropertyElement:
-            *outDataSize = sizeof(UInt32);
-            return kAudioHardwareNoError;
-
-        case kAudioLevelControlPropertyScalarValue:
-            *outDataSize = sizeof(Float32);
-            return kAudioHardwareNoError;
-
-        case kAudioLevelControlPropertyDecibelValue:
-            *outDataSize = sizeof(Float32);
-            return kAudioHardwareNoError;
+    if (sampleRate != 0.0 && !IOEngine::IsSupportedSampleRate(sampleRate)) {
+        return kAudioHardwareIllegalOperationError;
+    }
+    if (channels != 0 && !IOEngine::IsSupportedChannelCount(channels)) {
+        return kAudioHardwareIllegalOperationError;
+    }
 
-        case kAudioLevelControlPropertyDecibelRange:
-            *outDataSize = sizeof(AudioValueRange);
-            return kAudioHardwareNoError;
+    if (fabs(sampleRate - mEngine.GetSampleRate()) < 0.1) sampleRate = 0.0;
+    if (channels == mEngine.GetChannelCount()) channels = 0;
+    if (inputFormat == mEngine.GetInputSampleFormat()) inputFormat = 0;
+    if (inputChannelMode == mEngine.GetInputChannelMode()) inputChannelMode = 0;
+    if (sampleRate == 0.0 && channels == 0 && inputFormat == 0 && inputChannelMode == 0) {
+        return kAudioHardwareNoError;
+    }
+    if (!mHost) return kAudioHardwareUnspecifiedError;
 
-        case kAudioBooleanControlPropertyValue:
-            *outDataSize = sizeof(UInt32);
-            return kAudioHardwareNoError;
+    // The host stops IO and calls PerformConfigurationChange with this action
+    return mHost->RequestDeviceConfigurationChange(mHost, mDeviceID,
+        MakeFormatChangeAction((UInt32)lround(sampleRate), channels, inputFormat, inputChannelMode),
+        nullptr);
+}
 
-        default:
-            return kAudioHardwareUnknownPropertyError;
+OSStatus PulseDevice::PerformConfigurationChange(UInt64 changeAction, void* /*changeInfo*/)
+{
+    UInt32 sampleRate  = (UInt32)(changeAction & 0xFFFFFFFFu);
+    UInt32 channels    = (UInt32)((changeAction >> 32) & 0xFFFFu);
+    UInt32 inputFormat = (UInt32)((changeAction >> 48) & 0xFFu);
+    UInt32 inputMode   = (UInt32)((changeAction >> 56) & 0xFFu);
+
+    if (sampleRate != 0) {
+        OSStatus status = mEngine.SetSampleRate((Float64)sampleRate);
+        if (status != kAudioHardwareNoError) return status;
     }
+    if (channels != 0) {
+        OSStatus status = mEngine.SetChannelCount(channels);
+        if (status != kAudioHardwareNoError) return status;
+    }
+    if (inputFormat != 0) {
+        OSStatus status = mEngine.SetInputSampleFormat(inputFormat);
+        if (status != kAudioHardwareNoError) return status;
+    }
+    if (inputMode != 0) {
+        return mEngine.SetInputChannelMode(inputMode);
+    }
+    return kAudioHardwareNoError;
 }
 
-OSStatus PulseDevice::GetVolumePropertyData(const AudioObjectPropertyAddress* address,
-                                            UInt32 /*inDataSize*/,
-                                            UInt32* outDataSize,
-                                            void* outData)
+OSStatus PulseDevice::AbortConfigurationChange(UInt64 /*changeAction*/, void* /*changeInfo*/)
 {
-    switch (address->mSelector) {
-        case kAudioObjectPropertyBaseClass:
-            *outDataSize = sizeof(AudioClassID);
-            *(AudioClassID*)outData = kAudioObjectClassID;
-            return kAudioHardwareNoError;
-
-        case kAudioObjectPropertyClass:
-            *outDataSize = sizeof(AudioClassID);
-            *(AudioClassID*)outData = kAudioVolumeControlClassID;
-            return kAudioHardwareNoError;
-
-        case kAudioObjectPropertyOwner:
-            *outDataSize = sizeof(AudioObjectID);
-            *(AudioObjectID*)outData = kObjectID_Device;
-            return kAudioHardwareNoError;
-
-        case kAudioObjectPropertyElementName:
-            *outDataSize = sizeof(CFStringRef);
-            *(CFStringRef*)outData = CFStringCreateWithCString(kCFAllocatorDefault,
-                "Volume", kCFStringEncodingUTF8);
-            return kAudioHardwareNoError;
-
-        case kAudioControlPropertyScope:
-            *outDataSize = sizeof(UInt32);
-            *(UInt32*)outData = kAudioObjectPropertyScopeOutput;
-            return kAudioHardwareNoError;
-
-        case kAudioControlPropertyElement:
-            *outDataSize = sizeof(UInt32);
-            *(UInt32*)outData = kAudioObjectPropertyElementMain;
-            return kAudioHardwareNoError;
-
-        case kAudioLevelControlPropertyScalarValue:
-            *outDataSize = sizeof(Float32);
-            *(Float32*)outData = mVolume;
-            return kAudioHardwareNoError;
-
-        case kAudioLevelControlPropertyDecibelValue: {
-            // Convert scalar to dB: 0 = -96dB, 1 = 0dB
-            Float32 dB = (mVolume > 0.0f) ? (20.0f * log10f(mVolume)) : -96.0f;
-            *outDataSize = sizeof(Float32);
-            *(Float32*)outData = dB;
-            return kAudioHardwareNoError;
-        }
-
-        case kAudioLevelControlPropertyDecibelRange: {
-            AudioValueRange* range = (AudioValueRange*)outData;
-            range->mMinimum = -96.0;
-            range->mMaximum = 0.0;
-            *outDataSize = sizeof(AudioValueRange);
-            return kAudioHardwareNoError;
-        }
+    // Nothing was staged
+    return kAudioHardwareNoError;
+}
 
-        case kAudioBooleanControlPropertyValue:
-            *outDataSize = sizeof(UInt32);
-            *(UInt32*)outData = mMuted ? 1 : 0;
-            return kAudioHardwareNoError;
+// ============================================================================
+// Volume Control Properties
+// ============================================================================
 
-        default:
-            return kAudioHardwareUnknownPropertyError;
-    }
+OSStatus PulseDeviceProperties::SetScalarVolume(PulseDevice& device, const PropertyQuery& /*query*/,
+                                                const void* inData)
+{
+    Float32 newVolume = *(const Float32*)inData;
+    device.mEngine.SetVolume(fmaxf(kMinVolume, fminf(kMaxVolume, newVolume)));
+    return kAudioHardwareNoError;
 }
 
-OSStatus PulseDevice::SetVolumePropertyData(const AudioObjectPropertyAddress* address,
-                                            UInt32 /*inDataSize*/,
-                                            const void* inData)
+OSStatus PulseDeviceProperties::GetDecibelVolume(PulseDevice& device, const PropertyQuery& /*query*/,
+                                                 UInt32* /*ioDataSize*/, void* outData)
 {
-    switch (address->mSelector) {
-        case kAudioLevelControlPropertyScalarValue: {
-            Float32 newVolume = *(const Float32*)inData;
-            mVolume = fmaxf(kMinVolume, fminf(kMaxVolume, newVolume));
-            return kAudioHardwareNoError;
-        }
-
-        case kAudioLevelControlPropertyDecibelValue: {
-            Float32 dB = *(const Float32*)inData;
-            mVolume = (dB <= -96.0f) ? 0.0f : powf(10.0f, dB / 20.0f);
-            mVolume = fmaxf(kMinVolume, fminf(kMaxVolume, mVolume));
-            return kAudioHardwareNoError;
-        }
-
-        case kAudioBooleanControlPropertyValue:
-            mMuted = (*(const UInt32*)inData) != 0;
-            return kAudioHardwareNoError;
+    // Convert scalar to dB: 0 = -96dB, 1 = 0dB
+    Float32 volume = device.mEngine.GetVolume();
+    *(Float32*)outData = (volume > 0.0f) ? (20.0f * log10f(volume)) : -96.0f;
+    return kAudioHardwareNoError;
+}
 
-        default:
-            return kAudioHardwareUnknownPropertyError;
-    }
+OSStatus PulseDeviceProperties::SetDecibelVolume(PulseDevice& device, const PropertyQuery& /*query*/,
+                                                 const void* inData)
+{
+    Float32 dB = *(const Float32*)inData;
+    Float32 newVolume = (dB <= -96.0f) ? 0.0f : powf(10.0f, dB / 20.0f);
+    device.mEngine.SetVolume(fmaxf(kMinVolume, fminf(kMaxVolume, newVolume)));
+    return kAudioHardwareNoError;
 }
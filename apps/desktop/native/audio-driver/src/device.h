@@ -1,19 +1,26 @@
 #pragma once
 
 #include <CoreAudio/AudioServerPlugIn.h>
-#include <mutex>
-#include "ring-buffer.h"
+#include <dispatch/dispatch.h>
+#include "io-engine.h"
 #include "types.h"
 
 // Virtual audio device implementation.
 // Manages properties for the device, its streams, and volume control.
-// Routes IO operations through the shared ring buffer.
+// Routes IO operations through the portable IOEngine, one per device, so
+// every device has its own ring. The device at table slot N owns the object
+// IDs DeviceObjectID(N, ...).
 class PulseDevice {
 public:
-    PulseDevice();
+    // uid and name are retained
+    PulseDevice(AudioServerPlugInHostRef host, UInt32 slot, CFStringRef uid, CFStringRef name);
     ~PulseDevice();
 
-    // Property dispatch — routes to the correct handler based on object ID
+    AudioObjectID GetObjectID() const { return mDeviceID; }
+    CFStringRef   GetUID() const { return mUID; }
+
+    // Property dispatch — answered from the property table of the object's
+    // kind (device, stream or volume control), see PulseDeviceProperties
     Boolean HasProperty(AudioObjectID objectID,
                         const AudioObjectPropertyAddress* address);
 
@@ -49,52 +56,61 @@ public:
                               UInt64* outHostTime,
                               UInt64* outSeed);
     OSStatus DoIOOperation(AudioObjectID streamID,
+                           UInt32 clientID,
                            UInt32 operationID,
                            UInt32 ioBufferFrameSize,
                            AudioBufferList* ioMainBuffer,
                            AudioBufferList* ioSecondaryBuffer);
 
+    // Clients of the device; each capture client gets its own read cursor
+    OSStatus AddClient(const AudioServerPlugInClientInfo* clientInfo);
+    OSStatus RemoveClient(const AudioServerPlugInClientInfo* clientInfo);
+
+    // Configuration changes requested through the host. The action encodes
+    // the new rate, channel count and input stream format; the host has
+    // stopped IO when Perform is called.
+    OSStatus PerformConfigurationChange(UInt64 changeAction, void* changeInfo);
+    OSStatus AbortConfigurationChange(UInt64 changeAction, void* changeInfo);
+
     // Accessors
-    Float64  GetSampleRate() const { return mSampleRate; }
-    bool     IsIORunning() const { return mIORunning; }
+    Float64  GetSampleRate() const { return mEngine.GetSampleRate(); }
+    bool     IsIORunning() const { return mEngine.IsIORunning(); }
 
 private:
-    // Device properties
-    Boolean  HasDeviceProperty(const AudioObjectPropertyAddress* address);
-    OSStatus IsDevicePropertySettable(const AudioObjectPropertyAddress* address, Boolean* outIsSettable);
-    OSStatus GetDevicePropertyDataSize(const AudioObjectPropertyAddress* address, UInt32* outDataSize);
-    OSStatus GetDevicePropertyData(const AudioObjectPropertyAddress* address,
-                                   UInt32 inDataSize, UInt32* outDataSize, void* outData);
-    OSStatus SetDevicePropertyData(const AudioObjectPropertyAddress* address,
-                                   UInt32 inDataSize, const void* inData);
-
-    // Stream properties
-    Boolean  HasStreamProperty(AudioObjectID streamID, const AudioObjectPropertyAddress* address);
-    OSStatus IsStreamPropertySettable(const AudioObjectPropertyAddress* address, Boolean* outIsSettable);
-    OSStatus GetStreamPropertyDataSize(AudioObjectID streamID,
-                                       const AudioObjectPropertyAddress* address, UInt32* outDataSize);
-    OSStatus GetStreamPropertyData(AudioObjectID streamID,
-                                   const AudioObjectPropertyAddress* address,
-                                   UInt32 inDataSize, UInt32* outDataSize, void* outData);
-
-    // Volume control properties
-    Boolean  HasVolumeProperty(const AudioObjectPropertyAddress* address);
-    OSStatus IsVolumePropertySettable(const AudioObjectPropertyAddress* address, Boolean* outIsSettable);
-    OSStatus GetVolumePropertyDataSize(const AudioObjectPropertyAddress* address, UInt32* outDataSize);
-    OSStatus GetVolumePropertyData(const AudioObjectPropertyAddress* address,
-                                   UInt32 inDataSize, UInt32* outDataSize, void* outData);
-    OSStatus SetVolumePropertyData(const AudioObjectPropertyAddress* address,
-                                   UInt32 inDataSize, const void* inData);
+    // Property tables and their callbacks (device.cpp)
+    friend struct PulseDeviceProperties;
+
+    // Entries in a stream's available format lists: Float32 only on the
+    // output stream, Float32 and Int16 on the input stream
+    UInt32   NumAvailableStreamFormats(AudioObjectID streamID) const
+    {
+        UInt32 perSampleFormat = kNumSupportedChannelCounts * kNumSupportedSampleRates;
+        return (streamID == mInputStreamID) ? 2 * perSampleFormat : perSampleFormat;
+    }
+
+    // Ask the host to switch the stream format via PerformConfigurationChange.
+    // A zero rate, channel count, input sample format or input channel mode
+    // leaves that part of the format unchanged.
+    OSStatus RequestFormat(Float64 sampleRate, UInt32 channels, UInt32 inputFormat,
+                           UInt32 inputChannelMode);
+
+    // Tell listeners the input stream's 'pact' changed. Called from the IO
+    // thread, so it only signals mActivitySource; ReportInputActivity makes
+    // the host call from mActivityQueue.
+    void     NotifyInputActivity();
+    void     ReportInputActivity();
 
     // State
-    Float64         mSampleRate;
-    Float32         mVolume;
-    bool            mMuted;
-    bool            mIORunning;
-    UInt32          mIOStartCount;
-    UInt64          mIOAnchorHostTime;
-    UInt64          mIOAnchorSampleTime;
-    UInt64          mTimestampSeed;
-    RingBuffer      mRingBuffer;
-    std::mutex      mIOMutex;
+    AudioServerPlugInHostRef mHost;
+    AudioObjectID   mDeviceID;
+    AudioObjectID   mOutputStreamID;
+    AudioObjectID   mInputStreamID;
+    AudioObjectID   mVolumeID;
+    CFStringRef     mUID;
+    CFStringRef     mName;
+    IOEngine        mEngine;
+    bool            mReportedInputActive;   // last 'pact' value signalled (WriteMix thread only)
+    bool            mNotifiedInputActive;   // last 'pact' value sent to the host (mActivityQueue only)
+    dispatch_queue_t  mActivityQueue;
+    dispatch_source_t mActivitySource;      // DATA_OR, merged from the IO thread
 };
@@ -0,0 +1,212 @@
+#include "downmix.h"
+#include "types.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define PULSE_DOWNMIX_SSE 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define PULSE_DOWNMIX_NEON 1
+#endif
+
+static const Float32 kStereoGain   = 0.5f;         // -6 dB
+static const Float32 kCentreGain   = 0.70710678f;  // -3 dB
+static const Float32 kSurroundGain = 0.35355339f;  // -9 dB
+
+// Per-channel weights for a layout; coefficients[] holds kMaxNumChannels entries
+static void DownmixCoefficients(UInt32 channels, Float32* coefficients)
+{
+    for (UInt32 ch = 0; ch < kMaxNumChannels; ch++) coefficients[ch] = 0.0f;
+
+    if (channels == 6 || channels == 8) {
+        coefficients[0] = kStereoGain;
+        coefficients[1] = kStereoGain;
+        coefficients[2] = kCentreGain;
+        coefficients[3] = 0.0f;  // LFE
+        for (UInt32 ch = 4; ch < channels; ch++) coefficients[ch] = kSurroundGain;
+    } else {
+        UInt32 weighted = channels < kMaxNumChannels ? channels : kMaxNumChannels;
+        for (UInt32 ch = 0; ch < weighted; ch++) coefficients[ch] = 1.0f / (Float32)channels;
+    }
+}
+
+// ============================================================================
+// Scalar
+// ============================================================================
+
+// Downmix frames [start, numFrames)
+static void DownmixScalarFrom(float* dst, const float* src, UInt32 start, UInt32 numFrames,
+                              UInt32 channels)
+{
+    if (channels == 1) {
+        std::memcpy(dst + start, src + start, (numFrames - start) * sizeof(float));
+        return;
+    }
+
+    Float32 coefficients[kMaxNumChannels];
+    DownmixCoefficients(channels, coefficients);
+    UInt32 weighted = channels < kMaxNumChannels ? channels : kMaxNumChannels;
+
+    for (UInt32 frame = start; frame < numFrames; frame++) {
+        const float* in = src + frame * channels;
+        Float32 sum = 0.0f;
+        for (UInt32 ch = 0; ch < weighted; ch++) sum += in[ch] * coefficients[ch];
+        dst[frame] = sum;
+    }
+}
+
+static void DownmixScalar(float* dst, const float* src, UInt32 numFrames, UInt32 channels)
+{
+    DownmixScalarFrom(dst, src, 0, numFrames, channels);
+}
+
+// ============================================================================
+// x86_64 — SSE2 is baseline
+// ============================================================================
+
+#if defined(PULSE_DOWNMIX_SSE)
+
+// Stereo: split four frames into left and right vectors, one output vector
+static UInt32 DownmixStereoSSE(float* dst, const float* src, UInt32 numFrames)
+{
+    const __m128 gain = _mm_set1_ps(kStereoGain);
+    UInt32 vecFrames = numFrames & ~3u;
+
+    for (UInt32 i = 0; i < vecFrames; i += 4) {
+        __m128 a     = _mm_loadu_ps(src + i * 2);
+        __m128 b     = _mm_loadu_ps(src + i * 2 + 4);
+        __m128 left  = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_add_ps(left, right), gain));
+    }
+    return vecFrames;
+}
+
+// 6 and 8 channels: each frame is covered by two four-wide loads, at
+// channel 0 and at channel kChannels - 4 (overlapping for 5.1, with the
+// overlap weighted zero in the second load). Four frames' partial sums are
+// transposed so one vertical add yields four outputs.
+template <UInt32 kChannels>
+static UInt32 DownmixSurroundSSE(float* dst, const float* src, UInt32 numFrames)
+{
+    const UInt32 kSecond = kChannels - 4;
+
+    Float32 coefficients[kMaxNumChannels];
+    DownmixCoefficients(kChannels, coefficients);
+    Float32 second[4];
+    for (UInt32 j = 0; j < 4; j++) second[j] = (kSecond + j < 4) ? 0.0f : coefficients[kSecond + j];
+    const __m128 c0 = _mm_loadu_ps(coefficients);
+    const __m128 c1 = _mm_loadu_ps(second);
+
+    UInt32 vecFrames = numFrames & ~3u;
+    for (UInt32 i = 0; i < vecFrames; i += 4) {
+        const float* in = src + i * kChannels;
+        __m128 w[4];
+        for (UInt32 f = 0; f < 4; f++) {
+            const float* frame = in + f * kChannels;
+            w[f] = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(frame), c0),
+                              _mm_mul_ps(_mm_loadu_ps(frame + kSecond), c1));
+        }
+        _MM_TRANSPOSE4_PS(w[0], w[1], w[2], w[3]);
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_add_ps(w[0], w[1]), _mm_add_ps(w[2], w[3])));
+    }
+    return vecFrames;
+}
+
+static void DownmixSSE(float* dst, const float* src, UInt32 numFrames, UInt32 channels)
+{
+    UInt32 done;
+    switch (channels) {
+        case 2: done = DownmixStereoSSE(dst, src, numFrames); break;
+        case 6: done = DownmixSurroundSSE<6>(dst, src, numFrames); break;
+        case 8: done = DownmixSurroundSSE<8>(dst, src, numFrames); break;
+        default: done = 0; break;
+    }
+    DownmixScalarFrom(dst, src, done, numFrames, channels);
+}
+
+#endif
+
+// ============================================================================
+// arm64 — NEON is always available
+// ============================================================================
+
+#if defined(PULSE_DOWNMIX_NEON)
+
+// Stereo: vld2q deinterleaves four frames into left and right
+static UInt32 DownmixStereoNEON(float* dst, const float* src, UInt32 numFrames)
+{
+    UInt32 vecFrames = numFrames & ~3u;
+
+    for (UInt32 i = 0; i < vecFrames; i += 4) {
+        float32x4x2_t lr = vld2q_f32(src + i * 2);
+        vst1q_f32(dst + i, vmulq_n_f32(vaddq_f32(lr.val[0], lr.val[1]), kStereoGain));
+    }
+    return vecFrames;
+}
+
+// Same two-load scheme as the SSE kernel; pairwise adds do the transpose
+template <UInt32 kChannels>
+static UInt32 DownmixSurroundNEON(float* dst, const float* src, UInt32 numFrames)
+{
+    const UInt32 kSecond = kChannels - 4;
+
+    Float32 coefficients[kMaxNumChannels];
+    DownmixCoefficients(kChannels, coefficients);
+    Float32 second[4];
+    for (UInt32 j = 0; j < 4; j++) second[j] = (kSecond + j < 4) ? 0.0f : coefficients[kSecond + j];
+    const float32x4_t c0 = vld1q_f32(coefficients);
+    const float32x4_t c1 = vld1q_f32(second);
+
+    UInt32 vecFrames = numFrames & ~3u;
+    for (UInt32 i = 0; i < vecFrames; i += 4) {
+        const float* in = src + i * kChannels;
+        float32x4_t w[4];
+        for (UInt32 f = 0; f < 4; f++) {
+            const float* frame = in + f * kChannels;
+            w[f] = vmlaq_f32(vmulq_f32(vld1q_f32(frame), c0), vld1q_f32(frame + kSecond), c1);
+        }
+        float32x4_t sums = vpaddq_f32(vpaddq_f32(w[0], w[1]), vpaddq_f32(w[2], w[3]));
+        vst1q_f32(dst + i, sums);
+    }
+    return vecFrames;
+}
+
+static void DownmixNEON(float* dst, const float* src, UInt32 numFrames, UInt32 channels)
+{
+    UInt32 done;
+    switch (channels) {
+        case 2: done = DownmixStereoNEON(dst, src, numFrames); break;
+        case 6: done = DownmixSurroundNEON<6>(dst, src, numFrames); break;
+        case 8: done = DownmixSurroundNEON<8>(dst, src, numFrames); break;
+        default: done = 0; break;
+    }
+    DownmixScalarFrom(dst, src, done, numFrames, channels);
+}
+
+#endif
+
+// ============================================================================
+// Runtime selection
+// ============================================================================
+
+static const DownmixKernel kDownmixKernels[] = {
+#if defined(PULSE_DOWNMIX_SSE)
+    { "sse", DownmixSSE },
+#elif defined(PULSE_DOWNMIX_NEON)
+    { "neon", DownmixNEON },
+#endif
+    { "scalar", DownmixScalar },
+};
+
+const DownmixKernel* GetDownmixKernels(UInt32* outCount)
+{
+    *outCount = sizeof(kDownmixKernels) / sizeof(kDownmixKernels[0]);
+    return kDownmixKernels;
+}
+
+void DownmixToMono(float* dst, const float* src, UInt32 numFrames, UInt32 channels)
+{
+    kDownmixKernels[0].downmix(dst, src, numFrames, channels);
+}
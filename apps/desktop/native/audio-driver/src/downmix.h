@@ -0,0 +1,22 @@
+#pragma once
+
+#include "platform.h"
+
+// Mono downmix of interleaved float frames for voice capture.
+// Stereo is (L + R) / 2. 5.1 and 7.1 fold the centre in at -3 dB and the
+// surrounds at -9 dB, the mono sum of the ITU stereo downmix, and drop the
+// LFE. Channel order is the usual CoreAudio one (L R C LFE Ls Rs [Lb Rb]);
+// other counts get an equal-weight average.
+typedef void (*DownmixFn)(float* dst, const float* src, UInt32 numFrames, UInt32 channels);
+
+struct DownmixKernel {
+    const char* name;
+    DownmixFn   downmix;
+};
+
+// All kernels usable on this CPU, best first. The first entry is the one
+// DownmixToMono() uses.
+const DownmixKernel* GetDownmixKernels(UInt32* outCount);
+
+// dst may not alias src
+void DownmixToMono(float* dst, const float* src, UInt32 numFrames, UInt32 channels);
@@ -0,0 +1,121 @@
+#include "drift-resampler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+DriftResampler::DriftResampler()
+    : mChannels(0)
+    , mCarryFrames(kHistoryFrames)
+    , mPosition(1.0)
+    , mCarrySilent(true)
+{
+}
+
+void DriftResampler::Initialize(UInt32 channels)
+{
+    // Worst case input for one call, plus the interpolator's lookahead
+    UInt32 maxInputFrames = (UInt32)std::ceil(kMaxOutputFrames * kMaxRatio) + kHistoryFrames;
+
+    mChannels = channels;
+    mBuffer.assign((size_t)(kMaxCarryFrames + maxInputFrames) * channels, 0.0f);
+    Reset();
+}
+
+void DriftResampler::Reset()
+{
+    std::fill(mBuffer.begin(), mBuffer.end(), 0.0f);
+    mCarryFrames = kHistoryFrames;
+    mPosition    = 1.0;
+    mCarrySilent = true;
+}
+
+UInt32 DriftResampler::BufferedFrames(UInt32 outputFrames, Float64 ratio) const
+{
+    // The last output frame reads up to floor(pos) + 2, and the next call
+    // starts one frame before floor(end), reading up to floor(end) + 1
+    Float64 last = mPosition + (Float64)(outputFrames - 1) * ratio;
+    Float64 end  = mPosition + (Float64)outputFrames * ratio;
+    return std::max((UInt32)last + 3, (UInt32)end + 2);
+}
+
+UInt32 DriftResampler::InputFramesNeeded(UInt32 outputFrames, Float64 ratio) const
+{
+    if (outputFrames == 0) return 0;
+    return BufferedFrames(outputFrames, ratio) - mCarryFrames;
+}
+
+// Hermite interpolation of outputFrames frames starting at position start.
+// Positions are computed as start + frame * ratio, the same expression
+// BufferedFrames() uses, so the last frame never reads past the input.
+// Templated on the channel count so the inner loop unrolls for each
+// supported layout; kChannels == 0 means use the runtime count.
+template <UInt32 kChannels>
+static void Interpolate(float* output, const float* buffer, UInt32 outputFrames,
+                        UInt32 runtimeChannels, Float64 start, Float64 ratio)
+{
+    const UInt32 channels = kChannels ? kChannels : runtimeChannels;
+
+    for (UInt32 frame = 0; frame < outputFrames; frame++) {
+        Float64 position = start + (Float64)frame * ratio;
+        UInt32  index = (UInt32)position;
+        Float32 t     = (Float32)(position - (Float64)index);
+
+        const float* xm1 = buffer + (index - 1) * channels;
+        const float* x0  = xm1 + channels;
+        const float* x1  = x0 + channels;
+        const float* x2  = x1 + channels;
+
+        for (UInt32 ch = 0; ch < channels; ch++) {
+            Float32 c1 = 0.5f * (x1[ch] - xm1[ch]);
+            Float32 c2 = xm1[ch] - 2.5f * x0[ch] + 2.0f * x1[ch] - 0.5f * x2[ch];
+            Float32 c3 = 0.5f * (x2[ch] - xm1[ch]) + 1.5f * (x0[ch] - x1[ch]);
+            output[ch] = ((c3 * t + c2) * t + c1) * t + x0[ch];
+        }
+
+        output += channels;
+    }
+}
+
+UInt32 DriftResampler::Advance(UInt32 outputFrames, Float64 ratio)
+{
+    // Slide everything from one frame before the end position down to the
+    // front; with a ratio below 1 that can be one more frame than the history
+    UInt32  buffered = BufferedFrames(outputFrames, ratio);
+    Float64 end      = mPosition + (Float64)outputFrames * ratio;
+    UInt32  shift    = (UInt32)end - 1;
+    UInt32  fromOld  = shift < mCarryFrames ? mCarryFrames - shift : 0;
+    mCarryFrames = buffered - shift;
+    std::memmove(mBuffer.data(), mBuffer.data() + (size_t)shift * mChannels,
+                 (size_t)mCarryFrames * mChannels * sizeof(float));
+    mPosition = end - (Float64)shift;
+    return fromOld;
+}
+
+void DriftResampler::Process(float* output, UInt32 outputFrames, Float64 ratio, bool inputSilent)
+{
+    if (outputFrames == 0) return;
+
+    const float* buffer = mBuffer.data();
+    switch (mChannels) {
+        case 1: Interpolate<1>(output, buffer, outputFrames, mChannels, mPosition, ratio); break;
+        case 2: Interpolate<2>(output, buffer, outputFrames, mChannels, mPosition, ratio); break;
+        case 6: Interpolate<6>(output, buffer, outputFrames, mChannels, mPosition, ratio); break;
+        case 8: Interpolate<8>(output, buffer, outputFrames, mChannels, mPosition, ratio); break;
+        default: Interpolate<0>(output, buffer, outputFrames, mChannels, mPosition, ratio); break;
+    }
+
+    bool carrySilent = mCarrySilent;
+    UInt32 fromOld   = Advance(outputFrames, ratio);
+    mCarrySilent     = inputSilent && (fromOld == 0 || carrySilent);
+}
+
+bool DriftResampler::SkipSilence(UInt32 outputFrames, Float64 ratio)
+{
+    if (!mCarrySilent) return false;
+    if (outputFrames == 0) return true;
+
+    // The input was never written, so zero what becomes the carry
+    Advance(outputFrames, ratio);
+    std::memset(mBuffer.data(), 0, (size_t)mCarryFrames * mChannels * sizeof(float));
+    return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include "platform.h"
+
+// Variable-ratio resampler for the loopback read path.
+// The HAL clocks the Pulse device from the host clock while the aggregate's
+// main device runs on its own crystal, so over a long call the writer and
+// reader drift apart by a few hundred ppm. Reading input at a ratio slightly
+// above or below 1 absorbs that drift without ever dropping or padding frames.
+//
+// Interleaved float, 4-point Hermite interpolation. Frames the interpolator
+// still needs are carried over to the next call (three or four of them),
+// which adds two frames of latency. Every frame fetched from the ring is
+// used exactly once, so the stream stays continuous across calls.
+class DriftResampler {
+public:
+    // Largest number of output frames per Process() call
+    static constexpr UInt32 kMaxOutputFrames = 512;
+
+    // Supported ratio range (input frames consumed per output frame)
+    static constexpr Float64 kMinRatio = 0.5;
+    static constexpr Float64 kMaxRatio = 2.0;
+
+    // Upper bound on InputFramesNeeded(), for callers staging input elsewhere first
+    static constexpr UInt32 kMaxInputFrames = 2 * kMaxOutputFrames + 4;
+
+    DriftResampler();
+
+    // Allocates the input buffer; call before IO starts.
+    void    Initialize(UInt32 channels);
+
+    // Clear the history (call when IO restarts).
+    void    Reset();
+
+    // Input frames the next Process() of outputFrames will consume at ratio
+    UInt32  InputFramesNeeded(UInt32 outputFrames, Float64 ratio) const;
+
+    // Where to write those input frames before calling Process()
+    float*  InputBuffer() { return mBuffer.data() + mCarryFrames * mChannels; }
+
+    // Render outputFrames from the InputFramesNeeded() frames in InputBuffer().
+    // ratio must be the same value passed to InputFramesNeeded().
+    // inputSilent says the input was all zeros, which lets a later
+    // SkipSilence() know the carried frames are silent too.
+    void    Process(float* output, UInt32 outputFrames, Float64 ratio, bool inputSilent = false);
+
+    // In place of Process() when the InputFramesNeeded() input frames are
+    // known to be silent (InputBuffer() need not be written). If the carried
+    // frames are silent as well the output would be all zeros, so only the
+    // position advances and true is returned; the caller zero-fills the
+    // output. Returns false, doing nothing, if the carry holds signal.
+    bool    SkipSilence(UInt32 outputFrames, Float64 ratio);
+
+private:
+    static constexpr UInt32 kHistoryFrames  = 3;
+    static constexpr UInt32 kMaxCarryFrames = 4;
+
+    // Frames in mBuffer once this call's input is appended
+    UInt32  BufferedFrames(UInt32 outputFrames, Float64 ratio) const;
+
+    // Drop the frames the interpolator is done with, keeping the carry.
+    // Returns how many of the new carried frames came from the old carry.
+    UInt32  Advance(UInt32 outputFrames, Float64 ratio);
+
+    UInt32             mChannels;
+    UInt32             mCarryFrames; // frames carried over at the front of mBuffer
+    Float64            mPosition;    // read position into mBuffer, in [1, 2) between calls
+    bool               mCarrySilent; // every carried frame is zero
+    std::vector<float> mBuffer;      // carried frames followed by this call's input
+};
@@ -0,0 +1,301 @@
+#include "fanout-ring-buffer.h"
+#include <algorithm>
+
+FanoutRingBuffer::FanoutRingBuffer()
+    : mBuffer(nullptr)
+    , mCapacityFrames(0)
+    , mIndexMask(0)
+    , mBytesPerFrame(0)
+    , mChannels(0)
+    , mSilentBlocks(nullptr)
+    , mBlockMask(0)
+    , mReaderGeneration(0)
+    , mWriteHead(0)
+    , mCachedMinReadHead(0)
+    , mCachedReaderGeneration(0)
+    , mDroppedFrames(0)
+{
+    for (UInt32 i = 0; i < kMaxReaders; i++) {
+        mReaders[i].readHead.store(0, std::memory_order_relaxed);
+        mReaders[i].open.store(false, std::memory_order_relaxed);
+        mReaders[i].droppedFrames.store(0, std::memory_order_relaxed);
+        mReaders[i].underrunFrames.store(0, std::memory_order_relaxed);
+        mReaders[i].cachedWriteHead = 0;
+    }
+}
+
+FanoutRingBuffer::~FanoutRingBuffer()
+{
+    delete[] mBuffer;
+    delete[] mSilentBlocks;
+}
+
+void FanoutRingBuffer::Initialize(UInt32 capacityFrames, UInt32 bytesPerFrame)
+{
+    delete[] mBuffer;
+    delete[] mSilentBlocks;
+
+    // A power of two no smaller than a block, so blocks never straddle the wrap
+    mCapacityFrames = kSilenceBlockFrames;
+    while (mCapacityFrames < capacityFrames) mCapacityFrames <<= 1;
+    mIndexMask      = mCapacityFrames - 1;
+    mBytesPerFrame  = bytesPerFrame;
+    mChannels       = bytesPerFrame / sizeof(float);
+    mBlockMask      = mCapacityFrames / kSilenceBlockFrames - 1;
+
+    mBuffer       = new float[mCapacityFrames * mChannels];
+    mSilentBlocks = new std::atomic<UInt8>[mBlockMask + 1];
+    Reset();
+}
+
+void FanoutRingBuffer::Reset()
+{
+    if (mBuffer) {
+        std::memset(mBuffer, 0, mCapacityFrames * mChannels * sizeof(float));
+        for (UInt32 i = 0; i <= mBlockMask; i++) {
+            mSilentBlocks[i].store(0, std::memory_order_relaxed);
+        }
+    }
+    mWriteHead.store(0, std::memory_order_release);
+    mCachedMinReadHead = 0;
+    for (UInt32 i = 0; i < kMaxReaders; i++) {
+        mReaders[i].readHead.store(0, std::memory_order_release);
+        mReaders[i].cachedWriteHead = 0;
+    }
+}
+
+void FanoutRingBuffer::OpenReader(UInt32 reader, UInt32 backlogFrames)
+{
+    // Stay clear of the frames the writer is about to reuse
+    UInt64 writePos = mWriteHead.load(std::memory_order_acquire);
+    UInt64 backlog  = std::min(std::min((UInt64)backlogFrames, (UInt64)mCapacityFrames / 2), writePos);
+    mReaders[reader].readHead.store(writePos - backlog, std::memory_order_relaxed);
+    mReaders[reader].open.store(true, std::memory_order_release);
+
+    // The cursor may be behind mCachedMinReadHead; make the writer rescan
+    mReaderGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void FanoutRingBuffer::CloseReader(UInt32 reader)
+{
+    mReaders[reader].open.store(false, std::memory_order_release);
+}
+
+UInt32 FanoutRingBuffer::ReserveWrite(UInt32 numFrames, RingBufferRegions* outRegions)
+{
+    *outRegions = RingBufferRegions{ nullptr, 0, nullptr, 0 };
+    if (!mBuffer || numFrames == 0) return 0;
+
+    UInt64 writePos = mWriteHead.load(std::memory_order_relaxed);
+    UInt32 toWrite  = std::min(numFrames, mCapacityFrames);
+    EvictReaders(writePos, toWrite);
+
+    // The caller stores real samples in every block touched
+    UnflagPartialBlock(writePos);
+    for (UInt64 pos = writePos; pos < writePos + toWrite; pos += kSilenceBlockFrames) {
+        SilentFlag(pos).store(0, std::memory_order_release);
+    }
+    SilentFlag(writePos + toWrite - 1).store(0, std::memory_order_release);
+
+    UInt32 index      = (UInt32)(writePos & mIndexMask);
+    UInt32 firstChunk = std::min(toWrite, mCapacityFrames - index);
+    outRegions->first        = mBuffer + (index * mChannels);
+    outRegions->firstFrames  = firstChunk;
+    outRegions->second       = mBuffer;
+    outRegions->secondFrames = toWrite - firstChunk;
+    return toWrite;
+}
+
+void FanoutRingBuffer::EvictReaders(UInt64 writePos, UInt32 numFrames)
+{
+    // Every frame before oldestKept is about to be overwritten. Move any reader
+    // still behind it forward first, so its next commit fails instead of
+    // returning a torn copy.
+    UInt64 end        = writePos + numFrames;
+    UInt64 oldestKept = end > mCapacityFrames ? end - mCapacityFrames : 0;
+
+    // Readers only move their cursors forward, so the lower bound from the
+    // last scan holds until a write reaches past it or a reader is opened
+    UInt32 generation = mReaderGeneration.load(std::memory_order_acquire);
+    if (oldestKept <= mCachedMinReadHead && generation == mCachedReaderGeneration) return;
+    mCachedReaderGeneration = generation;
+
+    // No cursor is ahead of the writer, so end bounds an empty scan
+    UInt64 minReadHead = end;
+    UInt64 dropped     = 0;
+    for (UInt32 i = 0; i < kMaxReaders; i++) {
+        Reader& reader = mReaders[i];
+        if (!reader.open.load(std::memory_order_acquire)) continue;
+
+        UInt64 readPos = reader.readHead.load(std::memory_order_acquire);
+        while (readPos < oldestKept) {
+            if (reader.readHead.compare_exchange_weak(readPos, oldestKept, std::memory_order_acq_rel,
+                                                      std::memory_order_acquire)) {
+                reader.droppedFrames.store(reader.droppedFrames.load(std::memory_order_relaxed) +
+                                           (oldestKept - readPos), std::memory_order_relaxed);
+                dropped += oldestKept - readPos;
+                readPos = oldestKept;
+                break;
+            }
+        }
+        minReadHead = std::min(minReadHead, readPos);
+    }
+    mCachedMinReadHead = minReadHead;
+
+    if (dropped > 0) {
+        mDroppedFrames.store(mDroppedFrames.load(std::memory_order_relaxed) + dropped,
+                             std::memory_order_relaxed);
+    }
+}
+
+void FanoutRingBuffer::ZeroFrames(UInt64 pos, UInt32 numFrames)
+{
+    // Callers stay within one block, which never wraps
+    std::memset(mBuffer + (UInt32)(pos & mIndexMask) * mChannels, 0, numFrames * mBytesPerFrame);
+}
+
+void FanoutRingBuffer::UnflagPartialBlock(UInt64 pos)
+{
+    UInt32 offset = (UInt32)(pos % kSilenceBlockFrames);
+    std::atomic<UInt8>& flag = SilentFlag(pos);
+    if (offset != 0 && flag.load(std::memory_order_relaxed)) {
+        // Zero before clearing: a reader that sees the flag clear must see the zeros
+        ZeroFrames(pos - offset, offset);
+        flag.store(0, std::memory_order_release);
+    }
+}
+
+UInt32 FanoutRingBuffer::WriteSilence(UInt32 numFrames)
+{
+    if (!mBuffer || numFrames == 0) return 0;
+
+    UInt64 writePos = mWriteHead.load(std::memory_order_relaxed);
+    UInt32 toWrite  = std::min(numFrames, mCapacityFrames);
+    EvictReaders(writePos, toWrite);
+    UnflagPartialBlock(writePos);
+
+    UInt64 pos = writePos;
+    UInt64 end = writePos + toWrite;
+    while (pos < end) {
+        UInt64 blockEnd = (pos / kSilenceBlockFrames + 1) * kSilenceBlockFrames;
+        if (pos % kSilenceBlockFrames == 0 && blockEnd <= end) {
+            SilentFlag(pos).store(1, std::memory_order_release);
+            pos = blockEnd;
+        } else {
+            UInt64 stop = std::min(blockEnd, end);
+            ZeroFrames(pos, (UInt32)(stop - pos));
+            SilentFlag(pos).store(0, std::memory_order_release);
+            pos = stop;
+        }
+    }
+
+    CommitWrite(toWrite);
+    return toWrite;
+}
+
+void FanoutRingBuffer::CommitWrite(UInt32 numFrames)
+{
+    UInt64 writePos = mWriteHead.load(std::memory_order_relaxed);
+    mWriteHead.store(writePos + numFrames, std::memory_order_release);
+}
+
+UInt32 FanoutRingBuffer::AvailableFrom(Reader& reader, UInt64 readPos, UInt32 wantFrames)
+{
+    // The cached write head only lags the real one, so it is safe to read up to
+    UInt64 writePos = reader.cachedWriteHead;
+    if (writePos < readPos + wantFrames) {
+        writePos = mWriteHead.load(std::memory_order_acquire);
+        reader.cachedWriteHead = writePos;
+    }
+    UInt64 avail = writePos > readPos ? writePos - readPos : 0;
+    return (UInt32)std::min(avail, (UInt64)mCapacityFrames);
+}
+
+bool FanoutRingBuffer::CopyOut(float* dst, UInt64 pos, UInt32 numFrames) const
+{
+    // One memcpy or memset per run of blocks in the same state, split at the wrap
+    bool   allSilent = true;
+    UInt32 done      = 0;
+    while (done < numFrames) {
+        UInt64 at     = pos + done;
+        UInt32 index  = (UInt32)(at & mIndexMask);
+        UInt32 limit  = std::min(numFrames - done, mCapacityFrames - index);
+        bool   silent = mSilentBlocks[(at / kSilenceBlockFrames) & mBlockMask].load(std::memory_order_acquire) != 0;
+
+        UInt32 run = std::min(limit, kSilenceBlockFrames - (UInt32)(at % kSilenceBlockFrames));
+        while (run < limit &&
+               (mSilentBlocks[((at + run) / kSilenceBlockFrames) & mBlockMask].load(std::memory_order_acquire) != 0) == silent) {
+            run = std::min(limit, run + kSilenceBlockFrames);
+        }
+
+        if (silent) {
+            std::memset(dst + done * mChannels, 0, run * mBytesPerFrame);
+        } else {
+            std::memcpy(dst + done * mChannels, mBuffer + index * mChannels, run * mBytesPerFrame);
+            allSilent = false;
+        }
+        done += run;
+    }
+    return allSilent;
+}
+
+UInt32 FanoutRingBuffer::Fetch(UInt32 readerIndex, float* dst, UInt32 numFrames, bool* outSilent)
+{
+    if (!dst || numFrames == 0) return 0;
+
+    Reader& reader = mReaders[readerIndex];
+    UInt32  toRead = 0;
+    bool    silent = true;
+
+    if (mBuffer) {
+        UInt64 readPos = reader.readHead.load(std::memory_order_acquire);
+        for (;;) {
+            toRead = std::min(numFrames, AvailableFrom(reader, readPos, numFrames));
+            if (toRead == 0) {
+                silent = true;
+                break;
+            }
+
+            silent = CopyOut(dst, readPos, toRead);
+
+            // On failure the writer lapped us mid-copy; readPos now holds the new cursor
+            if (reader.readHead.compare_exchange_strong(readPos, readPos + toRead, std::memory_order_acq_rel,
+                                                        std::memory_order_acquire)) {
+                break;
+            }
+        }
+    }
+
+    if (outSilent) *outSilent = silent;
+
+    // Fill remaining with silence
+    if (toRead < numFrames) {
+        std::memset(dst + (toRead * mChannels), 0, (numFrames - toRead) * mBytesPerFrame);
+        reader.underrunFrames.store(reader.underrunFrames.load(std::memory_order_relaxed) + (numFrames - toRead),
+                                    std::memory_order_relaxed);
+    }
+
+    return toRead;
+}
+
+UInt32 FanoutRingBuffer::Discard(UInt32 readerIndex, UInt32 numFrames)
+{
+    Reader& reader  = mReaders[readerIndex];
+    UInt64  readPos = reader.readHead.load(std::memory_order_acquire);
+    UInt32  toDrop;
+
+    do {
+        toDrop = std::min(numFrames, AvailableFrom(reader, readPos, numFrames));
+        if (toDrop == 0) break;
+    } while (!reader.readHead.compare_exchange_weak(readPos, readPos + toDrop, std::memory_order_acq_rel,
+                                                    std::memory_order_acquire));
+    return toDrop;
+}
+
+UInt32 FanoutRingBuffer::AvailableFrames(UInt32 readerIndex)
+{
+    // Asking for a whole ring reloads the write head unless the cached one
+    // already shows a full ring, so the count is always current
+    Reader& reader = mReaders[readerIndex];
+    return AvailableFrom(reader, reader.readHead.load(std::memory_order_acquire), mCapacityFrames);
+}
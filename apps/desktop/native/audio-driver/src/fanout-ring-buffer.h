@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include "ring-buffer.h"
+#include "types.h"
+
+// Single-writer, multi-reader ring buffer for audio loopback.
+// Every reader has its own cursor and sees the full stream. The writer never
+// waits for readers: when a reader falls a whole ring behind, the writer
+// pushes that reader's cursor forward before overwriting its oldest frames,
+// and counts the frames it skipped. Other readers are unaffected.
+//
+// Readers copy first and then commit their cursor with a compare-and-swap.
+// If the writer moved the cursor in the meantime the copy may be torn, so
+// the read is retried from the new position — the same validate-after-read
+// scheme as Seqlock. Each reader must be driven by one thread at a time.
+//
+// As in RingBuffer, neither side reloads the other's heads every cycle. A
+// reader keeps its last observed write head and reloads it only when that
+// doesn't cover the read. The writer keeps a lower bound on the open
+// readers' heads and rescans them only when a write would reach past it, or
+// after OpenReader() has moved a cursor back.
+//
+// Silence is stored as a marker rather than as samples: the ring keeps a
+// flag per block of kSilenceBlockFrames, and a block written entirely by
+// WriteSilence() is only flagged. Readers zero-fill flagged blocks.
+class FanoutRingBuffer {
+public:
+    static const UInt32 kMaxReaders         = 8;
+    static const UInt32 kSilenceBlockFrames = 32;
+
+    FanoutRingBuffer();
+    ~FanoutRingBuffer();
+
+    // Allocate at least capacityFrames (and one silence block), rounded up to a power of two.
+    // Not safe while the writer or any reader is running.
+    void Initialize(UInt32 capacityFrames, UInt32 bytesPerFrame);
+
+    // Clear all data and rewind every cursor. Open readers stay open.
+    void Reset();
+
+    // Start or stop tracking a reader. An opened reader starts backlogFrames
+    // behind the write position (or at the oldest frame written, if fewer),
+    // so it can begin at its target latency instead of with an underrun.
+    // Lock-free; may be called from the reader's own IO thread.
+    void OpenReader(UInt32 reader, UInt32 backlogFrames);
+    void CloseReader(UInt32 reader);
+    bool IsReaderOpen(UInt32 reader) const { return mReaders[reader].open.load(std::memory_order_acquire); }
+
+    // Zero-copy producer API. Always reserves min(numFrames, capacity) frames,
+    // evicting the oldest frames of any reader that would be overwritten.
+    UInt32 ReserveWrite(UInt32 numFrames, RingBufferRegions* outRegions);
+    void   CommitWrite(UInt32 numFrames);
+
+    // Append min(numFrames, capacity) frames of silence and commit them.
+    // Whole blocks are only flagged; the partial blocks at either end are zeroed.
+    UInt32 WriteSilence(UInt32 numFrames);
+
+    // Copy up to numFrames for a reader and pad the rest with silence.
+    // Returns the number of frames actually fetched (underrun padding
+    // excluded). outSilent, if given, is set when everything written to dst
+    // came from silent blocks or padding.
+    UInt32 Fetch(UInt32 reader, float* dst, UInt32 numFrames, bool* outSilent = nullptr);
+
+    // Drop up to numFrames of a reader's unread data.
+    // Returns the number of frames discarded.
+    UInt32 Discard(UInt32 reader, UInt32 numFrames);
+
+    // Frames a reader has available. Called from the reader's thread, as it
+    // refreshes that reader's cached write head.
+    UInt32 AvailableFrames(UInt32 reader);
+
+    // Cumulative counters for the lifetime of this buffer. Readable from any thread.
+    UInt64 DroppedFrames() const { return mDroppedFrames.load(std::memory_order_relaxed); }            // evicted from all readers
+    UInt64 DroppedFrames(UInt32 reader) const { return mReaders[reader].droppedFrames.load(std::memory_order_relaxed); }
+    UInt64 UnderrunFrames(UInt32 reader) const { return mReaders[reader].underrunFrames.load(std::memory_order_relaxed); }
+
+    UInt32 CapacityFrames() const { return mCapacityFrames; }
+
+private:
+    struct alignas(kCacheLineSize) Reader {
+        std::atomic<UInt64> readHead;       // total frames consumed (monotonic)
+        std::atomic<bool>   open;
+        std::atomic<UInt64> droppedFrames;  // written by the writer only
+        std::atomic<UInt64> underrunFrames; // written by the reader only
+        UInt64              cachedWriteHead; // reader's last observed mWriteHead
+    };
+
+    // Frames readable from readPos, capped at the capacity. Reloads the
+    // write head only when the cached one has fewer than wantFrames (reader only).
+    UInt32 AvailableFrom(Reader& reader, UInt64 readPos, UInt32 wantFrames);
+
+    // Move every reader behind the frames [writePos, writePos + numFrames)
+    // will overwrite forward, counting the drops. Skips the scan while
+    // mCachedMinReadHead shows no reader can be that far behind (writer only).
+    void   EvictReaders(UInt64 writePos, UInt32 numFrames);
+
+    // Silence block bookkeeping (writer only). A partly written block must
+    // hold real samples; if it was flagged, its frames before pos are zeroed first.
+    std::atomic<UInt8>& SilentFlag(UInt64 pos) { return mSilentBlocks[(pos / kSilenceBlockFrames) & mBlockMask]; }
+    void   ZeroFrames(UInt64 pos, UInt32 numFrames);
+    void   UnflagPartialBlock(UInt64 pos);
+
+    // Copy numFrames starting at pos, zero-filling flagged blocks.
+    // Returns true if every frame was silent.
+    bool   CopyOut(float* dst, UInt64 pos, UInt32 numFrames) const;
+
+    // Read-only after Initialize()
+    float*              mBuffer;
+    UInt32              mCapacityFrames;
+    UInt32              mIndexMask;
+    UInt32              mBytesPerFrame;
+    UInt32              mChannels;
+    std::atomic<UInt8>* mSilentBlocks;    // one flag per kSilenceBlockFrames
+    UInt32              mBlockMask;
+
+    // Bumped by OpenReader(), which may place a cursor behind mCachedMinReadHead
+    std::atomic<UInt32> mReaderGeneration;
+
+    // Producer side
+    alignas(kCacheLineSize) std::atomic<UInt64> mWriteHead;  // total frames written (monotonic)
+    UInt64              mCachedMinReadHead;      // no open reader is behind this
+    UInt32              mCachedReaderGeneration; // mReaderGeneration at the last scan
+    std::atomic<UInt64> mDroppedFrames;
+
+    Reader              mReaders[kMaxReaders];
+};
@@ -0,0 +1,74 @@
+#include "fill-controller.h"
+#include "types.h"
+#include <algorithm>
+
+// Smoothing factor for the fill estimate (~8 cycle time constant)
+static const Float32 kFillSmoothing    = 1.0f / 8.0f;
+
+// PI gains, on the fill error measured in periods (error / request size).
+// The fill moves by (ratio - 1) * request frames per cycle, so these give a
+// loop independent of the period size: ~1000 cycle time constant, damping ~0.7.
+static const Float64 kProportionalGain = 1.0e-3;
+static const Float64 kIntegralGain     = 5.0e-7;
+
+// Largest deviation of the ratio from 1 (0.5%, under 9 cents of pitch).
+// Clock drift between real devices is a few hundred ppm at most.
+static const Float64 kMaxRatioDeviation = 0.005;
+
+// Backlog beyond target + this many periods is dropped in one step
+static const UInt32  kSnapPeriods      = 8;
+
+FillController::FillController()
+    : mTargetFrames(kDefaultTargetFillFrames)
+    , mCapacityFrames(kRingBufferFrameCapacity)
+    , mSmoothedFill(0.0f)
+    , mIntegral(0.0)
+    , mPrimed(false)
+{
+}
+
+void FillController::Reset()
+{
+    mSmoothedFill = 0.0f;
+    mIntegral     = 0.0;
+    mPrimed       = false;
+}
+
+FillController::Correction FillController::Update(UInt32 availableFrames, UInt32 requestFrames)
+{
+    Correction correction = { 0, 1.0 };
+    if (requestFrames == 0) return correction;
+
+    // Fill left in the ring after this read, before any correction
+    Float32 residual = (Float32)availableFrames - (Float32)requestFrames;
+    Float32 target   = (Float32)mTargetFrames;
+
+    // Large backlog, or more than the capacity allows — snap back to the
+    // target in one step
+    Float32 snapLimit    = target + (Float32)(kSnapPeriods * requestFrames);
+    bool    overCapacity = availableFrames > mCapacityFrames && residual > target;
+    if (overCapacity || residual > snapLimit) {
+        correction.dropFrames = (UInt32)(residual - target);
+        correction.ratio      = 1.0 + mIntegral;
+        mSmoothedFill = target;
+        mPrimed       = true;
+        return correction;
+    }
+
+    if (!mPrimed) {
+        mSmoothedFill = residual;
+        mPrimed       = true;
+    } else {
+        mSmoothedFill += kFillSmoothing * (residual - mSmoothedFill);
+    }
+
+    Float64 error = (Float64)(mSmoothedFill - target) / (Float64)requestFrames;
+
+    // Clamping the integral keeps it from winding up while the ring is empty
+    mIntegral = std::clamp(mIntegral + kIntegralGain * error, -kMaxRatioDeviation, kMaxRatioDeviation);
+
+    Float64 deviation = std::clamp(kProportionalGain * error + mIntegral,
+                                   -kMaxRatioDeviation, kMaxRatioDeviation);
+    correction.ratio = 1.0 + deviation;
+    return correction;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "platform.h"
+
+// Keeps the loopback ring's fill level near a target latency.
+// Runs on the ReadInput side once per IO cycle. A PI controller on the
+// smoothed fill level sets the read-side resampling ratio: slightly above 1
+// drains a ring that is filling up, slightly below 1 lets it refill. The
+// integral term settles on the steady clock drift between the writer and
+// reader, so the fill level holds without dropping or padding frames.
+// A backlog far above the target, e.g. after the reader stalled, is dropped
+// in one step, so capture latency doesn't stay at hundreds of milliseconds
+// after a hiccup. So is any fill beyond the configured capacity, which is
+// the most latency a client is ever allowed to see.
+class FillController {
+public:
+    // What to do this cycle
+    struct Correction {
+        UInt32  dropFrames;  // discard this many frames before reading
+        Float64 ratio;       // input frames to consume per output frame
+    };
+
+    FillController();
+
+    // Forget the smoothed fill level and the learned drift (call when IO restarts).
+    void   Reset();
+
+    void   SetTargetFrames(UInt32 targetFrames) { mTargetFrames = targetFrames; }
+    UInt32 GetTargetFrames() const { return mTargetFrames; }
+    void   SetCapacityFrames(UInt32 capacityFrames) { mCapacityFrames = capacityFrames; }
+    UInt32 GetCapacityFrames() const { return mCapacityFrames; }
+
+    // Decide the correction for a read of requestFrames with availableFrames
+    // currently in the ring.
+    Correction Update(UInt32 availableFrames, UInt32 requestFrames);
+
+private:
+    UInt32  mTargetFrames;
+    UInt32  mCapacityFrames;
+    Float32 mSmoothedFill;   // exponential moving average of the post-read fill
+    Float64 mIntegral;       // accumulated ratio correction (the learned drift)
+    bool    mPrimed;
+};
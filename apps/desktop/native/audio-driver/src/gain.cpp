@@ -0,0 +1,464 @@
+#include "gain.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define PULSE_GAIN_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define PULSE_GAIN_NEON 1
+#endif
+
+// Every kernel is instantiated for each supported channel count (1, 2, 6, 8).
+// A SIMD loop steps through blocks of lcm(channels, vector width) samples,
+// which always hold whole frames and whole vectors, so the per-lane gain
+// pattern repeats from block to block: a stereo block is one vector as
+// before, a 5.1 block is three. Other channel counts take the scalar path.
+//
+// The metering variants (kMeter) keep a peak and a sum-of-squares vector per
+// block vector. Lane k of a block always holds channel k % channels, so the
+// lanes fold back into per-channel levels once at the end.
+
+static constexpr UInt32 Gcd(UInt32 a, UInt32 b) { return b == 0 ? a : Gcd(b, a % b); }
+
+// Samples per SIMD block for a channel count and vector width
+static constexpr UInt32 BlockSamples(UInt32 channels, UInt32 width)
+{
+    return channels / Gcd(channels, width) * width;
+}
+
+// ============================================================================
+// Scalar
+// ============================================================================
+
+// kChannels == 0 means use the runtime count
+template <UInt32 kChannels, bool kMeter>
+static void GainRampFrames(float* dst, const float* src, UInt32 numFrames, UInt32 runtimeChannels,
+                           Float32 gain, Float32 gainStep, ChannelLevels* levels)
+{
+    const UInt32 channels = kChannels ? kChannels : runtimeChannels;
+
+    // Local accumulators: levels could alias dst, which would force a reload per sample
+    Float32 peak[kMaxNumChannels]       = {};
+    Float32 sumSquares[kMaxNumChannels] = {};
+
+    for (UInt32 frame = 0; frame < numFrames; frame++) {
+        Float32 g = gain + (Float32)frame * gainStep;
+        for (UInt32 ch = 0; ch < channels; ch++) {
+            Float32 out = src[ch] * g;
+            dst[ch] = out;
+            if (kMeter) {
+                Float32 magnitude = out < 0.0f ? -out : out;
+                peak[ch] = magnitude > peak[ch] ? magnitude : peak[ch];  // keeps peak for NaN
+                sumSquares[ch] += out * out;
+            }
+        }
+        dst += channels;
+        src += channels;
+    }
+
+    if (kMeter) {
+        for (UInt32 ch = 0; ch < channels; ch++) {
+            if (peak[ch] > levels->peak[ch]) levels->peak[ch] = peak[ch];
+            levels->sumSquares[ch] += sumSquares[ch];
+        }
+    }
+}
+
+template <bool kMeter>
+static void GainRampScalarImpl(float* dst, const float* src, UInt32 numFrames, UInt32 channels,
+                               Float32 gain, Float32 gainStep, ChannelLevels* levels)
+{
+    switch (channels) {
+        case 1: GainRampFrames<1, kMeter>(dst, src, numFrames, channels, gain, gainStep, levels); break;
+        case 2: GainRampFrames<2, kMeter>(dst, src, numFrames, channels, gain, gainStep, levels); break;
+        case 6: GainRampFrames<6, kMeter>(dst, src, numFrames, channels, gain, gainStep, levels); break;
+        case 8: GainRampFrames<8, kMeter>(dst, src, numFrames, channels, gain, gainStep, levels); break;
+        default: GainRampFrames<0, kMeter>(dst, src, numFrames, channels, gain, gainStep, levels); break;
+    }
+}
+
+static void GainRampScalar(float* dst, const float* src, UInt32 numFrames, UInt32 channels,
+                           Float32 gain, Float32 gainStep)
+{
+    GainRampScalarImpl<false>(dst, src, numFrames, channels, gain, gainStep, nullptr);
+}
+
+static void GainRampMeterScalar(float* dst, const float* src, UInt32 numFrames, UInt32 channels,
+                                Float32 gain, Float32 gainStep, ChannelLevels* levels)
+{
+    GainRampScalarImpl<true>(dst, src, numFrames, channels, gain, gainStep, levels);
+}
+
+// Finish the samples a vector loop left over, starting at sample `done`
+template <UInt32 kChannels, bool kMeter>
+static void GainRampTail(float* dst, const float* src, UInt32 numFrames,
+                         Float32 gain, Float32 gainStep, UInt32 done, ChannelLevels* levels)
+{
+    UInt32 frame = done / kChannels;
+    GainRampFrames<kChannels, kMeter>(dst + done, src + done, numFrames - frame, kChannels,
+                                      gain + (Float32)frame * gainStep, gainStep, levels);
+}
+
+// Starting gain of every lane in a block: lane k holds sample k, of frame k / kChannels
+template <UInt32 kChannels, UInt32 kBlock>
+static void BlockLaneGains(float* lanes, Float32 gain, Float32 gainStep)
+{
+    for (UInt32 k = 0; k < kBlock; k++) {
+        lanes[k] = gain + (Float32)(k / kChannels) * gainStep;
+    }
+}
+
+// Fold per-lane block levels into per-channel levels
+template <UInt32 kChannels, UInt32 kBlock>
+static void FoldLaneLevels(ChannelLevels* levels, const float* peaks, const float* sumSquares)
+{
+    for (UInt32 k = 0; k < kBlock; k++) {
+        UInt32 ch = k % kChannels;
+        if (peaks[k] > levels->peak[ch]) levels->peak[ch] = peaks[k];
+        levels->sumSquares[ch] += sumSquares[k];
+    }
+}
+
+// ============================================================================
+// x86_64 — SSE2 is baseline, AVX is picked at runtime
+// ============================================================================
+
+#if defined(PULSE_GAIN_X86)
+
+template <UInt32 kChannels, bool kMeter>
+static void GainRampSSEBlocks(float* dst, const float* src, UInt32 numFrames,
+                              Float32 gain, Float32 gainStep, ChannelLevels* levels)
+{
+    const UInt32 kWidth   = 4;
+    const UInt32 kBlock   = BlockSamples(kChannels, kWidth);
+    const UInt32 kVectors = kBlock / kWidth;
+
+    UInt32 numSamples = numFrames * kChannels;
+    UInt32 vecSamples = numSamples - numSamples % kBlock;
+
+    float lanes[kBlock];
+    BlockLaneGains<kChannels, kBlock>(lanes, gain, gainStep);
+    __m128 g[kVectors];
+    for (UInt32 v = 0; v < kVectors; v++) g[v] = _mm_loadu_ps(lanes + v * kWidth);
+    __m128 step = _mm_set1_ps(gainStep * (Float32)(kBlock / kChannels));
+
+    // maxps returns its second operand when either is NaN, so the peak goes there
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 peak[2][kVectors], sum[2][kVectors];
+    for (UInt32 v = 0; v < kVectors; v++) {
+        peak[0][v] = peak[1][v] = sum[0][v] = sum[1][v] = _mm_setzero_ps();
+    }
+
+    UInt32 i = 0;
+    if (kMeter) {
+        // Two blocks per step on separate accumulators, to overlap the max and add latencies
+        for (; i + 2 * kBlock <= vecSamples; i += 2 * kBlock) {
+            for (UInt32 u = 0; u < 2; u++) {
+                for (UInt32 v = 0; v < kVectors; v++) {
+                    UInt32 at  = i + u * kBlock + v * kWidth;
+                    __m128 out = _mm_mul_ps(_mm_loadu_ps(src + at), g[v]);
+                    _mm_storeu_ps(dst + at, out);
+                    g[v] = _mm_add_ps(g[v], step);
+                    peak[u][v] = _mm_max_ps(_mm_and_ps(out, absMask), peak[u][v]);
+                    sum[u][v]  = _mm_add_ps(sum[u][v], _mm_mul_ps(out, out));
+                }
+            }
+        }
+    }
+    for (; i < vecSamples; i += kBlock) {
+        for (UInt32 v = 0; v < kVectors; v++) {
+            UInt32 at  = i + v * kWidth;
+            __m128 out = _mm_mul_ps(_mm_loadu_ps(src + at), g[v]);
+            _mm_storeu_ps(dst + at, out);
+            g[v] = _mm_add_ps(g[v], step);
+            if (kMeter) {
+                peak[0][v] = _mm_max_ps(_mm_and_ps(out, absMask), peak[0][v]);
+                sum[0][v]  = _mm_add_ps(sum[0][v], _mm_mul_ps(out, out));
+            }
+        }
+    }
+
+    if (kMeter) {
+        float peaks[kBlock], sumSquares[kBlock];
+        for (UInt32 v = 0; v < kVectors; v++) {
+            _mm_storeu_ps(peaks + v * kWidth, _mm_max_ps(peak[0][v], peak[1][v]));
+            _mm_storeu_ps(sumSquares + v * kWidth, _mm_add_ps(sum[0][v], sum[1][v]));
+        }
+        FoldLaneLevels<kChannels, kBlock>(levels, peaks, sumSquares);
+    }
+
+    if (vecSamples < numSamples) {
+        GainRampTail<kChannels, kMeter>(dst, src, numFrames, gain, gainStep, vecSamples, levels);
+    }
+}
+
+template <bool kMeter>
+static void GainRampSSEImpl(float* dst, const float* src, UInt32 numFrames, UInt32 channels,
+                            Float32 gain, Float32 gainStep, ChannelLevels* levels)
+{
+    switch (channels) {
+        case 1: GainRampSSEBlocks<1, kMeter>(dst, src, numFrames, gain, gainStep, levels); break;
+        case 2: GainRampSSEBlocks<2, kMeter>(dst, src, numFrames, gain, gainStep, levels); break;
+        case 6: GainRampSSEBlocks<6, kMeter>(dst, src, numFrames, gain, gainStep, levels); break;
+        case 8: GainRampSSEBlocks<8, kMeter>(dst, src, numFrames, gain, gainStep, levels); break;
+        default: GainRampScalarImpl<kMeter>(dst, src, numFrames, channels, gain, gainStep, levels); break;
+    }
+}
+
+static void GainRampSSE(float* dst, const float* src, UInt32 numFrames, UInt32 channels,
+                        Float32 gain, Float32 gainStep)
+{
+    GainRampSSEImpl<false>(dst, src, numFrames, channels, gain, gainStep, nullptr);
+}
+
+static void GainRampMeterSSE(float* dst, const float* src, UInt32 numFrames, UInt32 channels,
+                             Float32 gain, Float32 gainStep, ChannelLevels* levels)
+{
+    GainRampSSEImpl<true>(dst, src, numFrames, channels, gain, gainStep, levels);
+}
+
+template <UInt32 kChannels, bool kMeter>
+__attribute__((target("avx")))
+static void GainRampAVXBlocks(float* dst, const float* src, UInt32 numFrames,
+                              Float32 gain, Float32 gainStep, ChannelLevels* levels)
+{
+    const UInt32 kWidth   = 8;
+    const UInt32 kBlock   = BlockSamples(kChannels, kWidth);
+    const UInt32 kVectors = kBlock / kWidth;
+
+    UInt32 numSamples = numFrames * kChannels;
+    UInt32 vecSamples = numSamples - numSamples % kBlock;
+
+    float lanes[kBlock];
+    BlockLaneGains<kChannels, kBlock>(lanes, gain, gainStep);
+    __m256 g[kVectors];
+    for (UInt32 v = 0; v < kVectors; v++) g[v] = _mm256_loadu_ps(lanes + v * kWidth);
+    __m256 step = _mm256_set1_ps(gainStep * (Float32)(kBlock / kChannels));
+
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    __m256 peak[2][kVectors], sum[2][kVectors];
+    for (UInt32 v = 0; v < kVectors; v++) {
+        peak[0][v] = peak[1][v] = sum[0][v] = sum[1][v] = _mm256_setzero_ps();
+    }
+
+    UInt32 i = 0;
+    if (kMeter) {
+        for (; i + 2 * kBlock <= vecSamples; i += 2 * kBlock) {
+            for (UInt32 u = 0; u < 2; u++) {
+                for (UInt32 v = 0; v < kVectors; v++) {
+                    UInt32 at  = i + u * kBlock + v * kWidth;
+                    __m256 out = _mm256_mul_ps(_mm256_loadu_ps(src + at), g[v]);
+                    _mm256_storeu_ps(dst + at, out);
+                    g[v] = _mm256_add_ps(g[v], step);
+                    peak[u][v] = _mm256_max_ps(_mm256_and_ps(out, absMask), peak[u][v]);
+                    sum[u][v]  = _mm256_add_ps(sum[u][v], _mm256_mul_ps(out, out));
+                }
+            }
+        }
+    }
+    for (; i < vecSamples; i += kBlock) {
+        for (UInt32 v = 0; v < kVectors; v++) {
+            UInt32 at  = i + v * kWidth;
+            __m256 out = _mm256_mul_ps(_mm256_loadu_ps(src + at), g[v]);
+            _mm256_storeu_ps(dst + at, out);
+            g[v] = _mm256_add_ps(g[v], step);
+            if (kMeter) {
+                peak[0][v] = _mm256_max_ps(_mm256_and_ps(out, absMask), peak[0][v]);
+                sum[0][v]  = _mm256_add_ps(sum[0][v], _mm256_mul_ps(out, out));
+            }
+        }
+    }
+
+    if (kMeter) {
+        float peaks[kBlock], sumSquares[kBlock];
+        for (UInt32 v = 0; v < kVectors; v++) {
+            _mm256_storeu_ps(peaks + v * kWidth, _mm256_max_ps(peak[0][v], peak[1][v]));
+            _mm256_storeu_ps(sumSquares + v * kWidth, _mm256_add_ps(sum[0][v], sum[1][v]));
+        }
+        FoldLaneLevels<kChannels, kBlock>(levels, peaks, sumSquares);
+    }
+
+    if (vecSamples < numSamples) {
+        GainRampTail<kChannels, kMeter>(dst, src, numFrames, gain, gainStep, vecSamples, levels);
+    }
+}
+
+template <bool kMeter>
+static void GainRampAVXImpl(float* dst, const float* src, UInt32 numFrames, UInt32 channels,
+                            Float32 gain, Float32 gainStep, ChannelLevels* levels)
+{
+    switch (channels) {
+        case 1: GainRampAVXBlocks<1, kMeter>(dst, src, numFrames, gain, gainStep, levels); break;
+        case 2: GainRampAVXBlocks<2, kMeter>(dst, src, numFrames, gain, gainStep, levels); break;
+        case 6: GainRampAVXBlocks<6, kMeter>(dst, src, numFrames, gain, gainStep, levels); break;
+        case 8: GainRampAVXBlocks<8, kMeter>(dst, src, numFrames, gain, gainStep, levels); break;
+        default: GainRampScalarImpl<kMeter>(dst, src, numFrames, channels, gain, gainStep, levels); break;
+    }
+}
+
+static void GainRampAVX(float* dst, const float* src, UInt32 numFrames, UInt32 channels,
+                        Float32 gain, Float32 gainStep)
+{
+    GainRampAVXImpl<false>(dst, src, numFrames, channels, gain, gainStep, nullptr);
+}
+
+static void GainRampMeterAVX(float* dst, const float* src, UInt32 numFrames, UInt32 channels,
+                             Float32 gain, Float32 gainStep, ChannelLevels* levels)
+{
+    GainRampAVXImpl<true>(dst, src, numFrames, channels, gain, gainStep, levels);
+}
+
+#endif
+
+// ============================================================================
+// arm64 — NEON is always available
+// ============================================================================
+
+#if defined(PULSE_GAIN_NEON)
+
+template <UInt32 kChannels, bool kMeter>
+static void GainRampNEONBlocks(float* dst, const float* src, UInt32 numFrames,
+                               Float32 gain, Float32 gainStep, ChannelLevels* levels)
+{
+    const UInt32 kWidth   = 4;
+    const UInt32 kBlock   = BlockSamples(kChannels, kWidth);
+    const UInt32 kVectors = kBlock / kWidth;
+
+    UInt32 numSamples = numFrames * kChannels;
+    UInt32 vecSamples = numSamples - numSamples % kBlock;
+
+    float lanes[kBlock];
+    BlockLaneGains<kChannels, kBlock>(lanes, gain, gainStep);
+    float32x4_t g[kVectors];
+    for (UInt32 v = 0; v < kVectors; v++) g[v] = vld1q_f32(lanes + v * kWidth);
+    float32x4_t step = vdupq_n_f32(gainStep * (Float32)(kBlock / kChannels));
+
+    // vmaxnmq ignores a NaN operand
+    float32x4_t peak[2][kVectors], sum[2][kVectors];
+    for (UInt32 v = 0; v < kVectors; v++) {
+        peak[0][v] = peak[1][v] = sum[0][v] = sum[1][v] = vdupq_n_f32(0.0f);
+    }
+
+    UInt32 i = 0;
+    if (kMeter) {
+        for (; i + 2 * kBlock <= vecSamples; i += 2 * kBlock) {
+            for (UInt32 u = 0; u < 2; u++) {
+                for (UInt32 v = 0; v < kVectors; v++) {
+                    UInt32 at = i + u * kBlock + v * kWidth;
+                    float32x4_t out = vmulq_f32(vld1q_f32(src + at), g[v]);
+                    vst1q_f32(dst + at, out);
+                    g[v] = vaddq_f32(g[v], step);
+                    peak[u][v] = vmaxnmq_f32(peak[u][v], vabsq_f32(out));
+                    sum[u][v]  = vfmaq_f32(sum[u][v], out, out);
+                }
+            }
+        }
+    }
+    for (; i < vecSamples; i += kBlock) {
+        for (UInt32 v = 0; v < kVectors; v++) {
+            UInt32 at = i + v * kWidth;
+            float32x4_t out = vmulq_f32(vld1q_f32(src + at), g[v]);
+            vst1q_f32(dst + at, out);
+            g[v] = vaddq_f32(g[v], step);
+            if (kMeter) {
+                peak[0][v] = vmaxnmq_f32(peak[0][v], vabsq_f32(out));
+                sum[0][v]  = vfmaq_f32(sum[0][v], out, out);
+            }
+        }
+    }
+
+    if (kMeter) {
+        float peaks[kBlock], sumSquares[kBlock];
+        for (UInt32 v = 0; v < kVectors; v++) {
+            vst1q_f32(peaks + v * kWidth, vmaxnmq_f32(peak[0][v], peak[1][v]));
+            vst1q_f32(sumSquares + v * kWidth, vaddq_f32(sum[0][v], sum[1][v]));
+        }
+        FoldLaneLevels<kChannels, kBlock>(levels, peaks, sumSquares);
+    }
+
+    if (vecSamples < numSamples) {
+        GainRampTail<kChannels, kMeter>(dst, src, numFrames, gain, gainStep, vecSamples, levels);
+    }
+}
+
+template <bool kMeter>
+static void GainRampNEONImpl(float* dst, const float* src, UInt32 numFrames, UInt32 channels,
+                             Float32 gain, Float32 gainStep, ChannelLevels* levels)
+{
+    switch (channels) {
+        case 1: GainRampNEONBlocks<1, kMeter>(dst, src, numFrames, gain, gainStep, levels); break;
+        case 2: GainRampNEONBlocks<2, kMeter>(dst, src, numFrames, gain, gainStep, levels); break;
+        case 6: GainRampNEONBlocks<6, kMeter>(dst, src, numFrames, gain, gainStep, levels); break;
+        case 8: GainRampNEONBlocks<8, kMeter>(dst, src, numFrames, gain, gainStep, levels); break;
+        default: GainRampScalarImpl<kMeter>(dst, src, numFrames, channels, gain, gainStep, levels); break;
+    }
+}
+
+static void GainRampNEON(float* dst, const float* src, UInt32 numFrames, UInt32 channels,
+                         Float32 gain, Float32 gainStep)
+{
+    GainRampNEONImpl<false>(dst, src, numFrames, channels, gain, gainStep, nullptr);
+}
+
+static void GainRampMeterNEON(float* dst, const float* src, UInt32 numFrames, UInt32 channels,
+                              Float32 gain, Float32 gainStep, ChannelLevels* levels)
+{
+    GainRampNEONImpl<true>(dst, src, numFrames, channels, gain, gainStep, levels);
+}
+
+#endif
+
+// ============================================================================
+// Runtime selection
+// ============================================================================
+
+struct GainKernelTable {
+    GainKernel kernels[3];
+    UInt32     count;
+
+    GainKernelTable() : count(0) {
+#if defined(PULSE_GAIN_X86)
+        if (__builtin_cpu_supports("avx")) {
+            kernels[count++] = GainKernel{ "avx", GainRampAVX, GainRampMeterAVX };
+        }
+        kernels[count++] = GainKernel{ "sse", GainRampSSE, GainRampMeterSSE };
+#elif defined(PULSE_GAIN_NEON)
+        kernels[count++] = GainKernel{ "neon", GainRampNEON, GainRampMeterNEON };
+#endif
+        kernels[count++] = GainKernel{ "scalar", GainRampScalar, GainRampMeterScalar };
+    }
+};
+
+// Function-local static: initialized once, thread-safe, before the first IO cycle
+static const GainKernelTable& KernelTable()
+{
+    static const GainKernelTable sTable;
+    return sTable;
+}
+
+static const GainRampFn      sGainRamp      = KernelTable().kernels[0].ramp;
+static const GainRampMeterFn sGainRampMeter = KernelTable().kernels[0].rampMeter;
+
+const GainKernel* GetGainKernels(UInt32* outCount)
+{
+    const GainKernelTable& table = KernelTable();
+    *outCount = table.count;
+    return table.kernels;
+}
+
+void ApplyGainRamp(float* dst, const float* src, UInt32 numFrames, UInt32 channels,
+                   Float32 gain, Float32 gainStep)
+{
+    sGainRamp(dst, src, numFrames, channels, gain, gainStep);
+}
+
+void ApplyGainRampMetered(float* dst, const float* src, UInt32 numFrames, UInt32 channels,
+                          Float32 gain, Float32 gainStep, ChannelLevels* levels)
+{
+    sGainRampMeter(dst, src, numFrames, channels, gain, gainStep, levels);
+}
+
+void ApplyGain(float* dst, const float* src, UInt32 numSamples, Float32 gain)
+{
+    sGainRamp(dst, src, numSamples, 1, gain, 0.0f);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "platform.h"
+#include "types.h"
+
+// Gain ramp kernel: scale numFrames interleaved frames of `channels` samples from
+// src into dst. Frame i gets gain + i * gainStep, so a constant gain is a ramp
+// with a zero step. dst may alias src for in-place scaling.
+typedef void (*GainRampFn)(float* dst, const float* src, UInt32 numFrames, UInt32 channels,
+                           Float32 gain, Float32 gainStep);
+
+// Per-channel levels of the samples a metering kernel wrote: the largest
+// absolute value and the sum of squares. Kernels accumulate into what is
+// already there, so a ring write split in two regions meters as one.
+// NaN samples are left out of the peak.
+struct ChannelLevels {
+    Float32 peak[kMaxNumChannels];
+    Float32 sumSquares[kMaxNumChannels];
+};
+
+// Gain ramp that also meters its output, in the same pass. channels must not
+// exceed kMaxNumChannels.
+typedef void (*GainRampMeterFn)(float* dst, const float* src, UInt32 numFrames, UInt32 channels,
+                                Float32 gain, Float32 gainStep, ChannelLevels* levels);
+
+struct GainKernel {
+    const char*     name;
+    GainRampFn      ramp;
+    GainRampMeterFn rampMeter;
+};
+
+// All kernels usable on this CPU, best first. The first entry is the one
+// ApplyGainRamp() dispatches to.
+const GainKernel* GetGainKernels(UInt32* outCount);
+
+// Scale using the best kernel for this CPU (selected once at startup).
+void ApplyGainRamp(float* dst, const float* src, UInt32 numFrames, UInt32 channels,
+                   Float32 gain, Float32 gainStep);
+
+void ApplyGainRampMetered(float* dst, const float* src, UInt32 numFrames, UInt32 channels,
+                          Float32 gain, Float32 gainStep, ChannelLevels* levels);
+
+// Scale numSamples interleaved samples from src into dst by a constant gain.
+// dst may alias src for in-place scaling.
+void ApplyGain(float* dst, const float* src, UInt32 numSamples, Float32 gain);
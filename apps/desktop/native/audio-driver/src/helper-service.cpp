@@ -0,0 +1,384 @@
+#include "helper-service.h"
+#include <cstdlib>
+#include <sys/types.h>
+#include "ndjson.h"
+
+HelperService::HelperService(DeviceBackend& backend)
+    : mBackend(backend)
+    , mDevices(backend)
+    , mSession()
+    , mHasSession(false)
+    , mShutdownRequested(false)
+    , mWaitTimeout(kDefaultWaitTimeout)
+{
+}
+
+// ============================================================================
+// Commands
+// ============================================================================
+
+OSStatus HelperService::GetDefaultOutput(AudioDeviceInfo* outDevice)
+{
+    AudioObjectID deviceId = kAudioObjectUnknown;
+    OSStatus err = mBackend.GetDefaultOutput(&deviceId);
+    if (err != kAudioHardwareNoError) return err;
+
+    // The default can be a device the table hasn't caught up with yet
+    const AudioDeviceInfo* device = FindDevice(deviceId);
+    if (!device) {
+        InvalidateDevices();
+        device = FindDevice(deviceId);
+    }
+    if (!device) return kAudioHardwareBadObjectError;
+
+    *outDevice = *device;
+    return kAudioHardwareNoError;
+}
+
+OSStatus HelperService::SetDefaultOutput(AudioObjectID deviceId)
+{
+    OSStatus err = mBackend.SetDefaultOutput(deviceId);
+    if (err != kAudioHardwareNoError) {
+        fprintf(stderr, "Failed to set default output: %d\n", (int)err);
+        return err;
+    }
+
+    // The HAL can accept the change and still not make it; only the
+    // default actually switching counts
+    AudioObjectID current = kAudioObjectUnknown;
+    bool switched = mBackend.Events().WaitUntil(mWaitTimeout, [&] {
+        return mBackend.GetDefaultOutput(&current) == kAudioHardwareNoError && current == deviceId;
+    });
+    if (!switched) {
+        fprintf(stderr, "Default output is still %u after %lld ms (wanted %u)\n",
+                (unsigned)current, (long long)mWaitTimeout.count(), (unsigned)deviceId);
+        return kAudioHardwareUnspecifiedError;
+    }
+    return kAudioHardwareNoError;
+}
+
+OSStatus HelperService::CreateAggregate(const std::string& realOutputUID, AudioObjectID* outDeviceId)
+{
+    // Multi-output, clocked by the real device: audio plays through the
+    // speakers and is sent to the Pulse device for capture
+    std::vector<std::string> subDevices;
+    subDevices.push_back(realOutputUID);
+    subDevices.push_back(kPulseDeviceUID);
+
+    AudioObjectID aggregateId = kAudioObjectUnknown;
+    OSStatus err = mBackend.CreateAggregate(kAggregateUID, kAggregateName, subDevices, realOutputUID,
+                                            &aggregateId);
+    InvalidateDevices();
+    if (err != kAudioHardwareNoError) return err;
+
+    // Usable once it's alive; a device that never comes up is removed again
+    bool alive = mBackend.Events().WaitUntil(mWaitTimeout, [&] {
+        return mBackend.IsDeviceAlive(aggregateId);
+    });
+    if (!alive) {
+        fprintf(stderr, "Aggregate device %u not alive after %lld ms\n",
+                (unsigned)aggregateId, (long long)mWaitTimeout.count());
+        DestroyAggregateAndWait(aggregateId);
+        return kAudioHardwareNotRunningError;
+    }
+
+    *outDeviceId = aggregateId;
+    return kAudioHardwareNoError;
+}
+
+OSStatus HelperService::DestroyAggregate()
+{
+    AudioObjectID aggregateId = FindDeviceId(kAggregateUID);
+    if (aggregateId == kAudioObjectUnknown) return kAudioHardwareNoError;   // already gone
+
+    return DestroyAggregateAndWait(aggregateId);
+}
+
+OSStatus HelperService::DestroyAggregateAndWait(AudioObjectID aggregateId)
+{
+    OSStatus err = mBackend.DestroyAggregate(aggregateId);
+    InvalidateDevices();
+    if (err != kAudioHardwareNoError) return err;
+
+    // Gone, and the system has moved the default output off it. Running
+    // on after the deadline is harmless, so that's only a warning.
+    bool gone = mBackend.Events().WaitUntil(mWaitTimeout, [&] {
+        AudioObjectID current = kAudioObjectUnknown;
+        return !mBackend.IsDeviceAlive(aggregateId) &&
+               mBackend.GetDefaultOutput(&current) == kAudioHardwareNoError && current != aggregateId;
+    });
+    if (!gone) {
+        fprintf(stderr, "Warning: aggregate device %u still present after %lld ms\n",
+                (unsigned)aggregateId, (long long)mWaitTimeout.count());
+    }
+    InvalidateDevices();
+    return kAudioHardwareNoError;
+}
+
+OSStatus HelperService::StartCapture(CaptureSession* outSession)
+{
+    // 1. Current default output
+    AudioDeviceInfo saved;
+    OSStatus err = GetDefaultOutput(&saved);
+    if (err != kAudioHardwareNoError) {
+        fprintf(stderr, "Failed to get current default output: %d\n", (int)err);
+        return err;
+    }
+    fprintf(stderr, "[audio-capture] Current default: %s (%s, ID %u)\n",
+            saved.name.c_str(), saved.uid.c_str(), (unsigned)saved.id);
+
+    // 2. Destroy any leftover aggregate, then re-read the default, which
+    // moves off the aggregate if it was left as the default
+    DestroyAggregate();
+    err = GetDefaultOutput(&saved);
+    if (err != kAudioHardwareNoError) {
+        fprintf(stderr, "Failed to re-read default output after cleanup: %d\n", (int)err);
+        return err;
+    }
+
+    // 3. Multi-output aggregate over the real output and Pulse Audio
+    AudioObjectID aggregateId = kAudioObjectUnknown;
+    err = CreateAggregate(saved.uid, &aggregateId);
+    if (err != kAudioHardwareNoError) {
+        fprintf(stderr, "Failed to create aggregate device: %d\n", (int)err);
+        return err;
+    }
+    fprintf(stderr, "[audio-capture] Created aggregate device (ID %u)\n", (unsigned)aggregateId);
+
+    // 4. Make it the default output
+    err = SetDefaultOutput(aggregateId);
+    if (err != kAudioHardwareNoError) {
+        fprintf(stderr, "Failed to set aggregate as default output, cleaning up: %d\n", (int)err);
+        DestroyAggregateAndWait(aggregateId);
+        return err;
+    }
+    fprintf(stderr, "[audio-capture] Set aggregate as default output\n");
+
+    mSession.savedDeviceId = saved.id;
+    mSession.savedUID      = saved.uid;
+    mSession.savedName     = saved.name;
+    mSession.aggregateId   = aggregateId;
+    mHasSession = true;
+    *outSession = mSession;
+    return kAudioHardwareNoError;
+}
+
+OSStatus HelperService::StopCapture(AudioObjectID savedDeviceId, const std::string& savedUID,
+                                    AudioObjectID* outRestoredId)
+{
+    *outRestoredId = kAudioObjectUnknown;
+    fprintf(stderr, "[audio-capture] Restoring default output to device %u\n", (unsigned)savedDeviceId);
+
+    // Destroy the aggregate first; the saved device may get a new ID, so
+    // prefer finding it again by UID
+    OSStatus err = DestroyAggregate();
+    if (err != kAudioHardwareNoError) {
+        fprintf(stderr, "[audio-capture] Warning: could not destroy aggregate: %d\n", (int)err);
+    }
+
+    AudioObjectID target = savedDeviceId;
+    if (!savedUID.empty()) {
+        AudioObjectID found = FindDeviceId(savedUID);
+        if (found != kAudioObjectUnknown) target = found;
+    }
+
+    if (target != kAudioObjectUnknown) {
+        err = SetDefaultOutput(target);
+        if (err == kAudioHardwareNoError) {
+            *outRestoredId = target;
+        } else {
+            fprintf(stderr, "[audio-capture] Warning: could not restore saved device %u: %d\n",
+                    (unsigned)target, (int)err);
+        }
+    }
+
+    mHasSession = false;
+    return kAudioHardwareNoError;
+}
+
+// ============================================================================
+// serve
+// ============================================================================
+
+static std::string ErrorResponse(const std::string& id, const std::string& message)
+{
+    JsonWriter json;
+    json.BeginObject();
+    json.Key("id").Raw(id);
+    json.Key("ok").Bool(false);
+    json.Key("error").String(message);
+    json.EndObject();
+    return json.Text();
+}
+
+static std::string FailedResponse(const std::string& id, const std::string& cmd, OSStatus err)
+{
+    return ErrorResponse(id, cmd + " failed: " + std::to_string((int)err));
+}
+
+// Device ID argument: a whole number that fits an AudioObjectID
+static bool GetDeviceIdArg(const JsonObject& request, AudioObjectID* outDeviceId)
+{
+    JsonObject::const_iterator it = request.find("deviceId");
+    if (it == request.end() || it->second.type != JsonScalar::kNumber) return false;
+
+    double value = it->second.number;
+    if (value < 0 || value > 4294967295.0 || value != (double)(UInt64)value) return false;
+    *outDeviceId = (AudioObjectID)value;
+    return true;
+}
+
+static std::string FourCCString(UInt32 code)
+{
+    std::string text;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        char c = (char)((code >> shift) & 0xFF);
+        text.push_back((c >= 0x20 && c < 0x7F) ? c : '?');
+    }
+    return text;
+}
+
+static void WriteDevice(JsonWriter& json, const AudioDeviceInfo& device)
+{
+    json.BeginObject();
+    json.Key("deviceId").UInt(device.id);
+    json.Key("uid").String(device.uid);
+    json.Key("name").String(device.name);
+    json.Key("outputStreams").UInt(device.outputStreams);
+    json.Key("inputStreams").UInt(device.inputStreams);
+    json.Key("transport").String(FourCCString(device.transportType));
+    json.EndObject();
+}
+
+std::string HelperService::HandleRequest(const std::string& line)
+{
+    JsonObject request;
+    std::string parseError;
+    if (!ParseJsonObject(line, &request, &parseError)) {
+        return ErrorResponse("null", "bad request: " + parseError);
+    }
+
+    JsonObject::const_iterator idField = request.find("id");
+    std::string id = (idField != request.end()) ? idField->second.raw : "null";
+
+    JsonObject::const_iterator cmdField = request.find("cmd");
+    if (cmdField == request.end() || cmdField->second.type != JsonScalar::kString) {
+        return ErrorResponse(id, "missing cmd");
+    }
+    const std::string& cmd = cmdField->second.string;
+
+    // Handlers write the result object's members
+    JsonWriter result;
+    result.BeginObject();
+
+    if (cmd == "ping") {
+        // Nothing to do
+    } else if (cmd == "shutdown") {
+        mShutdownRequested = true;
+    } else if (cmd == "detect") {
+        AudioObjectID pulseId = FindDeviceId(kPulseDeviceUID);
+        result.Key("present").Bool(pulseId != kAudioObjectUnknown);
+        if (pulseId != kAudioObjectUnknown) result.Key("deviceId").UInt(pulseId);
+    } else if (cmd == "refresh") {
+        InvalidateDevices();
+        OSStatus err;
+        const std::vector<AudioDeviceInfo>* devices = Devices(&err);
+        if (!devices) return FailedResponse(id, cmd, err);
+        result.Key("devices").UInt(devices->size());
+    } else if (cmd == "list-devices") {
+        OSStatus err;
+        const std::vector<AudioDeviceInfo>* devices = Devices(&err);
+        if (!devices) return FailedResponse(id, cmd, err);
+        result.Key("devices").BeginArray();
+        for (const AudioDeviceInfo& device : *devices) WriteDevice(result, device);
+        result.EndArray();
+
+        AudioObjectID defaultOutput = kAudioObjectUnknown;
+        mBackend.GetDefaultOutput(&defaultOutput);
+        result.Key("defaultOutput").UInt(defaultOutput);
+    } else if (cmd == "get-default") {
+        AudioDeviceInfo device;
+        OSStatus err = GetDefaultOutput(&device);
+        if (err != kAudioHardwareNoError) return FailedResponse(id, cmd, err);
+        result.Key("deviceId").UInt(device.id);
+        result.Key("uid").String(device.uid);
+        result.Key("name").String(device.name);
+    } else if (cmd == "set-default") {
+        AudioObjectID deviceId;
+        if (!GetDeviceIdArg(request, &deviceId)) return ErrorResponse(id, "set-default needs a deviceId");
+        OSStatus err = SetDefaultOutput(deviceId);
+        if (err != kAudioHardwareNoError) return FailedResponse(id, cmd, err);
+    } else if (cmd == "create-aggregate") {
+        JsonObject::const_iterator uid = request.find("uid");
+        if (uid == request.end() || uid->second.type != JsonScalar::kString) {
+            return ErrorResponse(id, "create-aggregate needs a uid");
+        }
+        AudioObjectID deviceId = kAudioObjectUnknown;
+        OSStatus err = CreateAggregate(uid->second.string, &deviceId);
+        if (err != kAudioHardwareNoError) return FailedResponse(id, cmd, err);
+        result.Key("deviceId").UInt(deviceId);
+        result.Key("uid").String(kAggregateUID);
+    } else if (cmd == "destroy-aggregate") {
+        OSStatus err = DestroyAggregate();
+        if (err != kAudioHardwareNoError) return FailedResponse(id, cmd, err);
+    } else if (cmd == "start-capture") {
+        CaptureSession session;
+        OSStatus err = StartCapture(&session);
+        if (err != kAudioHardwareNoError) return FailedResponse(id, cmd, err);
+        result.Key("savedDeviceId").UInt(session.savedDeviceId);
+        result.Key("savedUID").String(session.savedUID);
+        result.Key("savedName").String(session.savedName);
+        result.Key("aggregateId").UInt(session.aggregateId);
+        result.Key("pulseDeviceUID").String(kPulseDeviceUID);
+    } else if (cmd == "stop-capture") {
+        AudioObjectID savedDeviceId = kAudioObjectUnknown;
+        std::string   savedUID;
+        if (request.count("deviceId")) {
+            if (!GetDeviceIdArg(request, &savedDeviceId)) return ErrorResponse(id, "bad deviceId");
+        } else if (mHasSession) {
+            savedDeviceId = mSession.savedDeviceId;
+            savedUID      = mSession.savedUID;
+        }
+        AudioObjectID restoredId;
+        OSStatus err = StopCapture(savedDeviceId, savedUID, &restoredId);
+        if (err != kAudioHardwareNoError) return FailedResponse(id, cmd, err);
+        result.Key("restoredDeviceId").UInt(restoredId);
+    } else {
+        return ErrorResponse(id, "unknown cmd: " + cmd);
+    }
+
+    result.EndObject();
+
+    JsonWriter response;
+    response.BeginObject();
+    response.Key("id").Raw(id);
+    response.Key("ok").Bool(true);
+    response.Key("result").Raw(result.Text());
+    response.EndObject();
+    return response.Text();
+}
+
+void HelperService::Serve(FILE* in, FILE* out)
+{
+    char*   line     = nullptr;
+    size_t  capacity = 0;
+    ssize_t length;
+
+    while (!mShutdownRequested && (length = getline(&line, &capacity, in)) >= 0) {
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) length--;
+        if (length == 0) continue;
+
+        std::string response = HandleRequest(std::string(line, (size_t)length));
+        fputs(response.c_str(), out);
+        fputc('\n', out);
+        if (fflush(out) != 0) break;   // the client went away
+    }
+    free(line);
+
+    // A client that exits or crashes mid-capture must not leave the
+    // aggregate as the default output
+    if (mHasSession) {
+        AudioObjectID restoredId;
+        StopCapture(mSession.savedDeviceId, mSession.savedUID, &restoredId);
+    }
+}
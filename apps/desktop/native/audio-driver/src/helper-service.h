@@ -0,0 +1,106 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "device-backend.h"
+#include "device-registry.h"
+
+static const char* const kPulseDeviceUID = "com.pulse.audio.device";
+static const char* const kAggregateUID   = "com.pulse.aggregate.screenshare";
+static const char* const kAggregateName  = "Pulse Screen Share";
+
+// State of a running capture: what to restore on stop
+struct CaptureSession {
+    AudioObjectID savedDeviceId;
+    std::string   savedUID;
+    std::string   savedName;
+    AudioObjectID aggregateId;
+};
+
+// pulse-audio-helper's command logic over a DeviceBackend. The one-shot CLI
+// commands and `serve` share it; serve keeps one instance alive, so its
+// DeviceRegistry enumerates once and only again after the backend reports
+// a device list change (or after this service adds or removes a device).
+//
+// `serve` protocol: newline-delimited JSON on stdin/stdout. Each request is
+// a flat object with a "cmd" and an optional "id", echoed in the response:
+//
+//   {"id":1,"cmd":"detect"}
+//   {"id":1,"ok":true,"result":{"present":true,"deviceId":42}}
+//   {"id":2,"cmd":"set-default","deviceId":99}
+//   {"id":2,"ok":false,"error":"set-default failed: 560947818"}
+//
+// Commands and results:
+//   detect                  {present, deviceId}
+//   get-default             {deviceId, uid, name}
+//   set-default deviceId    {}
+//   list-devices            {devices: [{deviceId, uid, name, outputStreams, inputStreams, transport}], defaultOutput}
+//   create-aggregate uid    {deviceId, uid}
+//   destroy-aggregate       {}
+//   start-capture           {savedDeviceId, savedUID, savedName, aggregateId, pulseDeviceUID}
+//   stop-capture [deviceId] {restoredDeviceId}; without deviceId restores the
+//                           device start-capture saved, looked up by UID
+//   refresh                 {devices}; re-enumerates now
+//   ping                    {}
+//   shutdown                {}; then the loop exits
+// Requests are handled in order, one at a time. When stdin closes (the
+// client quit or crashed) a running capture is stopped before exiting.
+class HelperService {
+public:
+    explicit HelperService(DeviceBackend& backend);
+
+    // Cached device table, re-enumerated when stale
+    const std::vector<AudioDeviceInfo>* Devices(OSStatus* outStatus = nullptr) { return mDevices.Devices(outStatus); }
+    const AudioDeviceInfo* FindDevice(const std::string& uid) { return mDevices.Find(uid); }
+    const AudioDeviceInfo* FindDevice(AudioObjectID deviceId) { return mDevices.Find(deviceId); }
+    void     InvalidateDevices() { mDevices.Invalidate(); }
+
+    // Just the ID, without enumerating; kAudioObjectUnknown if absent
+    AudioObjectID FindDeviceId(const std::string& uid) { return mDevices.TranslateUID(uid); }
+
+    // Commands shared with the one-shot CLI. Progress goes to stderr.
+    // Changes return once the system reflects them: the default output has
+    // switched, the aggregate is alive, or it's gone. Each wait follows the
+    // backend's change notifications and fails after the wait timeout.
+    OSStatus GetDefaultOutput(AudioDeviceInfo* outDevice);
+    OSStatus SetDefaultOutput(AudioObjectID deviceId);
+    OSStatus CreateAggregate(const std::string& realOutputUID, AudioObjectID* outDeviceId);
+    OSStatus DestroyAggregate();
+
+    static constexpr std::chrono::milliseconds kDefaultWaitTimeout{2000};
+    void     SetWaitTimeout(std::chrono::milliseconds timeout) { mWaitTimeout = timeout; }
+
+    // The full capture flow: save the default output, replace any leftover
+    // aggregate with a multi-output one over it and the Pulse device, and
+    // make that the default. On failure nothing is left behind.
+    OSStatus StartCapture(CaptureSession* outSession);
+
+    // Destroy the aggregate and restore the saved default output. A device
+    // that can't be restored is only a warning, as the system falls back to
+    // its own default. Outputs the device restored, or kAudioObjectUnknown.
+    OSStatus StopCapture(AudioObjectID savedDeviceId, const std::string& savedUID,
+                         AudioObjectID* outRestoredId);
+
+    // Session of the last StartCapture() on this instance
+    const CaptureSession* ActiveSession() const { return mHasSession ? &mSession : nullptr; }
+
+    // Handle one request line; returns the response line without a newline
+    std::string HandleRequest(const std::string& line);
+    bool     IsShutdownRequested() const { return mShutdownRequested; }
+
+    // Read requests from in and answer on out until EOF or shutdown. A
+    // capture still running then is stopped, as the client is gone.
+    void     Serve(FILE* in, FILE* out);
+
+private:
+    OSStatus DestroyAggregateAndWait(AudioObjectID aggregateId);
+
+    DeviceBackend&               mBackend;
+    DeviceRegistry               mDevices;
+    CaptureSession               mSession;
+    bool                         mHasSession;
+    bool                         mShutdownRequested;
+    std::chrono::milliseconds    mWaitTimeout;
+};
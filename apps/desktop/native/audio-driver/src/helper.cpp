@@ -1,5 +1,6 @@
 // pulse-audio-helper: Standalone CLI for CoreAudio aggregate device management.
-// Used by the Electron main process via execSync instead of a N-API addon.
+// Used by the Electron main process, either one command per process or as a
+// resident `serve` process speaking newline-delimited JSON (see helper-service.h).
 //
 // Commands:
 //   detect                        — exits 0 if Pulse Audio device found, 1 otherwise
@@ -10,6 +11,14 @@
 //   start-capture                 — full capture flow: save default, create aggregate, set default, print result
 //   stop-capture <saved-device-id>— restore default, destroy aggregate
 //   list-devices                  — list all audio devices (for debugging)
+//   buffer-config [<cap> <target>]— print or set ring capacity / target fill, prints "capacity|target"
+//   stats                         — print the driver's IO counters, one "key=value" per line;
+//                                   histograms print as comma-separated log2 bucket counts
+//   meter [<interval-ms>]         — stream output levels until killed, one line per poll with new
+//                                   data: "periods|peak,peak,...|rms,rms,..." (linear, 1.0 = full scale)
+//   serve [--mock]                — stay resident and answer NDJSON requests on stdin/stdout,
+//                                   keeping the device table cached between them; --mock runs
+//                                   against an in-memory device set instead of CoreAudio
 
 #include <CoreAudio/CoreAudio.h>
 #include <CoreFoundation/CoreFoundation.h>
@@ -18,209 +27,49 @@
 #include <cstdlib>
 #include <cstring>
 #include <unistd.h>
-
-static const char* kPulseDeviceUID = "com.pulse.audio.device";
-static const char* kAggregateUID = "com.pulse.aggregate.screenshare";
-static const char* kAggregateName = "Pulse Screen Share";
+#include <algorithm>
+#include <vector>
+#include "coreaudio-device-backend.h"
+#include "helper-service.h"
+#include "mock-device-backend.h"
+#include "types.h"
 
 // ============================================================================
 // Helpers
 // ============================================================================
 
-static CFStringRef ToCFString(const char* str) {
-    return CFStringCreateWithCString(kCFAllocatorDefault, str, kCFStringEncodingUTF8);
-}
-
 static void CFStringToBuffer(CFStringRef cfStr, char* buf, size_t bufSize) {
     if (!cfStr || !CFStringGetCString(cfStr, buf, (CFIndex)bufSize, kCFStringEncodingUTF8)) {
         buf[0] = '\0';
     }
 }
 
-// Set the default output device using AudioObjectSetPropertyData.
-// Returns true on success.
-static bool setDefaultOutput(AudioObjectID deviceId) {
-    AudioObjectPropertyAddress prop = {
-        kAudioHardwarePropertyDefaultOutputDevice,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
-
-    OSStatus err = AudioObjectSetPropertyData(
-        kAudioObjectSystemObject, &prop, 0, nullptr, sizeof(deviceId), &deviceId);
-    if (err != noErr) {
-        fprintf(stderr, "AudioObjectSetPropertyData failed: %d\n", (int)err);
-        return false;
-    }
-
-    // Give CoreAudio time to process
-    usleep(200000); // 200ms
-
-    // Verify
-    AudioObjectID currentDefault = 0;
-    UInt32 size = sizeof(currentDefault);
-    err = AudioObjectGetPropertyData(kAudioObjectSystemObject, &prop, 0, nullptr, &size, &currentDefault);
-    if (err == noErr && currentDefault == deviceId) {
-        return true;
-    }
-
-    fprintf(stderr, "AudioObjectSetPropertyData returned noErr but default is %u (wanted %u)\n",
-            (unsigned)currentDefault, (unsigned)deviceId);
-    return false;
+static void SetDictionaryUInt32(CFMutableDictionaryRef dict, CFStringRef key, UInt32 value) {
+    SInt64 wide = value;
+    CFNumberRef number = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt64Type, &wide);
+    CFDictionarySetValue(dict, key, number);
+    CFRelease(number);
 }
 
-// Get the current default output device ID and UID.
-static bool getDefaultOutput(AudioObjectID& outDeviceId, char* outUID, size_t uidBufSize, char* outName, size_t nameBufSize) {
-    AudioObjectPropertyAddress prop = {
-        kAudioHardwarePropertyDefaultOutputDevice,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
-
-    UInt32 size = sizeof(outDeviceId);
-    OSStatus err = AudioObjectGetPropertyData(kAudioObjectSystemObject, &prop, 0, nullptr, &size, &outDeviceId);
-    if (err != noErr) return false;
-
-    // UID
-    AudioObjectPropertyAddress uidProp = {
-        kAudioDevicePropertyDeviceUID,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
-    CFStringRef uid = nullptr;
-    UInt32 uidSize = sizeof(CFStringRef);
-    err = AudioObjectGetPropertyData(outDeviceId, &uidProp, 0, nullptr, &uidSize, &uid);
-    if (err != noErr) return false;
-    CFStringToBuffer(uid, outUID, uidBufSize);
-    CFRelease(uid);
-
-    // Name
-    AudioObjectPropertyAddress nameProp = {
-        kAudioObjectPropertyName,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
-    CFStringRef name = nullptr;
-    UInt32 nameSize = sizeof(CFStringRef);
-    err = AudioObjectGetPropertyData(outDeviceId, &nameProp, 0, nullptr, &nameSize, &name);
-    if (err != noErr) {
-        outName[0] = '\0';
-        return true; // UID is enough
+static UInt64 GetDictionaryUInt64(CFDictionaryRef dict, CFStringRef key) {
+    CFTypeRef value = CFDictionaryGetValue(dict, key);
+    SInt64 wide = 0;
+    if (value && CFGetTypeID(value) == CFNumberGetTypeID()) {
+        CFNumberGetValue((CFNumberRef)value, kCFNumberSInt64Type, &wide);
     }
-    CFStringToBuffer(name, outName, nameBufSize);
-    CFRelease(name);
-    return true;
+    return (UInt64)wide;
 }
 
-// Create the multi-output aggregate device. Returns the device ID (0 on failure).
-static AudioObjectID createAggregate(const char* realOutputUID) {
-    CFStringRef aggUID = ToCFString(kAggregateUID);
-    CFStringRef aggName = ToCFString(kAggregateName);
-    CFStringRef realUID = ToCFString(realOutputUID);
-    CFStringRef pulseUID = ToCFString(kPulseDeviceUID);
-
-    // Build sub-device list
-    CFMutableArrayRef subDevices = CFArrayCreateMutable(kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks);
-
-    // Real output device
-    CFMutableDictionaryRef realDict = CFDictionaryCreateMutable(kCFAllocatorDefault, 0,
-        &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
-    CFDictionarySetValue(realDict, CFSTR(kAudioSubDeviceUIDKey), realUID);
-    CFArrayAppendValue(subDevices, realDict);
-    CFRelease(realDict);
-
-    // Pulse Audio virtual device
-    CFMutableDictionaryRef pulseDict = CFDictionaryCreateMutable(kCFAllocatorDefault, 0,
-        &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
-    CFDictionarySetValue(pulseDict, CFSTR(kAudioSubDeviceUIDKey), pulseUID);
-    CFArrayAppendValue(subDevices, pulseDict);
-    CFRelease(pulseDict);
-
-    // Aggregate device description
-    CFMutableDictionaryRef desc = CFDictionaryCreateMutable(kCFAllocatorDefault, 0,
-        &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
-
-    CFDictionarySetValue(desc, CFSTR(kAudioAggregateDeviceUIDKey), aggUID);
-    CFDictionarySetValue(desc, CFSTR(kAudioAggregateDeviceNameKey), aggName);
-    CFDictionarySetValue(desc, CFSTR(kAudioAggregateDeviceSubDeviceListKey), subDevices);
-
-    // Use the real device as the clock source
-    CFDictionarySetValue(desc, CFSTR(kAudioAggregateDeviceMainSubDeviceKey), realUID);
-
-    // Multi-output mode (NOT stacked, NOT private).
-    // Multi-output routes audio to all sub-devices simultaneously — audio plays
-    // through the real speakers AND gets sent to the Pulse virtual device for capture.
-
-    // Create the aggregate device
-    AudioObjectID aggregateId = 0;
-    OSStatus err = AudioHardwareCreateAggregateDevice(desc, &aggregateId);
-
-    CFRelease(desc);
-    CFRelease(subDevices);
-    CFRelease(aggUID);
-    CFRelease(aggName);
-    CFRelease(realUID);
-    CFRelease(pulseUID);
-
-    if (err != noErr) {
-        fprintf(stderr, "Failed to create aggregate device: %d\n", (int)err);
-        return 0;
-    }
-
-    // Wait for CoreAudio to fully initialize the aggregate device
-    usleep(500000); // 500ms
-
-    return aggregateId;
+// One-shot commands run against CoreAudio through the same service as serve
+static HelperService& Service() {
+    static CoreAudioDeviceBackend backend;
+    static HelperService service(backend);
+    return service;
 }
 
-// Destroy the aggregate device by finding it by UID.
-static bool destroyAggregate() {
-    AudioObjectPropertyAddress prop = {
-        kAudioHardwarePropertyDevices,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
-
-    UInt32 dataSize = 0;
-    OSStatus err = AudioObjectGetPropertyDataSize(kAudioObjectSystemObject, &prop, 0, nullptr, &dataSize);
-    if (err != noErr) return false;
-
-    UInt32 deviceCount = dataSize / sizeof(AudioObjectID);
-    auto* devices = new AudioObjectID[deviceCount];
-    err = AudioObjectGetPropertyData(kAudioObjectSystemObject, &prop, 0, nullptr, &dataSize, devices);
-    if (err != noErr) { delete[] devices; return false; }
-
-    AudioObjectPropertyAddress uidProp = {
-        kAudioDevicePropertyDeviceUID,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
-
-    CFStringRef targetUID = ToCFString(kAggregateUID);
-    AudioObjectID aggregateId = 0;
-
-    for (UInt32 i = 0; i < deviceCount; i++) {
-        CFStringRef uid = nullptr;
-        UInt32 uidSize = sizeof(CFStringRef);
-        err = AudioObjectGetPropertyData(devices[i], &uidProp, 0, nullptr, &uidSize, &uid);
-        if (err == noErr && uid) {
-            if (CFStringCompare(uid, targetUID, 0) == kCFCompareEqualTo) {
-                aggregateId = devices[i];
-            }
-            CFRelease(uid);
-            if (aggregateId) break;
-        }
-    }
-
-    CFRelease(targetUID);
-    delete[] devices;
-
-    if (aggregateId == 0) {
-        return true; // Already gone
-    }
-
-    err = AudioHardwareDestroyAggregateDevice(aggregateId);
-    return err == noErr;
+// ID of the Pulse Audio device, 0 if it isn't loaded
+static AudioObjectID FindPulseDevice() {
+    return Service().FindDeviceId(kPulseDeviceUID);
 }
 
 // ============================================================================
@@ -228,46 +77,7 @@ static bool destroyAggregate() {
 // ============================================================================
 
 static int cmd_detect() {
-    AudioObjectPropertyAddress prop = {
-        kAudioHardwarePropertyDevices,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
-
-    UInt32 dataSize = 0;
-    OSStatus err = AudioObjectGetPropertyDataSize(kAudioObjectSystemObject, &prop, 0, nullptr, &dataSize);
-    if (err != noErr) return 1;
-
-    UInt32 deviceCount = dataSize / sizeof(AudioObjectID);
-    auto* devices = new AudioObjectID[deviceCount];
-    err = AudioObjectGetPropertyData(kAudioObjectSystemObject, &prop, 0, nullptr, &dataSize, devices);
-    if (err != noErr) { delete[] devices; return 1; }
-
-    AudioObjectPropertyAddress uidProp = {
-        kAudioDevicePropertyDeviceUID,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
-
-    CFStringRef targetUID = ToCFString(kPulseDeviceUID);
-    bool found = false;
-
-    for (UInt32 i = 0; i < deviceCount; i++) {
-        CFStringRef uid = nullptr;
-        UInt32 uidSize = sizeof(CFStringRef);
-        err = AudioObjectGetPropertyData(devices[i], &uidProp, 0, nullptr, &uidSize, &uid);
-        if (err == noErr && uid) {
-            if (CFStringCompare(uid, targetUID, 0) == kCFCompareEqualTo) {
-                found = true;
-            }
-            CFRelease(uid);
-            if (found) break;
-        }
-    }
-
-    CFRelease(targetUID);
-    delete[] devices;
-    return found ? 0 : 1;
+    return FindPulseDevice() != 0 ? 0 : 1;
 }
 
 // ============================================================================
@@ -275,13 +85,12 @@ static int cmd_detect() {
 // ============================================================================
 
 static int cmd_get_default() {
-    AudioObjectID deviceId;
-    char uidBuf[256], nameBuf[256];
-    if (!getDefaultOutput(deviceId, uidBuf, sizeof(uidBuf), nameBuf, sizeof(nameBuf))) {
+    AudioDeviceInfo device;
+    if (Service().GetDefaultOutput(&device) != noErr) {
         fprintf(stderr, "Failed to get default output device\n");
         return 1;
     }
-    printf("%u|%s|%s\n", (unsigned)deviceId, uidBuf, nameBuf);
+    printf("%u|%s|%s\n", (unsigned)device.id, device.uid.c_str(), device.name.c_str());
     return 0;
 }
 
@@ -291,7 +100,7 @@ static int cmd_get_default() {
 
 static int cmd_set_default(const char* idStr) {
     AudioObjectID deviceId = (AudioObjectID)atoi(idStr);
-    return setDefaultOutput(deviceId) ? 0 : 1;
+    return Service().SetDefaultOutput(deviceId) == noErr ? 0 : 1;
 }
 
 // ============================================================================
@@ -299,24 +108,10 @@ static int cmd_set_default(const char* idStr) {
 // ============================================================================
 
 static int cmd_create_aggregate(const char* realOutputUID) {
-    AudioObjectID aggregateId = createAggregate(realOutputUID);
-    if (aggregateId == 0) return 1;
-
-    // Get the UID of the created device
-    AudioObjectPropertyAddress uidProp = {
-        kAudioDevicePropertyDeviceUID,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
-    CFStringRef createdUID = nullptr;
-    UInt32 uidSize = sizeof(CFStringRef);
-    AudioObjectGetPropertyData(aggregateId, &uidProp, 0, nullptr, &uidSize, &createdUID);
-
-    char uidBuf[256];
-    CFStringToBuffer(createdUID, uidBuf, sizeof(uidBuf));
-    if (createdUID) CFRelease(createdUID);
+    AudioObjectID aggregateId = 0;
+    if (Service().CreateAggregate(realOutputUID, &aggregateId) != noErr) return 1;
 
-    printf("%u|%s\n", (unsigned)aggregateId, uidBuf);
+    printf("%u|%s\n", (unsigned)aggregateId, kAggregateUID);
     return 0;
 }
 
@@ -325,7 +120,7 @@ static int cmd_create_aggregate(const char* realOutputUID) {
 // ============================================================================
 
 static int cmd_destroy_aggregate() {
-    return destroyAggregate() ? 0 : 1;
+    return Service().DestroyAggregate() == noErr ? 0 : 1;
 }
 
 // ============================================================================
@@ -338,45 +133,11 @@ static int cmd_destroy_aggregate() {
 // ============================================================================
 
 static int cmd_start_capture() {
-    // 1. Get current default output
-    AudioObjectID savedDeviceId;
-    char savedUID[256], savedName[256];
-    if (!getDefaultOutput(savedDeviceId, savedUID, sizeof(savedUID), savedName, sizeof(savedName))) {
-        fprintf(stderr, "Failed to get current default output\n");
-        return 1;
-    }
-    fprintf(stderr, "[audio-capture] Current default: %s (%s, ID %u)\n",
-            savedName, savedUID, (unsigned)savedDeviceId);
-
-    // 2. Destroy any leftover aggregate
-    destroyAggregate();
-    usleep(200000); // 200ms
-
-    // Re-read default (ID may change after destroying aggregate)
-    if (!getDefaultOutput(savedDeviceId, savedUID, sizeof(savedUID), savedName, sizeof(savedName))) {
-        fprintf(stderr, "Failed to re-read default output after cleanup\n");
-        return 1;
-    }
-
-    // 3. Create multi-output aggregate
-    AudioObjectID aggregateId = createAggregate(savedUID);
-    if (aggregateId == 0) {
-        fprintf(stderr, "Failed to create aggregate device\n");
-        return 1;
-    }
-    fprintf(stderr, "[audio-capture] Created aggregate device (ID %u)\n", (unsigned)aggregateId);
+    CaptureSession session;
+    if (Service().StartCapture(&session) != noErr) return 1;
 
-    // 4. Set aggregate as default output
-    if (!setDefaultOutput(aggregateId)) {
-        fprintf(stderr, "Failed to set aggregate as default output, cleaning up\n");
-        AudioHardwareDestroyAggregateDevice(aggregateId);
-        return 1;
-    }
-    fprintf(stderr, "[audio-capture] Set aggregate as default output\n");
-
-    // 5. Print result: savedDeviceId|savedName
     // The caller needs savedDeviceId to restore later
-    printf("%u|%s\n", (unsigned)savedDeviceId, savedName);
+    printf("%u|%s\n", (unsigned)session.savedDeviceId, session.savedName.c_str());
     return 0;
 }
 
@@ -387,24 +148,9 @@ static int cmd_start_capture() {
 static int cmd_stop_capture(const char* savedIdStr) {
     AudioObjectID savedDeviceId = (AudioObjectID)atoi(savedIdStr);
 
-    fprintf(stderr, "[audio-capture] Restoring default output to device %u\n", (unsigned)savedDeviceId);
-
-    // First destroy the aggregate (this may change device IDs)
-    destroyAggregate();
-    usleep(200000); // 200ms
-
-    // Now restore the default
-    // After destroying the aggregate, we need to find the real device again
-    // because the AudioObjectID may have changed
-    if (savedDeviceId > 0) {
-        // Try setting by the saved ID first
-        if (!setDefaultOutput(savedDeviceId)) {
-            fprintf(stderr, "[audio-capture] Warning: could not restore saved device %u (ID may have changed)\n",
-                    (unsigned)savedDeviceId);
-            // Not a fatal error — the system will fall back to its own default
-        }
-    }
-
+    // A separate process has no session, so only the ID is known
+    AudioObjectID restoredId;
+    Service().StopCapture(savedDeviceId, std::string(), &restoredId);
     return 0;
 }
 
@@ -413,87 +159,17 @@ static int cmd_stop_capture(const char* savedIdStr) {
 // ============================================================================
 
 static int cmd_list_devices() {
-    AudioObjectPropertyAddress prop = {
-        kAudioHardwarePropertyDevices,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
-
-    UInt32 dataSize = 0;
-    OSStatus err = AudioObjectGetPropertyDataSize(kAudioObjectSystemObject, &prop, 0, nullptr, &dataSize);
-    if (err != noErr) {
+    OSStatus err;
+    const std::vector<AudioDeviceInfo>* devices = Service().Devices(&err);
+    if (!devices) {
         fprintf(stderr, "Failed to get device list: %d\n", (int)err);
         return 1;
     }
 
-    UInt32 deviceCount = dataSize / sizeof(AudioObjectID);
-    auto* devices = new AudioObjectID[deviceCount];
-    err = AudioObjectGetPropertyData(kAudioObjectSystemObject, &prop, 0, nullptr, &dataSize, devices);
-    if (err != noErr) {
-        fprintf(stderr, "Failed to get devices: %d\n", (int)err);
-        delete[] devices;
-        return 1;
-    }
-
-    printf("Found %u audio devices:\n", (unsigned)deviceCount);
-
-    AudioObjectPropertyAddress uidProp = {
-        kAudioDevicePropertyDeviceUID,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
-    AudioObjectPropertyAddress nameProp = {
-        kAudioObjectPropertyName,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
-    AudioObjectPropertyAddress outStreamsProp = {
-        kAudioDevicePropertyStreams,
-        kAudioObjectPropertyScopeOutput,
-        kAudioObjectPropertyElementMain
-    };
-    AudioObjectPropertyAddress inStreamsProp = {
-        kAudioDevicePropertyStreams,
-        kAudioObjectPropertyScopeInput,
-        kAudioObjectPropertyElementMain
-    };
-    AudioObjectPropertyAddress transportProp = {
-        kAudioDevicePropertyTransportType,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
+    printf("Found %u audio devices:\n", (unsigned)devices->size());
 
-    for (UInt32 i = 0; i < deviceCount; i++) {
-        AudioObjectID devId = devices[i];
-
-        // UID
-        CFStringRef uid = nullptr;
-        UInt32 uidSize = sizeof(CFStringRef);
-        char uidBuf[256] = "?";
-        err = AudioObjectGetPropertyData(devId, &uidProp, 0, nullptr, &uidSize, &uid);
-        if (err == noErr && uid) { CFStringToBuffer(uid, uidBuf, sizeof(uidBuf)); CFRelease(uid); }
-
-        // Name
-        CFStringRef name = nullptr;
-        UInt32 nameSize = sizeof(CFStringRef);
-        char nameBuf[256] = "?";
-        err = AudioObjectGetPropertyData(devId, &nameProp, 0, nullptr, &nameSize, &name);
-        if (err == noErr && name) { CFStringToBuffer(name, nameBuf, sizeof(nameBuf)); CFRelease(name); }
-
-        // Output streams
-        UInt32 outSize = 0;
-        AudioObjectGetPropertyDataSize(devId, &outStreamsProp, 0, nullptr, &outSize);
-        UInt32 outCount = outSize / sizeof(AudioObjectID);
-
-        // Input streams
-        UInt32 inSize = 0;
-        AudioObjectGetPropertyDataSize(devId, &inStreamsProp, 0, nullptr, &inSize);
-        UInt32 inCount = inSize / sizeof(AudioObjectID);
-
-        // Transport type
-        UInt32 transport = 0;
-        UInt32 tSize = sizeof(transport);
-        AudioObjectGetPropertyData(devId, &transportProp, 0, nullptr, &tSize, &transport);
+    for (const AudioDeviceInfo& device : *devices) {
+        UInt32 transport = device.transportType;
         char fourCC[5] = {0};
         fourCC[0] = (char)((transport >> 24) & 0xFF);
         fourCC[1] = (char)((transport >> 16) & 0xFF);
@@ -501,11 +177,12 @@ static int cmd_list_devices() {
         fourCC[3] = (char)(transport & 0xFF);
 
         printf("  [%u] %s  uid=%s  out=%u in=%u  transport='%s'\n",
-               (unsigned)devId, nameBuf, uidBuf, (unsigned)outCount, (unsigned)inCount, fourCC);
+               (unsigned)device.id,
+               device.name.empty() ? "?" : device.name.c_str(),
+               device.uid.empty() ? "?" : device.uid.c_str(),
+               (unsigned)device.outputStreams, (unsigned)device.inputStreams, fourCC);
     }
 
-    delete[] devices;
-
     // Also show default
     AudioObjectID defaultOut = 0;
     UInt32 defSize = sizeof(defaultOut);
@@ -520,6 +197,210 @@ static int cmd_list_devices() {
     return 0;
 }
 
+// ============================================================================
+// buffer-config [<capacity-frames> <target-fill-frames>]
+// ============================================================================
+
+static int cmd_buffer_config(int argc, char* argv[]) {
+    AudioObjectID deviceId = FindPulseDevice();
+    if (deviceId == 0) {
+        fprintf(stderr, "Pulse Audio device not found\n");
+        return 1;
+    }
+
+    AudioObjectPropertyAddress prop = {
+        kPulseDevicePropertyBufferConfig,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+
+    if (argc >= 4) {
+        CFMutableDictionaryRef dict = CFDictionaryCreateMutable(kCFAllocatorDefault, 0,
+            &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+        SetDictionaryUInt32(dict, kBufferConfigCapacityKey, (UInt32)atoi(argv[2]));
+        SetDictionaryUInt32(dict, kBufferConfigTargetFillKey, (UInt32)atoi(argv[3]));
+
+        CFPropertyListRef plist = dict;
+        OSStatus err = AudioObjectSetPropertyData(deviceId, &prop, 0, nullptr, sizeof(plist), &plist);
+        CFRelease(dict);
+        if (err != noErr) {
+            fprintf(stderr, "Failed to set buffer config: %d\n", (int)err);
+            return 1;
+        }
+    }
+
+    CFPropertyListRef plist = nullptr;
+    UInt32 size = sizeof(plist);
+    OSStatus err = AudioObjectGetPropertyData(deviceId, &prop, 0, nullptr, &size, &plist);
+    if (err != noErr || !plist) {
+        fprintf(stderr, "Failed to read buffer config: %d\n", (int)err);
+        return 1;
+    }
+
+    CFDictionaryRef dict = (CFDictionaryRef)plist;
+    printf("%llu|%llu\n",
+           (unsigned long long)GetDictionaryUInt64(dict, kBufferConfigCapacityKey),
+           (unsigned long long)GetDictionaryUInt64(dict, kBufferConfigTargetFillKey));
+    CFRelease(plist);
+    return 0;
+}
+
+// ============================================================================
+// stats
+// ============================================================================
+
+static bool CFStringLess(CFStringRef a, CFStringRef b) {
+    return CFStringCompare(a, b, 0) == kCFCompareLessThan;
+}
+
+static int cmd_stats() {
+    AudioObjectID deviceId = FindPulseDevice();
+    if (deviceId == 0) {
+        fprintf(stderr, "Pulse Audio device not found\n");
+        return 1;
+    }
+
+    AudioObjectPropertyAddress prop = {
+        kPulseDevicePropertyStats,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+
+    CFPropertyListRef plist = nullptr;
+    UInt32 size = sizeof(plist);
+    OSStatus err = AudioObjectGetPropertyData(deviceId, &prop, 0, nullptr, &size, &plist);
+    if (err != noErr || !plist) {
+        fprintf(stderr, "Failed to read stats: %d\n", (int)err);
+        return 1;
+    }
+
+    // Print every numeric or array entry, sorted by key, so new counters show
+    // up without touching the helper
+    CFDictionaryRef dict = (CFDictionaryRef)plist;
+    CFIndex count = CFDictionaryGetCount(dict);
+    std::vector<const void*> keys(count);
+    CFDictionaryGetKeysAndValues(dict, keys.data(), nullptr);
+    std::sort(keys.begin(), keys.end(), [](const void* a, const void* b) {
+        return CFStringLess((CFStringRef)a, (CFStringRef)b);
+    });
+
+    for (const void* key : keys) {
+        CFTypeRef value = CFDictionaryGetValue(dict, key);
+        if (!value) continue;
+
+        char name[128];
+        CFStringToBuffer((CFStringRef)key, name, sizeof(name));
+
+        if (CFGetTypeID(value) == CFNumberGetTypeID() && CFNumberIsFloatType((CFNumberRef)value)) {
+            double real = 0;
+            CFNumberGetValue((CFNumberRef)value, kCFNumberDoubleType, &real);
+            printf("%s=%.6f\n", name, real);
+        } else if (CFGetTypeID(value) == CFNumberGetTypeID()) {
+            printf("%s=%llu\n", name, (unsigned long long)GetDictionaryUInt64(dict, (CFStringRef)key));
+        } else if (CFGetTypeID(value) == CFArrayGetTypeID()) {
+            CFArrayRef array = (CFArrayRef)value;
+            printf("%s=", name);
+            for (CFIndex i = 0; i < CFArrayGetCount(array); i++) {
+                SInt64 count = 0;
+                CFTypeRef item = CFArrayGetValueAtIndex(array, i);
+                if (CFGetTypeID(item) == CFNumberGetTypeID()) {
+                    CFNumberGetValue((CFNumberRef)item, kCFNumberSInt64Type, &count);
+                }
+                printf(i == 0 ? "%lld" : ",%lld", (long long)count);
+            }
+            printf("\n");
+        }
+    }
+
+    CFRelease(plist);
+    return 0;
+}
+
+// ============================================================================
+// meter [<interval-ms>]
+// ============================================================================
+
+static void PrintFloatArray(CFDictionaryRef dict, CFStringRef key) {
+    CFTypeRef value = CFDictionaryGetValue(dict, key);
+    if (!value || CFGetTypeID(value) != CFArrayGetTypeID()) return;
+
+    CFArrayRef array = (CFArrayRef)value;
+    for (CFIndex i = 0; i < CFArrayGetCount(array); i++) {
+        double level = 0;
+        CFTypeRef item = CFArrayGetValueAtIndex(array, i);
+        if (CFGetTypeID(item) == CFNumberGetTypeID()) {
+            CFNumberGetValue((CFNumberRef)item, kCFNumberDoubleType, &level);
+        }
+        printf(i == 0 ? "%.5f" : ",%.5f", level);
+    }
+}
+
+static int cmd_meter(int argc, char* argv[]) {
+    AudioObjectID deviceId = FindPulseDevice();
+    if (deviceId == 0) {
+        fprintf(stderr, "Pulse Audio device not found\n");
+        return 1;
+    }
+
+    int intervalMs = (argc >= 3) ? atoi(argv[2]) : 50;
+    if (intervalMs <= 0) intervalMs = 50;
+
+    AudioObjectPropertyAddress prop = {
+        kPulseDevicePropertyMeter,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+
+    // The driver accumulates levels between reads, so every peak shows up
+    // whatever the interval. Quiet while IO is stopped; exits when the
+    // reader closes the pipe.
+    UInt64 lastPeriods = 0;
+    for (;;) {
+        CFPropertyListRef plist = nullptr;
+        UInt32 size = sizeof(plist);
+        OSStatus err = AudioObjectGetPropertyData(deviceId, &prop, 0, nullptr, &size, &plist);
+        if (err != noErr || !plist) {
+            fprintf(stderr, "Failed to read meter: %d\n", (int)err);
+            return 1;
+        }
+
+        CFDictionaryRef dict = (CFDictionaryRef)plist;
+        UInt64 periods = GetDictionaryUInt64(dict, kMeterPeriodsKey);
+        if (periods != lastPeriods) {
+            lastPeriods = periods;
+            printf("%llu|", (unsigned long long)periods);
+            PrintFloatArray(dict, kMeterPeakKey);
+            printf("|");
+            PrintFloatArray(dict, kMeterRMSKey);
+            printf("\n");
+            if (fflush(stdout) != 0) {
+                CFRelease(plist);
+                return 0;
+            }
+        }
+        CFRelease(plist);
+        usleep((useconds_t)intervalMs * 1000);
+    }
+}
+
+// ============================================================================
+// serve [--mock] — resident NDJSON mode
+// ============================================================================
+
+static int cmd_serve(int argc, char* argv[]) {
+    bool mock = (argc >= 3 && strcmp(argv[2], "--mock") == 0);
+
+    // Progress messages go to stderr; stdout carries only responses
+    if (mock) {
+        MockDeviceBackend backend;
+        HelperService service(backend);
+        service.Serve(stdin, stdout);
+    } else {
+        Service().Serve(stdin, stdout);
+    }
+    return 0;
+}
+
 // ============================================================================
 // main
 // ============================================================================
@@ -536,6 +417,10 @@ int main(int argc, char* argv[]) {
         fprintf(stderr, "  start-capture             — full capture flow (create + activate)\n");
         fprintf(stderr, "  stop-capture <saved-id>   — restore default + destroy aggregate\n");
         fprintf(stderr, "  list-devices              — list all audio devices\n");
+        fprintf(stderr, "  buffer-config [<cap> <target>] — print or set ring capacity / target fill\n");
+        fprintf(stderr, "  stats                     — print IO counters as key=value lines\n");
+        fprintf(stderr, "  meter [<interval-ms>]     — stream output levels as \"periods|peaks|rms\" lines\n");
+        fprintf(stderr, "  serve [--mock]            — answer NDJSON requests on stdin/stdout until EOF\n");
         return 1;
     }
 
@@ -557,6 +442,14 @@ int main(int argc, char* argv[]) {
         return cmd_stop_capture(argv[2]);
     } else if (strcmp(cmd, "list-devices") == 0) {
         return cmd_list_devices();
+    } else if (strcmp(cmd, "buffer-config") == 0) {
+        return cmd_buffer_config(argc, argv);
+    } else if (strcmp(cmd, "stats") == 0) {
+        return cmd_stats();
+    } else if (strcmp(cmd, "meter") == 0) {
+        return cmd_meter(argc, argv);
+    } else if (strcmp(cmd, "serve") == 0) {
+        return cmd_serve(argc, argv);
     } else {
         fprintf(stderr, "Unknown command: %s\n", cmd);
         return 1;
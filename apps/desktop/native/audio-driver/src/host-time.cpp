@@ -0,0 +1,57 @@
+#include "host-time.h"
+
+#if defined(__APPLE__)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+#if defined(__APPLE__)
+
+UInt64 HostTimeNow()
+{
+    return mach_absolute_time();
+}
+
+static HostTimebase QueryHostTimebase()
+{
+    mach_timebase_info_data_t info = { 0, 0 };
+    mach_timebase_info(&info);
+    return HostTimebase{ info.numer, info.denom };
+}
+
+#else
+
+UInt64 HostTimeNow()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (UInt64)ts.tv_sec * 1000000000ull + (UInt64)ts.tv_nsec;
+}
+
+// The monotonic clock already counts nanoseconds
+static HostTimebase QueryHostTimebase()
+{
+    return HostTimebase{ 1, 1 };
+}
+
+#endif
+
+HostTimebase GetHostTimebase()
+{
+    // Function-local static: initialized exactly once, even under contention
+    static const HostTimebase sTimebase = QueryHostTimebase();
+    return sTimebase;
+}
+
+UInt64 HostTimeToNanos(UInt64 hostTime)
+{
+    HostTimebase timebase = GetHostTimebase();
+    return (UInt64)(((unsigned __int128)hostTime * timebase.numer) / timebase.denom);
+}
+
+UInt64 NanosToHostTime(UInt64 nanos)
+{
+    HostTimebase timebase = GetHostTimebase();
+    return (UInt64)(((unsigned __int128)nanos * timebase.denom) / timebase.numer);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "platform.h"
+
+// Host clock used for IO timestamps.
+// mach_absolute_time() ticks on macOS, CLOCK_MONOTONIC nanoseconds elsewhere.
+UInt64 HostTimeNow();
+
+// nanoseconds = ticks * numer / denom
+struct HostTimebase {
+    UInt32 numer;
+    UInt32 denom;
+};
+
+// Queried once, on first use; safe to call from any thread.
+HostTimebase GetHostTimebase();
+
+// Convert between host clock ticks and nanoseconds. 128-bit intermediates,
+// so neither overflows for any 64-bit input whose result fits in 64 bits.
+UInt64 HostTimeToNanos(UInt64 hostTime);
+UInt64 NanosToHostTime(UInt64 nanos);
@@ -0,0 +1,663 @@
+#include "io-engine.h"
+#include "downmix.h"
+#include "gain.h"
+#include "host-time.h"
+#include "signal-level.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+IOEngine::IOEngine()
+    : mSampleRate(kDefaultSampleRate)
+    , mFramesPerPeriod(kFramesPerPeriod)
+    , mChannelCount(kDefaultNumChannels)
+    , mInputSampleFormat(kInputSampleFormat_Float32)
+    , mInputChannelMode(kInputChannelMode_Mirror)
+    , mInputDither(true)
+    , mVolume(kDefaultVolume)
+    , mMuted(false)
+    , mAppliedGain(kDefaultVolume)
+    , mSilentRunFrames(0)
+    , mInputActive(false)
+    , mIOStartCount(0)
+    , mTimestampSeed(0)
+    , mCapacityFrames(kRingBufferFrameCapacity)
+    , mTargetFillFrames(kDefaultTargetFillFrames)
+    , mAllocatedCapacityFrames(0)
+    , mWriteStats()
+    , mMeterAccum()
+{
+#if PULSE_AUDIO_IO_HISTOGRAMS
+    mWriteMixTiming.lastStartTime  = 0;
+    mReadInputTiming.lastStartTime = 0;
+#endif
+    mAllocatedCapacityFrames = RingAllocationFrames(kRingBufferFrameCapacity);
+    mRingBuffer.Initialize(mAllocatedCapacityFrames, BytesPerFrame(kDefaultNumChannels));
+    for (UInt32 i = 0; i < FanoutRingBuffer::kMaxReaders; i++) {
+        CaptureClient& reader = mReaders[i];
+        reader.registered.store(false, std::memory_order_relaxed);
+        reader.clientID.store(0, std::memory_order_relaxed);
+        reader.resampler.Initialize(kDefaultNumChannels);
+        // Sized for any channel count, so a format change never reallocates them
+        reader.convertBuffer.resize(DriftResampler::kMaxOutputFrames * kMaxNumChannels);
+        reader.downmixBuffer.resize(DriftResampler::kMaxInputFrames * kMaxNumChannels);
+        InitDitherState(&reader.dither, i);
+        reader.stats = ReadSideStats();
+        reader.stats.resampleRatio = 1.0;
+        reader.publishedStats.Store(reader.stats);
+    }
+    PublishAnchor(0);
+}
+
+IOEngine::~IOEngine()
+{
+}
+
+// Supported rate within 0.1 Hz of sampleRate, or 0
+static Float64 FindSupportedSampleRate(Float64 sampleRate)
+{
+    for (UInt32 i = 0; i < kNumSupportedSampleRates; i++) {
+        if (std::fabs(sampleRate - kSupportedSampleRates[i]) < 0.1) return kSupportedSampleRates[i];
+    }
+    return 0.0;
+}
+
+bool IOEngine::IsSupportedSampleRate(Float64 sampleRate)
+{
+    return FindSupportedSampleRate(sampleRate) != 0.0;
+}
+
+UInt32 IOEngine::RingAllocationFrames(UInt32 capacityFrames) const
+{
+    return (UInt32)std::ceil((Float64)capacityFrames * kMaxSampleRate / mSampleRate);
+}
+
+OSStatus IOEngine::SetSampleRate(Float64 sampleRate)
+{
+    sampleRate = FindSupportedSampleRate(sampleRate);
+    if (sampleRate == 0.0) {
+        return kAudioHardwareIllegalOperationError;
+    }
+
+    std::lock_guard<std::mutex> lock(mConfigMutex);
+    if (sampleRate == mSampleRate) return kAudioHardwareNoError;
+    if (IsIORunning()) return kAudioHardwareIllegalOperationError;
+
+    // Keep the configured durations
+    Float64 scale = sampleRate / mSampleRate;
+    UInt32 capacityFrames = (UInt32)std::lround(GetCapacityFrames() * scale);
+    mCapacityFrames.store(capacityFrames, std::memory_order_relaxed);
+    mTargetFillFrames.store((UInt32)std::lround(GetTargetFillFrames() * scale), std::memory_order_relaxed);
+
+    mSampleRate      = sampleRate;
+    mFramesPerPeriod = (UInt32)(sampleRate / kPeriodsPerSecond);
+    PublishAnchor(HostTimeNow());
+
+    // The allocation already covers kMaxSampleRate; only rounding in the
+    // rescale can move it, and the power-of-two ring absorbs that
+    UInt32 allocationFrames = RingAllocationFrames(capacityFrames);
+    if (allocationFrames <= mRingBuffer.CapacityFrames()) {
+        mAllocatedCapacityFrames = allocationFrames;
+    }
+
+    // Audio buffered at the old rate is meaningless at the new one
+    mRingBuffer.Reset();
+    ResetReaders();
+    return kAudioHardwareNoError;
+}
+
+bool IOEngine::IsSupportedChannelCount(UInt32 channels)
+{
+    for (UInt32 i = 0; i < kNumSupportedChannelCounts; i++) {
+        if (channels == kSupportedChannelCounts[i]) return true;
+    }
+    return false;
+}
+
+OSStatus IOEngine::SetChannelCount(UInt32 channels)
+{
+    if (!IsSupportedChannelCount(channels)) {
+        return kAudioHardwareIllegalOperationError;
+    }
+
+    std::lock_guard<std::mutex> lock(mConfigMutex);
+    if (channels == GetChannelCount()) return kAudioHardwareNoError;
+    if (IsIORunning()) return kAudioHardwareIllegalOperationError;
+
+    mChannelCount.store(channels, std::memory_order_relaxed);
+    mRingBuffer.Initialize(mAllocatedCapacityFrames, BytesPerFrame(channels));
+    InitializeResamplers();
+    return kAudioHardwareNoError;
+}
+
+UInt32 IOEngine::GetInputChannelCount() const
+{
+    return GetInputChannelMode() == kInputChannelMode_Mono ? 1 : GetChannelCount();
+}
+
+OSStatus IOEngine::SetInputChannelMode(UInt32 mode)
+{
+    if (mode != kInputChannelMode_Mirror && mode != kInputChannelMode_Mono) {
+        return kAudioHardwareIllegalOperationError;
+    }
+
+    std::lock_guard<std::mutex> lock(mConfigMutex);
+    if (mode == GetInputChannelMode()) return kAudioHardwareNoError;
+    if (IsIORunning()) return kAudioHardwareIllegalOperationError;
+
+    mInputChannelMode.store(mode, std::memory_order_relaxed);
+    InitializeResamplers();
+    return kAudioHardwareNoError;
+}
+
+OSStatus IOEngine::SetInputSampleFormat(UInt32 format)
+{
+    if (format != kInputSampleFormat_Float32 && format != kInputSampleFormat_Int16) {
+        return kAudioHardwareIllegalOperationError;
+    }
+
+    std::lock_guard<std::mutex> lock(mConfigMutex);
+    if (format == GetInputSampleFormat()) return kAudioHardwareNoError;
+    if (IsIORunning()) return kAudioHardwareIllegalOperationError;
+
+    mInputSampleFormat.store(format, std::memory_order_relaxed);
+    return kAudioHardwareNoError;
+}
+
+OSStatus IOEngine::SetBufferConfig(UInt32 capacityFrames, UInt32 targetFillFrames)
+{
+    std::lock_guard<std::mutex> lock(mConfigMutex);
+
+    if (capacityFrames < kMinRingBufferPeriods * mFramesPerPeriod ||
+        capacityFrames > kMaxRingBufferSeconds * (UInt32)mSampleRate ||
+        targetFillFrames < mFramesPerPeriod ||
+        targetFillFrames > capacityFrames / 2) {
+        return kAudioHardwareIllegalOperationError;
+    }
+
+    mCapacityFrames.store(capacityFrames, std::memory_order_relaxed);
+    mTargetFillFrames.store(targetFillFrames, std::memory_order_relaxed);
+
+    // Never reallocate under a running IO thread
+    UInt32 allocationFrames = RingAllocationFrames(capacityFrames);
+    if (!IsIORunning() && allocationFrames != mAllocatedCapacityFrames) {
+        mRingBuffer.Initialize(allocationFrames, BytesPerFrame(GetChannelCount()));
+        mAllocatedCapacityFrames = allocationFrames;
+    }
+
+    return kAudioHardwareNoError;
+}
+
+OSStatus IOEngine::SetSharedMemoryName(const char* name)
+{
+    std::lock_guard<std::mutex> lock(mConfigMutex);
+
+    std::string requested = name ? name : "";
+    if (!requested.empty() && !IsValidShmRingName(requested.c_str())) {
+        return kAudioHardwareIllegalOperationError;
+    }
+
+    mSharedMemoryName = requested;
+    if (IsIORunning()) return kAudioHardwareNoError;
+    return UpdateSharedMemory();
+}
+
+std::string IOEngine::GetSharedMemoryName()
+{
+    std::lock_guard<std::mutex> lock(mConfigMutex);
+    return mSharedMemoryName;
+}
+
+OSStatus IOEngine::UpdateSharedMemory()
+{
+    if (mSharedMemoryName.empty()) {
+        mSharedMemory.Close();
+        return kAudioHardwareNoError;
+    }
+
+    UInt32 channels = GetChannelCount();
+    if (mSharedMemory.IsOpen() && mSharedMemoryName == mSharedMemory.Name() &&
+        mSharedMemory.Channels() == channels && mSharedMemory.SampleRate() == mSampleRate) {
+        return kAudioHardwareNoError;
+    }
+
+    // Readers see the old segment closed and reopen by name
+    if (!mSharedMemory.Create(mSharedMemoryName.c_str(), GetCapacityFrames(), channels, mSampleRate)) {
+        return kAudioHardwareUnspecifiedError;
+    }
+    return kAudioHardwareNoError;
+}
+
+IOStats IOEngine::GetStats() const
+{
+    WriteSideStats writeSide = mPublishedWriteStats.Load();
+
+    IOStats stats = {};
+    stats.writeMixCycles    = writeSide.cycles;
+    stats.overrunFrames     = writeSide.overrunFrames;
+    stats.silentFrames      = writeSide.silentFrames;
+    stats.resampleRatio     = 1.0;
+    stats.capacityFrames    = GetCapacityFrames();
+    stats.allocatedFrames   = mRingBuffer.CapacityFrames();
+
+    // Counters add up over every reader slot ever used; the fill level is
+    // the fullest open reader's, as that one is closest to losing frames
+    for (UInt32 i = 0; i < FanoutRingBuffer::kMaxReaders; i++) {
+        ReadSideStats readSide = mReaders[i].publishedStats.Load();
+        stats.readInputCycles   += readSide.cycles;
+        stats.underrunFrames    += readSide.underrunFrames;
+        stats.fillDroppedFrames += readSide.fillDroppedFrames;
+        stats.highWaterFrames    = std::max(stats.highWaterFrames, readSide.highWaterFrames);
+
+        if (!mRingBuffer.IsReaderOpen(i)) continue;
+        if (stats.readers == 0 || readSide.fillFrames > stats.fillFrames) {
+            stats.fillFrames    = readSide.fillFrames;
+            stats.resampleRatio = readSide.resampleRatio;
+        }
+        stats.readers++;
+    }
+    return stats;
+}
+
+MeterLevels IOEngine::ReadMeter()
+{
+    std::lock_guard<std::mutex> lock(mMeterReadMutex);
+    mMeter.Update();
+    const MeterRecord& record = mMeter.ReadBuffer();
+
+    MeterLevels levels = {};
+    levels.periods  = record.periods;
+    levels.frames   = record.frames;
+    levels.channels = record.channels;
+    for (UInt32 ch = 0; ch < record.channels && record.frames > 0; ch++) {
+        Float64 rms = std::sqrt(record.sumSquares[ch] / (Float64)record.frames);
+        levels.peak[ch] = record.peak[ch];
+        levels.rms[ch]  = std::isnan(rms) ? 0.0f : (Float32)rms;   // a NaN sample poisons the sum
+    }
+    return levels;
+}
+
+// ============================================================================
+// Capture clients
+// ============================================================================
+
+OSStatus IOEngine::AddClient(UInt32 clientID)
+{
+    std::lock_guard<std::mutex> lock(mConfigMutex);
+
+    for (UInt32 i = kSharedReader + 1; i < FanoutRingBuffer::kMaxReaders; i++) {
+        CaptureClient& reader = mReaders[i];
+        if (reader.registered.load(std::memory_order_relaxed)) continue;
+
+        // The slot is idle, so its IO-thread state can be reset from here.
+        // The client joins the ring on its first read, from a fresh cursor.
+        mRingBuffer.CloseReader(i);
+        reader.fillController.Reset();
+        reader.resampler.Reset();
+        reader.clientID.store(clientID, std::memory_order_relaxed);
+        reader.registered.store(true, std::memory_order_release);
+        return kAudioHardwareNoError;
+    }
+    return kAudioHardwareIllegalOperationError;
+}
+
+void IOEngine::RemoveClient(UInt32 clientID)
+{
+    std::lock_guard<std::mutex> lock(mConfigMutex);
+
+    for (UInt32 i = kSharedReader + 1; i < FanoutRingBuffer::kMaxReaders; i++) {
+        CaptureClient& reader = mReaders[i];
+        if (reader.registered.load(std::memory_order_relaxed) &&
+            reader.clientID.load(std::memory_order_relaxed) == clientID) {
+            reader.registered.store(false, std::memory_order_release);
+            // Pairs with the fence in ReadInput: either it sees the slot
+            // unregistered, or this close lands after its open
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            mRingBuffer.CloseReader(i);
+            return;
+        }
+    }
+}
+
+UInt32 IOEngine::FindReader(UInt32 clientID) const
+{
+    for (UInt32 i = kSharedReader + 1; i < FanoutRingBuffer::kMaxReaders; i++) {
+        if (mReaders[i].registered.load(std::memory_order_acquire) &&
+            mReaders[i].clientID.load(std::memory_order_relaxed) == clientID) {
+            return i;
+        }
+    }
+    return kSharedReader;
+}
+
+void IOEngine::ResetReaders()
+{
+    for (CaptureClient& reader : mReaders) {
+        reader.fillController.Reset();
+        reader.resampler.Reset();
+    }
+}
+
+void IOEngine::InitializeResamplers()
+{
+    UInt32 channels = GetInputChannelCount();
+    for (CaptureClient& reader : mReaders) {
+        reader.resampler.Initialize(channels);
+    }
+    ResetReaders();
+}
+
+// ============================================================================
+// IO lifecycle
+// ============================================================================
+
+void IOEngine::PublishAnchor(UInt64 hostTime)
+{
+    TimestampAnchor anchor;
+    anchor.clock.anchorHostTime      = hostTime;
+    anchor.clock.ticksPerPeriodFixed = HostTicksPerPeriodFixed((UInt32)mSampleRate, mFramesPerPeriod,
+                                                               GetHostTimebase());
+    anchor.clock.framesPerPeriod     = mFramesPerPeriod;
+    anchor.seed       = ++mTimestampSeed;
+    anchor.sampleRate = mSampleRate;
+    mAnchor.Store(anchor);
+}
+
+OSStatus IOEngine::StartIO()
+{
+    // Already running — just take another reference
+    UInt32 count = mIOStartCount.load(std::memory_order_acquire);
+    while (count > 0) {
+        if (mIOStartCount.compare_exchange_weak(count, count + 1, std::memory_order_acq_rel,
+                                                std::memory_order_acquire)) {
+            return kAudioHardwareNoError;
+        }
+    }
+
+    // Possibly the first client. The count only leaves 0 under this lock,
+    // so whoever sees 0 here sets up the ring before anyone can join.
+    std::lock_guard<std::mutex> lock(mConfigMutex);
+
+    count = mIOStartCount.load(std::memory_order_acquire);
+    while (count > 0) {
+        if (mIOStartCount.compare_exchange_weak(count, count + 1, std::memory_order_acq_rel,
+                                                std::memory_order_acquire)) {
+            return kAudioHardwareNoError;
+        }
+    }
+
+    UInt32 allocationFrames = RingAllocationFrames(GetCapacityFrames());
+    if (allocationFrames != mAllocatedCapacityFrames) {
+        mRingBuffer.Initialize(allocationFrames, BytesPerFrame(GetChannelCount()));
+        mAllocatedCapacityFrames = allocationFrames;
+    }
+    mRingBuffer.Reset();
+    ResetReaders();
+    // A segment that can't be created leaves the transport off; the loopback
+    // device itself still starts
+    UpdateSharedMemory();
+    mAppliedGain = IsMuted() ? 0.0f : GetVolume();
+    // Start gated; the first audible period opens the gate at once
+    mSilentRunFrames = kSilenceHoldPeriods * mFramesPerPeriod;
+    mInputActive.store(false, std::memory_order_relaxed);
+#if PULSE_AUDIO_IO_HISTOGRAMS
+    // Don't count the idle gap since the last session as jitter
+    mWriteMixTiming.lastStartTime  = 0;
+    mReadInputTiming.lastStartTime = 0;
+#endif
+    PublishAnchor(HostTimeNow());
+
+    // Release: the setup above is visible to anyone who sees a non-zero count
+    mIOStartCount.store(1, std::memory_order_release);
+    return kAudioHardwareNoError;
+}
+
+OSStatus IOEngine::StopIO()
+{
+    UInt32 count = mIOStartCount.load(std::memory_order_acquire);
+    do {
+        if (count == 0) return kAudioHardwareNotRunningError;
+    } while (!mIOStartCount.compare_exchange_weak(count, count - 1, std::memory_order_acq_rel,
+                                                  std::memory_order_acquire));
+
+    return kAudioHardwareNoError;
+}
+
+void IOEngine::GetZeroTimeStamp(Float64* outSampleTime,
+                                UInt64* outHostTime,
+                                UInt64* outSeed)
+{
+    TimestampAnchor anchor = mAnchor.Load();
+
+    UInt64 sampleTime;
+    ComputeZeroTimestamp(anchor.clock, HostTimeNow(), &sampleTime, outHostTime);
+
+    *outSampleTime = (Float64)sampleTime;
+    *outSeed       = anchor.seed;
+}
+
+// ============================================================================
+// IO operations
+// ============================================================================
+
+OSStatus IOEngine::DoIOOperation(UInt32 operationID,
+                                 UInt32 clientID,
+                                 UInt32 ioBufferFrameSize,
+                                 AudioBufferList* ioMainBuffer)
+{
+    if (!ioMainBuffer || ioMainBuffer->mNumberBuffers == 0) {
+        return kAudioHardwareNoError;
+    }
+
+    void* buffer = ioMainBuffer->mBuffers[0].mData;
+    if (!buffer) return kAudioHardwareNoError;
+
+#if PULSE_AUDIO_IO_HISTOGRAMS
+    UInt64 startTime = HostTimeNow();
+#endif
+
+    switch (operationID) {
+        case kAudioServerPlugInIOOperationWriteMix:
+            WriteMix((const float*)buffer, ioBufferFrameSize);
+            mWriteStats.cycles++;
+            mWriteStats.overrunFrames = mRingBuffer.DroppedFrames();
+            mPublishedWriteStats.Store(mWriteStats);
+#if PULSE_AUDIO_IO_HISTOGRAMS
+            RecordTiming(mWriteMixTiming, startTime);
+#endif
+            break;
+
+        case kAudioServerPlugInIOOperationReadInput: {
+            UInt32 reader = FindReader(clientID);
+            ReadSideStats& stats = mReaders[reader].stats;
+            ReadInput(reader, buffer, ioBufferFrameSize);
+            stats.cycles++;
+            stats.underrunFrames = mRingBuffer.UnderrunFrames(reader);
+            mReaders[reader].publishedStats.Store(stats);
+#if PULSE_AUDIO_IO_HISTOGRAMS
+            RecordTiming(mReadInputTiming, startTime);
+#endif
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    return kAudioHardwareNoError;
+}
+
+#if PULSE_AUDIO_IO_HISTOGRAMS
+void IOEngine::RecordTiming(IOTiming& timing, UInt64 startTime)
+{
+    timing.duration.Record(HostTimeToNanos(HostTimeNow() - startTime));
+    if (timing.lastStartTime != 0) {
+        timing.interval.Record(HostTimeToNanos(startTime - timing.lastStartTime));
+    }
+    timing.lastStartTime = startTime;
+}
+#endif
+
+// Output stream: apps writing audio → store in ring buffer.
+// The gain stage renders straight into ring storage, so the HAL mix buffer
+// (which other sub-devices of an aggregate may still read) is never modified.
+// Volume and mute changes ramp linearly across one period to avoid zipper noise.
+// The gain stage meters what it writes, so levels cost no extra pass.
+// Once the mix has stayed below kSilenceThreshold for kSilenceHoldPeriods
+// (at once when muted) only a silent-run marker is stored, which readers
+// expand to zeros without copying, resampling or converting; while gated a
+// read-only peak scan watches for signal.
+void IOEngine::WriteMix(const float* buffer, UInt32 numFrames)
+{
+    const UInt32 channels = GetChannelCount();
+    Float32 targetGain = IsMuted() ? 0.0f : GetVolume();
+    Float32 startGain  = mAppliedGain;
+    Float32 maxGain    = std::max(startGain, targetGain);
+    UInt32  holdFrames = kSilenceHoldPeriods * GetFramesPerPeriod();
+
+    if (maxGain <= 0.0f) {
+        mSilentRunFrames = holdFrames;
+    } else if (mSilentRunFrames >= holdFrames &&
+               PeakLevel(buffer, numFrames * channels) * maxGain >= kSilenceThreshold) {
+        mSilentRunFrames = 0;
+    }
+
+    ChannelLevels levels = {};
+    bool gated = mSilentRunFrames >= holdFrames;
+    mInputActive.store(!gated, std::memory_order_relaxed);
+    mAppliedGain = targetGain;
+    if (gated) {
+        mWriteStats.silentFrames += mRingBuffer.WriteSilence(numFrames);
+        mSharedMemory.WriteSilence(numFrames);
+        PublishMeter(levels, numFrames, channels);
+        return;
+    }
+
+    RingBufferRegions regions;
+    UInt32 reserved = mRingBuffer.ReserveWrite(numFrames, &regions);
+    if (reserved == 0) return;
+
+    // Frame i gets startGain + (i + 1) * step, landing exactly on the target;
+    // a constant gain is a zero step (and unity a multiply by 1, bit exact)
+    Float32 step  = (startGain != targetGain) ? (targetGain - startGain) / (Float32)numFrames : 0.0f;
+    Float32 first = (startGain != targetGain) ? startGain + step : targetGain;
+    ApplyGainRampMetered(regions.first, buffer, regions.firstFrames, channels, first, step, &levels);
+    ApplyGainRampMetered(regions.second, buffer + (regions.firstFrames * channels), regions.secondFrames,
+                         channels, first + (Float32)regions.firstFrames * step, step, &levels);
+    mRingBuffer.CommitWrite(reserved);
+    mSharedMemory.Write(regions.first, regions.firstFrames);
+    mSharedMemory.Write(regions.second, regions.secondFrames);
+
+    // A quiet period extends the silent run; gating starts with the next one
+    Float32 peak = 0.0f;
+    for (UInt32 ch = 0; ch < channels; ch++) peak = std::max(peak, levels.peak[ch]);
+    mSilentRunFrames = (peak < kSilenceThreshold) ? std::min(mSilentRunFrames + numFrames, holdFrames) : 0;
+
+    PublishMeter(levels, numFrames, channels);
+}
+
+void IOEngine::PublishMeter(const ChannelLevels& levels, UInt32 numFrames, UInt32 channels)
+{
+    // Start a new window once the reader has taken the last one; until then
+    // keep accumulating, so no peak between two reads is lost
+    MeterRecord& accum = mMeterAccum;
+    if (mMeter.IsConsumed() || accum.channels != channels) {
+        UInt64 periods = accum.periods;
+        accum = MeterRecord();
+        accum.periods  = periods;
+        accum.channels = channels;
+    }
+
+    accum.periods++;
+    accum.frames += numFrames;
+    for (UInt32 ch = 0; ch < channels; ch++) {
+        accum.peak[ch] = std::max(accum.peak[ch], levels.peak[ch]);
+        accum.sumSquares[ch] += levels.sumSquares[ch];
+    }
+
+    mMeter.WriteBuffer() = accum;
+    mMeter.Publish();
+}
+
+// Input stream: Electron reading audio → fetch from this client's cursor
+// through the drift resampler, whose ratio holds the fill level at the target latency.
+// In mono mode ring frames are fetched into a scratch buffer and downmixed
+// into the resampler's input. In Int16 mode the resampler renders into
+// another scratch buffer and each chunk is converted from there, so the HAL
+// buffer is written once.
+void IOEngine::ReadInput(UInt32 reader, void* buffer, UInt32 numFrames)
+{
+    const UInt32   ringChannels = GetChannelCount();
+    const UInt32   channels     = GetInputChannelCount();
+    const bool     downmix      = channels != ringChannels;
+    const bool     toInt16      = GetInputSampleFormat() == kInputSampleFormat_Int16;
+    CaptureClient& client       = mReaders[reader];
+    ReadSideStats& stats        = client.stats;
+
+    // Readers join the stream on their first read, so a client that never
+    // reads isn't counted as falling behind. RemoveClient may close the slot
+    // meanwhile; a reader opened for a client already gone is closed again,
+    // or the writer would evict it every cycle.
+    if (!mRingBuffer.IsReaderOpen(reader)) {
+        mRingBuffer.OpenReader(reader, GetTargetFillFrames());
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (reader != kSharedReader && !client.registered.load(std::memory_order_relaxed)) {
+            mRingBuffer.CloseReader(reader);
+        }
+    }
+
+    client.fillController.SetTargetFrames(GetTargetFillFrames());
+    client.fillController.SetCapacityFrames(GetCapacityFrames());
+    UInt32 available = mRingBuffer.AvailableFrames(reader);
+    FillController::Correction correction = client.fillController.Update(available, numFrames);
+
+    stats.fillFrames    = available;
+    stats.resampleRatio = correction.ratio;
+    if (available > stats.highWaterFrames) {
+        stats.highWaterFrames = available;
+    }
+
+    if (correction.dropFrames > 0) {
+        stats.fillDroppedFrames += mRingBuffer.Discard(reader, correction.dropFrames);
+    }
+
+    // An underrun leaves silence in the resampler input, same as a plain Fetch
+    DriftResampler& resampler = client.resampler;
+    DitherState*    dither    = IsInputDitherEnabled() ? &client.dither : nullptr;
+    float*          floatOut  = (float*)buffer;
+    SInt16*         int16Out  = (SInt16*)buffer;
+    while (numFrames > 0) {
+        UInt32 chunk   = std::min(numFrames, DriftResampler::kMaxOutputFrames);
+        UInt32 samples = chunk * channels;
+        UInt32 needed  = resampler.InputFramesNeeded(chunk, correction.ratio);
+        float* fetchTo = downmix ? client.downmixBuffer.data() : resampler.InputBuffer();
+        bool   silent  = false;
+        mRingBuffer.Fetch(reader, fetchTo, needed, &silent);
+
+        // A silent run with silent history renders zeros; skip straight to the output
+        if (silent && resampler.SkipSilence(chunk, correction.ratio)) {
+            if (toInt16) {
+                std::memset(int16Out, 0, samples * sizeof(SInt16));
+                int16Out += samples;
+            } else {
+                std::memset(floatOut, 0, samples * sizeof(float));
+                floatOut += samples;
+            }
+            numFrames -= chunk;
+            continue;
+        }
+
+        if (downmix) {
+            DownmixToMono(resampler.InputBuffer(), client.downmixBuffer.data(), needed, ringChannels);
+        }
+        if (toInt16) {
+            resampler.Process(client.convertBuffer.data(), chunk, correction.ratio, silent);
+            ConvertFloatToInt16(int16Out, client.convertBuffer.data(), samples, dither);
+            int16Out += samples;
+        } else {
+            resampler.Process(floatOut, chunk, correction.ratio, silent);
+            floatOut += samples;
+        }
+        numFrames -= chunk;
+    }
+}
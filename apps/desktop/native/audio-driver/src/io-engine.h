@@ -0,0 +1,291 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "drift-resampler.h"
+#include "fanout-ring-buffer.h"
+#include "fill-controller.h"
+#include "gain.h"
+#include "io-histogram.h"
+#include "sample-convert.h"
+#include "seqlock.h"
+#include "shm-ring.h"
+#include "triple-buffer.h"
+#include "types.h"
+#include "zero-timestamp.h"
+
+// Per-cycle timing histograms. Off by default; enable with the
+// PULSE_AUDIO_IO_HISTOGRAMS CMake option. When off, nothing is compiled in.
+#ifndef PULSE_AUDIO_IO_HISTOGRAMS
+#define PULSE_AUDIO_IO_HISTOGRAMS 0
+#endif
+
+// Snapshot of the IO counters, cumulative since the engine was created
+struct IOStats {
+    UInt64 writeMixCycles;
+    UInt64 readInputCycles;
+    UInt64 overrunFrames;        // frames skipped by readers that fell a whole ring behind
+    UInt64 underrunFrames;       // ReadInput frames padded because the ring was empty
+    UInt64 fillDroppedFrames;    // backlog dropped by the fill controller
+    UInt64 silentFrames;         // WriteMix frames stored as a silent-run marker
+    Float64 resampleRatio;       // read-side ratio of the fullest reader
+    UInt32 fillFrames;           // ring fill seen by the fullest reader's last ReadInput
+    UInt32 highWaterFrames;      // highest fill seen by any ReadInput
+    UInt32 capacityFrames;       // configured capacity (see SetBufferConfig)
+    UInt32 allocatedFrames;      // ring frames allocated; at least the capacity at kMaxSampleRate
+    UInt32 readers;              // capture clients currently reading
+};
+
+// Output mix levels after gain, per channel, linear (1.0 = full scale)
+struct MeterLevels {
+    UInt64  periods;                  // WriteMix periods metered since the engine was created
+    UInt64  frames;                   // frames the levels cover
+    UInt32  channels;                 // 0 until the first WriteMix
+    Float32 peak[kMaxNumChannels];
+    Float32 rms[kMaxNumChannels];
+};
+
+// Platform-neutral IO core of the virtual device: the loopback ring buffer,
+// output gain and zero-timestamp math. PulseDevice owns one of these and
+// forwards the HAL IO callbacks to it; pulse-audio-bench drives it directly.
+//
+// The ring fans out to several capture clients. Each client registered with
+// AddClient() has its own read cursor, fill controller and resampler, so
+// every client gets the full stream and a slow one only loses its own
+// frames. ReadInput from an unregistered client ID uses a shared reader.
+class IOEngine {
+public:
+    IOEngine();
+    ~IOEngine();
+
+    // IO lifecycle — reference counted across clients. Only the first
+    // StartIO (which sets up the ring) takes the configuration lock; other
+    // start/stop calls are a compare-and-swap on the count. GetZeroTimeStamp
+    // reads a seqlock-published anchor and never blocks.
+    OSStatus StartIO();
+    OSStatus StopIO();
+    void     GetZeroTimeStamp(Float64* outSampleTime,
+                              UInt64* outHostTime,
+                              UInt64* outSeed);
+
+    // Handle a WriteMix or ReadInput operation on the interleaved buffer: float
+    // for WriteMix, the input sample format for ReadInput. clientID picks the
+    // reader for ReadInput. Other operation IDs are ignored.
+    OSStatus DoIOOperation(UInt32 operationID,
+                           UInt32 clientID,
+                           UInt32 ioBufferFrameSize,
+                           AudioBufferList* ioMainBuffer);
+
+    // Capture clients (from AddDeviceClient / RemoveDeviceClient). A client
+    // joins the stream on its first ReadInput, one target fill behind the writer.
+    // AddClient returns kAudioHardwareIllegalOperationError when all
+    // reader slots are taken; that client then shares the common reader.
+    OSStatus AddClient(UInt32 clientID);
+    void     RemoveClient(UInt32 clientID);
+
+    // Nominal rate. Changing it rescales the capacity and target fill to keep
+    // their duration, and resets the ring. Ring storage is sized for
+    // kMaxSampleRate up front, so a rate change never reallocates. Only
+    // allowed while IO is stopped (from PerformDeviceConfigurationChange).
+    // Returns kAudioHardwareIllegalOperationError for an unsupported rate or
+    // while IO is running.
+    static bool IsSupportedSampleRate(Float64 sampleRate);
+    Float64  GetSampleRate() const { return mAnchor.Load().sampleRate; }
+    OSStatus SetSampleRate(Float64 sampleRate);
+    UInt32   GetFramesPerPeriod() const { return mAnchor.Load().clock.framesPerPeriod; }
+
+    // Interleaved channels per ring frame: the output stream's layout, which
+    // the input stream mirrors unless it is in mono mode. Changing it
+    // reallocates the ring, so it is only allowed while IO is stopped
+    // (kAudioHardwareIllegalOperationError otherwise, or for a count not in
+    // kSupportedChannelCounts). Buffered audio is discarded.
+    static bool IsSupportedChannelCount(UInt32 channels);
+    UInt32   GetChannelCount() const { return mChannelCount.load(std::memory_order_relaxed); }
+    OSStatus SetChannelCount(UInt32 channels);
+
+    // Sample format ReadInput delivers (an InputSampleFormat). Int16 is
+    // converted from the resampler's float output, clamped and, with dither
+    // enabled, TPDF-dithered. Like the channel count, the format only
+    // changes while IO is stopped; dither can be toggled at any time.
+    UInt32   GetInputSampleFormat() const { return mInputSampleFormat.load(std::memory_order_relaxed); }
+    OSStatus SetInputSampleFormat(UInt32 format);
+    bool     IsInputDitherEnabled() const { return mInputDither.load(std::memory_order_relaxed); }
+    void     SetInputDitherEnabled(bool enabled) { mInputDither.store(enabled, std::memory_order_relaxed); }
+
+    // Input channel layout (an InputChannelMode). In mono mode ring frames
+    // are downmixed before the drift resampler, so it runs on one channel.
+    // Stop-only, like the channel count.
+    UInt32   GetInputChannelMode() const { return mInputChannelMode.load(std::memory_order_relaxed); }
+    OSStatus SetInputChannelMode(UInt32 mode);
+    UInt32   GetInputChannelCount() const;
+
+    // Volume and mute are set from the control thread; the IO thread ramps
+    // from the previously applied gain to the new one across the next period.
+    Float32  GetVolume() const { return mVolume.load(std::memory_order_relaxed); }
+    void     SetVolume(Float32 volume) { mVolume.store(volume, std::memory_order_relaxed); }
+    bool     IsMuted() const { return mMuted.load(std::memory_order_relaxed); }
+    void     SetMuted(bool muted) { mMuted.store(muted, std::memory_order_relaxed); }
+    bool     IsIORunning() const { return mIOStartCount.load(std::memory_order_acquire) > 0; }
+
+    // Whether the output mix currently carries signal (see kSilenceThreshold).
+    // Updated by WriteMix; false until the first audible period after StartIO.
+    bool     IsInputActive() const { return mInputActive.load(std::memory_order_relaxed); }
+
+    // Ring capacity and target fill level, in frames at the current rate.
+    // The capacity is the most a capture client's fill may reach; anything
+    // beyond it is dropped by the fill controller. The ring behind it is
+    // rounded up and sized for the highest supported rate. Both limits apply
+    // from the next IO cycle; a capacity change also reallocates the ring,
+    // which happens immediately when IO is stopped and otherwise on the next
+    // StartIO.
+    // Returns kAudioHardwareIllegalOperationError for out-of-range values.
+    OSStatus SetBufferConfig(UInt32 capacityFrames, UInt32 targetFillFrames);
+    UInt32   GetCapacityFrames() const { return mCapacityFrames.load(std::memory_order_relaxed); }
+    UInt32   GetTargetFillFrames() const { return mTargetFillFrames.load(std::memory_order_relaxed); }
+
+    // Optional shared-memory copy of the post-gain mix (see shm-ring.h), for
+    // a native reader that maps it instead of capturing through the input
+    // stream. An empty name turns it off. Like a capacity change it is applied
+    // immediately when IO is stopped, and then reports a failure to create
+    // the segment; otherwise it is applied on the next StartIO, which also
+    // recreates the segment when the format has changed.
+    // Returns kAudioHardwareIllegalOperationError for an invalid name.
+    OSStatus SetSharedMemoryName(const char* name);
+    std::string GetSharedMemoryName();
+
+    // Consistent snapshot of the IO counters. Lock-free; safe from any thread.
+    IOStats  GetStats() const;
+
+    // Levels of every WriteMix period since the previous ReadMeter(), so a
+    // meter polled slower than the period still catches each peak. WriteMix
+    // measures them in its gain pass and publishes through a triple buffer;
+    // concurrent callers here are serialized by a mutex the IO thread never takes.
+    MeterLevels ReadMeter();
+
+#if PULSE_AUDIO_IO_HISTOGRAMS
+    // Timing of one IO operation, recorded on its IO thread
+    struct IOTiming {
+        IOHistogram duration;       // time spent in DoIOOperation
+        IOHistogram interval;       // start-to-start time between successive calls
+        UInt64      lastStartTime;  // host time of the previous call, 0 after StartIO
+    };
+    const IOTiming& GetWriteMixTiming() const { return mWriteMixTiming; }
+    const IOTiming& GetReadInputTiming() const { return mReadInputTiming; }
+#endif
+
+private:
+    // Counters owned by one IO thread each, published through a seqlock so
+    // GetStats() never sees a half-updated set
+    struct WriteSideStats {
+        UInt64 cycles;
+        UInt64 overrunFrames;
+        UInt64 silentFrames;
+    };
+    struct ReadSideStats {
+        UInt64 cycles;
+        UInt64 underrunFrames;
+        UInt64 fillDroppedFrames;
+        Float64 resampleRatio;
+        UInt32 fillFrames;
+        UInt32 highWaterFrames;
+    };
+
+    // Read-side state of one capture client. Slot kSharedReader serves
+    // client IDs that were never registered.
+    struct CaptureClient {
+        std::atomic<bool>   registered;
+        std::atomic<UInt32> clientID;
+        FillController  fillController;     // IO thread only
+        DriftResampler  resampler;          // IO thread only
+        ReadSideStats   stats;              // IO thread only
+        std::vector<float> convertBuffer;   // resampler output ahead of Int16 conversion; IO thread only
+        std::vector<float> downmixBuffer;   // ring frames ahead of the mono downmix; IO thread only
+        DitherState     dither;             // IO thread only
+        alignas(kCacheLineSize) Seqlock<ReadSideStats> publishedStats;
+    };
+    static const UInt32 kSharedReader = 0;
+
+    // Levels accumulated by WriteMix until the reader takes them
+    struct MeterRecord {
+        UInt64  periods;
+        UInt64  frames;
+        UInt32  channels;
+        Float32 peak[kMaxNumChannels];
+        Float64 sumSquares[kMaxNumChannels];
+    };
+
+    // Everything GetZeroTimeStamp needs, published as one record
+    struct TimestampAnchor {
+        ZeroTimestampClock clock;
+        UInt64  seed;             // changes whenever the timeline does
+        Float64 sampleRate;
+    };
+
+    // Ring frames to allocate for a capacity at the current rate
+    UInt32   RingAllocationFrames(UInt32 capacityFrames) const;
+
+    // Publish a new timeline starting at hostTime (config lock held)
+    void     PublishAnchor(UInt64 hostTime);
+
+    // Reader slot for a client ID; lock-free
+    UInt32   FindReader(UInt32 clientID) const;
+
+    // Clear every reader's controller and resampler (config lock held, IO stopped)
+    void     ResetReaders();
+
+    // Size every reader's resampler for the input layout (config lock held, IO stopped)
+    void     InitializeResamplers();
+
+    // Create, recreate or close the shared-memory ring to match the
+    // requested name and format (config lock held, IO stopped)
+    OSStatus UpdateSharedMemory();
+
+    void     WriteMix(const float* buffer, UInt32 numFrames);
+    void     PublishMeter(const ChannelLevels& levels, UInt32 numFrames, UInt32 channels);
+    void     ReadInput(UInt32 reader, void* buffer, UInt32 numFrames);
+#if PULSE_AUDIO_IO_HISTOGRAMS
+    static void RecordTiming(IOTiming& timing, UInt64 startTime);
+#endif
+
+    // State
+    Float64         mSampleRate;        // config lock; readers use mAnchor
+    UInt32          mFramesPerPeriod;   // config lock; readers use mAnchor
+    std::atomic<UInt32> mChannelCount;  // changed under the config lock while IO is stopped
+    std::atomic<UInt32> mInputSampleFormat; // likewise
+    std::atomic<UInt32> mInputChannelMode;  // likewise
+    std::atomic<bool>    mInputDither;
+    std::atomic<Float32> mVolume;
+    std::atomic<bool>    mMuted;
+    Float32         mAppliedGain;   // gain at the end of the last WriteMix (IO thread only)
+    UInt32          mSilentRunFrames;   // consecutive frames below the threshold, saturating (IO thread only)
+    std::atomic<bool>    mInputActive;
+    std::atomic<UInt32>  mIOStartCount;
+    UInt64          mTimestampSeed;     // config lock
+    Seqlock<TimestampAnchor> mAnchor;   // written under the config lock
+    std::atomic<UInt32> mCapacityFrames;     // requested ring capacity
+    std::atomic<UInt32> mTargetFillFrames;
+    UInt32          mAllocatedCapacityFrames; // ring frames allocated (for kMaxSampleRate)
+    FanoutRingBuffer mRingBuffer;
+    CaptureClient   mReaders[FanoutRingBuffer::kMaxReaders];
+    std::mutex      mConfigMutex;           // serializes ring, anchor and client changes; never taken on the IO path
+
+    // Shared-memory transport — the name is config lock; the writer is
+    // only replaced while IO is stopped, so WriteMix uses it without a lock
+    std::string     mSharedMemoryName;
+    ShmRingWriter   mSharedMemory;
+
+    // Write-side stats — the working copy is only touched by the WriteMix thread
+    WriteSideStats  mWriteStats;
+    alignas(kCacheLineSize) Seqlock<WriteSideStats> mPublishedWriteStats;
+
+    // Metering — the accumulator is only touched by the WriteMix thread
+    MeterRecord     mMeterAccum;
+    TripleBuffer<MeterRecord> mMeter;
+    std::mutex      mMeterReadMutex;        // makes ReadMeter() the triple buffer's single reader
+#if PULSE_AUDIO_IO_HISTOGRAMS
+    alignas(kCacheLineSize) IOTiming mWriteMixTiming;
+    alignas(kCacheLineSize) IOTiming mReadInputTiming;
+#endif
+};
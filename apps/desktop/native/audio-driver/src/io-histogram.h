@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include "platform.h"
+
+// Fixed log2-bucket histogram of nanosecond durations.
+// Bucket 0 counts values below 2 ns; bucket i (i > 0) counts [2^i, 2^(i+1)) ns.
+// The last bucket also takes everything above its range (~2 s and up).
+// Storage is preallocated and Record() is wait-free, so it is safe on the
+// real-time IO thread. There must be a single writer; readers on other
+// threads see each bucket atomically, though not all buckets at one instant.
+class IOHistogram {
+public:
+    static const UInt32 kNumBuckets = 32;
+
+    IOHistogram() {
+        for (UInt32 i = 0; i < kNumBuckets; i++) {
+            mBuckets[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void Record(UInt64 nanos) {
+        UInt32 bucket = nanos < 2 ? 0 : 63 - (UInt32)__builtin_clzll(nanos);
+        if (bucket >= kNumBuckets) bucket = kNumBuckets - 1;
+        std::atomic<UInt64>& count = mBuckets[bucket];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    UInt64 BucketCount(UInt32 bucket) const {
+        return mBuckets[bucket].load(std::memory_order_relaxed);
+    }
+
+    // Exclusive upper bound of a bucket, in nanoseconds
+    static UInt64 BucketLimitNanos(UInt32 bucket) { return (UInt64)2 << bucket; }
+
+    // Upper bound of the bucket holding the given fraction (0..1) of samples,
+    // or 0 when nothing has been recorded
+    UInt64 PercentileNanos(Float64 fraction) const {
+        UInt64 total = 0;
+        for (UInt32 i = 0; i < kNumBuckets; i++) total += BucketCount(i);
+        if (total == 0) return 0;
+
+        UInt64 rank = (UInt64)(fraction * (Float64)total);
+        if (rank >= total) rank = total - 1;
+
+        UInt64 seen = 0;
+        for (UInt32 i = 0; i < kNumBuckets; i++) {
+            seen += BucketCount(i);
+            if (seen > rank) return BucketLimitNanos(i);
+        }
+        return BucketLimitNanos(kNumBuckets - 1);
+    }
+
+private:
+    std::atomic<UInt64> mBuckets[kNumBuckets];
+};
@@ -0,0 +1,231 @@
+#include "io-simulator.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "io-engine.h"
+
+// Client ID of the simulated capture client
+static const UInt32 kSimulatedClientID = 1;
+
+// Test tone the writer plays: 440 Hz at -6 dBFS on every channel
+static const Float64 kToneHz        = 440.0;
+static const Float32 kToneAmplitude = 0.5f;
+
+// ============================================================================
+// Virtual clock
+// ============================================================================
+
+namespace {
+
+// Wake-up times of one simulated IO thread, in seconds since StartIO. Cycle n
+// is due at n periods of the drifted clock; the thread wakes late by the
+// jitter and any stall covering that time. Randomness comes from a
+// mersenne twister with hand-rolled distributions, since the standard ones
+// differ between standard libraries.
+class VirtualClock {
+public:
+    VirtualClock(const VirtualClockConfig& config, Float64 sampleRate, UInt64 seed)
+        : mConfig(config)
+        , mPeriodSeconds(config.framesPerPeriod / (sampleRate * (1.0 + config.driftPPM * 1e-6)))
+        , mRandom(seed)
+        , mCycle(0)
+        , mWake(0.0)
+        , mSkipped(0)
+    {
+        std::sort(mConfig.stalls.begin(), mConfig.stalls.end(),
+                  [](const SimulatedStall& a, const SimulatedStall& b) { return a.startSeconds < b.startSeconds; });
+        Schedule();
+    }
+
+    Float64 NextWake() const { return mWake; }
+    UInt64  Skipped() const { return mSkipped; }
+
+    // The cycle at NextWake() has run; schedule the next one
+    void Advance()
+    {
+        mCycle++;
+        Schedule();
+    }
+
+private:
+    Float64 Due(UInt64 cycle) const { return (Float64)cycle * mPeriodSeconds; }
+
+    // Uniform in [0, 1)
+    Float64 Uniform() { return (Float64)(mRandom() >> 11) * (1.0 / 9007199254740992.0); }
+
+    Float64 Jitter()
+    {
+        Float64 scale = mConfig.jitterMicros * 1e-6;
+        if (scale <= 0.0) return 0.0;
+        if (mConfig.jitter == kJitter_Uniform) return Uniform() * scale;
+
+        // Box-Muller; only lateness, so the magnitude
+        Float64 u1 = 1.0 - Uniform();
+        Float64 u2 = Uniform();
+        return fabs(sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2)) * scale;
+    }
+
+    void Schedule()
+    {
+        Float64 due  = Due(mCycle);
+        Float64 wake = std::max(due + Jitter(), mWake);
+
+        // A random stall starting at this cycle, as a Bernoulli trial per period
+        if (mConfig.stallsPerMinute > 0.0 &&
+            Uniform() < mConfig.stallsPerMinute * mPeriodSeconds / 60.0) {
+            wake = std::max(wake, due + mConfig.stallMs * 1e-3);
+        }
+
+        // Fixed stalls, in order, so back-to-back stalls chain
+        for (const SimulatedStall& stall : mConfig.stalls) {
+            Float64 end = stall.startSeconds + stall.durationMs * 1e-3;
+            if (wake >= stall.startSeconds && wake < end) wake = end;
+        }
+
+        // Whole periods missed are skipped (an IO overload); run the latest one due
+        if (wake - due >= mPeriodSeconds) {
+            UInt64 missed = (UInt64)((wake - due) / mPeriodSeconds);
+            mCycle   += missed;
+            mSkipped += missed;
+        }
+        mWake = wake;
+    }
+
+    VirtualClockConfig mConfig;
+    Float64            mPeriodSeconds;
+    std::mt19937_64    mRandom;
+    UInt64             mCycle;
+    Float64            mWake;
+    UInt64             mSkipped;
+};
+
+// Independent, reproducible seeds for the two clocks (splitmix64)
+UInt64 MixSeed(UInt64 seed)
+{
+    UInt64 z = seed + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+} // namespace
+
+// ============================================================================
+// Simulation
+// ============================================================================
+
+static OSStatus ConfigureEngine(IOEngine& engine, const SimulationConfig& config)
+{
+    OSStatus status = engine.SetSampleRate(config.sampleRate);
+    if (status != kAudioHardwareNoError) return status;
+    status = engine.SetChannelCount(config.channels);
+    if (status != kAudioHardwareNoError) return status;
+
+    if (config.capacityFrames != 0 || config.targetFillFrames != 0) {
+        UInt32 capacity = config.capacityFrames ? config.capacityFrames : engine.GetCapacityFrames();
+        UInt32 target   = config.targetFillFrames ? config.targetFillFrames : engine.GetTargetFillFrames();
+        status = engine.SetBufferConfig(capacity, target);
+        if (status != kAudioHardwareNoError) return status;
+    }
+
+    engine.AddClient(kSimulatedClientID);
+    return engine.StartIO();
+}
+
+static void RecordSample(const SimulationResult& result, const IOStats& stats, Float64 sampleRate,
+                         Float64 timeSeconds, std::vector<SimulationSample>* trace)
+{
+    SimulationSample sample;
+    sample.timeSeconds    = timeSeconds;
+    sample.fillFrames     = stats.fillFrames;
+    sample.latencyMs      = stats.fillFrames * 1000.0 / sampleRate;
+    sample.resampleRatio  = stats.resampleRatio;
+    sample.underrunFrames = stats.underrunFrames;
+    sample.overrunFrames  = stats.overrunFrames;
+    sample.droppedFrames  = stats.fillDroppedFrames;
+    sample.glitches       = result.Glitches();
+    trace->push_back(sample);
+}
+
+OSStatus RunSimulation(const SimulationConfig& config, SimulationResult* outResult)
+{
+    *outResult = SimulationResult();
+    SimulationResult& result = *outResult;
+    result.minLatencyMs = 0.0;
+
+    IOEngine engine;
+    OSStatus status = ConfigureEngine(engine, config);
+    if (status != kAudioHardwareNoError) return status;
+
+    VirtualClock writer(config.writer, config.sampleRate, MixSeed(config.seed));
+    VirtualClock reader(config.reader, config.sampleRate, MixSeed(config.seed ^ 0x5245414445520000ull));
+
+    const UInt32 channels = config.channels;
+    std::vector<float> writeBuffer((size_t)config.writer.framesPerPeriod * channels);
+    std::vector<float> readBuffer((size_t)config.reader.framesPerPeriod * channels);
+    AudioBufferList writeList = { 1, { { channels, (UInt32)(writeBuffer.size() * sizeof(float)), writeBuffer.data() } } };
+    AudioBufferList readList  = { 1, { { channels, (UInt32)(readBuffer.size() * sizeof(float)), readBuffer.data() } } };
+
+    const Float64 toneStep = 2.0 * M_PI * kToneHz / config.sampleRate;
+    const Float64 traceInterval = config.traceIntervalMs * 1e-3;
+    Float64 nextTrace   = 0.0;
+    Float64 tonePhase   = 0.0;
+    Float64 latencySum  = 0.0;
+    IOStats last        = engine.GetStats();
+
+    for (;;) {
+        // Ties go to the writer, as the HAL runs WriteMix before ReadInput
+        bool writeNext = writer.NextWake() <= reader.NextWake();
+        VirtualClock& clock = writeNext ? writer : reader;
+        Float64 now = clock.NextWake();
+        if (now >= config.durationSeconds) break;
+
+        while (traceInterval > 0.0 && nextTrace <= now) {
+            RecordSample(result, last, config.sampleRate, nextTrace, &result.trace);
+            nextTrace += traceInterval;
+        }
+
+        if (writeNext) {
+            for (UInt32 frame = 0; frame < config.writer.framesPerPeriod; frame++) {
+                float value = kToneAmplitude * (float)sin(tonePhase);
+                for (UInt32 ch = 0; ch < channels; ch++) writeBuffer[frame * channels + ch] = value;
+                tonePhase = fmod(tonePhase + toneStep, 2.0 * M_PI);
+            }
+            engine.DoIOOperation(kAudioServerPlugInIOOperationWriteMix, 0,
+                                 config.writer.framesPerPeriod, &writeList);
+            result.writeCycles++;
+        } else {
+            engine.DoIOOperation(kAudioServerPlugInIOOperationReadInput, kSimulatedClientID,
+                                 config.reader.framesPerPeriod, &readList);
+            result.readCycles++;
+
+            IOStats stats = engine.GetStats();
+            if (stats.underrunFrames > last.underrunFrames) result.underrunGlitches++;
+            if (stats.overrunFrames > last.overrunFrames) result.overrunGlitches++;
+            if (stats.fillDroppedFrames > last.fillDroppedFrames) result.dropGlitches++;
+
+            Float64 latencyMs = stats.fillFrames * 1000.0 / config.sampleRate;
+            if (result.readCycles == 1 || latencyMs < result.minLatencyMs) result.minLatencyMs = latencyMs;
+            if (latencyMs > result.maxLatencyMs) result.maxLatencyMs = latencyMs;
+            latencySum += latencyMs;
+            last = stats;
+        }
+        clock.Advance();
+    }
+
+    while (traceInterval > 0.0 && nextTrace < config.durationSeconds) {
+        RecordSample(result, last, config.sampleRate, nextTrace, &result.trace);
+        nextTrace += traceInterval;
+    }
+
+    engine.StopIO();
+    IOStats stats = engine.GetStats();
+    result.skippedWriteCycles = writer.Skipped();
+    result.skippedReadCycles  = reader.Skipped();
+    result.underrunFrames     = stats.underrunFrames;
+    result.overrunFrames      = stats.overrunFrames;
+    result.droppedFrames      = stats.fillDroppedFrames;
+    result.meanLatencyMs      = result.readCycles ? latencySum / result.readCycles : 0.0;
+    result.finalRatio         = stats.resampleRatio;
+    return kAudioHardwareNoError;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vector>
+#include "types.h"
+
+// Deterministic soak test of the IO core on a virtual clock. One IOEngine
+// (the portable half of PulseDevice) is driven by two independent simulated
+// IO threads: a writer making WriteMix calls and a capture client making
+// ReadInput calls, each on its own clock with its own period, ppm drift,
+// wake-up jitter and scheduling stalls. Nothing waits on real time, so an
+// hour of playback runs in seconds, and the same config and seed
+// always give the same result.
+//
+// A stall that makes a thread miss whole periods skips them, as coreaudiod
+// does on an IO overload: a stalled writer loses that audio, a stalled
+// reader comes back to a backlog.
+
+enum JitterDistribution : UInt32 {
+    kJitter_Uniform  = 0,   // wake-up delay uniform in [0, jitterMicros]
+    kJitter_Gaussian = 1,   // |N(0, jitterMicros)|
+};
+
+// A stall of one IO thread at a fixed time
+struct SimulatedStall {
+    Float64 startSeconds;
+    Float64 durationMs;
+};
+
+// Clock of one simulated IO thread
+struct VirtualClockConfig {
+    UInt32  framesPerPeriod = kFramesPerPeriod;
+    Float64 driftPPM        = 0.0;      // positive runs fast against the nominal rate
+    JitterDistribution jitter = kJitter_Gaussian;
+    Float64 jitterMicros    = 0.0;      // wake-up lateness; never early
+    Float64 stallsPerMinute = 0.0;      // random stalls, on average
+    Float64 stallMs         = 0.0;      // length of each random stall
+    std::vector<SimulatedStall> stalls;
+};
+
+struct SimulationConfig {
+    Float64 sampleRate       = kDefaultSampleRate;
+    UInt32  channels         = kDefaultNumChannels;
+    UInt32  capacityFrames   = 0;       // 0 keeps the engine default
+    UInt32  targetFillFrames = 0;       // likewise
+    Float64 durationSeconds  = 60.0;
+    Float64 traceIntervalMs  = 100.0;   // 0 records no trace
+    UInt64  seed             = 1;
+    VirtualClockConfig writer;
+    VirtualClockConfig reader;
+};
+
+// One row of the trace: state after the last IO call before timeSeconds.
+// Frame and glitch counts are cumulative.
+struct SimulationSample {
+    Float64 timeSeconds;
+    UInt32  fillFrames;         // ring fill seen by the last ReadInput
+    Float64 latencyMs;          // the same fill as capture latency
+    Float64 resampleRatio;
+    UInt64  underrunFrames;
+    UInt64  overrunFrames;
+    UInt64  droppedFrames;
+    UInt64  glitches;
+};
+
+struct SimulationResult {
+    UInt64  writeCycles;
+    UInt64  readCycles;
+    UInt64  skippedWriteCycles;     // periods a stalled writer missed
+    UInt64  skippedReadCycles;      // periods a stalled reader missed
+
+    // A glitch is a ReadInput during which frames were padded (underrun),
+    // skipped because the reader fell a whole ring behind (overrun), or
+    // dropped by the fill controller to cut a backlog
+    UInt64  underrunGlitches;
+    UInt64  overrunGlitches;
+    UInt64  dropGlitches;
+    UInt64  underrunFrames;
+    UInt64  overrunFrames;
+    UInt64  droppedFrames;
+
+    // Capture latency (ring fill) over every ReadInput
+    Float64 minLatencyMs;
+    Float64 maxLatencyMs;
+    Float64 meanLatencyMs;
+    Float64 finalRatio;             // resample ratio the fill controller settled on
+
+    std::vector<SimulationSample> trace;
+
+    UInt64  Glitches() const { return underrunGlitches + overrunGlitches + dropGlitches; }
+};
+
+// Run config to completion. Fails with the engine's status if the rate,
+// channel count or buffer config is rejected.
+OSStatus RunSimulation(const SimulationConfig& config, SimulationResult* outResult);
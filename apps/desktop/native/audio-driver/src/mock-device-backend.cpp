@@ -0,0 +1,292 @@
+#include "mock-device-backend.h"
+#include <utility>
+#include "helper-service.h"
+
+// Transport types of the seeded devices ('bltn', 'blue', 'virt', 'grup')
+static const UInt32 kTransportBuiltIn   = 0x626C746E;
+static const UInt32 kTransportBluetooth = 0x626C7565;
+static const UInt32 kTransportVirtual   = 0x76697274;
+static const UInt32 kTransportAggregate = 0x67727570;
+
+MockDeviceBackend::MockDeviceBackend()
+    : mDefaultOutput(kAudioObjectUnknown)
+    , mNextID(40)
+    , mGeneration(1)
+    , mListCalls(0)
+    , mTranslateCalls(0)
+    , mSettleDelay(0)
+    , mStalled(false)
+    , mStopping(false)
+{
+    mDefaultOutput = AddDevice("BuiltInSpeakerDevice", "MacBook Pro Speakers", 1, 0, kTransportBuiltIn);
+    AddDevice("AA-BB-CC-DD-EE-FF:output", "AirPods Pro", 1, 1, kTransportBluetooth);
+    AddDevice(kPulseDeviceUID, "Pulse Audio", 1, 1, kTransportVirtual);
+}
+
+MockDeviceBackend::~MockDeviceBackend()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mPendingCond.notify_all();
+    if (mSettleThread.joinable()) mSettleThread.join();
+}
+
+// ============================================================================
+// Test hooks
+// ============================================================================
+
+AudioObjectID MockDeviceBackend::AddDevice(const std::string& uid, const std::string& name,
+                                           UInt32 outputStreams, UInt32 inputStreams, UInt32 transportType)
+{
+    AudioObjectID id;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        id = AddDeviceLocked(uid, name, outputStreams, inputStreams, transportType);
+    }
+    mEvents.Notify();
+    return id;
+}
+
+void MockDeviceBackend::RemoveDevice(AudioObjectID deviceId)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        RemoveDeviceLocked(deviceId);
+    }
+    mEvents.Notify();
+}
+
+UInt32 MockDeviceBackend::ListCalls() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mListCalls;
+}
+
+UInt32 MockDeviceBackend::TranslateCalls() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mTranslateCalls;
+}
+
+const std::vector<std::string>* MockDeviceBackend::SubDevices(AudioObjectID aggregateId) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const MockDevice& device : mDevices) {
+        if (device.info.id == aggregateId && device.aggregate) return &device.subDeviceUIDs;
+    }
+    return nullptr;
+}
+
+void MockDeviceBackend::SetSettleDelay(std::chrono::milliseconds delay)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSettleDelay = delay;
+}
+
+void MockDeviceBackend::SetStalled(bool stalled)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStalled = stalled;
+}
+
+// ============================================================================
+// Device state (mMutex held)
+// ============================================================================
+
+AudioObjectID MockDeviceBackend::AddDeviceLocked(const std::string& uid, const std::string& name,
+                                                 UInt32 outputStreams, UInt32 inputStreams, UInt32 transportType)
+{
+    MockDevice device;
+    device.info.id            = mNextID++;
+    device.info.uid           = uid;
+    device.info.name          = name;
+    device.info.outputStreams = outputStreams;
+    device.info.inputStreams  = inputStreams;
+    device.info.transportType = transportType;
+    device.aggregate          = false;
+    device.alive              = true;
+    mDevices.push_back(device);
+    mGeneration.fetch_add(1, std::memory_order_acq_rel);
+    return device.info.id;
+}
+
+void MockDeviceBackend::RemoveDeviceLocked(AudioObjectID deviceId)
+{
+    for (size_t i = 0; i < mDevices.size(); i++) {
+        if (mDevices[i].info.id != deviceId) continue;
+        mDevices.erase(mDevices.begin() + i);
+        mGeneration.fetch_add(1, std::memory_order_acq_rel);
+        break;
+    }
+
+    if (deviceId == mDefaultOutput) {
+        mDefaultOutput = kAudioObjectUnknown;
+        for (const MockDevice& device : mDevices) {
+            if (device.info.outputStreams > 0) {
+                mDefaultOutput = device.info.id;
+                break;
+            }
+        }
+    }
+}
+
+MockDeviceBackend::MockDevice* MockDeviceBackend::Find(AudioObjectID deviceId)
+{
+    for (MockDevice& device : mDevices) {
+        if (device.info.id == deviceId) return &device;
+    }
+    return nullptr;
+}
+
+// Apply a change now, after the settle delay, or never if stalled. The
+// caller notifies for a change applied now.
+void MockDeviceBackend::Defer(std::function<void()> apply)
+{
+    if (mStalled) return;
+    if (mSettleDelay.count() == 0) {
+        apply();
+        return;
+    }
+
+    PendingChange change;
+    change.due   = std::chrono::steady_clock::now() + mSettleDelay;
+    change.apply = std::move(apply);
+    mPending.push_back(std::move(change));
+    if (!mSettleThread.joinable()) mSettleThread = std::thread(&MockDeviceBackend::SettleThread, this);
+    mPendingCond.notify_all();
+}
+
+// Lands pending changes in order as they come due
+void MockDeviceBackend::SettleThread()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (!mStopping) {
+        if (mPending.empty()) {
+            mPendingCond.wait(lock);
+            continue;
+        }
+        if (std::chrono::steady_clock::now() < mPending.front().due) {
+            mPendingCond.wait_until(lock, mPending.front().due);
+            continue;
+        }
+
+        PendingChange change = std::move(mPending.front());
+        mPending.erase(mPending.begin());
+        change.apply();
+
+        lock.unlock();
+        mEvents.Notify();
+        lock.lock();
+    }
+}
+
+// ============================================================================
+// DeviceBackend
+// ============================================================================
+
+OSStatus MockDeviceBackend::ListDevices(std::vector<AudioDeviceInfo>* outDevices)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mListCalls++;
+    outDevices->clear();
+    for (const MockDevice& device : mDevices) outDevices->push_back(device.info);
+    return kAudioHardwareNoError;
+}
+
+OSStatus MockDeviceBackend::TranslateUIDToDevice(const std::string& uid, AudioObjectID* outDeviceId)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mTranslateCalls++;
+    *outDeviceId = kAudioObjectUnknown;
+    for (const MockDevice& device : mDevices) {
+        if (device.info.uid == uid) *outDeviceId = device.info.id;
+    }
+    return kAudioHardwareNoError;
+}
+
+OSStatus MockDeviceBackend::GetDefaultOutput(AudioObjectID* outDeviceId)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mDefaultOutput == kAudioObjectUnknown) return kAudioHardwareUnspecifiedError;
+    *outDeviceId = mDefaultOutput;
+    return kAudioHardwareNoError;
+}
+
+OSStatus MockDeviceBackend::SetDefaultOutput(AudioObjectID deviceId)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        MockDevice* device = Find(deviceId);
+        if (device == nullptr) return kAudioHardwareBadObjectError;
+        if (device->info.outputStreams == 0) return kAudioHardwareIllegalOperationError;
+
+        Defer([this, deviceId] {
+            // The target may have gone in the meantime
+            if (Find(deviceId)) mDefaultOutput = deviceId;
+        });
+    }
+    mEvents.Notify();
+    return kAudioHardwareNoError;
+}
+
+bool MockDeviceBackend::IsDeviceAlive(AudioObjectID deviceId)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    MockDevice* device = Find(deviceId);
+    return device != nullptr && device->alive;
+}
+
+OSStatus MockDeviceBackend::CreateAggregate(const std::string& uid,
+                                            const std::string& name,
+                                            const std::vector<std::string>& subDeviceUIDs,
+                                            const std::string& mainSubDeviceUID,
+                                            AudioObjectID* outDeviceId)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        // Like CoreAudio, refuse a duplicate UID or a sub-device that doesn't exist
+        for (const MockDevice& device : mDevices) {
+            if (device.info.uid == uid) return kAudioHardwareIllegalOperationError;
+        }
+
+        bool mainFound = false;
+        for (const std::string& subUID : subDeviceUIDs) {
+            bool found = false;
+            for (const MockDevice& device : mDevices) {
+                if (device.info.uid == subUID) found = true;
+            }
+            if (!found) return kAudioHardwareBadObjectError;
+            if (subUID == mainSubDeviceUID) mainFound = true;
+        }
+        if (!mainFound) return kAudioHardwareIllegalOperationError;
+
+        // Listed straight away, alive once it settles
+        AudioObjectID id = AddDeviceLocked(uid, name, 1, 0, kTransportAggregate);
+        MockDevice* device = Find(id);
+        device->aggregate     = true;
+        device->alive         = false;
+        device->subDeviceUIDs = subDeviceUIDs;
+        Defer([this, id] {
+            MockDevice* created = Find(id);
+            if (created) created->alive = true;
+        });
+        *outDeviceId = id;
+    }
+    mEvents.Notify();
+    return kAudioHardwareNoError;
+}
+
+OSStatus MockDeviceBackend::DestroyAggregate(AudioObjectID deviceId)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        MockDevice* device = Find(deviceId);
+        if (device == nullptr || !device->aggregate) return kAudioHardwareBadObjectError;
+        Defer([this, deviceId] { RemoveDeviceLocked(deviceId); });
+    }
+    mEvents.Notify();
+    return kAudioHardwareNoError;
+}
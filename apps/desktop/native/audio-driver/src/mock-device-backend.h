@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "device-backend.h"
+
+// In-memory DeviceBackend for tests and `pulse-audio-helper serve --mock`.
+// Starts with a built-in output, a Bluetooth headset and the Pulse Audio
+// loopback device, the first being the default output. Aggregates get the
+// next free ID and behave like real ones: destroying the default output
+// falls back to the first remaining device with output streams.
+//
+// By default every change takes effect before the call returns. With a
+// settle delay, changes land that much later on a background thread, as
+// they do in the HAL: a new aggregate is listed but not alive, a destroyed
+// one lingers, the default output switches late. A stalled backend accepts
+// changes and never applies them. Either way Events() is notified as
+// changes land. Safe to call from any thread.
+class MockDeviceBackend : public DeviceBackend {
+public:
+    MockDeviceBackend();
+    ~MockDeviceBackend() override;
+
+    OSStatus ListDevices(std::vector<AudioDeviceInfo>* outDevices) override;
+    UInt64   DeviceListGeneration() const override { return mGeneration.load(std::memory_order_acquire); }
+    OSStatus TranslateUIDToDevice(const std::string& uid, AudioObjectID* outDeviceId) override;
+    OSStatus GetDefaultOutput(AudioObjectID* outDeviceId) override;
+    OSStatus SetDefaultOutput(AudioObjectID deviceId) override;
+    bool     IsDeviceAlive(AudioObjectID deviceId) override;
+    OSStatus CreateAggregate(const std::string& uid,
+                             const std::string& name,
+                             const std::vector<std::string>& subDeviceUIDs,
+                             const std::string& mainSubDeviceUID,
+                             AudioObjectID* outDeviceId) override;
+    OSStatus DestroyAggregate(AudioObjectID deviceId) override;
+
+    // Test hooks
+    AudioObjectID AddDevice(const std::string& uid, const std::string& name,
+                            UInt32 outputStreams, UInt32 inputStreams, UInt32 transportType);
+    void     RemoveDevice(AudioObjectID deviceId);
+    UInt32   ListCalls() const;
+    UInt32   TranslateCalls() const;
+    const std::vector<std::string>* SubDevices(AudioObjectID aggregateId) const;
+    void     SetSettleDelay(std::chrono::milliseconds delay);
+    void     SetStalled(bool stalled);
+
+private:
+    struct MockDevice {
+        AudioDeviceInfo          info;
+        bool                     aggregate;
+        bool                     alive;
+        std::vector<std::string> subDeviceUIDs;
+    };
+
+    struct PendingChange {
+        std::chrono::steady_clock::time_point due;
+        std::function<void()>                 apply;   // runs with mMutex held
+    };
+
+    // Callers hold mMutex
+    AudioObjectID AddDeviceLocked(const std::string& uid, const std::string& name,
+                                  UInt32 outputStreams, UInt32 inputStreams, UInt32 transportType);
+    void        RemoveDeviceLocked(AudioObjectID deviceId);
+    MockDevice* Find(AudioObjectID deviceId);
+    void        Defer(std::function<void()> apply);
+
+    void        SettleThread();
+
+    mutable std::mutex         mMutex;
+    std::vector<MockDevice>    mDevices;
+    AudioObjectID              mDefaultOutput;
+    AudioObjectID              mNextID;
+    std::atomic<UInt64>        mGeneration;
+    UInt32                     mListCalls;
+    UInt32                     mTranslateCalls;
+
+    std::chrono::milliseconds  mSettleDelay;
+    bool                       mStalled;
+    std::vector<PendingChange> mPending;
+    std::condition_variable    mPendingCond;
+    std::thread                mSettleThread;
+    bool                       mStopping;
+};
@@ -0,0 +1,353 @@
+#include "ndjson.h"
+#include <cerrno>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// ============================================================================
+// Parsing
+// ============================================================================
+
+namespace {
+
+class Parser {
+public:
+    explicit Parser(const std::string& text) : mText(text), mPos(0) {}
+
+    bool ParseObject(JsonObject* outObject, std::string* outError);
+
+private:
+    void SkipSpace();
+    bool Fail(const char* message, std::string* outError);
+    bool ParseString(std::string* outValue, std::string* outError);
+    bool ParseScalar(JsonScalar* outValue, std::string* outError);
+    bool ParseHex4(UInt32* outValue);
+
+    const std::string& mText;
+    size_t             mPos;
+};
+
+void Parser::SkipSpace()
+{
+    while (mPos < mText.size() &&
+           (mText[mPos] == ' ' || mText[mPos] == '\t' || mText[mPos] == '\r' || mText[mPos] == '\n')) {
+        mPos++;
+    }
+}
+
+bool Parser::Fail(const char* message, std::string* outError)
+{
+    char buffer[96];
+    snprintf(buffer, sizeof(buffer), "%s at offset %zu", message, mPos);
+    *outError = buffer;
+    return false;
+}
+
+bool Parser::ParseHex4(UInt32* outValue)
+{
+    if (mPos + 4 > mText.size()) return false;
+    UInt32 value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = mText[mPos++];
+        value <<= 4;
+        if (c >= '0' && c <= '9')      value |= (UInt32)(c - '0');
+        else if (c >= 'a' && c <= 'f') value |= (UInt32)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') value |= (UInt32)(c - 'A' + 10);
+        else return false;
+    }
+    *outValue = value;
+    return true;
+}
+
+static void AppendUTF8(std::string* out, UInt32 codePoint)
+{
+    if (codePoint < 0x80) {
+        out->push_back((char)codePoint);
+    } else if (codePoint < 0x800) {
+        out->push_back((char)(0xC0 | (codePoint >> 6)));
+        out->push_back((char)(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        out->push_back((char)(0xE0 | (codePoint >> 12)));
+        out->push_back((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+        out->push_back((char)(0x80 | (codePoint & 0x3F)));
+    } else {
+        out->push_back((char)(0xF0 | (codePoint >> 18)));
+        out->push_back((char)(0x80 | ((codePoint >> 12) & 0x3F)));
+        out->push_back((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+        out->push_back((char)(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+bool Parser::ParseString(std::string* outValue, std::string* outError)
+{
+    if (mPos >= mText.size() || mText[mPos] != '"') return Fail("expected string", outError);
+    mPos++;
+
+    outValue->clear();
+    while (mPos < mText.size()) {
+        char c = mText[mPos++];
+        if (c == '"') return true;
+        if ((unsigned char)c < 0x20) return Fail("control character in string", outError);
+        if (c != '\\') {
+            outValue->push_back(c);
+            continue;
+        }
+
+        if (mPos >= mText.size()) break;
+        char escape = mText[mPos++];
+        switch (escape) {
+            case '"':  outValue->push_back('"');  break;
+            case '\\': outValue->push_back('\\'); break;
+            case '/':  outValue->push_back('/');  break;
+            case 'b':  outValue->push_back('\b'); break;
+            case 'f':  outValue->push_back('\f'); break;
+            case 'n':  outValue->push_back('\n'); break;
+            case 'r':  outValue->push_back('\r'); break;
+            case 't':  outValue->push_back('\t'); break;
+            case 'u': {
+                UInt32 codePoint;
+                if (!ParseHex4(&codePoint)) return Fail("bad \\u escape", outError);
+                // A high surrogate must be followed by a low one
+                if (codePoint >= 0xD800 && codePoint < 0xDC00) {
+                    UInt32 low;
+                    if (mPos + 2 > mText.size() || mText[mPos] != '\\' || mText[mPos + 1] != 'u') {
+                        return Fail("unpaired surrogate", outError);
+                    }
+                    mPos += 2;
+                    if (!ParseHex4(&low) || low < 0xDC00 || low >= 0xE000) {
+                        return Fail("unpaired surrogate", outError);
+                    }
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                } else if (codePoint >= 0xDC00 && codePoint < 0xE000) {
+                    return Fail("unpaired surrogate", outError);
+                }
+                AppendUTF8(outValue, codePoint);
+                break;
+            }
+            default:
+                return Fail("bad escape", outError);
+        }
+    }
+    return Fail("unterminated string", outError);
+}
+
+bool Parser::ParseScalar(JsonScalar* outValue, std::string* outError)
+{
+    size_t start = mPos;
+    *outValue = JsonScalar();
+    if (mPos >= mText.size()) return Fail("expected value", outError);
+
+    char c = mText[mPos];
+    if (c == '"') {
+        if (!ParseString(&outValue->string, outError)) return false;
+        outValue->type = JsonScalar::kString;
+    } else if (mText.compare(mPos, 4, "true") == 0) {
+        mPos += 4;
+        outValue->type    = JsonScalar::kBool;
+        outValue->boolean = true;
+    } else if (mText.compare(mPos, 5, "false") == 0) {
+        mPos += 5;
+        outValue->type    = JsonScalar::kBool;
+        outValue->boolean = false;
+    } else if (mText.compare(mPos, 4, "null") == 0) {
+        mPos += 4;
+        outValue->type = JsonScalar::kNull;
+    } else if (c == '-' || (c >= '0' && c <= '9')) {
+        // Validate the JSON number grammar; strtod does the conversion
+        size_t pos = mPos;
+        if (mText[pos] == '-') pos++;
+        if (pos >= mText.size() || mText[pos] < '0' || mText[pos] > '9') return Fail("bad number", outError);
+        if (mText[pos] == '0') {
+            pos++;
+        } else {
+            while (pos < mText.size() && mText[pos] >= '0' && mText[pos] <= '9') pos++;
+        }
+        if (pos < mText.size() && mText[pos] == '.') {
+            pos++;
+            size_t digits = pos;
+            while (pos < mText.size() && mText[pos] >= '0' && mText[pos] <= '9') pos++;
+            if (pos == digits) return Fail("bad number", outError);
+        }
+        if (pos < mText.size() && (mText[pos] == 'e' || mText[pos] == 'E')) {
+            pos++;
+            if (pos < mText.size() && (mText[pos] == '+' || mText[pos] == '-')) pos++;
+            size_t digits = pos;
+            while (pos < mText.size() && mText[pos] >= '0' && mText[pos] <= '9') pos++;
+            if (pos == digits) return Fail("bad number", outError);
+        }
+        outValue->type   = JsonScalar::kNumber;
+        outValue->number = strtod(mText.c_str() + mPos, nullptr);
+        mPos = pos;
+    } else if (c == '{' || c == '[') {
+        return Fail("nested values are not supported", outError);
+    } else {
+        return Fail("expected value", outError);
+    }
+
+    outValue->raw = mText.substr(start, mPos - start);
+    return true;
+}
+
+bool Parser::ParseObject(JsonObject* outObject, std::string* outError)
+{
+    outObject->clear();
+    SkipSpace();
+    if (mPos >= mText.size() || mText[mPos] != '{') return Fail("expected object", outError);
+    mPos++;
+
+    SkipSpace();
+    if (mPos < mText.size() && mText[mPos] == '}') {
+        mPos++;
+    } else {
+        for (;;) {
+            std::string key;
+            SkipSpace();
+            if (!ParseString(&key, outError)) return false;
+            SkipSpace();
+            if (mPos >= mText.size() || mText[mPos] != ':') return Fail("expected ':'", outError);
+            mPos++;
+            SkipSpace();
+
+            JsonScalar value;
+            if (!ParseScalar(&value, outError)) return false;
+            (*outObject)[key] = value;   // the last duplicate wins, as in JSON.parse
+
+            SkipSpace();
+            if (mPos < mText.size() && mText[mPos] == ',') { mPos++; continue; }
+            if (mPos < mText.size() && mText[mPos] == '}') { mPos++; break; }
+            return Fail("expected ',' or '}'", outError);
+        }
+    }
+
+    SkipSpace();
+    if (mPos != mText.size()) return Fail("trailing characters", outError);
+    return true;
+}
+
+}  // namespace
+
+bool ParseJsonObject(const std::string& text, JsonObject* outObject, std::string* outError)
+{
+    Parser parser(text);
+    return parser.ParseObject(outObject, outError);
+}
+
+// ============================================================================
+// Writing
+// ============================================================================
+
+void JsonWriter::Separate()
+{
+    if (mAfterKey) {
+        mAfterKey = false;
+        return;
+    }
+    if (!mHasItems.empty()) {
+        if (mHasItems.back()) mText.push_back(',');
+        mHasItems.back() = true;
+    }
+}
+
+JsonWriter& JsonWriter::BeginObject()
+{
+    Separate();
+    mText.push_back('{');
+    mHasItems.push_back(false);
+    return *this;
+}
+
+JsonWriter& JsonWriter::EndObject()
+{
+    mText.push_back('}');
+    mHasItems.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::BeginArray()
+{
+    Separate();
+    mText.push_back('[');
+    mHasItems.push_back(false);
+    return *this;
+}
+
+JsonWriter& JsonWriter::EndArray()
+{
+    mText.push_back(']');
+    mHasItems.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::Key(const char* key)
+{
+    String(key);
+    mText.push_back(':');
+    mAfterKey = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::String(const std::string& value)
+{
+    Separate();
+    mText.push_back('"');
+    for (char c : value) {
+        switch (c) {
+            case '"':  mText += "\\\""; break;
+            case '\\': mText += "\\\\"; break;
+            case '\n': mText += "\\n";  break;
+            case '\r': mText += "\\r";  break;
+            case '\t': mText += "\\t";  break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char escape[8];
+                    snprintf(escape, sizeof(escape), "\\u%04x", (unsigned)(unsigned char)c);
+                    mText += escape;
+                } else {
+                    mText.push_back(c);   // UTF-8 passes through
+                }
+        }
+    }
+    mText.push_back('"');
+    return *this;
+}
+
+JsonWriter& JsonWriter::UInt(UInt64 value)
+{
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), "%" PRIu64, (uint64_t)value);
+    return Raw(buffer);
+}
+
+JsonWriter& JsonWriter::Int(SInt64 value)
+{
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), "%" PRId64, (int64_t)value);
+    return Raw(buffer);
+}
+
+JsonWriter& JsonWriter::Number(double value)
+{
+    // JSON has no NaN or infinity
+    if (!std::isfinite(value)) return Null();
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.9g", value);
+    return Raw(buffer);
+}
+
+JsonWriter& JsonWriter::Bool(bool value)
+{
+    return Raw(value ? "true" : "false");
+}
+
+JsonWriter& JsonWriter::Null()
+{
+    return Raw("null");
+}
+
+JsonWriter& JsonWriter::Raw(const std::string& json)
+{
+    Separate();
+    mText += json;
+    return *this;
+}
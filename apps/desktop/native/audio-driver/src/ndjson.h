@@ -0,0 +1,56 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include "platform.h"
+
+// Just enough JSON for pulse-audio-helper's newline-delimited protocol.
+// Requests are flat objects of scalars, parsed by ParseJsonObject();
+// responses (and pulse-audio-sim's reports) are built with JsonWriter. No
+// dependencies, so the protocol code builds and is tested on Linux.
+
+struct JsonScalar {
+    enum Type { kNull, kBool, kNumber, kString };
+
+    Type        type = kNull;
+    bool        boolean = false;
+    double      number = 0.0;
+    std::string string;     // decoded value of a kString
+    std::string raw;        // the token as it appeared in the source
+};
+
+typedef std::map<std::string, JsonScalar> JsonObject;
+
+// Parse one JSON object whose values are all scalars. Nested objects and
+// arrays are rejected. Returns false with a message in outError.
+bool ParseJsonObject(const std::string& text, JsonObject* outObject, std::string* outError);
+
+// Appends JSON text; commas and key/value separators are inserted as needed
+class JsonWriter {
+public:
+    JsonWriter() : mAfterKey(false) {}
+
+    JsonWriter& BeginObject();
+    JsonWriter& EndObject();
+    JsonWriter& BeginArray();
+    JsonWriter& EndArray();
+    JsonWriter& Key(const char* key);
+
+    JsonWriter& String(const std::string& value);
+    JsonWriter& UInt(UInt64 value);
+    JsonWriter& Int(SInt64 value);
+    JsonWriter& Number(double value);           // null if not finite
+    JsonWriter& Bool(bool value);
+    JsonWriter& Null();
+    JsonWriter& Raw(const std::string& json);   // an already-encoded value
+
+    const std::string& Text() const { return mText; }
+
+private:
+    void Separate();
+
+    std::string       mText;
+    std::vector<bool> mHasItems;   // per open container
+    bool              mAfterKey;     // the next value completes a Key()
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+// Platform shim for the portable audio core (ring buffer, gain, IO engine).
+// On macOS this is just the CoreAudio plug-in header. Elsewhere it provides the
+// small subset of CoreAudio types and constants the core uses, so the IO hot
+// path can be built, tested and benchmarked on Linux.
+
+#if defined(__APPLE__)
+
+#include <CoreAudio/AudioServerPlugIn.h>
+
+#else
+
+#include <cstdint>
+
+typedef uint8_t   Boolean;
+typedef uint8_t   UInt8;
+typedef int16_t   SInt16;
+typedef uint32_t  UInt32;
+typedef int32_t   SInt32;
+typedef uint64_t  UInt64;
+typedef int64_t   SInt64;
+typedef float     Float32;
+typedef double    Float64;
+typedef SInt32    OSStatus;
+typedef UInt32    AudioObjectID;
+
+struct AudioBuffer {
+    UInt32  mNumberChannels;
+    UInt32  mDataByteSize;
+    void*   mData;
+};
+
+struct AudioBufferList {
+    UInt32      mNumberBuffers;
+    AudioBuffer mBuffers[1];
+};
+
+typedef UInt32    AudioObjectPropertySelector;
+typedef UInt32    AudioObjectPropertyScope;
+typedef UInt32    AudioObjectPropertyElement;
+
+struct AudioObjectPropertyAddress {
+    AudioObjectPropertySelector mSelector;
+    AudioObjectPropertyScope    mScope;
+    AudioObjectPropertyElement  mElement;
+};
+
+// Four-char codes spelled out as hex to avoid multi-char literal warnings
+enum : OSStatus {
+    kAudioHardwareNoError                   = 0,
+    kAudioHardwareNotRunningError           = 0x73746F70, // 'stop'
+    kAudioHardwareUnspecifiedError          = 0x77686174, // 'what'
+    kAudioHardwareUnknownPropertyError      = 0x77686F3F, // 'who?'
+    kAudioHardwareBadPropertySizeError      = 0x2173697A, // '!siz'
+    kAudioHardwareIllegalOperationError     = 0x6E6F7065, // 'nope'
+    kAudioHardwareBadObjectError            = 0x216F626A, // '!obj'
+};
+
+enum : UInt32 {
+    kAudioServerPlugInIOOperationReadInput  = 0x72656164, // 'read'
+    kAudioServerPlugInIOOperationWriteMix   = 0x726D6978, // 'rmix'
+};
+
+enum : AudioObjectID {
+    kAudioObjectUnknown                     = 0,
+    kAudioObjectPlugInObject                = 1,
+};
+
+#endif
@@ -1,16 +1,35 @@
 #include "plugin.h"
 #include "device.h"
+#include "property-table.h"
 #include "types.h"
 #include <CoreFoundation/CoreFoundation.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
 
 // ============================================================================
 // Global state
 // ============================================================================
 
 static AudioServerPlugInHostRef     gHost = nullptr;
-static PulseDevice*                 gDevice = nullptr;
 static UInt32                       gRefCount = 0;
 
+// Device table, indexed by slot. IO and property calls look devices up
+// without locking; gDeviceMutex only serializes create and destroy.
+static std::atomic<PulseDevice*>    gDevices[kMaxDevices];
+static std::mutex                   gDeviceMutex;
+
+// Destroyed devices. coreaudiod may still be inside a call on one when it is
+// removed from the table, so they are only freed when the plug-in is released.
+static std::vector<PulseDevice*>    gRetiredDevices;
+
+static InternedStrings              gStrings = {};
+
+const InternedStrings& PluginStrings()
+{
+    return gStrings;
+}
+
 // Forward declarations for the vtable
 static HRESULT   Plugin_QueryInterface(void* driver, REFIID iid, LPVOID* ppv);
 static ULONG     Plugin_AddRef(void* driver);
@@ -143,6 +162,89 @@ static AudioServerPlugInDriverInterface gDriverInterface = {
 
 static AudioServerPlugInDriverInterface* gDriverInterfacePtr = &gDriverInterface;
 
+// ============================================================================
+// Device table
+// ============================================================================
+
+// Device owning objectID, or nullptr — O(1), lock-free
+static PulseDevice* FindDevice(AudioObjectID objectID)
+{
+    if (objectID < kFirstDeviceObjectID) return nullptr;
+    UInt32 slot = DeviceSlotForObject(objectID);
+    if (slot >= kMaxDevices) return nullptr;
+    return gDevices[slot].load(std::memory_order_acquire);
+}
+
+// Copy up to maxCount device IDs in slot order; returns the total device count
+static UInt32 CopyDeviceIDs(AudioObjectID* ids, UInt32 maxCount)
+{
+    UInt32 count = 0;
+    for (UInt32 slot = 0; slot < kMaxDevices; slot++) {
+        PulseDevice* device = gDevices[slot].load(std::memory_order_acquire);
+        if (!device) continue;
+        if (ids && count < maxCount) ids[count] = device->GetObjectID();
+        count++;
+    }
+    return count;
+}
+
+static AudioObjectID TranslateUIDToDevice(CFStringRef uid)
+{
+    if (!uid) return kAudioObjectUnknown;
+    for (UInt32 slot = 0; slot < kMaxDevices; slot++) {
+        PulseDevice* device = gDevices[slot].load(std::memory_order_acquire);
+        if (device && CFStringCompare(device->GetUID(), uid, 0) == kCFCompareEqualTo) {
+            return device->GetObjectID();
+        }
+    }
+    return kAudioObjectUnknown;
+}
+
+// Create a device in the first free slot. A null uid or name picks the
+// slot's default. Caller holds gDeviceMutex.
+static OSStatus AddDevice(CFStringRef uid, CFStringRef name, AudioObjectID* outDeviceID)
+{
+    if (uid && TranslateUIDToDevice(uid) != kAudioObjectUnknown) {
+        return kAudioHardwareIllegalOperationError;
+    }
+
+    UInt32 slot = 0;
+    while (slot < kMaxDevices && gDevices[slot].load(std::memory_order_relaxed)) slot++;
+    if (slot == kMaxDevices) return kAudioHardwareIllegalOperationError;
+
+    CFStringRef defaultUID = nullptr;
+    CFStringRef defaultName = nullptr;
+    if (!uid) {
+        uid = defaultUID = (slot == 0)
+            ? (CFStringRef)CFRetain(kDeviceUID)
+            : CFStringCreateWithFormat(kCFAllocatorDefault, nullptr, CFSTR("%@.%u"),
+                                       kDeviceUID, (unsigned)slot);
+    }
+    if (!name) {
+        name = defaultName = (slot == 0)
+            ? (CFStringRef)CFRetain(gStrings.deviceName)
+            : CFStringCreateWithFormat(kCFAllocatorDefault, nullptr, CFSTR("%s %u"),
+                                       kDeviceName, (unsigned)(slot + 1));
+    }
+
+    PulseDevice* device = new PulseDevice(gHost, slot, uid, name);
+    if (defaultUID) CFRelease(defaultUID);
+    if (defaultName) CFRelease(defaultName);
+
+    gDevices[slot].store(device, std::memory_order_release);
+    *outDeviceID = device->GetObjectID();
+    return kAudioHardwareNoError;
+}
+
+static void NotifyDeviceListChanged()
+{
+    const AudioObjectPropertyAddress addresses[] = {
+        { kAudioPlugInPropertyDeviceList,   kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain },
+        { kAudioObjectPropertyOwnedObjects, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain },
+    };
+    gHost->PropertiesChanged(gHost, kAudioObjectPlugInObject, 2, addresses);
+}
+
 // ============================================================================
 // COM Factory Function — entry point for coreaudiod
 // ============================================================================
@@ -197,8 +299,12 @@ static ULONG Plugin_Release(void* /*driver*/)
 {
     UInt32 count = --gRefCount;
     if (count == 0) {
-        delete gDevice;
-        gDevice = nullptr;
+        std::lock_guard<std::mutex> lock(gDeviceMutex);
+        for (UInt32 slot = 0; slot < kMaxDevices; slot++) {
+            delete gDevices[slot].exchange(nullptr);
+        }
+        for (PulseDevice* device : gRetiredDevices) delete device;
+        gRetiredDevices.clear();
     }
     return count;
 }
@@ -211,83 +317,161 @@ static OSStatus Plugin_Initialize(AudioServerPlugInDriverRef /*driver*/,
                                   AudioServerPlugInHostRef host)
 {
     gHost = host;
-    gDevice = new PulseDevice();
-    return kAudioHardwareNoError;
+
+    if (!gStrings.manufacturer) {
+        gStrings.manufacturer = CFStringCreateWithCString(kCFAllocatorDefault, kDeviceManufacturer,
+                                                          kCFStringEncodingUTF8);
+        gStrings.deviceName   = CFStringCreateWithCString(kCFAllocatorDefault, kDeviceName,
+                                                          kCFStringEncodingUTF8);
+        gStrings.volumeName   = CFSTR("Volume");
+    }
+
+    // The default device always exists; more can be added with CreateDevice
+    std::lock_guard<std::mutex> lock(gDeviceMutex);
+    AudioObjectID deviceID;
+    return AddDevice(nullptr, nullptr, &deviceID);
 }
 
 static OSStatus Plugin_CreateDevice(AudioServerPlugInDriverRef /*driver*/,
-                                    CFDictionaryRef /*description*/,
+                                    CFDictionaryRef description,
                                     const AudioServerPlugInClientInfo* /*clientInfo*/,
                                     AudioObjectID* outDeviceObjectID)
 {
-    // We create our device in Initialize, so just return it here
-    *outDeviceObjectID = kObjectID_Device;
-    return kAudioHardwareNoError;
+    // Optional "uid" and "name" strings pick the new device's identity
+    CFStringRef uid = nullptr;
+    CFStringRef name = nullptr;
+    if (description) {
+        CFTypeRef value = CFDictionaryGetValue(description, kDeviceDescriptionUIDKey);
+        if (value && CFGetTypeID(value) == CFStringGetTypeID()) uid = (CFStringRef)value;
+        value = CFDictionaryGetValue(description, kDeviceDescriptionNameKey);
+        if (value && CFGetTypeID(value) == CFStringGetTypeID()) name = (CFStringRef)value;
+    }
+
+    OSStatus status;
+    {
+        std::lock_guard<std::mutex> lock(gDeviceMutex);
+        status = AddDevice(uid, name, outDeviceObjectID);
+    }
+    if (status == kAudioHardwareNoError) NotifyDeviceListChanged();
+    return status;
 }
 
 static OSStatus Plugin_DestroyDevice(AudioServerPlugInDriverRef /*driver*/,
-                                     AudioObjectID /*objectID*/)
+                                     AudioObjectID objectID)
 {
+    {
+        std::lock_guard<std::mutex> lock(gDeviceMutex);
+        PulseDevice* device = FindDevice(objectID);
+        if (!device || objectID != device->GetObjectID()) return kAudioHardwareBadObjectError;
+        if (device->IsIORunning()) return kAudioHardwareIllegalOperationError;
+
+        gDevices[DeviceSlotForObject(objectID)].store(nullptr, std::memory_order_release);
+        gRetiredDevices.push_back(device);
+    }
+    NotifyDeviceListChanged();
     return kAudioHardwareNoError;
 }
 
 static OSStatus Plugin_AddDeviceClient(AudioServerPlugInDriverRef /*driver*/,
-                                       AudioObjectID /*objectID*/,
-                                       const AudioServerPlugInClientInfo* /*clientInfo*/)
+                                       AudioObjectID objectID,
+                                       const AudioServerPlugInClientInfo* clientInfo)
 {
-    return kAudioHardwareNoError;
+    PulseDevice* device = FindDevice(objectID);
+    if (!device) return kAudioHardwareBadObjectError;
+    return device->AddClient(clientInfo);
 }
 
 static OSStatus Plugin_RemoveDeviceClient(AudioServerPlugInDriverRef /*driver*/,
-                                          AudioObjectID /*objectID*/,
-                                          const AudioServerPlugInClientInfo* /*clientInfo*/)
+                                          AudioObjectID objectID,
+                                          const AudioServerPlugInClientInfo* clientInfo)
 {
-    return kAudioHardwareNoError;
+    PulseDevice* device = FindDevice(objectID);
+    if (!device) return kAudioHardwareBadObjectError;
+    return device->RemoveClient(clientInfo);
 }
 
 static OSStatus Plugin_PerformDeviceConfigurationChange(AudioServerPlugInDriverRef /*driver*/,
-                                                        AudioObjectID /*objectID*/,
-                                                        UInt64 /*changeAction*/,
-                                                        void* /*changeInfo*/)
+                                                        AudioObjectID objectID,
+                                                        UInt64 changeAction,
+                                                        void* changeInfo)
 {
-    return kAudioHardwareNoError;
+    PulseDevice* device = FindDevice(objectID);
+    if (!device || objectID != device->GetObjectID()) return kAudioHardwareBadObjectError;
+    return device->PerformConfigurationChange(changeAction, changeInfo);
 }
 
 static OSStatus Plugin_AbortDeviceConfigurationChange(AudioServerPlugInDriverRef /*driver*/,
-                                                      AudioObjectID /*objectID*/,
-                                                      UInt64 /*changeAction*/,
-                                                      void* /*changeInfo*/)
+                                                      AudioObjectID objectID,
+                                                      UInt64 changeAction,
+                                                      void* changeInfo)
 {
-    return kAudioHardwareNoError;
+    PulseDevice* device = FindDevice(objectID);
+    if (!device || objectID != device->GetObjectID()) return kAudioHardwareBadObjectError;
+    return device->AbortConfigurationChange(changeAction, changeInfo);
 }
 
 // ============================================================================
 // Plugin-level property handlers
 // ============================================================================
 
+// The plug-in's state is the globals above; its rows take this tag as their object
+struct PlugInObject {};
+static PlugInObject gPlugIn;
+
+typedef PropertyDescriptor<PlugInObject> PlugInRow;
+
+// The plug-in owns exactly its devices, so OwnedObjects and DeviceList match
+static UInt32 SizeOfDeviceList(const PlugInObject&, const PropertyQuery&)
+{
+    return CopyDeviceIDs(nullptr, 0) * sizeof(AudioObjectID);
+}
+
+static OSStatus GetDeviceList(PlugInObject&, const PropertyQuery& query, UInt32* ioDataSize, void* outData)
+{
+    UInt32 maxCount = query.inDataSize / sizeof(AudioObjectID);
+    UInt32 count = CopyDeviceIDs((AudioObjectID*)outData, maxCount);
+    *ioDataSize = (count < maxCount ? count : maxCount) * sizeof(AudioObjectID);
+    return kAudioHardwareNoError;
+}
+
+static constexpr auto kPlugInProperties = MakePropertyRows<PlugInObject>({
+    PlugInRow::Constant<AudioClassID, kAudioObjectClassID>(kAudioObjectPropertyBaseClass),
+    PlugInRow::Constant<AudioClassID, kAudioPlugInClassID>(kAudioObjectPropertyClass),
+    PlugInRow::Constant<AudioObjectID, kAudioObjectPlugInObject>(kAudioObjectPropertyOwner),
+    PlugInRow::Of<CFStringRef>(kAudioObjectPropertyManufacturer,
+        [](PlugInObject&, const PropertyQuery&, UInt32*, void* outData) -> OSStatus {
+            *(CFStringRef*)outData = (CFStringRef)CFRetain(gStrings.manufacturer);
+            return kAudioHardwareNoError;
+        }),
+    PlugInRow::Variable(kAudioObjectPropertyOwnedObjects, &SizeOfDeviceList, &GetDeviceList),
+    PlugInRow::Variable(kAudioPlugInPropertyDeviceList, &SizeOfDeviceList, &GetDeviceList),
+    PlugInRow::Of<AudioObjectID>(kAudioPlugInPropertyTranslateUIDToDevice,
+        [](PlugInObject&, const PropertyQuery& query, UInt32*, void* outData) -> OSStatus {
+            if (query.qualifierDataSize < sizeof(CFStringRef)) return kAudioHardwareBadPropertySizeError;
+            *(AudioObjectID*)outData = TranslateUIDToDevice(*(const CFStringRef*)query.qualifierData);
+            return kAudioHardwareNoError;
+        }),
+    PlugInRow::Of<CFStringRef>(kAudioPlugInPropertyResourceBundle,
+        [](PlugInObject&, const PropertyQuery&, UInt32*, void* outData) -> OSStatus {
+            *(CFStringRef*)outData = CFSTR("");
+            return kAudioHardwareNoError;
+        }),
+});
+static_assert(kPlugInProperties.IsValid(), "plug-in property rows: duplicate selector or bad row");
+
 static Boolean Plugin_HasProperty(AudioServerPlugInDriverRef /*driver*/,
                                   AudioObjectID objectID,
                                   pid_t /*clientPID*/,
                                   const AudioObjectPropertyAddress* address)
 {
     if (objectID == kAudioObjectPlugInObject) {
-        switch (address->mSelector) {
-            case kAudioObjectPropertyBaseClass:
-            case kAudioObjectPropertyClass:
-            case kAudioObjectPropertyOwner:
-            case kAudioObjectPropertyManufacturer:
-            case kAudioObjectPropertyOwnedObjects:
-            case kAudioPlugInPropertyDeviceList:
-            case kAudioPlugInPropertyTranslateUIDToDevice:
-            case kAudioPlugInPropertyResourceBundle:
-                return true;
-            default:
-                return false;
-        }
+        PropertyQuery query = { objectID, address, 0, nullptr, 0 };
+        return kPlugInProperties.Table().Has(gPlugIn, query);
     }
 
-    if (!gDevice) return false;
-    return gDevice->HasProperty(objectID, address);
+    PulseDevice* device = FindDevice(objectID);
+    if (!device) return false;
+    return device->HasProperty(objectID, address);
 }
 
 static OSStatus Plugin_IsPropertySettable(AudioServerPlugInDriverRef /*driver*/,
@@ -297,12 +481,13 @@ static OSStatus Plugin_IsPropertySettable(AudioServerPlugInDriverRef /*driver*/,
                                           Boolean* outIsSettable)
 {
     if (objectID == kAudioObjectPlugInObject) {
-        *outIsSettable = false;
-        return kAudioHardwareNoError;
+        PropertyQuery query = { objectID, address, 0, nullptr, 0 };
+        return kPlugInProperties.Table().IsSettable(gPlugIn, query, outIsSettable);
     }
 
-    if (!gDevice) return kAudioHardwareBadObjectError;
-    return gDevice->IsPropertySettable(objectID, address, outIsSettable);
+    PulseDevice* device = FindDevice(objectID);
+    if (!device) return kAudioHardwareBadObjectError;
+    return device->IsPropertySettable(objectID, address, outIsSettable);
 }
 
 static OSStatus Plugin_GetPropertyDataSize(AudioServerPlugInDriverRef /*driver*/,
@@ -314,34 +499,13 @@ static OSStatus Plugin_GetPropertyDataSize(AudioServerPlugInDriverRef /*driver*/
                                            UInt32* outDataSize)
 {
     if (objectID == kAudioObjectPlugInObject) {
-        switch (address->mSelector) {
-            case kAudioObjectPropertyBaseClass:
-            case kAudioObjectPropertyClass:
-                *outDataSize = sizeof(AudioClassID);
-                return kAudioHardwareNoError;
-            case kAudioObjectPropertyOwner:
-                *outDataSize = sizeof(AudioObjectID);
-                return kAudioHardwareNoError;
-            case kAudioObjectPropertyManufacturer:
-                *outDataSize = sizeof(CFStringRef);
-                return kAudioHardwareNoError;
-            case kAudioObjectPropertyOwnedObjects:
-            case kAudioPlugInPropertyDeviceList:
-                *outDataSize = sizeof(AudioObjectID);
-                return kAudioHardwareNoError;
-            case kAudioPlugInPropertyTranslateUIDToDevice:
-                *outDataSize = sizeof(AudioObjectID);
-                return kAudioHardwareNoError;
-            case kAudioPlugInPropertyResourceBundle:
-                *outDataSize = sizeof(CFStringRef);
-                return kAudioHardwareNoError;
-            default:
-                return kAudioHardwareUnknownPropertyError;
-        }
+        PropertyQuery query = { objectID, address, qualifierDataSize, qualifierData, 0 };
+        return kPlugInProperties.Table().GetSize(gPlugIn, query, outDataSize);
     }
 
-    if (!gDevice) return kAudioHardwareBadObjectError;
-    return gDevice->GetPropertyDataSize(objectID, address, qualifierDataSize, qualifierData, outDataSize);
+    PulseDevice* device = FindDevice(objectID);
+    if (!device) return kAudioHardwareBadObjectError;
+    return device->GetPropertyDataSize(objectID, address, qualifierDataSize, qualifierData, outDataSize);
 }
 
 static OSStatus Plugin_GetPropertyData(AudioServerPlugInDriverRef /*driver*/,
@@ -355,58 +519,14 @@ static OSStatus Plugin_GetPropertyData(AudioServerPlugInDriverRef /*driver*/,
                                        void* outData)
 {
     if (objectID == kAudioObjectPlugInObject) {
-        switch (address->mSelector) {
-            case kAudioObjectPropertyBaseClass:
-                *outDataSize = sizeof(AudioClassID);
-                *(AudioClassID*)outData = kAudioObjectClassID;
-                return kAudioHardwareNoError;
-
-            case kAudioObjectPropertyClass:
-                *outDataSize = sizeof(AudioClassID);
-                *(AudioClassID*)outData = kAudioPlugInClassID;
-                return kAudioHardwareNoError;
-
-            case kAudioObjectPropertyOwner:
-                *outDataSize = sizeof(AudioObjectID);
-                *(AudioObjectID*)outData = kAudioObjectPlugInObject;
-                return kAudioHardwareNoError;
-
-            case kAudioObjectPropertyManufacturer:
-                *outDataSize = sizeof(CFStringRef);
-                *(CFStringRef*)outData = CFStringCreateWithCString(kCFAllocatorDefault,
-                    kDeviceManufacturer, kCFStringEncodingUTF8);
-                return kAudioHardwareNoError;
-
-            case kAudioObjectPropertyOwnedObjects:
-            case kAudioPlugInPropertyDeviceList:
-                *outDataSize = sizeof(AudioObjectID);
-                *(AudioObjectID*)outData = kObjectID_Device;
-                return kAudioHardwareNoError;
-
-            case kAudioPlugInPropertyTranslateUIDToDevice: {
-                CFStringRef uid = *(CFStringRef*)qualifierData;
-                if (uid && CFStringCompare(uid, kDeviceUID, 0) == kCFCompareEqualTo) {
-                    *(AudioObjectID*)outData = kObjectID_Device;
-                } else {
-                    *(AudioObjectID*)outData = kAudioObjectUnknown;
-                }
-                *outDataSize = sizeof(AudioObjectID);
-                return kAudioHardwareNoError;
-            }
-
-            case kAudioPlugInPropertyResourceBundle:
-                *outDataSize = sizeof(CFStringRef);
-                *(CFStringRef*)outData = CFSTR("");
-                return kAudioHardwareNoError;
-
-            default:
-                return kAudioHardwareUnknownPropertyError;
-        }
+        PropertyQuery query = { objectID, address, qualifierDataSize, qualifierData, inDataSize };
+        return kPlugInProperties.Table().Get(gPlugIn, query, outDataSize, outData);
     }
 
-    if (!gDevice) return kAudioHardwareBadObjectError;
-    return gDevice->GetPropertyData(objectID, address, qualifierDataSize, qualifierData,
-                                    inDataSize, outDataSize, outData);
+    PulseDevice* device = FindDevice(objectID);
+    if (!device) return kAudioHardwareBadObjectError;
+    return device->GetPropertyData(objectID, address, qualifierDataSize, qualifierData,
+                                   inDataSize, outDataSize, outData);
 }
 
 static OSStatus Plugin_SetPropertyData(AudioServerPlugInDriverRef /*driver*/,
@@ -419,12 +539,14 @@ static OSStatus Plugin_SetPropertyData(AudioServerPlugInDriverRef /*driver*/,
                                        const void* inData)
 {
     if (objectID == kAudioObjectPlugInObject) {
-        return kAudioHardwareUnknownPropertyError;
+        PropertyQuery query = { objectID, address, qualifierDataSize, qualifierData, inDataSize };
+        return kPlugInProperties.Table().Set(gPlugIn, query, inData);
     }
 
-    if (!gDevice) return kAudioHardwareBadObjectError;
-    return gDevice->SetPropertyData(objectID, address, qualifierDataSize, qualifierData,
-                                    inDataSize, inData);
+    PulseDevice* device = FindDevice(objectID);
+    if (!device) return kAudioHardwareBadObjectError;
+    return device->SetPropertyData(objectID, address, qualifierDataSize, qualifierData,
+                                   inDataSize, inData);
 }
 
 // ============================================================================
@@ -432,30 +554,33 @@ static OSStatus Plugin_SetPropertyData(AudioServerPlugInDriverRef /*driver*/,
 // ============================================================================
 
 static OSStatus Plugin_StartIO(AudioServerPlugInDriverRef /*driver*/,
-                               AudioObjectID /*objectID*/,
+                               AudioObjectID objectID,
                                UInt32 /*clientID*/)
 {
-    if (!gDevice) return kAudioHardwareBadObjectError;
-    return gDevice->StartIO();
+    PulseDevice* device = FindDevice(objectID);
+    if (!device) return kAudioHardwareBadObjectError;
+    return device->StartIO();
 }
 
 static OSStatus Plugin_StopIO(AudioServerPlugInDriverRef /*driver*/,
-                              AudioObjectID /*objectID*/,
+                              AudioObjectID objectID,
                               UInt32 /*clientID*/)
 {
-    if (!gDevice) return kAudioHardwareBadObjectError;
-    return gDevice->StopIO();
+    PulseDevice* device = FindDevice(objectID);
+    if (!device) return kAudioHardwareBadObjectError;
+    return device->StopIO();
 }
 
 static OSStatus Plugin_GetZeroTimeStamp(AudioServerPlugInDriverRef /*driver*/,
-                                        AudioObjectID /*objectID*/,
+                                        AudioObjectID objectID,
                                         UInt32 /*clientID*/,
                                         Float64* outSampleTime,
                                         UInt64* outHostTime,
                                         UInt64* outSeed)
 {
-    if (!gDevice) return kAudioHardwareBadObjectError;
-    gDevice->GetZeroTimeStamp(outSampleTime, outHostTime, outSeed);
+    PulseDevice* device = FindDevice(objectID);
+    if (!device) return kAudioHardwareBadObjectError;
+    device->GetZeroTimeStamp(outSampleTime, outHostTime, outSeed);
     return kAudioHardwareNoError;
 }
 
@@ -494,19 +619,20 @@ static OSStatus Plugin_BeginIOOperation(AudioServerPlugInDriverRef /*driver*/,
 }
 
 static OSStatus Plugin_DoIOOperation(AudioServerPlugInDriverRef /*driver*/,
-                                     AudioObjectID /*objectID*/,
+                                     AudioObjectID objectID,
                                      AudioObjectID streamID,
-                                     UInt32 /*clientID*/,
+                                     UInt32 clientID,
                                      UInt32 operationID,
                                      UInt32 ioBufferFrameSize,
                                      const AudioServerPlugInIOCycleInfo* /*ioCycleInfo*/,
                                      void* ioMainBuffer,
                                      void* ioSecondaryBuffer)
 {
-    if (!gDevice) return kAudioHardwareBadObjectError;
-    return gDevice->DoIOOperation(streamID, operationID, ioBufferFrameSize,
-                                  (AudioBufferList*)ioMainBuffer,
-                                  (AudioBufferList*)ioSecondaryBuffer);
+    PulseDevice* device = FindDevice(objectID);
+    if (!device) return kAudioHardwareBadObjectError;
+    return device->DoIOOperation(streamID, clientID, operationID, ioBufferFrameSize,
+                                 (AudioBufferList*)ioMainBuffer,
+                                 (AudioBufferList*)ioSecondaryBuffer);
 }
 
 static OSStatus Plugin_EndIOOperation(AudioServerPlugInDriverRef /*driver*/,
@@ -4,3 +4,14 @@
 
 // Entry point — the COM interface factory function
 extern "C" void* PulseAudio_Create(CFAllocatorRef allocator, CFUUIDRef requestedTypeUUID);
+
+// CF strings handed out by property queries, built once in Initialize rather
+// than on every query. Getters return them retained (the caller releases);
+// they live as long as the plug-in.
+struct InternedStrings {
+    CFStringRef manufacturer;   // kDeviceManufacturer
+    CFStringRef deviceName;     // kDeviceName, the default device's name
+    CFStringRef volumeName;     // element name of the volume control
+};
+
+const InternedStrings& PluginStrings();
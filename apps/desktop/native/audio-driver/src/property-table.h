@@ -0,0 +1,231 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include "platform.h"
+
+// Compile-time property dispatch for HAL objects. Each object kind lists its
+// properties once, as rows of a constexpr table: selector, data size, getter
+// and, for settable properties, a setter. HasProperty, IsPropertySettable,
+// GetPropertyDataSize, GetPropertyData and SetPropertyData are all answered
+// from the same row, so the size a property reports is the size it writes.
+//
+// Rows are sorted by selector at compile time and looked up by binary search.
+// Callbacks are plain function pointers (captureless lambdas) taking the
+// object they describe, so the table itself holds no state.
+
+// Arguments of one property call
+struct PropertyQuery {
+    AudioObjectID                     objectID;
+    const AudioObjectPropertyAddress* address;
+    UInt32                            qualifierDataSize;
+    const void*                       qualifierData;
+    UInt32                            inDataSize;
+};
+
+template <typename Object>
+struct PropertyDescriptor {
+    typedef bool     (*HasFn)(const Object& object, const PropertyQuery& query);
+    typedef UInt32   (*SizeFn)(const Object& object, const PropertyQuery& query);
+    // ioDataSize holds the row's size for fixed-size rows; variable-size
+    // getters set it to what they wrote, at most query.inDataSize
+    typedef OSStatus (*GetFn)(Object& object, const PropertyQuery& query, UInt32* ioDataSize, void* outData);
+    typedef OSStatus (*SetFn)(Object& object, const PropertyQuery& query, const void* inData);
+
+    AudioObjectPropertySelector selector = 0;
+    UInt32                      size     = 0;       // 0: sizeOf decides
+    SizeFn                      sizeOf   = nullptr;
+    GetFn                       get      = nullptr;
+    SetFn                       set      = nullptr; // nullptr: read-only
+    HasFn                       has      = nullptr; // nullptr: every object of the kind has it
+
+    // Read-only property holding one T
+    template <typename T>
+    static constexpr PropertyDescriptor Of(AudioObjectPropertySelector selector, GetFn get)
+    {
+        PropertyDescriptor row;
+        row.selector = selector;
+        row.size     = sizeof(T);
+        row.get      = get;
+        return row;
+    }
+
+    // Settable property holding one T; the table checks inDataSize before set
+    template <typename T>
+    static constexpr PropertyDescriptor Of(AudioObjectPropertySelector selector, GetFn get, SetFn set)
+    {
+        PropertyDescriptor row = Of<T>(selector, get);
+        row.set = set;
+        return row;
+    }
+
+    // Read-only property whose value never changes
+    template <typename T, T Value>
+    static constexpr PropertyDescriptor Constant(AudioObjectPropertySelector selector)
+    {
+        return Of<T>(selector, &GetConstant<T, Value>);
+    }
+
+    // Read-only array whose length depends on the object or the address
+    static constexpr PropertyDescriptor Variable(AudioObjectPropertySelector selector, SizeFn sizeOf, GetFn get)
+    {
+        PropertyDescriptor row;
+        row.selector = selector;
+        row.sizeOf   = sizeOf;
+        row.get      = get;
+        return row;
+    }
+
+    // The same row, present only on objects for which has returns true
+    constexpr PropertyDescriptor When(HasFn predicate) const
+    {
+        PropertyDescriptor row = *this;
+        row.has = predicate;
+        return row;
+    }
+
+    template <typename T, T Value>
+    static OSStatus GetConstant(Object&, const PropertyQuery&, UInt32*, void* outData)
+    {
+        *(T*)outData = Value;
+        return kAudioHardwareNoError;
+    }
+};
+
+// Copy up to query.inDataSize bytes' worth of count items; the HAL sizes the
+// buffer from GetPropertyDataSize, which may be stale by the time it asks.
+template <typename T>
+static inline OSStatus CopyPropertyArray(const PropertyQuery& query, const T* items, UInt32 count,
+                                         UInt32* ioDataSize, void* outData)
+{
+    UInt32 maxCount = query.inDataSize / sizeof(T);
+    if (count > maxCount) count = maxCount;
+    T* out = (T*)outData;
+    for (UInt32 i = 0; i < count; i++) out[i] = items[i];
+    *ioDataSize = count * sizeof(T);
+    return kAudioHardwareNoError;
+}
+
+// Lookup over a sorted run of rows. This is what objects dispatch through;
+// PropertyRows below builds the run at compile time.
+template <typename Object>
+class PropertyTable {
+public:
+    typedef PropertyDescriptor<Object> Row;
+
+    constexpr PropertyTable() : mRows(nullptr), mCount(0) {}
+    constexpr PropertyTable(const Row* rows, size_t count) : mRows(rows), mCount(count) {}
+
+    bool Has(const Object& object, const PropertyQuery& query) const
+    {
+        return Find(object, query) != nullptr;
+    }
+
+    OSStatus IsSettable(const Object& object, const PropertyQuery& query, Boolean* outIsSettable) const
+    {
+        const Row* row = Find(object, query);
+        if (!row) return kAudioHardwareUnknownPropertyError;
+        *outIsSettable = (row->set != nullptr);
+        return kAudioHardwareNoError;
+    }
+
+    OSStatus GetSize(const Object& object, const PropertyQuery& query, UInt32* outDataSize) const
+    {
+        const Row* row = Find(object, query);
+        if (!row) return kAudioHardwareUnknownPropertyError;
+        *outDataSize = row->size != 0 ? row->size : row->sizeOf(object, query);
+        return kAudioHardwareNoError;
+    }
+
+    OSStatus Get(Object& object, const PropertyQuery& query, UInt32* outDataSize, void* outData) const
+    {
+        const Row* row = Find(object, query);
+        if (!row) return kAudioHardwareUnknownPropertyError;
+        if (row->size != 0) {
+            if (query.inDataSize < row->size) return kAudioHardwareBadPropertySizeError;
+            *outDataSize = row->size;
+        }
+        return row->get(object, query, outDataSize, outData);
+    }
+
+    OSStatus Set(Object& object, const PropertyQuery& query, const void* inData) const
+    {
+        const Row* row = Find(object, query);
+        if (!row || !row->set) return kAudioHardwareUnknownPropertyError;
+        if (query.inDataSize < row->size) return kAudioHardwareBadPropertySizeError;
+        return row->set(object, query, inData);
+    }
+
+    size_t Count() const { return mCount; }
+
+private:
+    const Row* Find(const Object& object, const PropertyQuery& query) const
+    {
+        AudioObjectPropertySelector selector = query.address->mSelector;
+        size_t lo = 0;
+        size_t hi = mCount;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (mRows[mid].selector < selector) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo == mCount || mRows[lo].selector != selector) return nullptr;
+        const Row* row = &mRows[lo];
+        if (row->has && !row->has(object, query)) return nullptr;
+        return row;
+    }
+
+    const Row* mRows;
+    size_t     mCount;
+};
+
+// Storage for one object kind's rows, sorted by selector when constructed.
+// Declare it static constexpr and check it with static_assert(IsValid()).
+template <typename Object, size_t N>
+class PropertyRows {
+public:
+    typedef PropertyDescriptor<Object> Row;
+
+    constexpr explicit PropertyRows(const Row (&rows)[N]) : mRows()
+    {
+        // Insertion sort; N is a few dozen at most
+        for (size_t i = 0; i < N; i++) {
+            Row row = rows[i];
+            size_t j = i;
+            while (j > 0 && mRows[j - 1].selector > row.selector) {
+                mRows[j] = mRows[j - 1];
+                j--;
+            }
+            mRows[j] = row;
+        }
+    }
+
+    // Every selector listed once, every row readable, every settable row
+    // of fixed size (Set checks inDataSize against it)
+    constexpr bool IsValid() const
+    {
+        for (size_t i = 0; i < N; i++) {
+            if (i > 0 && mRows[i - 1].selector == mRows[i].selector) return false;
+            if (!mRows[i].get) return false;
+            if (mRows[i].size == 0 && !mRows[i].sizeOf) return false;
+            if (mRows[i].set && mRows[i].size == 0) return false;
+        }
+        return true;
+    }
+
+    constexpr PropertyTable<Object> Table() const { return PropertyTable<Object>(mRows.data(), N); }
+    constexpr const Row& operator[](size_t i) const { return mRows[i]; }
+    constexpr size_t Count() const { return N; }
+
+private:
+    std::array<Row, N> mRows;
+};
+
+template <typename Object, size_t N>
+constexpr PropertyRows<Object, N> MakePropertyRows(const PropertyDescriptor<Object> (&rows)[N])
+{
+    return PropertyRows<Object, N>(rows);
+}
@@ -4,10 +4,15 @@
 RingBuffer::RingBuffer()
     : mBuffer(nullptr)
     , mCapacityFrames(0)
+    , mIndexMask(0)
     , mBytesPerFrame(0)
     , mChannels(0)
     , mWriteHead(0)
+    , mCachedReadHead(0)
+    , mOverrunFrames(0)
     , mReadHead(0)
+    , mCachedWriteHead(0)
+    , mUnderrunFrames(0)
 {
 }
 
@@ -16,11 +21,25 @@ RingBuffer::~RingBuffer()
     delete[] mBuffer;
 }
 
-void RingBuffer::Initialize(UInt32 capacityFrames, UInt32 bytesPerFrame)
+// Smallest power of two >= value
+static UInt32 NextPowerOfTwo(UInt32 value)
+{
+    UInt32 result = 1;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+void RingBuffer::Initialize(UInt32 capacityFrames, UInt32 bytesPerFrame, bool roundToPowerOfTwo)
 {
     delete[] mBuffer;
 
-    mCapacityFrames = capacityFrames;
+    if (roundToPowerOfTwo) {
+        mCapacityFrames = NextPowerOfTwo(capacityFrames);
+        mIndexMask      = mCapacityFrames - 1;
+    } else {
+        mCapacityFrames = capacityFrames;
+        mIndexMask      = 0;
+    }
     mBytesPerFrame  = bytesPerFrame;
     mChannels       = bytesPerFrame / sizeof(float);
 
@@ -30,6 +49,8 @@ void RingBuffer::Initialize(UInt32 capacityFrames, UInt32 bytesPerFrame)
 
     mWriteHead.store(0, std::memory_order_relaxed);
     mReadHead.store(0, std::memory_order_relaxed);
+    mCachedReadHead  = 0;
+    mCachedWriteHead = 0;
 }
 
 void RingBuffer::Reset()
@@ -37,101 +58,142 @@ void RingBuffer::Reset()
     if (mBuffer) {
         std::memset(mBuffer, 0, mCapacityFrames * mChannels * sizeof(float));
     }
+    mCachedReadHead  = 0;
+    mCachedWriteHead = 0;
     mWriteHead.store(0, std::memory_order_release);
     mReadHead.store(0, std::memory_order_release);
 }
 
-UInt32 RingBuffer::Store(const float* src, UInt32 numFrames)
+void RingBuffer::MakeRegions(UInt64 position, UInt32 numFrames, RingBufferRegions* outRegions) const
+{
+    UInt32 index      = WrapIndex(position);
+    UInt32 firstChunk = std::min(numFrames, mCapacityFrames - index);
+
+    outRegions->first        = mBuffer + (index * mChannels);
+    outRegions->firstFrames  = firstChunk;
+    outRegions->second       = mBuffer;
+    outRegions->secondFrames = numFrames - firstChunk;
+}
+
+UInt32 RingBuffer::ReserveWrite(UInt32 numFrames, RingBufferRegions* outRegions)
 {
-    if (!mBuffer || !src || numFrames == 0) return 0;
+    *outRegions = RingBufferRegions{ nullptr, 0, nullptr, 0 };
+    if (!mBuffer || numFrames == 0) return 0;
 
     UInt64 writePos = mWriteHead.load(std::memory_order_relaxed);
-    UInt64 readPos  = mReadHead.load(std::memory_order_acquire);
 
-    // Don't overwrite unread data — cap at available space
-    UInt64 used      = writePos - readPos;
+    // Don't overwrite unread data — cap at available space. The cached read
+    // head can only lag the real one, so it underestimates free space; only
+    // reload the consumer's head when the cached value isn't enough.
+    UInt64 used      = writePos - mCachedReadHead;
     UInt32 available = (used < mCapacityFrames) ? (mCapacityFrames - (UInt32)used) : 0;
+    if (available < numFrames) {
+        mCachedReadHead = mReadHead.load(std::memory_order_acquire);
+        used      = writePos - mCachedReadHead;
+        available = (used < mCapacityFrames) ? (mCapacityFrames - (UInt32)used) : 0;
+    }
     UInt32 toWrite   = std::min(numFrames, available);
 
-    if (toWrite == 0) return 0;
-
-    UInt32 writeIndex = (UInt32)(writePos % mCapacityFrames);
-    UInt32 samplesPerFrame = mChannels;
-
-    // First chunk: from writeIndex to end of buffer (or less)
-    UInt32 firstChunk = std::min(toWrite, mCapacityFrames - writeIndex);
-    std::memcpy(
-        mBuffer + (writeIndex * samplesPerFrame),
-        src,
-        firstChunk * samplesPerFrame * sizeof(float)
-    );
-
-    // Second chunk: wrap around to beginning
-    if (toWrite > firstChunk) {
-        UInt32 secondChunk = toWrite - firstChunk;
-        std::memcpy(
-            mBuffer,
-            src + (firstChunk * samplesPerFrame),
-            secondChunk * samplesPerFrame * sizeof(float)
-        );
+    // Single writer — a plain load/store is enough, no read-modify-write
+    if (toWrite < numFrames) {
+        mOverrunFrames.store(mOverrunFrames.load(std::memory_order_relaxed) + (numFrames - toWrite),
+                             std::memory_order_relaxed);
     }
 
-    mWriteHead.store(writePos + toWrite, std::memory_order_release);
+    if (toWrite > 0) {
+        MakeRegions(writePos, toWrite, outRegions);
+    }
     return toWrite;
 }
 
-UInt32 RingBuffer::Fetch(float* dst, UInt32 numFrames)
+void RingBuffer::CommitWrite(UInt32 numFrames)
 {
-    if (!mBuffer || !dst || numFrames == 0) {
-        if (dst && numFrames > 0) {
-            std::memset(dst, 0, numFrames * mChannels * sizeof(float));
-        }
-        return 0;
-    }
+    UInt64 writePos = mWriteHead.load(std::memory_order_relaxed);
+    mWriteHead.store(writePos + numFrames, std::memory_order_release);
+}
+
+UInt32 RingBuffer::PeekRead(UInt32 numFrames, RingBufferRegions* outRegions)
+{
+    *outRegions = RingBufferRegions{ nullptr, 0, nullptr, 0 };
+    if (!mBuffer || numFrames == 0) return 0;
 
-    UInt64 writePos = mWriteHead.load(std::memory_order_acquire);
     UInt64 readPos  = mReadHead.load(std::memory_order_relaxed);
 
-    UInt64 available64 = writePos - readPos;
+    // Same trick as ReserveWrite(): the cached write head can only lag the real one
+    UInt64 available64 = mCachedWriteHead - readPos;
+    if (available64 < numFrames) {
+        mCachedWriteHead = mWriteHead.load(std::memory_order_acquire);
+        available64 = mCachedWriteHead - readPos;
+    }
     UInt32 available   = (UInt32)std::min(available64, (UInt64)mCapacityFrames);
     UInt32 toRead      = std::min(numFrames, available);
 
-    UInt32 readIndex = (UInt32)(readPos % mCapacityFrames);
-    UInt32 samplesPerFrame = mChannels;
+    if (toRead > 0) {
+        MakeRegions(readPos, toRead, outRegions);
+    }
+    return toRead;
+}
+
+void RingBuffer::ConsumeRead(UInt32 numFrames)
+{
+    UInt64 readPos = mReadHead.load(std::memory_order_relaxed);
+    mReadHead.store(readPos + numFrames, std::memory_order_release);
+}
+
+UInt32 RingBuffer::Store(const float* src, UInt32 numFrames)
+{
+    if (!src) return 0;
+
+    RingBufferRegions regions;
+    UInt32 toWrite = ReserveWrite(numFrames, &regions);
+    if (toWrite == 0) return 0;
+
+    std::memcpy(regions.first, src, regions.firstFrames * mBytesPerFrame);
+    if (regions.secondFrames > 0) {
+        std::memcpy(regions.second, src + (regions.firstFrames * mChannels),
+                    regions.secondFrames * mBytesPerFrame);
+    }
+
+    CommitWrite(toWrite);
+    return toWrite;
+}
+
+UInt32 RingBuffer::Fetch(float* dst, UInt32 numFrames)
+{
+    if (!dst || numFrames == 0) return 0;
+
+    RingBufferRegions regions;
+    UInt32 toRead = PeekRead(numFrames, &regions);
 
     if (toRead > 0) {
-        // First chunk: from readIndex to end of buffer
-        UInt32 firstChunk = std::min(toRead, mCapacityFrames - readIndex);
-        std::memcpy(
-            dst,
-            mBuffer + (readIndex * samplesPerFrame),
-            firstChunk * samplesPerFrame * sizeof(float)
-        );
-
-        // Second chunk: wrap around
-        if (toRead > firstChunk) {
-            UInt32 secondChunk = toRead - firstChunk;
-            std::memcpy(
-                dst + (firstChunk * samplesPerFrame),
-                mBuffer,
-                secondChunk * samplesPerFrame * sizeof(float)
-            );
+        std::memcpy(dst, regions.first, regions.firstFrames * mBytesPerFrame);
+        if (regions.secondFrames > 0) {
+            std::memcpy(dst + (regions.firstFrames * mChannels), regions.second,
+                        regions.secondFrames * mBytesPerFrame);
         }
+        ConsumeRead(toRead);
     }
 
     // Fill remaining with silence
     if (toRead < numFrames) {
-        std::memset(
-            dst + (toRead * samplesPerFrame),
-            0,
-            (numFrames - toRead) * samplesPerFrame * sizeof(float)
-        );
+        std::memset(dst + (toRead * mChannels), 0, (numFrames - toRead) * mBytesPerFrame);
+        mUnderrunFrames.store(mUnderrunFrames.load(std::memory_order_relaxed) + (numFrames - toRead),
+                              std::memory_order_relaxed);
     }
 
-    mReadHead.store(readPos + toRead, std::memory_order_release);
     return toRead;
 }
 
+UInt32 RingBuffer::Discard(UInt32 numFrames)
+{
+    RingBufferRegions regions;
+    UInt32 toDrop = PeekRead(numFrames, &regions);
+    if (toDrop > 0) {
+        ConsumeRead(toDrop);
+    }
+    return toDrop;
+}
+
 UInt32 RingBuffer::AvailableFrames() const
 {
     UInt64 writePos = mWriteHead.load(std::memory_order_acquire);
@@ -5,17 +5,40 @@
 #include <cstring>
 #include "types.h"
 
+// Destructive interference size — Apple Silicon uses 128-byte cache lines
+#if defined(__APPLE__) && defined(__aarch64__)
+static const size_t kCacheLineSize = 128;
+#else
+static const size_t kCacheLineSize = 64;
+#endif
+
+// Up to two contiguous regions of ring storage, in frames.
+// The second region is only non-empty when the range wraps around the end.
+struct RingBufferRegions {
+    float*  first;
+    UInt32  firstFrames;
+    float*  second;
+    UInt32  secondFrames;
+};
+
 // Lock-free ring buffer for audio loopback.
 // Output stream calls Store() to write audio data.
 // Input stream calls Fetch() to read it back.
 // Uses atomic frame counters for thread safety without locks.
+// The producer and consumer heads live on separate cache lines, and each side
+// keeps a cached copy of the other side's head so it only reloads it (and pulls
+// the other core's cache line) when the cached value says it has to.
+// Single reader only: IOEngine uses FanoutRingBuffer, and this one is built
+// into pulse-audio-bench alone, as the baseline it is measured against.
 class RingBuffer {
 public:
     RingBuffer();
     ~RingBuffer();
 
     // Initialize with the given capacity in frames.
-    void Initialize(UInt32 capacityFrames, UInt32 bytesPerFrame);
+    // With roundToPowerOfTwo the capacity is rounded up to the next power of two
+    // and positions are wrapped with a mask instead of a 64-bit modulo.
+    void Initialize(UInt32 capacityFrames, UInt32 bytesPerFrame, bool roundToPowerOfTwo = false);
 
     // Reset the buffer (clear all data and counters).
     void Reset();
@@ -29,14 +52,56 @@ public:
     // Returns the number of frames actually fetched (non-silent).
     UInt32 Fetch(float* dst, UInt32 numFrames);
 
+    // Zero-copy producer API: expose up to numFrames of free space as writable
+    // regions so the caller can render straight into ring storage.
+    // Returns the number of frames reserved; publish them with CommitWrite().
+    UInt32 ReserveWrite(UInt32 numFrames, RingBufferRegions* outRegions);
+    void   CommitWrite(UInt32 numFrames);
+
+    // Zero-copy consumer API: expose up to numFrames of readable data.
+    // Returns the number of frames available; release them with ConsumeRead().
+    UInt32 PeekRead(UInt32 numFrames, RingBufferRegions* outRegions);
+    void   ConsumeRead(UInt32 numFrames);
+
+    // Drop up to numFrames of unread data (consumer side).
+    // Returns the number of frames discarded.
+    UInt32 Discard(UInt32 numFrames);
+
     // Get the number of frames currently available for reading.
     UInt32 AvailableFrames() const;
 
+    // Cumulative counters for the lifetime of this RingBuffer.
+    // Each is written only by its own side and may be read from any thread.
+    UInt64 OverrunFrames() const { return mOverrunFrames.load(std::memory_order_relaxed); }   // frames Store()/ReserveWrite() couldn't fit
+    UInt64 UnderrunFrames() const { return mUnderrunFrames.load(std::memory_order_relaxed); } // frames Fetch() padded with silence
+
+    // Get the capacity in frames (after any power-of-two rounding).
+    UInt32 CapacityFrames() const { return mCapacityFrames; }
+
 private:
+    // Split numFrames starting at position into (up to) two storage regions
+    void   MakeRegions(UInt64 position, UInt32 numFrames, RingBufferRegions* outRegions) const;
+
+    // Map a monotonic frame position to an index into mBuffer
+    UInt32 WrapIndex(UInt64 position) const {
+        return mIndexMask ? (UInt32)(position & mIndexMask)
+                          : (UInt32)(position % mCapacityFrames);
+    }
+
+    // Read-only after Initialize()
     float*              mBuffer;
     UInt32              mCapacityFrames;
+    UInt32              mIndexMask;      // capacity - 1 in power-of-two mode, 0 otherwise
     UInt32              mBytesPerFrame;
     UInt32              mChannels;
-    std::atomic<UInt64> mWriteHead;  // total frames written (monotonic)
-    std::atomic<UInt64> mReadHead;   // total frames read (monotonic)
+
+    // Producer (Store) side
+    alignas(kCacheLineSize) std::atomic<UInt64> mWriteHead;  // total frames written (monotonic)
+    UInt64              mCachedReadHead;  // producer's last observed mReadHead
+    std::atomic<UInt64> mOverrunFrames;
+
+    // Consumer (Fetch) side
+    alignas(kCacheLineSize) std::atomic<UInt64> mReadHead;   // total frames read (monotonic)
+    UInt64              mCachedWriteHead; // consumer's last observed mWriteHead
+    std::atomic<UInt64> mUnderrunFrames;
 };
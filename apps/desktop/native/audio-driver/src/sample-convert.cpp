@@ -0,0 +1,213 @@
+#include "sample-convert.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define PULSE_CONVERT_SSE 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define PULSE_CONVERT_NEON 1
+#endif
+
+// Full scale maps to ±32767, so +1.0 and -1.0 are symmetric. All kernels
+// round to nearest; only ties may go a different way.
+static const Float32 kInt16Scale   = 32767.0f;
+
+// Each xorshift draw supplies both TPDF terms, one per 16-bit half, scaled
+// to [0, 1). Sixteen bits is far finer than the 1 LSB the noise spans, and
+// one draw per sample keeps the SIMD generator's dependency chain short.
+static const Float32 kUniformScale = 1.0f / 65536.0f;
+
+void InitDitherState(DitherState* state, UInt32 seed)
+{
+    for (UInt32 i = 0; i < DitherState::kLanes; i++) {
+        // Spread the seed across lanes (Knuth's multiplicative hash); never zero
+        UInt32 lane = (seed + i + 1) * 2654435761u;
+        state->lanes[i] = lane ? lane : 1;
+    }
+}
+
+// ============================================================================
+// Scalar
+// ============================================================================
+
+// Triangular noise in (-1, 1)
+static inline Float32 NextTriangular(UInt32& lane)
+{
+    lane ^= lane << 13;
+    lane ^= lane >> 17;
+    lane ^= lane << 5;
+    return ((Float32)(lane >> 16) - (Float32)(lane & 0xFFFFu)) * kUniformScale;
+}
+
+// Converts samples [start, numSamples); sample i draws from lane i % kLanes,
+// the lane the SIMD kernels would give it
+static void ConvertInt16ScalarFrom(SInt16* dst, const float* src, UInt32 start, UInt32 numSamples,
+                                   DitherState* dither)
+{
+    for (UInt32 i = start; i < numSamples; i++) {
+        // Written so NaN fails the first test and lands on -1
+        Float32 x = src[i] > -1.0f ? src[i] : -1.0f;
+        x = (x < 1.0f ? x : 1.0f) * kInt16Scale;
+        if (dither) {
+            x += NextTriangular(dither->lanes[i % DitherState::kLanes]);
+        }
+        // x + 32768.5 is positive, so truncation rounds to nearest without a libm call
+        SInt32 value = (SInt32)(x + 32768.5f) - 32768;
+        dst[i] = (SInt16)(value > 32767 ? 32767 : (value < -32768 ? -32768 : value));
+    }
+}
+
+static void ConvertInt16Scalar(SInt16* dst, const float* src, UInt32 numSamples, DitherState* dither)
+{
+    ConvertInt16ScalarFrom(dst, src, 0, numSamples, dither);
+}
+
+// ============================================================================
+// x86_64 — SSE2 is baseline
+// ============================================================================
+
+#if defined(PULSE_CONVERT_SSE)
+
+static inline __m128i XorShiftSSE(__m128i s)
+{
+    s = _mm_xor_si128(s, _mm_slli_epi32(s, 13));
+    s = _mm_xor_si128(s, _mm_srli_epi32(s, 17));
+    return _mm_xor_si128(s, _mm_slli_epi32(s, 5));
+}
+
+// Triangular noise in (-1, 1), one draw per lane
+static inline __m128 TriangularSSE(__m128i& s)
+{
+    s = XorShiftSSE(s);
+    __m128 hi = _mm_cvtepi32_ps(_mm_srli_epi32(s, 16));
+    __m128 lo = _mm_cvtepi32_ps(_mm_and_si128(s, _mm_set1_epi32(0xFFFF)));
+    return _mm_mul_ps(_mm_sub_ps(hi, lo), _mm_set1_ps(kUniformScale));
+}
+
+// Eight samples per iteration: two float vectors packed into one Int16 vector.
+// _mm_packs_epi32 saturates, which also catches dither pushing past full scale.
+template <bool kDither>
+static void ConvertInt16SSEImpl(SInt16* dst, const float* src, UInt32 numSamples, DitherState* dither)
+{
+    const __m128 lo    = _mm_set1_ps(-1.0f);
+    const __m128 hi    = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(kInt16Scale);
+
+    // One generator per vector, so the two xorshift chains run in parallel
+    __m128i stateA = kDither ? _mm_loadu_si128((const __m128i*)dither->lanes) : _mm_setzero_si128();
+    __m128i stateB = kDither ? _mm_loadu_si128((const __m128i*)(dither->lanes + 4)) : _mm_setzero_si128();
+    UInt32 vecSamples = numSamples & ~7u;
+
+    for (UInt32 i = 0; i < vecSamples; i += 8) {
+        __m128 a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), lo), hi), scale);
+        __m128 b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), lo), hi), scale);
+        if (kDither) {
+            a = _mm_add_ps(a, TriangularSSE(stateA));
+            b = _mm_add_ps(b, TriangularSSE(stateB));
+        }
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+        _mm_storeu_si128((__m128i*)(dst + i), packed);
+    }
+
+    if (kDither) {
+        _mm_storeu_si128((__m128i*)dither->lanes, stateA);
+        _mm_storeu_si128((__m128i*)(dither->lanes + 4), stateB);
+    }
+    ConvertInt16ScalarFrom(dst, src, vecSamples, numSamples, dither);
+}
+
+static void ConvertInt16SSE(SInt16* dst, const float* src, UInt32 numSamples, DitherState* dither)
+{
+    if (dither) {
+        ConvertInt16SSEImpl<true>(dst, src, numSamples, dither);
+    } else {
+        ConvertInt16SSEImpl<false>(dst, src, numSamples, nullptr);
+    }
+}
+
+#endif
+
+// ============================================================================
+// arm64 — NEON is always available
+// ============================================================================
+
+#if defined(PULSE_CONVERT_NEON)
+
+static inline uint32x4_t XorShiftNEON(uint32x4_t s)
+{
+    s = veorq_u32(s, vshlq_n_u32(s, 13));
+    s = veorq_u32(s, vshrq_n_u32(s, 17));
+    return veorq_u32(s, vshlq_n_u32(s, 5));
+}
+
+static inline float32x4_t TriangularNEON(uint32x4_t& s)
+{
+    s = XorShiftNEON(s);
+    float32x4_t hi = vcvtq_f32_u32(vshrq_n_u32(s, 16));
+    float32x4_t lo = vcvtq_f32_u32(vandq_u32(s, vdupq_n_u32(0xFFFF)));
+    return vmulq_n_f32(vsubq_f32(hi, lo), kUniformScale);
+}
+
+// vqmovn_s32 saturates like _mm_packs_epi32
+template <bool kDither>
+static void ConvertInt16NEONImpl(SInt16* dst, const float* src, UInt32 numSamples, DitherState* dither)
+{
+    const float32x4_t lo = vdupq_n_f32(-1.0f);
+    const float32x4_t hi = vdupq_n_f32(1.0f);
+
+    uint32x4_t stateA = kDither ? vld1q_u32(dither->lanes) : vdupq_n_u32(0);
+    uint32x4_t stateB = kDither ? vld1q_u32(dither->lanes + 4) : vdupq_n_u32(0);
+    UInt32 vecSamples = numSamples & ~7u;
+
+    for (UInt32 i = 0; i < vecSamples; i += 8) {
+        float32x4_t a = vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(src + i), lo), hi), kInt16Scale);
+        float32x4_t b = vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(src + i + 4), lo), hi), kInt16Scale);
+        if (kDither) {
+            a = vaddq_f32(a, TriangularNEON(stateA));
+            b = vaddq_f32(b, TriangularNEON(stateB));
+        }
+        int16x8_t packed = vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(a)), vqmovn_s32(vcvtnq_s32_f32(b)));
+        vst1q_s16(dst + i, packed);
+    }
+
+    if (kDither) {
+        vst1q_u32(dither->lanes, stateA);
+        vst1q_u32(dither->lanes + 4, stateB);
+    }
+    ConvertInt16ScalarFrom(dst, src, vecSamples, numSamples, dither);
+}
+
+static void ConvertInt16NEON(SInt16* dst, const float* src, UInt32 numSamples, DitherState* dither)
+{
+    if (dither) {
+        ConvertInt16NEONImpl<true>(dst, src, numSamples, dither);
+    } else {
+        ConvertInt16NEONImpl<false>(dst, src, numSamples, nullptr);
+    }
+}
+
+#endif
+
+// ============================================================================
+// Runtime selection
+// ============================================================================
+
+static const Int16ConvertKernel kInt16ConvertKernels[] = {
+#if defined(PULSE_CONVERT_SSE)
+    { "sse", ConvertInt16SSE },
+#elif defined(PULSE_CONVERT_NEON)
+    { "neon", ConvertInt16NEON },
+#endif
+    { "scalar", ConvertInt16Scalar },
+};
+
+const Int16ConvertKernel* GetInt16ConvertKernels(UInt32* outCount)
+{
+    *outCount = sizeof(kInt16ConvertKernels) / sizeof(kInt16ConvertKernels[0]);
+    return kInt16ConvertKernels;
+}
+
+void ConvertFloatToInt16(SInt16* dst, const float* src, UInt32 numSamples, DitherState* dither)
+{
+    kInt16ConvertKernels[0].convert(dst, src, numSamples, dither);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "platform.h"
+
+// TPDF dither generator: eight independent xorshift32 lanes, so the SIMD
+// kernels can draw two vectors of four at a time. Keep one per stream; it
+// is only touched by that stream's IO thread.
+struct DitherState {
+    static const UInt32 kLanes = 8;
+    UInt32 lanes[kLanes];
+};
+
+// Seed a dither state (any seed; zero lanes are avoided)
+void InitDitherState(DitherState* state, UInt32 seed);
+
+// Float to Int16 kernel: convert numSamples samples, clamping to [-1, 1].
+// With a dither state, ±1 LSB triangular noise is added before rounding;
+// with nullptr the samples are just rounded to the nearest step.
+typedef void (*Int16ConvertFn)(SInt16* dst, const float* src, UInt32 numSamples, DitherState* dither);
+
+struct Int16ConvertKernel {
+    const char*    name;
+    Int16ConvertFn convert;
+};
+
+// All kernels usable on this CPU, best first. The first entry is the one
+// ConvertFloatToInt16() uses.
+const Int16ConvertKernel* GetInt16ConvertKernels(UInt32* outCount);
+
+void ConvertFloatToInt16(SInt16* dst, const float* src, UInt32 numSamples, DitherState* dither);
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+#include "platform.h"
+
+// Single-writer sequence lock over a small trivially copyable struct.
+// Store() is wait-free and safe to call from the real-time IO thread.
+// Load() may be called from any thread; it retries if it overlaps a Store(),
+// so readers always see a consistent snapshot and never block the writer.
+template <typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock requires a trivially copyable type");
+
+public:
+    Seqlock() : mSequence(0) {
+        for (UInt32 i = 0; i < kNumWords; i++) {
+            mWords[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Publish a new value. Only one thread may call this.
+    void Store(const T& value) {
+        UInt64 words[kNumWords] = {};
+        std::memcpy(words, &value, sizeof(T));
+
+        UInt32 seq = mSequence.load(std::memory_order_relaxed);
+        mSequence.store(seq + 1, std::memory_order_relaxed);   // odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (UInt32 i = 0; i < kNumWords; i++) {
+            mWords[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        mSequence.store(seq + 2, std::memory_order_release);   // even: stable
+    }
+
+    // Read the latest consistent value.
+    T Load() const {
+        UInt64 words[kNumWords];
+        UInt32 before, after;
+
+        do {
+            before = mSequence.load(std::memory_order_acquire);
+            for (UInt32 i = 0; i < kNumWords; i++) {
+                words[i] = mWords[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = mSequence.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    static const UInt32 kNumWords = (sizeof(T) + sizeof(UInt64) - 1) / sizeof(UInt64);
+
+    std::atomic<UInt32> mSequence;
+    std::atomic<UInt64> mWords[kNumWords];
+};
@@ -0,0 +1,350 @@
+#include "shm-ring.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Smallest power of two >= value
+static UInt32 NextPowerOfTwo(UInt32 value)
+{
+    UInt32 result = 1;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+bool IsValidShmRingName(const char* name)
+{
+    if (name == nullptr || name[0] != '/') return false;
+    size_t length = std::strlen(name);
+    return length > 1 && length <= kShmRingMaxNameLength && std::strchr(name + 1, '/') == nullptr;
+}
+
+static size_t MappedBytes(UInt32 capacityFrames, UInt32 bytesPerFrame)
+{
+    return sizeof(ShmRingHeader) + (size_t)capacityFrames * bytesPerFrame;
+}
+
+// ============================================================================
+// ShmRingWriter
+// ============================================================================
+
+ShmRingWriter::ShmRingWriter()
+    : mHeader(nullptr)
+    , mSamples(nullptr)
+    , mMappedBytes(0)
+    , mChannels(0)
+    , mSampleRate(0.0)
+    , mCapacityFrames(0)
+    , mIndexMask(0)
+    , mWritePos(0)
+    , mDroppedFrames(0)
+{
+    mName[0] = '\0';
+}
+
+ShmRingWriter::~ShmRingWriter()
+{
+    Close();
+}
+
+bool ShmRingWriter::Create(const char* name, UInt32 capacityFrames, UInt32 channels, Float64 sampleRate)
+{
+    Close();
+
+    if (!IsValidShmRingName(name) || channels == 0 || capacityFrames == 0 || sampleRate <= 0.0) {
+        errno = EINVAL;
+        return false;
+    }
+
+    UInt32 capacity      = NextPowerOfTwo(capacityFrames);
+    UInt32 bytesPerFrame = channels * (UInt32)sizeof(float);
+    size_t bytes         = MappedBytes(capacity, bytesPerFrame);
+
+    // A ring left behind by a crashed writer would never see its state change
+    shm_unlink(name);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0666);
+    if (fd < 0) return false;
+
+    // shm_open applies the umask; the reader runs as another user and needs
+    // write access to readHead
+    fchmod(fd, 0666);
+    if (ftruncate(fd, (off_t)bytes) != 0) {
+        int error = errno;
+        close(fd);
+        shm_unlink(name);
+        errno = error;
+        return false;
+    }
+
+    void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int error = errno;
+    close(fd);
+    if (base == MAP_FAILED) {
+        shm_unlink(name);
+        errno = error;
+        return false;
+    }
+
+    // ftruncate zero-fills, so the heads and reserved bytes start at zero
+    ShmRingHeader* header = static_cast<ShmRingHeader*>(base);
+    header->magic          = kShmRingMagic;
+    header->version        = kShmRingVersion;
+    header->headerBytes    = sizeof(ShmRingHeader);
+    header->sampleFormat   = kShmRingFormat_Float32;
+    header->channels       = channels;
+    header->sampleRate     = sampleRate;
+    header->capacityFrames = capacity;
+    header->bytesPerFrame  = bytesPerFrame;
+    header->writeHead.store(0, std::memory_order_relaxed);
+    header->droppedFrames.store(0, std::memory_order_relaxed);
+    header->readHead.store(0, std::memory_order_relaxed);
+    header->state.store(kShmRingState_Open, std::memory_order_release);
+
+    mHeader         = header;
+    mSamples        = reinterpret_cast<float*>(static_cast<UInt8*>(base) + sizeof(ShmRingHeader));
+    mMappedBytes    = bytes;
+    mChannels       = channels;
+    mSampleRate     = sampleRate;
+    mCapacityFrames = capacity;
+    mIndexMask      = capacity - 1;
+    mWritePos       = 0;
+    mDroppedFrames  = 0;
+    std::strncpy(mName, name, sizeof(mName) - 1);
+    mName[sizeof(mName) - 1] = '\0';
+    return true;
+}
+
+void ShmRingWriter::Close()
+{
+    if (mHeader == nullptr) return;
+
+    mHeader->state.store(kShmRingState_Closed, std::memory_order_release);
+    munmap(mHeader, mMappedBytes);
+    shm_unlink(mName);
+
+    mHeader         = nullptr;
+    mSamples        = nullptr;
+    mMappedBytes    = 0;
+    mChannels       = 0;
+    mSampleRate     = 0.0;
+    mCapacityFrames = 0;
+    mIndexMask      = 0;
+    mWritePos       = 0;
+    mDroppedFrames  = 0;
+    mName[0]        = '\0';
+}
+
+UInt32 ShmRingWriter::Reserve(UInt32 numFrames, UInt64* outWritePos)
+{
+    UInt64 writePos = mWritePos;
+    UInt64 readPos  = mHeader->readHead.load(std::memory_order_acquire);
+
+    // A reader can only run ahead of the writer by misbehaving; treat it as empty
+    UInt64 used  = writePos >= readPos ? writePos - readPos : 0;
+    UInt64 space = used < mCapacityFrames ? mCapacityFrames - used : 0;
+    UInt32 count = (UInt32)std::min<UInt64>(numFrames, space);
+
+    if (count < numFrames) {
+        mDroppedFrames += numFrames - count;
+        mHeader->droppedFrames.store(mDroppedFrames, std::memory_order_relaxed);
+    }
+
+    *outWritePos = writePos;
+    return count;
+}
+
+UInt32 ShmRingWriter::Write(const float* src, UInt32 numFrames)
+{
+    if (mHeader == nullptr || numFrames == 0) return 0;
+
+    UInt64 writePos;
+    UInt32 count = Reserve(numFrames, &writePos);
+    if (count == 0) return 0;
+
+    UInt32 channels = mChannels;
+    UInt32 index    = (UInt32)writePos & mIndexMask;
+    UInt32 first    = std::min(count, mCapacityFrames - index);
+    std::memcpy(mSamples + (size_t)index * channels, src, (size_t)first * channels * sizeof(float));
+    if (count > first) {
+        std::memcpy(mSamples, src + (size_t)first * channels, (size_t)(count - first) * channels * sizeof(float));
+    }
+
+    mWritePos = writePos + count;
+    mHeader->writeHead.store(mWritePos, std::memory_order_release);
+    return count;
+}
+
+UInt32 ShmRingWriter::WriteSilence(UInt32 numFrames)
+{
+    if (mHeader == nullptr || numFrames == 0) return 0;
+
+    UInt64 writePos;
+    UInt32 count = Reserve(numFrames, &writePos);
+    if (count == 0) return 0;
+
+    UInt32 channels = mChannels;
+    UInt32 index    = (UInt32)writePos & mIndexMask;
+    UInt32 first    = std::min(count, mCapacityFrames - index);
+    std::memset(mSamples + (size_t)index * channels, 0, (size_t)first * channels * sizeof(float));
+    if (count > first) {
+        std::memset(mSamples, 0, (size_t)(count - first) * channels * sizeof(float));
+    }
+
+    mWritePos = writePos + count;
+    mHeader->writeHead.store(mWritePos, std::memory_order_release);
+    return count;
+}
+
+// ============================================================================
+// ShmRingReader
+// ============================================================================
+
+ShmRingReader::ShmRingReader()
+    : mHeader(nullptr)
+    , mSamples(nullptr)
+    , mMappedBytes(0)
+    , mChannels(0)
+    , mSampleRate(0.0)
+    , mCapacityFrames(0)
+    , mIndexMask(0)
+    , mReadPos(0)
+{
+}
+
+ShmRingReader::~ShmRingReader()
+{
+    Close();
+}
+
+bool ShmRingReader::Open(const char* name)
+{
+    Close();
+
+    if (!IsValidShmRingName(name)) {
+        errno = EINVAL;
+        return false;
+    }
+
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(ShmRingHeader)) {
+        close(fd);
+        errno = EPROTO;
+        return false;
+    }
+
+    // Map the header first to learn the full size
+    void* base = mmap(nullptr, sizeof(ShmRingHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return false;
+    }
+
+    // Each field is read once; the copies are what get validated and used
+    const ShmRingHeader* header = static_cast<const ShmRingHeader*>(base);
+    UInt32  capacity      = header->capacityFrames;
+    UInt32  channels      = header->channels;
+    UInt32  bytesPerFrame = header->bytesPerFrame;
+    Float64 sampleRate    = header->sampleRate;
+    // state is stored last, so a zero means the writer is still filling in the header
+    bool valid = header->state.load(std::memory_order_acquire) != 0
+              && header->magic == kShmRingMagic
+              && header->version == kShmRingVersion
+              && header->headerBytes == sizeof(ShmRingHeader)
+              && header->sampleFormat == kShmRingFormat_Float32
+              && channels > 0 && channels <= kMaxNumChannels
+              && bytesPerFrame == channels * sizeof(float)
+              && sampleRate > 0.0
+              && capacity > 0 && (capacity & (capacity - 1)) == 0
+              && (size_t)info.st_size >= MappedBytes(capacity, bytesPerFrame);
+    size_t bytes = valid ? MappedBytes(capacity, bytesPerFrame) : 0;
+    munmap(base, sizeof(ShmRingHeader));
+
+    if (!valid) {
+        close(fd);
+        errno = EPROTO;
+        return false;
+    }
+
+    base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int error = errno;
+    close(fd);
+    if (base == MAP_FAILED) {
+        errno = error;
+        return false;
+    }
+
+    mHeader         = static_cast<ShmRingHeader*>(base);
+    mSamples        = reinterpret_cast<const float*>(static_cast<const UInt8*>(base) + sizeof(ShmRingHeader));
+    mMappedBytes    = bytes;
+    mChannels       = channels;
+    mSampleRate     = sampleRate;
+    mCapacityFrames = capacity;
+    mIndexMask      = capacity - 1;
+    mReadPos        = mHeader->readHead.load(std::memory_order_relaxed);
+    return true;
+}
+
+void ShmRingReader::Close()
+{
+    if (mHeader == nullptr) return;
+
+    munmap(mHeader, mMappedBytes);
+    mHeader         = nullptr;
+    mSamples        = nullptr;
+    mMappedBytes    = 0;
+    mChannels       = 0;
+    mSampleRate     = 0.0;
+    mCapacityFrames = 0;
+    mIndexMask      = 0;
+    mReadPos        = 0;
+}
+
+bool ShmRingReader::IsWriterClosed() const
+{
+    return mHeader == nullptr || mHeader->state.load(std::memory_order_acquire) != kShmRingState_Open;
+}
+
+UInt32 ShmRingReader::Available() const
+{
+    if (mHeader == nullptr) return 0;
+
+    UInt64 writePos = mHeader->writeHead.load(std::memory_order_acquire);
+    UInt64 used     = writePos >= mReadPos ? writePos - mReadPos : 0;
+    return (UInt32)std::min<UInt64>(used, mCapacityFrames);
+}
+
+UInt32 ShmRingReader::Read(float* dst, UInt32 numFrames)
+{
+    UInt32 count = std::min(numFrames, Available());
+    if (count == 0) return 0;
+
+    UInt32 channels = mChannels;
+    UInt32 index    = (UInt32)mReadPos & mIndexMask;
+    UInt32 first    = std::min(count, mCapacityFrames - index);
+    std::memcpy(dst, mSamples + (size_t)index * channels, (size_t)first * channels * sizeof(float));
+    if (count > first) {
+        std::memcpy(dst + (size_t)first * channels, mSamples, (size_t)(count - first) * channels * sizeof(float));
+    }
+
+    mReadPos += count;
+    mHeader->readHead.store(mReadPos, std::memory_order_release);
+    return count;
+}
+
+UInt32 ShmRingReader::Skip(UInt32 numFrames)
+{
+    UInt32 count = std::min(numFrames, Available());
+    if (count == 0) return 0;
+
+    mReadPos += count;
+    mHeader->readHead.store(mReadPos, std::memory_order_release);
+    return count;
+}
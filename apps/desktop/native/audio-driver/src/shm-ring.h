@@ -0,0 +1,163 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include "types.h"
+
+// Shared-memory capture transport.
+// A single-producer, single-consumer ring of interleaved Float32 frames in a
+// POSIX shared memory object. The driver writes the same post-gain mix the
+// loopback ring gets; a native reader in the capturing app maps the object
+// and reads it directly, skipping coreaudiod and the input stream.
+// Nothing here is macOS specific, so the Linux tests drive both ends.
+//
+// Layout, in native byte order (little endian on every supported CPU). The
+// writer and reader fields sit 128 bytes apart so each side owns its cache
+// line on any CPU:
+//
+//   offset  size  field
+//        0     4  magic           kShmRingMagic ('PSHM')
+//        4     4  version         kShmRingVersion
+//        8     4  headerBytes     offset of the first sample (384)
+//       12     4  state           kShmRingState_Open, or _Closed once the writer is done;
+//                                 a reader seeing Closed should unmap and reopen by name
+//       16     4  sampleFormat    kShmRingFormat_Float32 (interleaved)
+//       20     4  channels
+//       24     8  sampleRate      Float64, frames per second
+//       32     4  capacityFrames  a power of two
+//       36     4  bytesPerFrame   channels * 4
+//      128     8  writeHead       frames written, monotonic; written by the writer (release)
+//      136     8  droppedFrames   frames the writer discarded because the ring was full
+//      256     8  readHead        frames consumed, monotonic; written by the reader (release)
+//      384     …  capacityFrames * bytesPerFrame of samples; frame n is at
+//                 slot n & (capacityFrames - 1)
+//
+// The writer never waits: frames that don't fit are dropped and counted. The
+// object is created mode 0666, since the driver runs as a different user
+// than the app reading it; pick an unguessable name per session. Anyone who
+// can open it can also scribble on it, so neither end trusts the shared
+// header after setup: the layout is copied when the ring is created or
+// opened, and the only field each side reads back is the other's head.
+static const UInt32 kShmRingMagic          = 0x5053484D;  // 'PSHM'
+static const UInt32 kShmRingVersion        = 1;
+static const UInt32 kShmRingFormat_Float32 = 1;
+static const UInt32 kShmRingMaxNameLength  = 31;          // PSHMNAMLEN on macOS
+
+enum ShmRingState : UInt32 {
+    kShmRingState_Open   = 1,
+    kShmRingState_Closed = 2,
+};
+
+struct ShmRingHeader {
+    UInt32              magic;
+    UInt32              version;
+    UInt32              headerBytes;
+    std::atomic<UInt32> state;
+    UInt32              sampleFormat;
+    UInt32              channels;
+    Float64             sampleRate;
+    UInt32              capacityFrames;
+    UInt32              bytesPerFrame;
+    UInt8               reserved0[88];
+
+    std::atomic<UInt64> writeHead;
+    std::atomic<UInt64> droppedFrames;
+    UInt8               reserved1[112];
+
+    std::atomic<UInt64> readHead;
+    UInt8               reserved2[120];
+};
+
+static_assert(std::atomic<UInt64>::is_always_lock_free, "shared heads must be lock-free");
+static_assert(offsetof(ShmRingHeader, state) == 12, "ShmRingHeader layout");
+static_assert(offsetof(ShmRingHeader, sampleRate) == 24, "ShmRingHeader layout");
+static_assert(offsetof(ShmRingHeader, bytesPerFrame) == 36, "ShmRingHeader layout");
+static_assert(offsetof(ShmRingHeader, writeHead) == 128, "ShmRingHeader layout");
+static_assert(offsetof(ShmRingHeader, droppedFrames) == 136, "ShmRingHeader layout");
+static_assert(offsetof(ShmRingHeader, readHead) == 256, "ShmRingHeader layout");
+static_assert(sizeof(ShmRingHeader) == 384, "ShmRingHeader layout");
+
+// "/name" with no other slash, at most kShmRingMaxNameLength characters
+bool IsValidShmRingName(const char* name);
+
+// Producer end. Create and Close are not real-time safe; Write and
+// WriteSilence are wait-free and meant for the IO thread.
+class ShmRingWriter {
+public:
+    ShmRingWriter();
+    ~ShmRingWriter();
+
+    // Create the named object, replacing any stale one and closing the
+    // current mapping.
+    // capacityFrames is rounded up to a power of two. Returns false, with
+    // errno set, on failure.
+    bool     Create(const char* name, UInt32 capacityFrames, UInt32 channels, Float64 sampleRate);
+
+    // Mark the ring closed for readers, unmap it and unlink the name
+    void     Close();
+
+    bool     IsOpen() const { return mHeader != nullptr; }
+    const char* Name() const { return mName; }
+    UInt32   Channels() const { return mChannels; }
+    Float64  SampleRate() const { return mSampleRate; }
+    UInt32   CapacityFrames() const { return mCapacityFrames; }
+
+    // Append up to numFrames, dropping what doesn't fit. Returns frames written.
+    UInt32   Write(const float* src, UInt32 numFrames);
+    UInt32   WriteSilence(UInt32 numFrames);
+
+private:
+    // Frames that fit right now; counts the rest as dropped
+    UInt32   Reserve(UInt32 numFrames, UInt64* outWritePos);
+
+    ShmRingHeader* mHeader;
+    float*         mSamples;
+    size_t         mMappedBytes;
+
+    // Private copies of the layout and of this side's counters; the shared
+    // ones are only ever stored to
+    UInt32         mChannels;
+    Float64        mSampleRate;
+    UInt32         mCapacityFrames;
+    UInt32         mIndexMask;
+    UInt64         mWritePos;
+    UInt64         mDroppedFrames;
+    char           mName[kShmRingMaxNameLength + 1];
+};
+
+// Consumer end. Open maps an existing ring read-write (the reader owns
+// readHead). Reading starts at the oldest unread frame; Skip(Available())
+// jumps to live.
+class ShmRingReader {
+public:
+    ShmRingReader();
+    ~ShmRingReader();
+
+    // Returns false, with errno set, if the object doesn't exist or its
+    // header doesn't describe a ring this code understands (EPROTO).
+    bool     Open(const char* name);
+    void     Close();
+
+    bool     IsOpen() const { return mHeader != nullptr; }
+    const ShmRingHeader* Header() const { return mHeader; }
+    bool     IsWriterClosed() const;
+    UInt32   Channels() const { return mChannels; }
+    Float64  SampleRate() const { return mSampleRate; }
+    UInt32   CapacityFrames() const { return mCapacityFrames; }
+
+    UInt32   Available() const;
+    UInt32   Read(float* dst, UInt32 numFrames);
+    UInt32   Skip(UInt32 numFrames);
+
+private:
+    ShmRingHeader* mHeader;
+    const float*   mSamples;
+    size_t         mMappedBytes;
+
+    // Layout as validated by Open, and this side's head
+    UInt32         mChannels;
+    Float64        mSampleRate;
+    UInt32         mCapacityFrames;
+    UInt32         mIndexMask;
+    UInt64         mReadPos;
+};
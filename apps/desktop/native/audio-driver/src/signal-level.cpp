@@ -0,0 +1,102 @@
+#include "signal-level.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define PULSE_LEVEL_SSE 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define PULSE_LEVEL_NEON 1
+#endif
+
+// ============================================================================
+// Scalar
+// ============================================================================
+
+static Float32 PeakLevelScalarFrom(const float* src, UInt32 start, UInt32 numSamples, Float32 peak)
+{
+    for (UInt32 i = start; i < numSamples; i++) {
+        Float32 x = src[i] < 0.0f ? -src[i] : src[i];
+        if (x > peak) peak = x;  // false for NaN
+    }
+    return peak;
+}
+
+static Float32 PeakLevelScalar(const float* src, UInt32 numSamples)
+{
+    return PeakLevelScalarFrom(src, 0, numSamples, 0.0f);
+}
+
+// ============================================================================
+// x86_64 — SSE2 is baseline
+// ============================================================================
+
+#if defined(PULSE_LEVEL_SSE)
+
+// Two independent accumulators of four lanes; clearing the sign bit gives |x|
+static Float32 PeakLevelSSE(const float* src, UInt32 numSamples)
+{
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 peakA = _mm_setzero_ps();
+    __m128 peakB = _mm_setzero_ps();
+
+    UInt32 vecSamples = numSamples & ~7u;
+    for (UInt32 i = 0; i < vecSamples; i += 8) {
+        // maxps returns its second operand when either is NaN, so keep the peak there
+        peakA = _mm_max_ps(_mm_and_ps(_mm_loadu_ps(src + i), absMask), peakA);
+        peakB = _mm_max_ps(_mm_and_ps(_mm_loadu_ps(src + i + 4), absMask), peakB);
+    }
+
+    __m128 peak = _mm_max_ps(peakA, peakB);
+    peak = _mm_max_ps(peak, _mm_shuffle_ps(peak, peak, _MM_SHUFFLE(1, 0, 3, 2)));
+    peak = _mm_max_ps(peak, _mm_shuffle_ps(peak, peak, _MM_SHUFFLE(2, 3, 0, 1)));
+    return PeakLevelScalarFrom(src, vecSamples, numSamples, _mm_cvtss_f32(peak));
+}
+
+#endif
+
+// ============================================================================
+// arm64 — NEON is always available
+// ============================================================================
+
+#if defined(PULSE_LEVEL_NEON)
+
+// vmaxnmq ignores a NaN operand
+static Float32 PeakLevelNEON(const float* src, UInt32 numSamples)
+{
+    float32x4_t peakA = vdupq_n_f32(0.0f);
+    float32x4_t peakB = vdupq_n_f32(0.0f);
+
+    UInt32 vecSamples = numSamples & ~7u;
+    for (UInt32 i = 0; i < vecSamples; i += 8) {
+        peakA = vmaxnmq_f32(peakA, vabsq_f32(vld1q_f32(src + i)));
+        peakB = vmaxnmq_f32(peakB, vabsq_f32(vld1q_f32(src + i + 4)));
+    }
+
+    return PeakLevelScalarFrom(src, vecSamples, numSamples, vmaxnmvq_f32(vmaxnmq_f32(peakA, peakB)));
+}
+
+#endif
+
+// ============================================================================
+// Runtime selection
+// ============================================================================
+
+static const LevelKernel kLevelKernels[] = {
+#if defined(PULSE_LEVEL_SSE)
+    { "sse", PeakLevelSSE },
+#elif defined(PULSE_LEVEL_NEON)
+    { "neon", PeakLevelNEON },
+#endif
+    { "scalar", PeakLevelScalar },
+};
+
+const LevelKernel* GetLevelKernels(UInt32* outCount)
+{
+    *outCount = sizeof(kLevelKernels) / sizeof(kLevelKernels[0]);
+    return kLevelKernels;
+}
+
+Float32 PeakLevel(const float* src, UInt32 numSamples)
+{
+    return kLevelKernels[0].peak(src, numSamples);
+}
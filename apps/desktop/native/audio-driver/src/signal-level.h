@@ -0,0 +1,19 @@
+#pragma once
+
+#include "platform.h"
+
+// Signal level detection for the WriteMix path.
+// Peak is the largest absolute sample value in a buffer of interleaved
+// samples (any channel count). NaN samples are ignored.
+typedef Float32 (*PeakLevelFn)(const float* src, UInt32 numSamples);
+
+struct LevelKernel {
+    const char* name;
+    PeakLevelFn peak;
+};
+
+// All kernels usable on this CPU, best first. The first entry is the one
+// PeakLevel() uses.
+const LevelKernel* GetLevelKernels(UInt32* outCount);
+
+Float32 PeakLevel(const float* src, UInt32 numSamples);
@@ -0,0 +1,312 @@
+// pulse-audio-sim: Deterministic soak test of the IO core (see io-simulator.h).
+// Runs WriteMix and ReadInput on two virtual clocks with drift, jitter and
+// stalls, prints a summary, and writes the fill/latency trace as CSV and the
+// whole report as JSON. With --max-glitches it fails when the run glitched
+// more often, for CI.
+//
+// Usage:
+//   pulse-audio-sim [options]
+//     --duration S             simulated seconds (60)
+//     --seed N                 random seed (1)
+//     --rate HZ                nominal sample rate (48000)
+//     --channels N             ring channels (2)
+//     --capacity FRAMES        ring capacity (engine default)
+//     --target FRAMES          target fill (engine default)
+//     --{writer,reader}-period FRAMES      IO buffer size (480)
+//     --{writer,reader}-ppm P              clock drift in ppm (0)
+//     --{writer,reader}-jitter US          wake-up jitter in microseconds (0)
+//     --{writer,reader}-stall AT_S:MS      stall at AT_S seconds for MS ms (repeatable)
+//     --{writer,reader}-stalls-per-min N   random stalls per minute (0)
+//     --stall-ms MS            length of random stalls (20)
+//     --jitter-dist uniform|gaussian       jitter distribution (gaussian)
+//     --trace-ms MS            trace row interval (100)
+//     --csv PATH               write the trace as CSV ("-" for stdout)
+//     --json PATH              write the report as JSON ("-" for stdout)
+//     --max-glitches N         exit 1 if the run had more glitches
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "io-simulator.h"
+#include "ndjson.h"
+
+static void PrintUsage()
+{
+    fprintf(stderr,
+            "Usage: pulse-audio-sim [--duration S] [--seed N] [--rate HZ] [--channels N]\n"
+            "                       [--capacity FRAMES] [--target FRAMES] [--trace-ms MS]\n"
+            "                       [--{writer,reader}-period FRAMES] [--{writer,reader}-ppm P]\n"
+            "                       [--{writer,reader}-jitter US] [--jitter-dist uniform|gaussian]\n"
+            "                       [--{writer,reader}-stall AT_S:MS] [--{writer,reader}-stalls-per-min N]\n"
+            "                       [--stall-ms MS] [--csv PATH] [--json PATH] [--max-glitches N]\n");
+}
+
+// Strict number parsing; the whole argument must be a number
+static bool ParseDouble(const char* text, Float64* outValue)
+{
+    char* end = nullptr;
+    *outValue = strtod(text, &end);
+    return end != text && *end == '\0';
+}
+
+static bool ParseUInt(const char* text, UInt64* outValue)
+{
+    char* end = nullptr;
+    if (*text == '-') return false;
+    *outValue = strtoull(text, &end, 10);
+    return end != text && *end == '\0';
+}
+
+static bool ParseStall(const char* text, SimulatedStall* outStall)
+{
+    const char* colon = strchr(text, ':');
+    if (!colon) return false;
+    std::string at(text, colon - text);
+    return ParseDouble(at.c_str(), &outStall->startSeconds) &&
+           ParseDouble(colon + 1, &outStall->durationMs) &&
+           outStall->startSeconds >= 0.0 && outStall->durationMs >= 0.0;
+}
+
+// Options for one clock ("writer" or "reader"); false if name isn't one
+static bool ParseClockOption(const char* name, const char* value, const char* prefix,
+                             VirtualClockConfig* clock, bool* outValid)
+{
+    size_t length = strlen(prefix);
+    if (strncmp(name, prefix, length) != 0) return false;
+    const char* option = name + length;
+
+    UInt64  count = 0;
+    Float64 number = 0.0;
+    if (strcmp(option, "-period") == 0) {
+        *outValid = ParseUInt(value, &count) && count > 0 && count <= kRingBufferFrameCapacity;
+        clock->framesPerPeriod = (UInt32)count;
+    } else if (strcmp(option, "-ppm") == 0) {
+        *outValid = ParseDouble(value, &clock->driftPPM) && clock->driftPPM > -1e6;
+    } else if (strcmp(option, "-jitter") == 0) {
+        *outValid = ParseDouble(value, &clock->jitterMicros) && clock->jitterMicros >= 0.0;
+    } else if (strcmp(option, "-stall") == 0) {
+        SimulatedStall stall;
+        *outValid = ParseStall(value, &stall);
+        clock->stalls.push_back(stall);
+    } else if (strcmp(option, "-stalls-per-min") == 0) {
+        *outValid = ParseDouble(value, &number) && number >= 0.0;
+        clock->stallsPerMinute = number;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Opens path for writing; "-" is stdout
+static FILE* OpenOutput(const std::string& path)
+{
+    if (path == "-") return stdout;
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) fprintf(stderr, "pulse-audio-sim: cannot write %s\n", path.c_str());
+    return file;
+}
+
+static void CloseOutput(FILE* file)
+{
+    if (file && file != stdout) fclose(file);
+}
+
+static void WriteCSV(FILE* file, const SimulationResult& result)
+{
+    fprintf(file, "time_s,fill_frames,latency_ms,resample_ratio,underrun_frames,overrun_frames,"
+                  "dropped_frames,glitches\n");
+    for (const SimulationSample& sample : result.trace) {
+        fprintf(file, "%.3f,%u,%.3f,%.9f,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n",
+                sample.timeSeconds, (unsigned)sample.fillFrames, sample.latencyMs, sample.resampleRatio,
+                (uint64_t)sample.underrunFrames, (uint64_t)sample.overrunFrames,
+                (uint64_t)sample.droppedFrames, (uint64_t)sample.glitches);
+    }
+}
+
+static void WriteClockJSON(JsonWriter& json, const VirtualClockConfig& clock)
+{
+    json.BeginObject()
+        .Key("framesPerPeriod").UInt(clock.framesPerPeriod)
+        .Key("driftPPM").Number(clock.driftPPM)
+        .Key("jitter").String(clock.jitter == kJitter_Uniform ? "uniform" : "gaussian")
+        .Key("jitterMicros").Number(clock.jitterMicros)
+        .Key("stallsPerMinute").Number(clock.stallsPerMinute)
+        .Key("stallMs").Number(clock.stallMs)
+        .Key("stalls").BeginArray();
+    for (const SimulatedStall& stall : clock.stalls) {
+        json.BeginObject()
+            .Key("startSeconds").Number(stall.startSeconds)
+            .Key("durationMs").Number(stall.durationMs)
+            .EndObject();
+    }
+    json.EndArray().EndObject();
+}
+
+static void WriteJSON(FILE* file, const SimulationConfig& config, const SimulationResult& result)
+{
+    JsonWriter json;
+    json.BeginObject().Key("config").BeginObject()
+        .Key("sampleRate").Number(config.sampleRate)
+        .Key("channels").UInt(config.channels)
+        .Key("capacityFrames").UInt(config.capacityFrames)
+        .Key("targetFillFrames").UInt(config.targetFillFrames)
+        .Key("durationSeconds").Number(config.durationSeconds)
+        .Key("seed").UInt(config.seed)
+        .Key("writer");
+    WriteClockJSON(json, config.writer);
+    json.Key("reader");
+    WriteClockJSON(json, config.reader);
+    json.EndObject();
+
+    json.Key("summary").BeginObject()
+        .Key("writeCycles").UInt(result.writeCycles)
+        .Key("readCycles").UInt(result.readCycles)
+        .Key("skippedWriteCycles").UInt(result.skippedWriteCycles)
+        .Key("skippedReadCycles").UInt(result.skippedReadCycles)
+        .Key("glitches").UInt(result.Glitches())
+        .Key("underrunGlitches").UInt(result.underrunGlitches)
+        .Key("overrunGlitches").UInt(result.overrunGlitches)
+        .Key("dropGlitches").UInt(result.dropGlitches)
+        .Key("underrunFrames").UInt(result.underrunFrames)
+        .Key("overrunFrames").UInt(result.overrunFrames)
+        .Key("droppedFrames").UInt(result.droppedFrames)
+        .Key("minLatencyMs").Number(result.minLatencyMs)
+        .Key("maxLatencyMs").Number(result.maxLatencyMs)
+        .Key("meanLatencyMs").Number(result.meanLatencyMs)
+        .Key("finalRatio").Number(result.finalRatio)
+        .EndObject();
+
+    json.Key("trace").BeginArray();
+    for (const SimulationSample& sample : result.trace) {
+        json.BeginObject()
+            .Key("time").Number(sample.timeSeconds)
+            .Key("fillFrames").UInt(sample.fillFrames)
+            .Key("latencyMs").Number(sample.latencyMs)
+            .Key("ratio").Number(sample.resampleRatio)
+            .Key("underrunFrames").UInt(sample.underrunFrames)
+            .Key("overrunFrames").UInt(sample.overrunFrames)
+            .Key("droppedFrames").UInt(sample.droppedFrames)
+            .Key("glitches").UInt(sample.glitches)
+            .EndObject();
+    }
+    json.EndArray().EndObject();
+    fprintf(file, "%s\n", json.Text().c_str());
+}
+
+static void PrintSummary(FILE* file, const SimulationConfig& config, const SimulationResult& result)
+{
+    fprintf(file, "pulse-audio-sim: %.1f s at %.0f Hz, writer %u frames %+.1f ppm, reader %u frames %+.1f ppm\n",
+            config.durationSeconds, config.sampleRate,
+            (unsigned)config.writer.framesPerPeriod, config.writer.driftPPM,
+            (unsigned)config.reader.framesPerPeriod, config.reader.driftPPM);
+    fprintf(file, "  cycles          %" PRIu64 " write, %" PRIu64 " read (%" PRIu64 " / %" PRIu64 " skipped)\n",
+            (uint64_t)result.writeCycles, (uint64_t)result.readCycles,
+            (uint64_t)result.skippedWriteCycles, (uint64_t)result.skippedReadCycles);
+    fprintf(file, "  glitches        %" PRIu64 " (%" PRIu64 " underrun, %" PRIu64 " overrun, %" PRIu64 " drop)\n",
+            (uint64_t)result.Glitches(), (uint64_t)result.underrunGlitches,
+            (uint64_t)result.overrunGlitches, (uint64_t)result.dropGlitches);
+    fprintf(file, "  frames          %" PRIu64 " underrun, %" PRIu64 " overrun, %" PRIu64 " dropped\n",
+            (uint64_t)result.underrunFrames, (uint64_t)result.overrunFrames, (uint64_t)result.droppedFrames);
+    fprintf(file, "  latency         %.2f min, %.2f mean, %.2f max ms\n",
+            result.minLatencyMs, result.meanLatencyMs, result.maxLatencyMs);
+    fprintf(file, "  resample ratio  %.9f\n", result.finalRatio);
+}
+
+int main(int argc, char* argv[])
+{
+    SimulationConfig config;
+    config.writer.stallMs = config.reader.stallMs = 20.0;
+    std::string csvPath;
+    std::string jsonPath;
+    bool    checkGlitches = false;
+    UInt64  maxGlitches   = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char* name = argv[i];
+        if (i + 1 >= argc) {
+            PrintUsage();
+            return 1;
+        }
+        const char* value = argv[++i];
+
+        UInt64  count  = 0;
+        Float64 number = 0.0;
+        bool    valid  = true;
+        if (ParseClockOption(name, value, "--writer", &config.writer, &valid) ||
+            ParseClockOption(name, value, "--reader", &config.reader, &valid)) {
+            // handled
+        } else if (strcmp(name, "--duration") == 0) {
+            valid = ParseDouble(value, &config.durationSeconds) && config.durationSeconds > 0.0;
+        } else if (strcmp(name, "--seed") == 0) {
+            valid = ParseUInt(value, &config.seed);
+        } else if (strcmp(name, "--rate") == 0) {
+            valid = ParseDouble(value, &config.sampleRate);
+        } else if (strcmp(name, "--channels") == 0) {
+            valid = ParseUInt(value, &count) && count <= kMaxNumChannels;
+            config.channels = (UInt32)count;
+        } else if (strcmp(name, "--capacity") == 0) {
+            valid = ParseUInt(value, &count) && count <= 0xFFFFFFFFull;
+            config.capacityFrames = (UInt32)count;
+        } else if (strcmp(name, "--target") == 0) {
+            valid = ParseUInt(value, &count) && count <= 0xFFFFFFFFull;
+            config.targetFillFrames = (UInt32)count;
+        } else if (strcmp(name, "--stall-ms") == 0) {
+            valid = ParseDouble(value, &number) && number >= 0.0;
+            config.writer.stallMs = config.reader.stallMs = number;
+        } else if (strcmp(name, "--jitter-dist") == 0) {
+            valid = strcmp(value, "uniform") == 0 || strcmp(value, "gaussian") == 0;
+            config.writer.jitter = config.reader.jitter =
+                strcmp(value, "uniform") == 0 ? kJitter_Uniform : kJitter_Gaussian;
+        } else if (strcmp(name, "--trace-ms") == 0) {
+            valid = ParseDouble(value, &config.traceIntervalMs) && config.traceIntervalMs >= 0.0;
+        } else if (strcmp(name, "--csv") == 0) {
+            csvPath = value;
+        } else if (strcmp(name, "--json") == 0) {
+            jsonPath = value;
+        } else if (strcmp(name, "--max-glitches") == 0) {
+            valid = ParseUInt(value, &maxGlitches);
+            checkGlitches = true;
+        } else {
+            valid = false;
+        }
+
+        if (!valid) {
+            fprintf(stderr, "pulse-audio-sim: bad option %s %s\n", name, value);
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    SimulationResult result;
+    OSStatus status = RunSimulation(config, &result);
+    if (status != kAudioHardwareNoError) {
+        fprintf(stderr, "pulse-audio-sim: engine rejected the configuration (status %d)\n", (int)status);
+        return 1;
+    }
+
+    // Keep stdout clean for whichever report goes there
+    bool reportOnStdout = csvPath == "-" || jsonPath == "-";
+    PrintSummary(reportOnStdout ? stderr : stdout, config, result);
+
+    if (!csvPath.empty()) {
+        FILE* file = OpenOutput(csvPath);
+        if (!file) return 1;
+        WriteCSV(file, result);
+        CloseOutput(file);
+    }
+    if (!jsonPath.empty()) {
+        FILE* file = OpenOutput(jsonPath);
+        if (!file) return 1;
+        WriteJSON(file, config, result);
+        CloseOutput(file);
+    }
+
+    if (checkGlitches && result.Glitches() > maxGlitches) {
+        fprintf(stderr, "pulse-audio-sim: %" PRIu64 " glitches, more than the %" PRIu64 " allowed\n",
+                (uint64_t)result.Glitches(), (uint64_t)maxGlitches);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <type_traits>
+#include "platform.h"
+#include "ring-buffer.h"   // kCacheLineSize
+
+// Single-writer, single-reader triple buffer over a trivially copyable struct.
+// The writer fills WriteBuffer() and Publish()es it; the reader calls Update()
+// and reads ReadBuffer(). Both sides are wait-free and never copy through a
+// shared slot: three slots rotate through one atomic index, so the writer
+// always has a private slot to fill and the reader always sees a whole value.
+// Unlike Seqlock, the reader can tell whether it has seen the latest value,
+// and the writer whether the reader took the last one.
+template <typename T>
+class TripleBuffer {
+    static_assert(std::is_trivially_copyable<T>::value, "TripleBuffer requires a trivially copyable type");
+
+public:
+    TripleBuffer() : mMiddle(1), mBack(2), mFront(0) {
+        for (T& slot : mSlots) slot = T();
+    }
+
+    // Writer: the slot to fill before Publish()
+    T&   WriteBuffer() { return mSlots[mBack]; }
+
+    // Writer: make WriteBuffer() the latest value and take a fresh slot
+    void Publish() {
+        UInt32 old = mMiddle.exchange(mBack | kFresh, std::memory_order_acq_rel);
+        mBack = old & kIndexMask;
+    }
+
+    // Writer: whether the reader has taken the last published value
+    bool IsConsumed() const { return (mMiddle.load(std::memory_order_relaxed) & kFresh) == 0; }
+
+    // Reader: swap in the latest published value, if there is one.
+    // Returns false when ReadBuffer() is already the latest.
+    bool Update() {
+        if ((mMiddle.load(std::memory_order_relaxed) & kFresh) == 0) return false;
+        UInt32 old = mMiddle.exchange(mFront, std::memory_order_acq_rel);
+        mFront = old & kIndexMask;
+        return true;
+    }
+
+    // Reader: the value taken by the last Update() (value-initialized before any)
+    const T& ReadBuffer() const { return mSlots[mFront]; }
+
+private:
+    static const UInt32 kIndexMask = 3;
+    static const UInt32 kFresh     = 4;   // set in mMiddle by Publish(), cleared by Update()
+
+    T                   mSlots[3];
+    alignas(kCacheLineSize) std::atomic<UInt32> mMiddle;   // slot index | kFresh
+    alignas(kCacheLineSize) UInt32 mBack;                  // writer only
+    alignas(kCacheLineSize) UInt32 mFront;                 // reader only
+};
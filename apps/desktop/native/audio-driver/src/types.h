@@ -1,44 +1,155 @@
 #pragma once
 
-#include <CoreAudio/AudioServerPlugIn.h>
-#include <CoreFoundation/CoreFoundation.h>
+#include "platform.h"
 
-// Static object IDs — we have exactly one device with fixed topology
+// Object IDs. The plug-in is always 1. Each device owns a block of
+// kObjectsPerDevice consecutive IDs starting at kFirstDeviceObjectID, in
+// table slot order, so the owning device of any object is found by division.
+// Slot 0 keeps the original fixed IDs 2..5.
 enum ObjectID : AudioObjectID {
     kObjectID_Plugin        = kAudioObjectPlugInObject, // always 1
-    kObjectID_Device        = 2,
-    kObjectID_Stream_Output = 3,
-    kObjectID_Stream_Input  = 4,
-    kObjectID_Volume        = 5,
 };
 
+enum DeviceObjectOffset : UInt32 {
+    kObjectOffset_Device        = 0,
+    kObjectOffset_Stream_Output = 1,
+    kObjectOffset_Stream_Input  = 2,
+    kObjectOffset_Volume        = 3,
+    kObjectsPerDevice           = 4,
+};
+
+static const AudioObjectID kFirstDeviceObjectID = 2;
+static const UInt32        kMaxDevices          = 16;
+
+static inline AudioObjectID DeviceObjectID(UInt32 slot, DeviceObjectOffset offset)
+{
+    return kFirstDeviceObjectID + slot * kObjectsPerDevice + offset;
+}
+
+// Table slot of the device owning objectID (>= kFirstDeviceObjectID)
+static inline UInt32 DeviceSlotForObject(AudioObjectID objectID)
+{
+    return (objectID - kFirstDeviceObjectID) / kObjectsPerDevice;
+}
+
+static inline DeviceObjectOffset DeviceObjectOffsetOf(AudioObjectID objectID)
+{
+    return (DeviceObjectOffset)((objectID - kFirstDeviceObjectID) % kObjectsPerDevice);
+}
+
 // String constants
-static const char* kDeviceName          = "Pulse Audio";
-static const char* kDeviceManufacturer  = "Pulse";
+static const char* const kDeviceName         = "Pulse Audio";
+static const char* const kDeviceManufacturer = "Pulse";
 
 // CFString UIDs (created lazily)
 #define kPluginBundleID     CFSTR("com.pulse.audio.driver")
-#define kDeviceUID          CFSTR("com.pulse.audio.device")
+#define kDeviceUID          CFSTR("com.pulse.audio.device")       // the default device (slot 0)
 #define kDeviceModelUID     CFSTR("com.pulse.audio.device.model")
 
-// Audio format constants
-static const Float64 kSupportedSampleRates[]    = { 44100.0, 48000.0 };
-static const UInt32  kNumSupportedSampleRates    = 2;
+// Keys of the description dictionary passed to CreateDevice. Both optional:
+// the UID defaults to "<kDeviceUID>.<slot>", the name to "<kDeviceName> <slot + 1>".
+#define kDeviceDescriptionUIDKey   CFSTR("uid")
+#define kDeviceDescriptionNameKey  CFSTR("name")
+
+// Audio format constants. 16 kHz is there for speech-only capture (see
+// kPulseDevicePropertyVoiceCapture).
+static const Float64 kSupportedSampleRates[]    = { 16000.0, 44100.0, 48000.0, 96000.0 };
+static const UInt32  kNumSupportedSampleRates    = 4;
 static const Float64 kDefaultSampleRate          = 48000.0;
-static const UInt32  kNumChannels                = 2;
+static const Float64 kMaxSampleRate              = 96000.0;
 static const UInt32  kBitsPerChannel             = 32;
-static const UInt32  kBytesPerFrame              = kNumChannels * (kBitsPerChannel / 8);
 static const UInt32  kBytesPerSample             = kBitsPerChannel / 8;
 
-// IO timing
+// Channel counts both streams can be switched between (mono, stereo, 5.1, 7.1).
+// Interleaved in the usual CoreAudio order for each layout.
+static const UInt32  kSupportedChannelCounts[]  = { 1, 2, 6, 8 };
+static const UInt32  kNumSupportedChannelCounts = 4;
+static const UInt32  kDefaultNumChannels        = 2;
+static const UInt32  kMaxNumChannels            = 8;
+
+static inline UInt32 BytesPerFrame(UInt32 channels) { return channels * kBytesPerSample; }
+
+// Sample formats of the input stream. The output stream is always Float32;
+// capture can switch to packed Int16 to halve the bytes moved per IO cycle.
+enum InputSampleFormat : UInt32 {
+    kInputSampleFormat_Float32 = 1,
+    kInputSampleFormat_Int16   = 2,
+};
+
+static const UInt32  kInt16BitsPerChannel        = 16;
+
+static inline UInt32 Int16BytesPerFrame(UInt32 channels) { return channels * sizeof(SInt16); }
+
+// Channel layouts of the input stream. By default it mirrors the output
+// stream's layout; in mono mode ReadInput downmixes every frame to one channel.
+enum InputChannelMode : UInt32 {
+    kInputChannelMode_Mirror = 1,
+    kInputChannelMode_Mono   = 2,
+};
+
+// IO timing — the period is a fixed 10ms at every rate.
+// Frame counts below are at kDefaultSampleRate; the engine rescales the
+// capacity and target fill when the nominal rate changes.
+static const UInt32  kPeriodsPerSecond           = 100;
 static const UInt32  kFramesPerPeriod            = 480;  // 10ms at 48kHz
-static const UInt32  kRingBufferFrameCapacity    = 48000; // 1 second
+static const UInt32  kRingBufferFrameCapacity    = 48000; // 1 second (default)
+static const UInt32  kMinRingBufferPeriods       = 4;
+static const UInt32  kMaxRingBufferSeconds       = 4;
+static const UInt32  kDefaultTargetFillFrames    = 3 * kFramesPerPeriod; // 30ms capture latency
+
+// Silence gating. WriteMix output whose peak (after gain) stays below
+// kSilenceThreshold — half an Int16 LSB, so it would convert to zero — for
+// kSilenceHoldPeriods periods is stored in the ring as a silent-run marker
+// instead of samples, and the input stream reports itself inactive.
+static const Float32 kSilenceThreshold           = 1.0f / 65536.0f;
+static const UInt32  kSilenceHoldPeriods         = 20;   // 200ms
 
 // Latency
 static const UInt32  kDeviceLatencyFrames        = 0;
 static const UInt32  kStreamLatencyFrames        = 0;
 static const UInt32  kSafetyOffsetFrames         = 0;
 
+// Custom device properties (four-char codes spelled out in hex)
+// 'pbcf' — CFDictionary { capacityFrames, targetFillFrames }, settable,
+// in frames at the current nominal rate
+static const UInt32  kPulseDevicePropertyBufferConfig = 0x70626366;
+#define kBufferConfigCapacityKey    CFSTR("capacityFrames")
+#define kBufferConfigTargetFillKey  CFSTR("targetFillFrames")
+
+// 'pstt' — read-only CFDictionary snapshot of the IO counters (see IOStats)
+static const UInt32  kPulseDevicePropertyStats = 0x70737474;
+
+// 'pdth' — CFBoolean, settable: TPDF dither when the input stream is Int16 (default on)
+static const UInt32  kPulseDevicePropertyInt16Dither = 0x70647468;
+
+// 'pvoc' — CFNumber, settable: voice capture. 48000 or 16000 switches the
+// device to that nominal rate with a mono input stream; 0 restores the
+// mirrored input layout (the rate stays). Reads back the nominal rate while
+// the input is mono, else 0.
+static const UInt32  kPulseDevicePropertyVoiceCapture = 0x70766F63;
+
+// 'pmtr' — read-only CFDictionary of output mix levels after gain since the
+// previous read: { periods, frames, peak: [per channel], rms: [per channel] },
+// linear with 1.0 = full scale. Each read starts a new window, so one
+// poller (the helper's meter command) should own it.
+static const UInt32  kPulseDevicePropertyMeter = 0x706D7472;
+#define kMeterPeriodsKey  CFSTR("periods")
+#define kMeterFramesKey   CFSTR("frames")
+#define kMeterPeakKey     CFSTR("peak")
+#define kMeterRMSKey      CFSTR("rms")
+
+// 'pshm' — CFString, settable: name of the shared-memory capture ring
+// ("/name", at most 31 characters; layout in shm-ring.h). The driver
+// mirrors the output mix into it from the next StartIO, or at once while IO
+// is stopped. An empty string turns it off; reads back "" while off.
+static const UInt32  kPulseDevicePropertySharedMemory = 0x7073686D;
+
+// Custom stream properties
+// 'pact' — read-only CFBoolean on the input stream: true while the output
+// mix carries signal, false once it has been silent for kSilenceHoldPeriods.
+// Listeners are notified on every change, so a client can pause encoding.
+static const UInt32  kPulseStreamPropertyActive = 0x70616374;
+
 // Volume
 static const Float32 kDefaultVolume              = 1.0f;
 static const Float32 kMinVolume                  = 0.0f;
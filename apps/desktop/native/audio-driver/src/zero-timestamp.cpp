@@ -0,0 +1,32 @@
+#include "zero-timestamp.h"
+
+typedef unsigned __int128 UInt128;
+
+UInt64 HostTicksPerPeriodFixed(UInt32 sampleRate, UInt32 framesPerPeriod, HostTimebase timebase)
+{
+    // ticks = frames / rate seconds * 1e9 ns * denom / numer
+    UInt128 numerator   = ((UInt128)framesPerPeriod * 1000000000ull * timebase.denom) << 32;
+    UInt128 denominator = (UInt128)sampleRate * timebase.numer;
+    return (UInt64)(numerator / denominator);
+}
+
+void ComputeZeroTimestamp(const ZeroTimestampClock& clock, UInt64 nowHostTime,
+                          UInt64* outSampleTime, UInt64* outHostTime)
+{
+    UInt64 elapsed = nowHostTime - clock.anchorHostTime;
+    UInt64 periods;
+
+    if ((clock.ticksPerPeriodFixed & 0xFFFFFFFFull) == 0) {
+        // Whole number of ticks per period (every real timebase and supported
+        // rate): a single 64-bit division
+        UInt64 ticksPerPeriod = clock.ticksPerPeriodFixed >> 32;
+        periods        = elapsed / ticksPerPeriod;
+        *outHostTime   = clock.anchorHostTime + periods * ticksPerPeriod;
+    } else {
+        periods        = (UInt64)(((UInt128)elapsed << 32) / clock.ticksPerPeriodFixed);
+        *outHostTime   = clock.anchorHostTime +
+                         (UInt64)(((UInt128)periods * clock.ticksPerPeriodFixed) >> 32);
+    }
+
+    *outSampleTime = periods * clock.framesPerPeriod;
+}
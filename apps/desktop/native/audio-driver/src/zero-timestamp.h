@@ -0,0 +1,23 @@
+#pragma once
+
+#include "host-time.h"
+#include "platform.h"
+
+// Integer-only zero timestamp math.
+// The period length in host ticks is precomputed as 32.32 fixed point when
+// the timeline is anchored, so each GetZeroTimeStamp is one division and one
+// multiply. Every result is derived from the anchor, never accumulated, so
+// there is no drift however long IO runs.
+struct ZeroTimestampClock {
+    UInt64 anchorHostTime;       // host time of sample time 0
+    UInt64 ticksPerPeriodFixed;  // host ticks per period, 32.32 fixed point
+    UInt32 framesPerPeriod;
+};
+
+// Host ticks per period, 32.32 fixed point. sampleRate must be a whole
+// number of Hz (all supported rates are).
+UInt64 HostTicksPerPeriodFixed(UInt32 sampleRate, UInt32 framesPerPeriod, HostTimebase timebase);
+
+// Start of the latest period that began at or before nowHostTime.
+void   ComputeZeroTimestamp(const ZeroTimestampClock& clock, UInt64 nowHostTime,
+                            UInt64* outSampleTime, UInt64* outHostTime);
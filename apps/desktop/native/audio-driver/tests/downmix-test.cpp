@@ -0,0 +1,106 @@
+// Checks every downmix kernel this CPU can run against the scalar one for
+// each supported channel count, with frame counts that leave tails after the
+// SIMD blocks, and the channel weights on single-channel impulses.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "downmix.h"
+#include "test-check.h"
+
+// 1 and 4 take the equal-weight path, the others have their own kernels
+static const UInt32 kChannelCounts[] = { 1, 2, 4, 6, 8 };
+
+// Odd counts leave tails after the 4-frame blocks
+static const UInt32 kFrameCounts[] = { 0, 1, 3, 4, 7, 13, 31, 480, 481, 1023 };
+
+// The SIMD kernels sum the weighted channels in a different order
+static const Float32 kSampleTolerance = 1e-6f;
+
+// Deterministic signal in [-1, 1)
+static std::vector<float> Signal(UInt32 numSamples, UInt32 seed)
+{
+    std::vector<float> samples(numSamples);
+    UInt32 state = seed * 2654435761u + 1;
+    for (float& sample : samples) {
+        state = state * 1664525u + 1013904223u;
+        sample = (Float32)(state >> 8) / (Float32)(1u << 23) - 1.0f;
+    }
+    return samples;
+}
+
+static bool Near(Float32 a, Float32 b, Float32 tolerance)
+{
+    return std::fabs(a - b) <= tolerance * std::fmax(1.0f, std::fabs(b));
+}
+
+static void TestAgainstScalar(const DownmixKernel& kernel, const DownmixKernel& scalar)
+{
+    for (UInt32 channels : kChannelCounts) {
+        for (UInt32 frames : kFrameCounts) {
+            std::vector<float> src = Signal(frames * channels, frames + channels);
+            std::vector<float> expected(frames), actual(frames);
+            scalar.downmix(expected.data(), src.data(), frames, channels);
+            kernel.downmix(actual.data(), src.data(), frames, channels);
+            for (UInt32 i = 0; i < frames; i++) {
+                CHECK(Near(actual[i], expected[i], kSampleTolerance),
+                      "%s: %u ch, %u frames: frame %u is %g, scalar %g", kernel.name, channels, frames, i,
+                      actual[i], expected[i]);
+            }
+        }
+    }
+}
+
+// Each channel alone at full scale, in every frame position of a vector block
+static void TestWeights(const DownmixKernel& kernel)
+{
+    const Float32 c = 0.70710678f, s = 0.35355339f;
+    const Float32 stereo[] = { 0.5f, 0.5f };
+    const Float32 surround51[] = { 0.5f, 0.5f, c, 0.0f, s, s };
+    const Float32 surround71[] = { 0.5f, 0.5f, c, 0.0f, s, s, s, s };
+    const Float32 quad[] = { 0.25f, 0.25f, 0.25f, 0.25f };
+    const struct { UInt32 channels; const Float32* weights; } layouts[] = {
+        { 2, stereo }, { 4, quad }, { 6, surround51 }, { 8, surround71 },
+    };
+
+    const UInt32 frames = 8;
+    for (const auto& layout : layouts) {
+        for (UInt32 ch = 0; ch < layout.channels; ch++) {
+            std::vector<float> src(frames * layout.channels, 0.0f);
+            for (UInt32 f = 0; f < frames; f++) src[f * layout.channels + ch] = 1.0f;
+            std::vector<float> dst(frames);
+            kernel.downmix(dst.data(), src.data(), frames, layout.channels);
+            for (UInt32 f = 0; f < frames; f++) {
+                CHECK(Near(dst[f], layout.weights[ch], kSampleTolerance),
+                      "%s: %u ch: channel %u weighs %g in frame %u, expected %g", kernel.name,
+                      layout.channels, ch, dst[f], f, layout.weights[ch]);
+            }
+        }
+    }
+}
+
+int main()
+{
+    UInt32 count = 0;
+    const DownmixKernel* kernels = GetDownmixKernels(&count);
+    if (count == 0 || strcmp(kernels[count - 1].name, "scalar") != 0) {
+        fprintf(stderr, "FAIL: the last downmix kernel is not the scalar one\n");
+        return EXIT_FAILURE;
+    }
+    const DownmixKernel& scalar = kernels[count - 1];
+
+    for (UInt32 k = 0; k < count; k++) {
+        TestAgainstScalar(kernels[k], scalar);
+        TestWeights(kernels[k]);
+        printf("downmix-test: %s checked\n", kernels[k].name);
+    }
+
+    if (gFailures > 0) {
+        fprintf(stderr, "%d failure(s)\n", gFailures);
+        return EXIT_FAILURE;
+    }
+    printf("downmix-test: OK\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,234 @@
+// Checks that every FanoutRingBuffer reader sees the full stream, that a
+// slow reader is dropped on its own without affecting the others, also when
+// it was opened behind them, that concurrent readers never return a torn or
+// reordered frame, and that silent runs read back as zeros however they
+// straddle the silence blocks.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "fanout-ring-buffer.h"
+#include "test-check.h"
+
+// Write frames [first, first + count) of a stereo ramp; both channels hold the frame index
+static void WriteRamp(FanoutRingBuffer& ring, UInt64 first, UInt32 count)
+{
+    RingBufferRegions regions;
+    UInt32 reserved = ring.ReserveWrite(count, &regions);
+    for (UInt32 i = 0; i < reserved; i++) {
+        float* frame = i < regions.firstFrames ? regions.first + i * 2
+                                               : regions.second + (i - regions.firstFrames) * 2;
+        frame[0] = frame[1] = (float)(first + i);
+    }
+    ring.CommitWrite(reserved);
+}
+
+static void TestIndependentReaders()
+{
+    const UInt32 kPeriod = 480;
+    FanoutRingBuffer ring;
+    ring.Initialize(4096, 2 * sizeof(float));
+    ring.OpenReader(0, 0);
+    ring.OpenReader(1, 0);
+
+    std::vector<float> buffer(kPeriod * 2);
+    UInt64 written = 0;
+    UInt64 nextFast = 0;
+
+    // Reader 0 keeps up; reader 1 stops reading for 20 periods
+    for (UInt32 cycle = 0; cycle < 40; cycle++) {
+        WriteRamp(ring, written, kPeriod);
+        written += kPeriod;
+
+        UInt32 got = ring.Fetch(0, buffer.data(), kPeriod);
+        CHECK(got == kPeriod, "fast reader got %u frames in cycle %u", got, cycle);
+        CHECK(buffer[0] == (float)nextFast, "fast reader at %.0f, expected %llu",
+              buffer[0], (unsigned long long)nextFast);
+        nextFast += kPeriod;
+
+        if (cycle < 20) {
+            got = ring.Fetch(1, buffer.data(), kPeriod);
+            CHECK(got == kPeriod, "slow reader got %u frames in cycle %u", got, cycle);
+        }
+    }
+
+    CHECK(ring.DroppedFrames(0) == 0, "fast reader lost %llu frames",
+          (unsigned long long)ring.DroppedFrames(0));
+    CHECK(ring.AvailableFrames(1) == ring.CapacityFrames(), "slow reader has %u frames",
+          ring.AvailableFrames(1));
+
+    // The slow reader resumes at the oldest frame still in the ring
+    UInt64 expected = written - ring.CapacityFrames();
+    CHECK(ring.DroppedFrames(1) == expected - 20 * kPeriod, "slow reader dropped %llu frames",
+          (unsigned long long)ring.DroppedFrames(1));
+    ring.Fetch(1, buffer.data(), kPeriod);
+    CHECK(buffer[0] == (float)expected, "slow reader resumed at %.0f, expected %llu",
+          buffer[0], (unsigned long long)expected);
+
+    // A closed reader no longer holds anything back or collects drops
+    ring.CloseReader(1);
+    UInt64 dropped = ring.DroppedFrames(1);
+    for (UInt32 cycle = 0; cycle < 20; cycle++) {
+        WriteRamp(ring, written, kPeriod);
+        written += kPeriod;
+        ring.Fetch(0, buffer.data(), kPeriod);
+    }
+    CHECK(ring.DroppedFrames(1) == dropped, "closed reader collected drops");
+
+    // A new reader starts its backlog behind the writer
+    ring.OpenReader(2, 1000);
+    CHECK(ring.AvailableFrames(2) == 1000, "new reader has %u frames", ring.AvailableFrames(2));
+}
+
+// The writer only rescans the readers when a write could reach one of them.
+// A reader opened with a deep backlog sits behind the cursors of that scan
+// and must still be dropped once the writer reaches it.
+static void TestReaderOpenedBehind()
+{
+    const UInt32 kPeriod = 480;
+    FanoutRingBuffer ring;
+    ring.Initialize(4096, 2 * sizeof(float));
+    ring.OpenReader(0, 0);
+
+    // The ninth write is the first to overwrite anything, so it scans reader 0
+    std::vector<float> buffer(kPeriod * 2);
+    UInt64 written = 0;
+    for (UInt32 cycle = 0; cycle < 9; cycle++) {
+        WriteRamp(ring, written, kPeriod);
+        written += kPeriod;
+        ring.Fetch(0, buffer.data(), kPeriod);
+    }
+
+    ring.OpenReader(1, 2000);
+    UInt64 opened = written - 2000;
+    for (UInt32 cycle = 0; cycle < 5; cycle++) {
+        WriteRamp(ring, written, kPeriod);
+        written += kPeriod;
+        ring.Fetch(0, buffer.data(), kPeriod);
+    }
+
+    UInt64 oldest = written - ring.CapacityFrames();
+    CHECK(ring.DroppedFrames(1) == oldest - opened, "reader opened behind dropped %llu frames, expected %llu",
+          (unsigned long long)ring.DroppedFrames(1), (unsigned long long)(oldest - opened));
+    ring.Fetch(1, buffer.data(), kPeriod);
+    CHECK(buffer[0] == (float)oldest, "reader opened behind resumed at %.0f, expected %llu",
+          buffer[0], (unsigned long long)oldest);
+    CHECK(ring.DroppedFrames(0) == 0, "reader 0 lost %llu frames", (unsigned long long)ring.DroppedFrames(0));
+}
+
+// Alternate sample and silence runs of awkward lengths through a small ring,
+// so runs start and end mid-block and wrap, and check every frame read back
+static void TestSilentRuns()
+{
+    const UInt32 kRuns[]  = { 45, 100, 7, 64, 33, 200, 1, 31, 96, 150 };
+    const UInt32 kNumRuns = sizeof(kRuns) / sizeof(kRuns[0]);
+    const UInt32 kRead    = 37;
+
+    FanoutRingBuffer ring;
+    ring.Initialize(256, 2 * sizeof(float));
+    ring.OpenReader(0, 0);
+
+    // Frames are numbered from 1 so that sample frames are never zero
+    std::vector<float> expected;
+    std::vector<float> buffer(kRead * 2);
+    size_t checked = 0;
+
+    for (UInt32 run = 0; run < 4 * kNumRuns; run++) {
+        UInt32 count = kRuns[run % kNumRuns];
+        if (run % 2 == 0) {
+            WriteRamp(ring, expected.size() + 1, count);
+            for (UInt32 i = 0; i < count; i++) expected.push_back((float)(expected.size() + 1));
+        } else {
+            ring.WriteSilence(count);
+            expected.insert(expected.end(), count, 0.0f);
+        }
+
+        while (ring.AvailableFrames(0) > 0) {
+            bool   silent = false;
+            UInt32 got    = ring.Fetch(0, buffer.data(), kRead, &silent);
+            bool   zeros  = true;
+            for (UInt32 i = 0; i < got; i++, checked++) {
+                CHECK(buffer[i * 2] == expected[checked] && buffer[i * 2 + 1] == expected[checked],
+                      "frame %zu read %.0f/%.0f, expected %.0f", checked,
+                      buffer[i * 2], buffer[i * 2 + 1], expected[checked]);
+                zeros = zeros && expected[checked] == 0.0f;
+            }
+            // Short runs are stored as zeroed samples, so only one direction holds
+            CHECK(!silent || zeros, "fetch ending at frame %zu reported silent", checked);
+        }
+    }
+    CHECK(checked == expected.size(), "read %zu of %zu frames", checked, expected.size());
+    CHECK(ring.DroppedFrames(0) == 0, "reader dropped %llu frames",
+          (unsigned long long)ring.DroppedFrames(0));
+}
+
+static void TestConcurrentReaders()
+{
+    const UInt32 kReaders     = 3;
+    const UInt64 kTotalFrames = 1 << 21;  // exact in float
+    const UInt32 kWriteFrames = 256;
+
+    FanoutRingBuffer ring;
+    ring.Initialize(1024, 2 * sizeof(float));
+    for (UInt32 r = 0; r < kReaders; r++) ring.OpenReader(r, 0);
+
+    std::atomic<bool>   done(false);
+    std::atomic<int>    errors(0);
+    std::atomic<UInt32> started(0);
+    UInt64 received[kReaders] = {};
+
+    std::vector<std::thread> readers;
+    for (UInt32 r = 0; r < kReaders; r++) {
+        readers.emplace_back([&, r]() {
+            std::vector<float> buffer(97 * 2);
+            double last = -1.0;
+            started++;
+            for (;;) {
+                bool finished = done.load(std::memory_order_acquire);
+                UInt32 got = ring.Fetch(r, buffer.data(), 97);
+                for (UInt32 i = 0; i < got; i++) {
+                    float left = buffer[i * 2], right = buffer[i * 2 + 1];
+                    if (left != right || left <= last) errors++;
+                    last = left;
+                }
+                received[r] += got;
+                if (finished && got == 0) break;
+                // Reader 2 is slow and should be dropped regularly
+                if (r == 2) std::this_thread::yield();
+            }
+        });
+    }
+
+    while (started.load() < kReaders) std::this_thread::yield();
+    for (UInt64 written = 0; written < kTotalFrames; written += kWriteFrames) {
+        WriteRamp(ring, written, kWriteFrames);
+        if ((written / kWriteFrames) % 4 == 0) std::this_thread::yield();
+    }
+    done.store(true, std::memory_order_release);
+    for (std::thread& reader : readers) reader.join();
+
+    CHECK(errors.load() == 0, "%d torn or out-of-order frames", errors.load());
+    for (UInt32 r = 0; r < kReaders; r++) {
+        CHECK(received[r] + ring.DroppedFrames(r) == kTotalFrames,
+              "reader %u: %llu received + %llu dropped != %llu", r,
+              (unsigned long long)received[r], (unsigned long long)ring.DroppedFrames(r),
+              (unsigned long long)kTotalFrames);
+    }
+}
+
+int main()
+{
+    TestIndependentReaders();
+    TestReaderOpenedBehind();
+    TestSilentRuns();
+    TestConcurrentReaders();
+
+    if (gFailures > 0) {
+        fprintf(stderr, "%d failure(s)\n", gFailures);
+        return EXIT_FAILURE;
+    }
+    printf("fanout-ring-buffer-test: OK\n");
+    return EXIT_SUCCESS;
+}
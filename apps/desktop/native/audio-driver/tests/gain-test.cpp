@@ -0,0 +1,154 @@
+// Checks every gain kernel this CPU can run against the scalar one: ramps and
+// constant gains for each supported channel count, frame counts that leave
+// tails after the SIMD blocks, in place, and the per-channel levels of the
+// metering variants, including accumulation into earlier levels and a NaN
+// sample left out of the peak.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "gain.h"
+#include "test-check.h"
+
+static const UInt32 kChannelCounts[] = { 1, 2, 6, 8 };
+
+// Odd counts leave tails after every block size (4, 8, 12, 24 samples)
+static const UInt32 kFrameCounts[] = { 0, 1, 3, 7, 13, 31, 480, 481, 1023 };
+
+// The SIMD kernels step the gain by addition, the scalar one multiplies, so
+// the outputs differ by rounding. A lane off by one frame would be out by a
+// whole gain step (~2e-3 here).
+static const Float32 kSampleTolerance = 1e-4f;
+
+// Deterministic signal in [-1, 1)
+static std::vector<float> Signal(UInt32 numSamples, UInt32 seed)
+{
+    std::vector<float> samples(numSamples);
+    UInt32 state = seed * 2654435761u + 1;
+    for (float& sample : samples) {
+        state = state * 1664525u + 1013904223u;
+        sample = (Float32)(state >> 8) / (Float32)(1u << 23) - 1.0f;
+    }
+    return samples;
+}
+
+static bool Near(Float32 a, Float32 b, Float32 tolerance)
+{
+    return std::fabs(a - b) <= tolerance * std::fmax(1.0f, std::fabs(b));
+}
+
+static void TestRamps(const GainKernel& kernel, const GainKernel& scalar)
+{
+    const Float32 ramps[][2] = { { 1.0f, 0.0f }, { 0.0f, 1.0f / 480 }, { 1.0f, -1.0f / 480 }, { 0.25f, 0.0f } };
+
+    for (UInt32 channels : kChannelCounts) {
+        for (UInt32 frames : kFrameCounts) {
+            for (const auto& ramp : ramps) {
+                UInt32 numSamples = frames * channels;
+                std::vector<float> src = Signal(numSamples, frames + channels);
+                std::vector<float> expected(numSamples), actual(numSamples);
+                scalar.ramp(expected.data(), src.data(), frames, channels, ramp[0], ramp[1]);
+                kernel.ramp(actual.data(), src.data(), frames, channels, ramp[0], ramp[1]);
+                for (UInt32 i = 0; i < numSamples; i++) {
+                    CHECK(Near(actual[i], expected[i], kSampleTolerance),
+                          "%s: %u ch, %u frames, gain %g step %g: sample %u is %g, scalar %g", kernel.name,
+                          channels, frames, ramp[0], ramp[1], i, actual[i], expected[i]);
+                }
+
+                // In place
+                kernel.ramp(src.data(), src.data(), frames, channels, ramp[0], ramp[1]);
+                for (UInt32 i = 0; i < numSamples; i++) {
+                    CHECK(Near(src[i], expected[i], kSampleTolerance),
+                          "%s: %u ch, %u frames in place: sample %u is %g, scalar %g", kernel.name,
+                          channels, frames, i, src[i], expected[i]);
+                }
+            }
+        }
+    }
+}
+
+static void CheckLevels(const char* name, UInt32 channels, UInt32 frames,
+                        const ChannelLevels& actual, const ChannelLevels& expected)
+{
+    for (UInt32 ch = 0; ch < channels; ch++) {
+        CHECK(Near(actual.peak[ch], expected.peak[ch], kSampleTolerance),
+              "%s: %u ch, %u frames: channel %u peak %g, scalar %g", name, channels, frames, ch,
+              actual.peak[ch], expected.peak[ch]);
+        // Summed in a different order
+        CHECK(Near(actual.sumSquares[ch], expected.sumSquares[ch], 1e-3f),
+              "%s: %u ch, %u frames: channel %u sum of squares %g, scalar %g", name, channels, frames, ch,
+              actual.sumSquares[ch], expected.sumSquares[ch]);
+    }
+}
+
+static void TestMeters(const GainKernel& kernel, const GainKernel& scalar)
+{
+    for (UInt32 channels : kChannelCounts) {
+        for (UInt32 frames : kFrameCounts) {
+            UInt32 numSamples = frames * channels;
+            std::vector<float> src = Signal(numSamples, 3 * frames + channels);
+            std::vector<float> expected(numSamples), actual(numSamples);
+
+            // Start from earlier levels, as the second region of a ring write does
+            ChannelLevels expectedLevels = {}, actualLevels = {};
+            for (UInt32 ch = 0; ch < channels; ch++) {
+                expectedLevels.peak[ch] = actualLevels.peak[ch] = (ch % 2) ? 0.9f : 0.05f;
+                expectedLevels.sumSquares[ch] = actualLevels.sumSquares[ch] = 1.0f + ch;
+            }
+
+            scalar.rampMeter(expected.data(), src.data(), frames, channels, 0.5f, 1.0f / 960, &expectedLevels);
+            kernel.rampMeter(actual.data(), src.data(), frames, channels, 0.5f, 1.0f / 960, &actualLevels);
+            for (UInt32 i = 0; i < numSamples; i++) {
+                CHECK(Near(actual[i], expected[i], kSampleTolerance),
+                      "%s: %u ch, %u frames metered: sample %u is %g, scalar %g", kernel.name,
+                      channels, frames, i, actual[i], expected[i]);
+            }
+            CheckLevels(kernel.name, channels, frames, actualLevels, expectedLevels);
+            if (gFailures > 0) return;
+        }
+    }
+}
+
+static void TestNaNPeak(const GainKernel& kernel)
+{
+    for (UInt32 channels : kChannelCounts) {
+        const UInt32 frames = 64;
+        std::vector<float> src = Signal(frames * channels, channels);
+        std::vector<float> dst(frames * channels);
+        src[5 * channels] = NAN;
+
+        ChannelLevels levels = {};
+        kernel.rampMeter(dst.data(), src.data(), frames, channels, 1.0f, 0.0f, &levels);
+        for (UInt32 ch = 0; ch < channels; ch++) {
+            CHECK(std::isfinite(levels.peak[ch]) && levels.peak[ch] > 0.0f,
+                  "%s: %u ch: channel %u peak %g with a NaN sample", kernel.name, channels, ch, levels.peak[ch]);
+        }
+    }
+}
+
+int main()
+{
+    UInt32 count = 0;
+    const GainKernel* kernels = GetGainKernels(&count);
+    if (count == 0 || strcmp(kernels[count - 1].name, "scalar") != 0) {
+        fprintf(stderr, "FAIL: the last gain kernel is not the scalar one\n");
+        return EXIT_FAILURE;
+    }
+    const GainKernel& scalar = kernels[count - 1];
+
+    for (UInt32 k = 0; k < count; k++) {
+        TestRamps(kernels[k], scalar);
+        TestMeters(kernels[k], scalar);
+        TestNaNPeak(kernels[k]);
+        printf("gain-test: %s checked\n", kernels[k].name);
+    }
+
+    if (gFailures > 0) {
+        fprintf(stderr, "%d failure(s)\n", gFailures);
+        return EXIT_FAILURE;
+    }
+    printf("gain-test: OK\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,280 @@
+// Checks pulse-audio-helper's serve mode against the mock device backend:
+// the NDJSON parser and writer, the capture flow (default output saved,
+// aggregate created and made default, everything restored on stop), that
+// the device table is only re-enumerated after a device change and ID-only
+// lookups don't enumerate at all, and that Serve() answers one line per
+// request until shutdown and cleans up a capture its client abandoned. With a backend that applies changes late,
+// commands wait for them to land, and give up at their deadline when they
+// never do.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "helper-service.h"
+#include "mock-device-backend.h"
+#include "ndjson.h"
+#include "test-check.h"
+
+static bool Contains(const std::string& text, const char* part)
+{
+    return text.find(part) != std::string::npos;
+}
+
+static void TestJson()
+{
+    JsonObject object;
+    std::string error;
+    CHECK(ParseJsonObject(" {\"id\": 7, \"cmd\":\"a\\\"b\\u00e9\\ud83d\\ude00\", \"x\": -1.5e2, \"y\": true, \"z\": null} ",
+                          &object, &error), "parse failed: %s", error.c_str());
+    CHECK(object["id"].type == JsonScalar::kNumber && object["id"].raw == "7", "id raw '%s'", object["id"].raw.c_str());
+    CHECK(object["cmd"].string == "a\"b\xC3\xA9\xF0\x9F\x98\x80", "escapes decoded to '%s'", object["cmd"].string.c_str());
+    CHECK(object["x"].number == -150.0, "number %f", object["x"].number);
+    CHECK(object["y"].type == JsonScalar::kBool && object["y"].boolean, "bool");
+    CHECK(object["z"].type == JsonScalar::kNull, "null");
+
+    const char* bad[] = { "", "[]", "{", "{\"a\":}", "{\"a\":1,}", "{\"a\":{}}", "{\"a\":01}",
+                          "{\"a\":\"\\ud800\"}", "{\"a\":1} x", "{\"a\":tru}" };
+    for (const char* text : bad) {
+        CHECK(!ParseJsonObject(text, &object, &error), "accepted %s", text);
+    }
+
+    JsonWriter json;
+    json.BeginObject();
+    json.Key("s").String("q\"\\\n\x01");
+    json.Key("a").BeginArray().UInt(1).Int(-2).Bool(false).Null().EndArray();
+    json.Key("o").BeginObject().EndObject();
+    json.EndObject();
+    CHECK(json.Text() == "{\"s\":\"q\\\"\\\\\\n\\u0001\",\"a\":[1,-2,false,null],\"o\":{}}",
+          "writer produced %s", json.Text().c_str());
+}
+
+static void TestCaptureFlow()
+{
+    MockDeviceBackend backend;
+    HelperService service(backend);
+
+    AudioDeviceInfo speakers;
+    CHECK(service.GetDefaultOutput(&speakers) == kAudioHardwareNoError, "no default output");
+
+    // A leftover aggregate from a crashed session, left as the default
+    AudioObjectID leftover;
+    CHECK(service.CreateAggregate(speakers.uid, &leftover) == kAudioHardwareNoError, "leftover aggregate");
+    CHECK(backend.SetDefaultOutput(leftover) == kAudioHardwareNoError, "leftover default");
+
+    std::string response = service.HandleRequest("{\"id\":\"s1\",\"cmd\":\"start-capture\"}");
+    CHECK(Contains(response, "\"id\":\"s1\",\"ok\":true"), "start-capture: %s", response.c_str());
+    const CaptureSession* session = service.ActiveSession();
+    CHECK(session != nullptr, "no session after start-capture");
+    CHECK(session->savedUID == speakers.uid, "saved %s, expected the speakers", session->savedUID.c_str());
+    CHECK(session->aggregateId != leftover, "leftover aggregate was reused");
+
+    AudioObjectID current;
+    backend.GetDefaultOutput(&current);
+    CHECK(current == session->aggregateId, "default is %u, expected the aggregate", (unsigned)current);
+    const std::vector<std::string>* subDevices = backend.SubDevices(session->aggregateId);
+    CHECK(subDevices && subDevices->size() == 2 && (*subDevices)[0] == speakers.uid &&
+          (*subDevices)[1] == kPulseDeviceUID, "aggregate sub-devices");
+
+    response = service.HandleRequest("{\"id\":2,\"cmd\":\"stop-capture\"}");
+    CHECK(Contains(response, "\"ok\":true"), "stop-capture: %s", response.c_str());
+    backend.GetDefaultOutput(&current);
+    CHECK(current == speakers.id, "default is %u after stop, expected %u", (unsigned)current, (unsigned)speakers.id);
+    CHECK(service.FindDevice(kAggregateUID) == nullptr, "aggregate survived stop-capture");
+    CHECK(service.ActiveSession() == nullptr, "session survived stop-capture");
+
+    // Without the Pulse device the aggregate can't be built, and nothing is left behind
+    const AudioDeviceInfo* pulse = service.FindDevice(kPulseDeviceUID);
+    CHECK(pulse != nullptr, "no Pulse device");
+    backend.RemoveDevice(pulse->id);
+    response = service.HandleRequest("{\"id\":3,\"cmd\":\"start-capture\"}");
+    CHECK(Contains(response, "\"ok\":false"), "start-capture without driver: %s", response.c_str());
+    backend.GetDefaultOutput(&current);
+    CHECK(current == speakers.id, "failed start changed the default");
+    CHECK(Contains(service.HandleRequest("{\"cmd\":\"detect\"}"), "\"present\":false"), "detect after removal");
+}
+
+static void TestDeviceCache()
+{
+    MockDeviceBackend backend;
+    HelperService service(backend);
+
+    // Without a table, detect translates the UID instead of enumerating
+    std::string response = service.HandleRequest("{\"id\":1,\"cmd\":\"detect\"}");
+    CHECK(Contains(response, "\"present\":true"), "detect: %s", response.c_str());
+    CHECK(backend.ListCalls() == 0 && backend.TranslateCalls() == 1,
+          "detect made %u enumerations, %u translations", backend.ListCalls(), backend.TranslateCalls());
+
+    // With one, lookups are index hits
+    service.HandleRequest("{\"id\":2,\"cmd\":\"list-devices\"}");
+    for (int i = 0; i < 5; i++) {
+        response = service.HandleRequest("{\"id\":1,\"cmd\":\"detect\"}");
+        CHECK(Contains(response, "\"present\":true"), "detect: %s", response.c_str());
+        CHECK(service.FindDevice(kPulseDeviceUID) != nullptr, "Pulse device not indexed");
+    }
+    CHECK(backend.ListCalls() == 1, "%u enumerations for an unchanged device list", backend.ListCalls());
+    CHECK(backend.TranslateCalls() == 1, "%u translations with a current table", backend.TranslateCalls());
+
+    // A hot-plugged device shows up on the next request
+    backend.AddDevice("usb-dac", "USB DAC", 1, 0, 0x75736220);
+    response = service.HandleRequest("{\"id\":3,\"cmd\":\"list-devices\"}");
+    CHECK(backend.ListCalls() == 2, "%u enumerations after a change", backend.ListCalls());
+    CHECK(Contains(response, "\"uid\":\"usb-dac\"") && Contains(response, "\"transport\":\"usb \""),
+          "list-devices: %s", response.c_str());
+
+    response = service.HandleRequest("{\"id\":4,\"cmd\":\"refresh\"}");
+    CHECK(Contains(response, "\"devices\":4") && backend.ListCalls() == 3, "refresh: %s", response.c_str());
+}
+
+static void TestErrors()
+{
+    MockDeviceBackend backend;
+    HelperService service(backend);
+
+    struct { const char* request; const char* expected; } cases[] = {
+        { "not json",                                  "{\"id\":null,\"ok\":false,\"error\":\"bad request" },
+        { "{\"id\":5}",                                "{\"id\":5,\"ok\":false,\"error\":\"missing cmd\"}" },
+        { "{\"id\":6,\"cmd\":\"fly\"}",                "{\"id\":6,\"ok\":false,\"error\":\"unknown cmd: fly\"}" },
+        { "{\"id\":7,\"cmd\":\"set-default\"}",        "{\"id\":7,\"ok\":false,\"error\":\"set-default needs a deviceId\"}" },
+        { "{\"id\":8,\"cmd\":\"set-default\",\"deviceId\":1.5}", "set-default needs a deviceId" },
+        { "{\"id\":9,\"cmd\":\"set-default\",\"deviceId\":9999}", "{\"id\":9,\"ok\":false,\"error\":\"set-default failed: " },
+        { "{\"id\":10,\"cmd\":\"ping\"}",              "{\"id\":10,\"ok\":true,\"result\":{}}" },
+    };
+    for (const auto& test : cases) {
+        std::string response = service.HandleRequest(test.request);
+        CHECK(Contains(response, test.expected), "%s -> %s", test.request, response.c_str());
+    }
+}
+
+static void TestServeLoop()
+{
+    MockDeviceBackend backend;
+    HelperService service(backend);
+
+    const char* input =
+        "{\"id\":1,\"cmd\":\"ping\"}\n"
+        "\n"
+        "{\"id\":2,\"cmd\":\"get-default\"}\r\n"
+        "{\"id\":3,\"cmd\":\"shutdown\"}\n"
+        "{\"id\":4,\"cmd\":\"ping\"}\n";
+    FILE* in  = tmpfile();
+    FILE* out = tmpfile();
+    CHECK(in && out, "tmpfile failed");
+    fputs(input, in);
+    rewind(in);
+
+    service.Serve(in, out);
+    CHECK(service.IsShutdownRequested(), "shutdown not seen");
+
+    rewind(out);
+    char line[512];
+    int  lines = 0;
+    std::string all;
+    while (fgets(line, sizeof(line), out)) {
+        lines++;
+        all += line;
+    }
+    fclose(in);
+    fclose(out);
+
+    CHECK(lines == 3, "%d responses, expected 3 (blank line skipped, nothing after shutdown):\n%s", lines, all.c_str());
+    CHECK(Contains(all, "{\"id\":2,\"ok\":true,\"result\":{\"deviceId\":40,\"uid\":\"BuiltInSpeakerDevice\""),
+          "get-default response:\n%s", all.c_str());
+}
+
+static void TestServeRestoresOnEOF()
+{
+    MockDeviceBackend backend;
+    HelperService service(backend);
+    AudioObjectID speakers;
+    backend.GetDefaultOutput(&speakers);
+
+    // The client starts a capture and then disappears
+    FILE* in  = tmpfile();
+    FILE* out = tmpfile();
+    CHECK(in && out, "tmpfile failed");
+    fputs("{\"id\":1,\"cmd\":\"start-capture\"}\n", in);
+    rewind(in);
+    service.Serve(in, out);
+    fclose(in);
+    fclose(out);
+
+    AudioObjectID current;
+    backend.GetDefaultOutput(&current);
+    CHECK(current == speakers, "default is %u after EOF, expected %u", (unsigned)current, (unsigned)speakers);
+    CHECK(service.FindDevice(kAggregateUID) == nullptr, "aggregate survived EOF");
+}
+
+static long long MillisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return (long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+static void TestSettleWaits()
+{
+    MockDeviceBackend backend;
+    HelperService service(backend);
+    AudioObjectID speakers;
+    backend.GetDefaultOutput(&speakers);
+
+    // Each change lands 5 ms late; the old fixed sleeps added up to 900 ms
+    backend.SetSettleDelay(std::chrono::milliseconds(5));
+
+    auto start = std::chrono::steady_clock::now();
+    CaptureSession session;
+    CHECK(service.StartCapture(&session) == kAudioHardwareNoError, "start-capture failed");
+    long long startMs = MillisecondsSince(start);
+
+    // Returned only once the changes were visible
+    AudioObjectID current;
+    backend.GetDefaultOutput(&current);
+    CHECK(current == session.aggregateId, "default is %u on return, expected the aggregate", (unsigned)current);
+    CHECK(backend.IsDeviceAlive(session.aggregateId), "aggregate not alive on return");
+    CHECK(startMs < 500, "start-capture took %lld ms", startMs);
+
+    start = std::chrono::steady_clock::now();
+    AudioObjectID restored;
+    CHECK(service.StopCapture(session.savedDeviceId, session.savedUID, &restored) == kAudioHardwareNoError,
+          "stop-capture failed");
+    long long stopMs = MillisecondsSince(start);
+    backend.GetDefaultOutput(&current);
+    CHECK(current == speakers && restored == speakers, "default is %u after stop", (unsigned)current);
+    CHECK(!backend.IsDeviceAlive(session.aggregateId), "aggregate still alive after stop");
+    CHECK(stopMs < 500, "stop-capture took %lld ms", stopMs);
+
+    // A change that never lands fails at the deadline instead of hanging
+    service.SetWaitTimeout(std::chrono::milliseconds(100));
+    backend.SetStalled(true);
+    const AudioDeviceInfo* headset = service.FindDevice(std::string("AA-BB-CC-DD-EE-FF:output"));
+    CHECK(headset != nullptr, "no headset");
+    start = std::chrono::steady_clock::now();
+    CHECK(service.SetDefaultOutput(headset->id) != kAudioHardwareNoError, "stalled set-default succeeded");
+    long long stalledMs = MillisecondsSince(start);
+    CHECK(stalledMs >= 100 && stalledMs < 1000, "stalled set-default gave up after %lld ms", stalledMs);
+
+    // An aggregate that never comes alive isn't returned
+    AudioObjectID aggregateId = kAudioObjectUnknown;
+    CHECK(service.CreateAggregate("BuiltInSpeakerDevice", &aggregateId) ==
+          kAudioHardwareNotRunningError, "stalled create-aggregate succeeded");
+    CHECK(aggregateId == kAudioObjectUnknown, "stalled create-aggregate returned %u", (unsigned)aggregateId);
+}
+
+int main()
+{
+    TestJson();
+    TestCaptureFlow();
+    TestDeviceCache();
+    TestErrors();
+    TestServeLoop();
+    TestServeRestoresOnEOF();
+    TestSettleWaits();
+
+    if (gFailures > 0) {
+        fprintf(stderr, "%d failure(s)\n", gFailures);
+        return EXIT_FAILURE;
+    }
+    printf("helper-service-test: OK\n");
+    return EXIT_SUCCESS;
+}
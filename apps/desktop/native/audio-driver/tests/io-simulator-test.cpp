@@ -0,0 +1,183 @@
+// Checks the virtual-clock simulator against the IO engine: the same config
+// and seed give the same run, drifting and jittery clocks hold the target
+// latency without glitches, a stalled reader skips periods and comes back
+// to a backlog, a backlog beyond the configured capacity is dropped, a
+// stalled writer shows up as underruns, a rejected configuration fails
+// the run, and the engine refuses format changes while IO is running.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "io-engine.h"
+#include "io-simulator.h"
+#include "test-check.h"
+
+// Latency the engine settles at: the fill each ReadInput sees, which is the
+// target plus the period it is about to read
+static const Float64 kSteadyLatencyMs =
+    (kDefaultTargetFillFrames + kFramesPerPeriod) * 1000.0 / kDefaultSampleRate;
+
+static SimulationConfig DriftingConfig()
+{
+    SimulationConfig config;
+    config.durationSeconds     = 300.0;
+    config.seed                = 7;
+    config.writer.driftPPM     = 100.0;
+    config.writer.jitterMicros = 300.0;
+    config.reader.driftPPM     = -100.0;
+    config.reader.jitterMicros = 300.0;
+    config.reader.jitter       = kJitter_Uniform;
+    return config;
+}
+
+static void TestDeterministic()
+{
+    SimulationConfig config = DriftingConfig();
+    config.durationSeconds = 30.0;
+    config.reader.stallsPerMinute = 6.0;
+    config.reader.stallMs = 15.0;
+
+    SimulationResult first, second;
+    CHECK(RunSimulation(config, &first) == kAudioHardwareNoError, "first run failed");
+    CHECK(RunSimulation(config, &second) == kAudioHardwareNoError, "second run failed");
+    CHECK(first.readCycles == second.readCycles && first.writeCycles == second.writeCycles,
+          "cycle counts differ");
+    CHECK(first.Glitches() == second.Glitches(), "glitch counts differ");
+    CHECK(first.meanLatencyMs == second.meanLatencyMs, "mean latency differs");
+    CHECK(first.trace.size() == second.trace.size() && first.trace.size() == 300,
+          "trace has %zu and %zu rows", first.trace.size(), second.trace.size());
+    for (size_t i = 0; i < first.trace.size(); i++) {
+        CHECK(first.trace[i].fillFrames == second.trace[i].fillFrames, "trace differs at row %zu", i);
+    }
+
+    config.seed++;
+    SimulationResult other;
+    CHECK(RunSimulation(config, &other) == kAudioHardwareNoError, "reseeded run failed");
+    CHECK(other.meanLatencyMs != first.meanLatencyMs, "seed had no effect");
+}
+
+static void TestDriftHoldsLatency()
+{
+    SimulationResult result;
+    CHECK(RunSimulation(DriftingConfig(), &result) == kAudioHardwareNoError, "run failed");
+
+    // The reader may wake before the first WriteMix; nothing after that
+    CHECK(result.Glitches() <= 1, "%llu glitches", (unsigned long long)result.Glitches());
+    CHECK(result.overrunGlitches == 0 && result.dropGlitches == 0, "overrun or drop under drift");
+    CHECK(fabs(result.meanLatencyMs - kSteadyLatencyMs) < 2.0,
+          "mean latency %.2f ms, steady %.2f", result.meanLatencyMs, kSteadyLatencyMs);
+
+    // The controller is still trimming the 200 ppm between the clocks
+    CHECK(fabs(result.finalRatio - 1.0) < 1e-3, "ratio %.9f", result.finalRatio);
+    const SimulationSample& end = result.trace.back();
+    CHECK(fabs(end.latencyMs - kSteadyLatencyMs) < 5.0, "latency ended at %.2f ms", end.latencyMs);
+}
+
+static void TestReaderStall()
+{
+    SimulationConfig config;
+    config.durationSeconds = 10.0;
+    config.reader.stalls.push_back({ 3.0, 200.0 });
+
+    SimulationResult result;
+    CHECK(RunSimulation(config, &result) == kAudioHardwareNoError, "run failed");
+    CHECK(result.skippedReadCycles == 19 || result.skippedReadCycles == 20,
+          "skipped %llu reads", (unsigned long long)result.skippedReadCycles);
+    CHECK(result.skippedWriteCycles == 0, "writer skipped");
+    CHECK(result.underrunGlitches == 0, "stalled reader underran");
+
+    // The backlog it returns to is cut back, by overrun or by the controller
+    CHECK(result.overrunFrames + result.droppedFrames > 0, "backlog never cut");
+    CHECK(result.maxLatencyMs > kSteadyLatencyMs + 100.0, "max latency %.2f ms", result.maxLatencyMs);
+    CHECK(fabs(result.trace.back().latencyMs - kSteadyLatencyMs) < 5.0,
+          "latency ended at %.2f ms", result.trace.back().latencyMs);
+}
+
+static void TestCapacityCeiling()
+{
+    // A 60 ms stall leaves a backlog under the snap threshold but over this
+    // capacity, so only the capacity cuts it
+    SimulationConfig config;
+    config.durationSeconds  = 10.0;
+    config.capacityFrames   = 4 * kFramesPerPeriod;
+    config.targetFillFrames = 2 * kFramesPerPeriod;
+    config.reader.stalls.push_back({ 3.0, 60.0 });
+
+    SimulationResult result;
+    CHECK(RunSimulation(config, &result) == kAudioHardwareNoError, "run failed");
+    CHECK(result.droppedFrames > 0 && result.overrunFrames == 0,
+          "dropped %llu, overran %llu", (unsigned long long)result.droppedFrames,
+          (unsigned long long)result.overrunFrames);
+    for (const SimulationSample& sample : result.trace) {
+        if (sample.timeSeconds < 3.2) continue;
+        CHECK(sample.fillFrames <= config.capacityFrames, "fill %u over the capacity at %.1f s",
+              (unsigned)sample.fillFrames, sample.timeSeconds);
+    }
+
+    // The default capacity leaves the same backlog to the controller
+    config.capacityFrames = 0;
+    CHECK(RunSimulation(config, &result) == kAudioHardwareNoError, "default capacity run failed");
+    CHECK(result.droppedFrames == 0, "dropped %llu under the default capacity",
+          (unsigned long long)result.droppedFrames);
+}
+
+static void TestWriterStall()
+{
+    SimulationConfig config;
+    config.durationSeconds = 10.0;
+    config.writer.stalls.push_back({ 5.0, 100.0 });
+
+    SimulationResult result;
+    CHECK(RunSimulation(config, &result) == kAudioHardwareNoError, "run failed");
+    CHECK(result.skippedWriteCycles >= 9, "skipped %llu writes", (unsigned long long)result.skippedWriteCycles);
+    CHECK(result.underrunGlitches > 0, "stalled writer caused no underrun");
+    CHECK(result.overrunGlitches == 0, "stalled writer caused an overrun");
+
+    // Nothing went wrong before the stall
+    for (const SimulationSample& sample : result.trace) {
+        if (sample.timeSeconds >= 5.0) break;
+        CHECK(sample.glitches == 0, "glitch at %.1f s before the stall", sample.timeSeconds);
+    }
+}
+
+static void TestRejectedConfig()
+{
+    SimulationConfig config;
+    config.channels = 0;
+    SimulationResult result;
+    CHECK(RunSimulation(config, &result) != kAudioHardwareNoError, "zero channels accepted");
+}
+
+static void TestFormatLockedWhileRunning()
+{
+    IOEngine engine;
+    CHECK(engine.StartIO() == kAudioHardwareNoError, "StartIO failed");
+    CHECK(engine.SetSampleRate(96000.0) == kAudioHardwareIllegalOperationError, "rate changed while running");
+    CHECK(engine.SetChannelCount(6) == kAudioHardwareIllegalOperationError, "channels changed while running");
+    CHECK(engine.GetSampleRate() == kDefaultSampleRate, "rate is %g", engine.GetSampleRate());
+
+    // The current values are still accepted
+    CHECK(engine.SetSampleRate(kDefaultSampleRate) == kAudioHardwareNoError, "current rate refused");
+
+    engine.StopIO();
+    CHECK(engine.SetSampleRate(96000.0) == kAudioHardwareNoError, "rate refused after StopIO");
+    CHECK(engine.GetSampleRate() == 96000.0, "rate is %g after StopIO", engine.GetSampleRate());
+}
+
+int main()
+{
+    TestDeterministic();
+    TestDriftHoldsLatency();
+    TestReaderStall();
+    TestCapacityCeiling();
+    TestWriterStall();
+    TestRejectedConfig();
+    TestFormatLockedWhileRunning();
+
+    if (gFailures > 0) {
+        fprintf(stderr, "%d failure(s)\n", gFailures);
+        return EXIT_FAILURE;
+    }
+    printf("io-simulator-test: OK\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+// Checks the constexpr property table the way the plug-in uses it: rows given
+// out of order are found by selector, size and data come from the same row,
+// short buffers are refused, settability follows the setter, predicates hide
+// rows per object, and arrays are clamped to the caller's buffer.
+
+#include <cstdio>
+#include <cstdlib>
+#include "property-table.h"
+#include "test-check.h"
+
+enum : AudioObjectPropertySelector {
+    kSelectorClass   = 0x636C6173, // 'clas'
+    kSelectorVolume  = 0x766F6C6D, // 'volm'
+    kSelectorList    = 0x6C697374, // 'list'
+    kSelectorPrivate = 0x70727674, // 'prvt'
+    kSelectorMissing = 0x6E6F6E65, // 'none'
+};
+
+static const UInt32 kClassID = 0x61626364;
+
+// Stands in for PulseDevice: private state reached through a friend struct
+class FakeObject {
+public:
+    explicit FakeObject(AudioObjectID specialID) : mSpecialID(specialID), mVolume(0.5f) {}
+
+    Float32 Volume() const { return mVolume; }
+
+private:
+    friend struct FakeObjectProperties;
+
+    AudioObjectID mSpecialID;
+    Float32       mVolume;
+    UInt32        mItems[4] = { 10, 20, 30, 40 };
+};
+
+typedef PropertyDescriptor<FakeObject> Row;
+
+struct FakeObjectProperties {
+    static constexpr auto kRows = MakePropertyRows<FakeObject>({
+        Row::Of<Float32>(kSelectorVolume,
+            [](FakeObject& object, const PropertyQuery&, UInt32*, void* outData) -> OSStatus {
+                *(Float32*)outData = object.mVolume;
+                return kAudioHardwareNoError;
+            },
+            [](FakeObject& object, const PropertyQuery&, const void* inData) -> OSStatus {
+                object.mVolume = *(const Float32*)inData;
+                return kAudioHardwareNoError;
+            }),
+        Row::Variable(kSelectorList,
+            [](const FakeObject&, const PropertyQuery&) -> UInt32 { return 4 * sizeof(UInt32); },
+            [](FakeObject& object, const PropertyQuery& query, UInt32* ioDataSize, void* outData) -> OSStatus {
+                return CopyPropertyArray(query, object.mItems, 4, ioDataSize, outData);
+            }),
+        Row::Constant<UInt32, kClassID>(kSelectorClass),
+        Row::Constant<UInt32, 7>(kSelectorPrivate).When(
+            [](const FakeObject& object, const PropertyQuery& query) {
+                return query.objectID == object.mSpecialID;
+            }),
+    });
+    static_assert(kRows.IsValid(), "bad FakeObject property rows");
+};
+
+static PropertyQuery Query(const AudioObjectPropertyAddress& address, UInt32 inDataSize,
+                           AudioObjectID objectID = 1)
+{
+    PropertyQuery query = { objectID, &address, 0, nullptr, inDataSize };
+    return query;
+}
+
+static void TestSorted()
+{
+    const PropertyTable<FakeObject> table = FakeObjectProperties::kRows.Table();
+    CHECK(table.Count() == 4, "expected 4 rows, got %zu", table.Count());
+    for (size_t i = 1; i < FakeObjectProperties::kRows.Count(); i++) {
+        CHECK(FakeObjectProperties::kRows[i - 1].selector < FakeObjectProperties::kRows[i].selector,
+              "rows not sorted at %zu", i);
+    }
+
+    FakeObject object(2);
+    const AudioObjectPropertyAddress missing = { kSelectorMissing, 0, 0 };
+    CHECK(!table.Has(object, Query(missing, 0)), "unlisted selector reported");
+
+    UInt32 size = 0;
+    CHECK(table.GetSize(object, Query(missing, 0), &size) == kAudioHardwareUnknownPropertyError,
+          "unlisted selector has a size");
+}
+
+static void TestGetAndSet()
+{
+    const PropertyTable<FakeObject> table = FakeObjectProperties::kRows.Table();
+    FakeObject object(2);
+    const AudioObjectPropertyAddress klass  = { kSelectorClass, 0, 0 };
+    const AudioObjectPropertyAddress volume = { kSelectorVolume, 0, 0 };
+
+    UInt32 size = 0;
+    CHECK(table.GetSize(object, Query(klass, 0), &size) == kAudioHardwareNoError && size == sizeof(UInt32),
+          "class size %u", size);
+
+    UInt32 value = 0;
+    size = 0;
+    CHECK(table.Get(object, Query(klass, sizeof(value)), &size, &value) == kAudioHardwareNoError,
+          "class get failed");
+    CHECK(value == kClassID && size == sizeof(UInt32), "class value %08x size %u", value, size);
+
+    SInt16 small = 0;
+    CHECK(table.Get(object, Query(klass, sizeof(small)), &size, &small) == kAudioHardwareBadPropertySizeError,
+          "short buffer accepted");
+
+    Boolean settable = true;
+    CHECK(table.IsSettable(object, Query(klass, 0), &settable) == kAudioHardwareNoError && !settable,
+          "constant reported settable");
+    CHECK(table.IsSettable(object, Query(volume, 0), &settable) == kAudioHardwareNoError && settable,
+          "volume not settable");
+    CHECK(table.Set(object, Query(klass, sizeof(value)), &value) == kAudioHardwareUnknownPropertyError,
+          "set on read-only row succeeded");
+
+    Float32 newVolume = 0.25f;
+    CHECK(table.Set(object, Query(volume, 2), &newVolume) == kAudioHardwareBadPropertySizeError,
+          "short set accepted");
+    CHECK(object.Volume() == 0.5f, "short set changed the value");
+    CHECK(table.Set(object, Query(volume, sizeof(newVolume)), &newVolume) == kAudioHardwareNoError,
+          "volume set failed");
+
+    Float32 readBack = 0;
+    CHECK(table.Get(object, Query(volume, sizeof(readBack)), &size, &readBack) == kAudioHardwareNoError &&
+          readBack == 0.25f, "volume read back %f", readBack);
+}
+
+static void TestVariableAndPredicate()
+{
+    const PropertyTable<FakeObject> table = FakeObjectProperties::kRows.Table();
+    FakeObject object(2);
+    const AudioObjectPropertyAddress list = { kSelectorList, 0, 0 };
+    const AudioObjectPropertyAddress prvt = { kSelectorPrivate, 0, 0 };
+
+    UInt32 size = 0;
+    CHECK(table.GetSize(object, Query(list, 0), &size) == kAudioHardwareNoError && size == 16,
+          "list size %u", size);
+
+    // A buffer sized for three items gets three
+    UInt32 items[4] = {};
+    CHECK(table.Get(object, Query(list, 3 * sizeof(UInt32) + 1), &size, items) == kAudioHardwareNoError,
+          "list get failed");
+    CHECK(size == 3 * sizeof(UInt32) && items[2] == 30 && items[3] == 0,
+          "list not clamped: size %u, items[3] %u", size, items[3]);
+
+    CHECK(table.Has(object, Query(prvt, 0, 2)), "predicate row missing on its object");
+    CHECK(!table.Has(object, Query(prvt, 0, 3)), "predicate row present on another object");
+    UInt32 value = 0;
+    CHECK(table.Get(object, Query(prvt, sizeof(value), 3), &size, &value) == kAudioHardwareUnknownPropertyError,
+          "hidden row readable");
+}
+
+int main()
+{
+    TestSorted();
+    TestGetAndSet();
+    TestVariableAndPredicate();
+
+    if (gFailures > 0) {
+        fprintf(stderr, "%d failure(s)\n", gFailures);
+        return EXIT_FAILURE;
+    }
+    printf("property-table-test: OK\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+// Checks every Float32 to Int16 kernel this CPU can run against the scalar
+// one: sample counts that leave tails after the SIMD blocks, samples past
+// full scale and NaN, with and without dither, and the dither lanes left for
+// the next call.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "sample-convert.h"
+#include "test-check.h"
+
+// Odd counts leave tails after the 8-sample blocks
+static const UInt32 kSampleCounts[] = { 0, 1, 3, 7, 8, 9, 13, 31, 480, 481, 1023 };
+
+// Deterministic signal in [-1.25, 1.25), so some samples clip, with NaN and
+// the infinities sprinkled in
+static std::vector<float> Signal(UInt32 numSamples, UInt32 seed)
+{
+    std::vector<float> samples(numSamples);
+    UInt32 state = seed * 2654435761u + 1;
+    for (float& sample : samples) {
+        state = state * 1664525u + 1013904223u;
+        sample = 1.25f * ((Float32)(state >> 8) / (Float32)(1u << 23) - 1.0f);
+    }
+    const float special[] = { NAN, INFINITY, -INFINITY, 1.0f, -1.0f, 0.0f };
+    for (UInt32 i = 0; i < sizeof(special) / sizeof(special[0]) && 5 * i < numSamples; i++) {
+        samples[5 * i] = special[i];
+    }
+    return samples;
+}
+
+// The scalar kernel rounds through x + 32768.5, whose float sum is only good
+// to 1/256, so it may round the other way within that of a tie
+static bool NearTie(float sample)
+{
+    Float32 x = sample > -1.0f ? sample : -1.0f;
+    x = (x < 1.0f ? x : 1.0f) * 32767.0f;
+    return std::fabs(x - std::floor(x) - 0.5f) < 1.0f / 128;
+}
+
+static void TestRounding(const Int16ConvertKernel& kernel, const Int16ConvertKernel& scalar)
+{
+    for (UInt32 numSamples : kSampleCounts) {
+        std::vector<float> src = Signal(numSamples, numSamples);
+        std::vector<SInt16> expected(numSamples), actual(numSamples);
+        scalar.convert(expected.data(), src.data(), numSamples, nullptr);
+        kernel.convert(actual.data(), src.data(), numSamples, nullptr);
+        for (UInt32 i = 0; i < numSamples; i++) {
+            int diff = std::abs(actual[i] - expected[i]);
+            CHECK(diff == 0 || (diff == 1 && NearTie(src[i])),
+                  "%s: %u samples: sample %u (%g) is %d, scalar %d", kernel.name, numSamples, i,
+                  src[i], actual[i], expected[i]);
+        }
+    }
+
+    // Full scale is symmetric and NaN lands on -1
+    const float edges[8] = { 1.0f, -1.0f, 2.0f, -2.0f, NAN, 0.0f, 0.5f, -0.5f };
+    const SInt16 expected[8] = { 32767, -32767, 32767, -32767, -32767, 0, 16384, -16384 };
+    SInt16 actual[8];
+    kernel.convert(actual, edges, 8, nullptr);
+    for (UInt32 i = 0; i < 8; i++) {
+        CHECK(actual[i] == expected[i] || (std::abs(actual[i] - expected[i]) == 1 && NearTie(edges[i])),
+              "%s: %g converts to %d, expected %d", kernel.name, edges[i], actual[i], expected[i]);
+    }
+}
+
+static void TestDither(const Int16ConvertKernel& kernel, const Int16ConvertKernel& scalar)
+{
+    DitherState expectedDither, actualDither;
+    InitDitherState(&expectedDither, 7);
+    InitDitherState(&actualDither, 7);
+
+    // Consecutive calls on the same states, as the IO thread makes them
+    for (UInt32 numSamples : kSampleCounts) {
+        std::vector<float> src = Signal(numSamples, 2 * numSamples + 1);
+        std::vector<SInt16> expected(numSamples), actual(numSamples), undithered(numSamples);
+        scalar.convert(expected.data(), src.data(), numSamples, &expectedDither);
+        kernel.convert(actual.data(), src.data(), numSamples, &actualDither);
+        scalar.convert(undithered.data(), src.data(), numSamples, nullptr);
+
+        // Same noise, so only near-ties of the dithered value may differ
+        UInt32 mismatches = 0, dithered = 0;
+        for (UInt32 i = 0; i < numSamples; i++) {
+            CHECK(std::abs(actual[i] - expected[i]) <= 1,
+                  "%s: %u samples dithered: sample %u (%g) is %d, scalar %d", kernel.name, numSamples, i,
+                  src[i], actual[i], expected[i]);
+            mismatches += actual[i] != expected[i];
+            dithered += expected[i] != undithered[i];
+        }
+        CHECK(mismatches <= numSamples / 16,
+              "%s: %u samples dithered: %u differ from scalar", kernel.name, numSamples, mismatches);
+        CHECK(numSamples < 480 || dithered > 0,
+              "%s: %u samples: dither changed nothing", kernel.name, numSamples);
+
+        for (UInt32 lane = 0; lane < DitherState::kLanes; lane++) {
+            CHECK(actualDither.lanes[lane] == expectedDither.lanes[lane],
+                  "%s: after %u samples dither lane %u is %08x, scalar %08x", kernel.name, numSamples,
+                  lane, actualDither.lanes[lane], expectedDither.lanes[lane]);
+        }
+    }
+}
+
+int main()
+{
+    UInt32 count = 0;
+    const Int16ConvertKernel* kernels = GetInt16ConvertKernels(&count);
+    if (count == 0 || strcmp(kernels[count - 1].name, "scalar") != 0) {
+        fprintf(stderr, "FAIL: the last Int16 conversion kernel is not the scalar one\n");
+        return EXIT_FAILURE;
+    }
+    const Int16ConvertKernel& scalar = kernels[count - 1];
+
+    for (UInt32 k = 0; k < count; k++) {
+        TestRounding(kernels[k], scalar);
+        TestDither(kernels[k], scalar);
+        printf("sample-convert-test: %s checked\n", kernels[k].name);
+    }
+
+    if (gFailures > 0) {
+        fprintf(stderr, "%d failure(s)\n", gFailures);
+        return EXIT_FAILURE;
+    }
+    printf("sample-convert-test: OK\n");
+    return EXIT_SUCCESS;
+}
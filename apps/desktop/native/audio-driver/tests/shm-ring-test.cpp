@@ -0,0 +1,205 @@
+// Checks the shared-memory ring from both ends: that a reader mapping the
+// object sees the documented header, that the writer drops and counts what
+// doesn't fit, that a concurrent reader gets every frame in order across the
+// wrap, that closing the writer is visible to a reader still mapped, and
+// that a process scribbling on the shared header can't move either end's
+// copies out of bounds.
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "shm-ring.h"
+#include "test-check.h"
+
+static char gName[kShmRingMaxNameLength + 1];
+
+// Frames [first, first + count) of a stereo ramp; both channels hold the frame index
+static std::vector<float> Ramp(UInt64 first, UInt32 count)
+{
+    std::vector<float> frames(count * 2);
+    for (UInt32 i = 0; i < count; i++) frames[i * 2] = frames[i * 2 + 1] = (float)(first + i);
+    return frames;
+}
+
+static void TestHeader()
+{
+    ShmRingWriter writer;
+    CHECK(writer.Create(gName, 1000, 2, 48000.0), "create failed: %s", strerror(errno));
+
+    ShmRingReader reader;
+    CHECK(reader.Open(gName), "open failed: %s", strerror(errno));
+
+    // Read the layout by offset, as a reader in another language would
+    const UInt8* base = reinterpret_cast<const UInt8*>(reader.Header());
+    UInt32 fields[10];
+    std::memcpy(fields, base, sizeof(fields));
+    Float64 rate;
+    std::memcpy(&rate, base + 24, sizeof(rate));
+    CHECK(fields[0] == kShmRingMagic, "magic %08x", fields[0]);
+    CHECK(fields[1] == kShmRingVersion, "version %u", fields[1]);
+    CHECK(fields[2] == 384, "headerBytes %u", fields[2]);
+    CHECK(fields[3] == kShmRingState_Open, "state %u", fields[3]);
+    CHECK(fields[4] == kShmRingFormat_Float32, "sampleFormat %u", fields[4]);
+    CHECK(fields[5] == 2, "channels %u", fields[5]);
+    CHECK(rate == 48000.0, "sampleRate %f", rate);
+    CHECK(fields[8] == 1024, "capacityFrames %u, expected rounding up to 1024", fields[8]);
+    CHECK(fields[9] == 8, "bytesPerFrame %u", fields[9]);
+
+    CHECK(!reader.IsWriterClosed(), "open ring reported closed");
+    writer.Close();
+    CHECK(reader.IsWriterClosed(), "closed ring reported open");
+
+    ShmRingReader late;
+    CHECK(!late.Open(gName) && errno == ENOENT, "opened an unlinked ring");
+    CHECK(!writer.Create("/pulse-audio-name-longer-than-31-chars", 1024, 2, 48000.0) && errno == EINVAL,
+          "accepted a name macOS can't create");
+}
+
+static void TestDropsAndWrap()
+{
+    ShmRingWriter writer;
+    CHECK(writer.Create(gName, 256, 2, 48000.0), "create failed: %s", strerror(errno));
+    ShmRingReader reader;
+    CHECK(reader.Open(gName), "open failed: %s", strerror(errno));
+
+    std::vector<float> ramp = Ramp(0, 200);
+    CHECK(writer.Write(ramp.data(), 200) == 200, "first write short");
+
+    std::vector<float> buffer(256 * 2);
+    CHECK(reader.Read(buffer.data(), 100) == 100, "first read short");
+    CHECK(buffer[99 * 2] == 99.0f, "first read ended at %.0f", buffer[99 * 2]);
+
+    // 156 frames free: the tail of this write is dropped, not wrapped over
+    ramp = Ramp(200, 200);
+    CHECK(writer.Write(ramp.data(), 200) == 156, "second write should fill the ring");
+    CHECK(reader.Header()->droppedFrames.load() == 44, "dropped %llu, expected 44",
+          (unsigned long long)reader.Header()->droppedFrames.load());
+    CHECK(reader.Available() == 256, "available %u, expected 256", reader.Available());
+
+    CHECK(reader.Read(buffer.data(), 256) == 256, "second read short");
+    for (UInt32 i = 0; i < 256; i++) {
+        CHECK(buffer[i * 2] == (float)(100 + i) && buffer[i * 2 + 1] == (float)(100 + i),
+              "frame %u is %.0f, expected %u", i, buffer[i * 2], 100 + i);
+    }
+
+    CHECK(writer.WriteSilence(50) == 50, "silence write short");
+    CHECK(reader.Skip(10) == 10, "skip short");
+    CHECK(reader.Read(buffer.data(), 64) == 40, "silence read length");
+    for (UInt32 i = 0; i < 40 * 2; i++) CHECK(buffer[i] == 0.0f, "silence sample %u is %f", i, buffer[i]);
+}
+
+static void TestHostileHeader()
+{
+    ShmRingWriter writer;
+    CHECK(writer.Create(gName, 256, 2, 48000.0), "create failed: %s", strerror(errno));
+    ShmRingReader reader;
+    CHECK(reader.Open(gName), "open failed: %s", strerror(errno));
+
+    // Another process maps the ring and rewrites the layout to describe far
+    // more memory than exists
+    int fd = shm_open(gName, O_RDWR, 0);
+    CHECK(fd >= 0, "hostile open failed: %s", strerror(errno));
+    void* base = mmap(nullptr, sizeof(ShmRingHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    CHECK(base != MAP_FAILED, "hostile map failed: %s", strerror(errno));
+    ShmRingHeader* hostile = static_cast<ShmRingHeader*>(base);
+    hostile->channels       = kMaxNumChannels;
+    hostile->bytesPerFrame  = kMaxNumChannels * sizeof(float);
+    hostile->capacityFrames = 1u << 20;
+    hostile->sampleRate     = 1.0;
+    hostile->writeHead.store(123456789);
+
+    CHECK(writer.Channels() == 2 && writer.CapacityFrames() == 256 && writer.SampleRate() == 48000.0,
+          "writer picked up the rewritten layout");
+    CHECK(reader.Channels() == 2 && reader.CapacityFrames() == 256, "reader picked up the rewritten layout");
+
+    // Both ends keep to the layout they set up; the stream survives
+    std::vector<float> ramp = Ramp(0, 200);
+    CHECK(writer.Write(ramp.data(), 200) == 200, "write after scribble short");
+    std::vector<float> buffer(256 * 2);
+    CHECK(reader.Read(buffer.data(), 256) == 200, "read after scribble length");
+    for (UInt32 i = 0; i < 200; i++) {
+        CHECK(buffer[i * 2] == (float)i && buffer[i * 2 + 1] == (float)i,
+              "frame %u is %.0f after scribble", i, buffer[i * 2]);
+    }
+
+    // A readHead far ahead reads as an empty ring, one far behind as a full
+    // one; neither lets a write past the capacity
+    hostile->readHead.store(1ull << 40);
+    CHECK(writer.WriteSilence(1000) == 256, "write against a runaway readHead");
+    hostile->readHead.store(0);
+    CHECK(writer.WriteSilence(1000) == 0, "write against a stale readHead");
+
+    // A new reader validates the rewritten header and refuses it
+    ShmRingReader late;
+    CHECK(!late.Open(gName) && errno == EPROTO, "opened a ring whose header overstates its size");
+    munmap(base, sizeof(ShmRingHeader));
+}
+
+static void TestConcurrentReader()
+{
+    const UInt64 kTotalFrames = 1 << 21;  // exact in float
+    const UInt32 kWriteFrames = 256;
+
+    ShmRingWriter writer;
+    CHECK(writer.Create(gName, 1024, 2, 48000.0), "create failed: %s", strerror(errno));
+
+    std::atomic<int>  errors(0);
+    UInt64 received = 0;
+
+    // The reader maps its own view, as it would in another process
+    std::thread consumer([&]() {
+        ShmRingReader reader;
+        if (!reader.Open(gName)) { errors++; return; }
+        std::vector<float> buffer(97 * 2);
+        while (received < kTotalFrames) {
+            UInt32 got = reader.Read(buffer.data(), 97);
+            for (UInt32 i = 0; i < got; i++) {
+                float expected = (float)(received + i);
+                if (buffer[i * 2] != expected || buffer[i * 2 + 1] != expected) errors++;
+            }
+            received += got;
+            if (got == 0) std::this_thread::yield();
+        }
+    });
+
+    // Retry what didn't fit, so every frame arrives and order is checkable
+    for (UInt64 written = 0; written < kTotalFrames;) {
+        std::vector<float> ramp = Ramp(written, kWriteFrames);
+        UInt32 done = 0;
+        while (done < kWriteFrames) {
+            done += writer.Write(ramp.data() + done * 2, kWriteFrames - done);
+            if (done < kWriteFrames) std::this_thread::yield();
+        }
+        written += kWriteFrames;
+    }
+    consumer.join();
+
+    CHECK(errors.load() == 0, "%d frames out of order or torn", errors.load());
+    CHECK(received == kTotalFrames, "received %llu of %llu frames",
+          (unsigned long long)received, (unsigned long long)kTotalFrames);
+}
+
+int main()
+{
+    snprintf(gName, sizeof(gName), "/pulse-shm-test-%d", (int)getpid());
+
+    TestHeader();
+    TestDropsAndWrap();
+    TestHostileHeader();
+    TestConcurrentReader();
+
+    if (gFailures > 0) {
+        fprintf(stderr, "%d failure(s)\n", gFailures);
+        return EXIT_FAILURE;
+    }
+    printf("shm-ring-test: OK\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,85 @@
+// Checks every peak level kernel this CPU can run against the scalar one:
+// sample counts that leave tails after the SIMD blocks, the peak in each
+// position, negative peaks, and NaN samples left out.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "signal-level.h"
+#include "test-check.h"
+
+// Odd counts leave tails after the 8-sample blocks
+static const UInt32 kSampleCounts[] = { 0, 1, 3, 7, 8, 9, 13, 31, 480, 481, 1023 };
+
+// Deterministic signal in [-0.5, 0.5)
+static std::vector<float> Signal(UInt32 numSamples, UInt32 seed)
+{
+    std::vector<float> samples(numSamples);
+    UInt32 state = seed * 2654435761u + 1;
+    for (float& sample : samples) {
+        state = state * 1664525u + 1013904223u;
+        sample = 0.5f * ((Float32)(state >> 8) / (Float32)(1u << 23) - 1.0f);
+    }
+    return samples;
+}
+
+// A max picks one of its inputs, so every kernel must agree exactly
+static void TestAgainstScalar(const LevelKernel& kernel, const LevelKernel& scalar)
+{
+    for (UInt32 numSamples : kSampleCounts) {
+        std::vector<float> src = Signal(numSamples, numSamples);
+        Float32 expected = scalar.peak(src.data(), numSamples);
+        Float32 actual = kernel.peak(src.data(), numSamples);
+        CHECK(actual == expected, "%s: %u samples: peak %g, scalar %g", kernel.name, numSamples, actual, expected);
+    }
+}
+
+// The peak at every position of a block and its tail, either sign, with
+// NaN before and after it and in its lane of the next block
+static void TestPeakPositions(const LevelKernel& kernel)
+{
+    const UInt32 numSamples = 29;
+    for (UInt32 pos = 0; pos < numSamples; pos++) {
+        for (Float32 peak : { 0.9f, -0.9f }) {
+            std::vector<float> src = Signal(numSamples, pos);
+            src[pos] = peak;
+            src[(pos + 3) % numSamples] = NAN;
+            src[(pos + numSamples - 5) % numSamples] = NAN;
+            src[(pos + 8) % numSamples] = NAN;
+            Float32 actual = kernel.peak(src.data(), numSamples);
+            CHECK(actual == 0.9f, "%s: %g at sample %u of %u: peak %g", kernel.name, peak, pos, numSamples, actual);
+        }
+    }
+
+    // Only NaN and silence
+    std::vector<float> src(numSamples, 0.0f);
+    for (UInt32 i = 0; i < numSamples; i += 2) src[i] = NAN;
+    Float32 actual = kernel.peak(src.data(), numSamples);
+    CHECK(actual == 0.0f, "%s: NaN and silence: peak %g", kernel.name, actual);
+}
+
+int main()
+{
+    UInt32 count = 0;
+    const LevelKernel* kernels = GetLevelKernels(&count);
+    if (count == 0 || strcmp(kernels[count - 1].name, "scalar") != 0) {
+        fprintf(stderr, "FAIL: the last level kernel is not the scalar one\n");
+        return EXIT_FAILURE;
+    }
+    const LevelKernel& scalar = kernels[count - 1];
+
+    for (UInt32 k = 0; k < count; k++) {
+        TestAgainstScalar(kernels[k], scalar);
+        TestPeakPositions(kernels[k]);
+        printf("signal-level-test: %s checked\n", kernels[k].name);
+    }
+
+    if (gFailures > 0) {
+        fprintf(stderr, "%d failure(s)\n", gFailures);
+        return EXIT_FAILURE;
+    }
+    printf("signal-level-test: OK\n");
+    return EXIT_SUCCESS;
+}
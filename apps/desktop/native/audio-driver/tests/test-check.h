@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdio>
+
+// Check harness shared by the tests. CHECK reports a failed condition with
+// its location and message, counts it in gFailures and returns from the
+// test function, so main() runs every test and fails at the end if any did.
+static int gFailures = 0;
+
+#define CHECK(cond, ...)                                        \
+    do {                                                        \
+        if (!(cond)) {                                          \
+            fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                       \
+            fprintf(stderr, "\n");                              \
+            gFailures++;                                        \
+            return;                                             \
+        }                                                       \
+    } while (0)
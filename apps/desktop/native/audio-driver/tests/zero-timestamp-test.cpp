@@ -0,0 +1,118 @@
+// Checks the integer zero timestamp math against an exact reference over
+// days of simulated uptime, for each supported rate and the host timebases
+// seen in practice.
+
+#include <cstdio>
+#include <cstdlib>
+#include "test-check.h"
+#include "types.h"
+#include "zero-timestamp.h"
+
+typedef unsigned __int128 UInt128;
+
+// Exact period index for a tick count: floor(ticks * numer * rate / (denom * 1e9 * frames))
+static UInt64 ReferencePeriods(UInt64 ticks, UInt32 rate, UInt32 frames, HostTimebase timebase)
+{
+    UInt128 numerator   = (UInt128)ticks * timebase.numer * rate;
+    UInt128 denominator = (UInt128)timebase.denom * 1000000000ull * frames;
+    return (UInt64)(numerator / denominator);
+}
+
+// Exact host tick at which a period starts, rounded down
+static UInt64 ReferencePeriodStart(UInt64 periods, UInt32 rate, UInt32 frames, HostTimebase timebase)
+{
+    UInt128 numerator   = (UInt128)periods * frames * 1000000000ull * timebase.denom;
+    UInt128 denominator = (UInt128)rate * timebase.numer;
+    return (UInt64)(numerator / denominator);
+}
+
+static void TestUptime(UInt32 rate, HostTimebase timebase, UInt64 anchorHostTime)
+{
+    const UInt32 frames = rate / kPeriodsPerSecond;
+    const UInt64 kDays  = 30;
+
+    ZeroTimestampClock clock;
+    clock.anchorHostTime      = anchorHostTime;
+    clock.ticksPerPeriodFixed = HostTicksPerPeriodFixed(rate, frames, timebase);
+    clock.framesPerPeriod     = frames;
+
+    // Host ticks in the simulated span
+    UInt64 span = (UInt64)(((UInt128)kDays * 86400ull * 1000000000ull * timebase.denom) / timebase.numer);
+
+    UInt64 lastSampleTime = 0;
+    UInt64 lastHostTime   = anchorHostTime;
+    UInt64 step = span / 100003;   // odd step so samples land at varied phases
+
+    for (UInt64 elapsed = 0; elapsed <= span; elapsed += step) {
+        UInt64 now = anchorHostTime + elapsed;
+        UInt64 sampleTime, hostTime;
+        ComputeZeroTimestamp(clock, now, &sampleTime, &hostTime);
+
+        UInt64 periods = ReferencePeriods(elapsed, rate, frames, timebase);
+        CHECK(sampleTime == periods * frames,
+              "rate %u timebase %u/%u: sample time %llu, expected %llu after %llu ticks",
+              rate, timebase.numer, timebase.denom, (unsigned long long)sampleTime,
+              (unsigned long long)(periods * frames), (unsigned long long)elapsed);
+
+        // Within one tick of the exact period start, never after now
+        UInt64 expectedHost = anchorHostTime + ReferencePeriodStart(periods, rate, frames, timebase);
+        UInt64 error = hostTime > expectedHost ? hostTime - expectedHost : expectedHost - hostTime;
+        CHECK(error <= 1, "rate %u timebase %u/%u: host time off by %llu ticks at period %llu",
+              rate, timebase.numer, timebase.denom, (unsigned long long)error,
+              (unsigned long long)periods);
+        CHECK(hostTime <= now, "rate %u: zero timestamp is in the future", rate);
+
+        CHECK(sampleTime >= lastSampleTime && hostTime >= lastHostTime,
+              "rate %u: timestamp went backwards", rate);
+        lastSampleTime = sampleTime;
+        lastHostTime   = hostTime;
+    }
+}
+
+// Boundaries: the tick before, at and after each period start
+static void TestPeriodEdges(UInt32 rate, HostTimebase timebase)
+{
+    const UInt32 frames = rate / kPeriodsPerSecond;
+
+    ZeroTimestampClock clock;
+    clock.anchorHostTime      = 1000;
+    clock.ticksPerPeriodFixed = HostTicksPerPeriodFixed(rate, frames, timebase);
+    clock.framesPerPeriod     = frames;
+
+    for (UInt64 period = 1; period < 1000; period++) {
+        UInt64 start = clock.anchorHostTime + ReferencePeriodStart(period, rate, frames, timebase);
+        UInt64 sampleTime, hostTime;
+
+        ComputeZeroTimestamp(clock, start - 1, &sampleTime, &hostTime);
+        UInt64 expectedBefore = ReferencePeriods(start - 1 - clock.anchorHostTime, rate, frames, timebase);
+        CHECK(sampleTime == expectedBefore * frames,
+              "rate %u: wrong period one tick before period %llu", rate, (unsigned long long)period);
+
+        ComputeZeroTimestamp(clock, start + 1, &sampleTime, &hostTime);
+        CHECK(sampleTime == period * frames,
+              "rate %u: wrong period one tick after period %llu starts", rate, (unsigned long long)period);
+    }
+}
+
+int main()
+{
+    // Nanosecond clock (Linux, Intel Macs), 24 MHz Apple silicon, and a
+    // made-up timebase that gives a fractional tick count per period
+    const HostTimebase kTimebases[] = { { 1, 1 }, { 125, 3 }, { 7, 3 } };
+
+    for (UInt32 i = 0; i < kNumSupportedSampleRates; i++) {
+        UInt32 rate = (UInt32)kSupportedSampleRates[i];
+        for (const HostTimebase& timebase : kTimebases) {
+            TestUptime(rate, timebase, 0);
+            TestUptime(rate, timebase, 1ull << 62);   // long-running host
+            TestPeriodEdges(rate, timebase);
+        }
+    }
+
+    if (gFailures > 0) {
+        fprintf(stderr, "%d failure(s)\n", gFailures);
+        return EXIT_FAILURE;
+    }
+    printf("zero-timestamp-test: OK\n");
+    return EXIT_SUCCESS;
+}
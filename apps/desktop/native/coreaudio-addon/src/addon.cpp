@@ -2,7 +2,9 @@
 #include "driver-detect.h"
 #include "aggregate-device.h"
 #include "default-device.h"
+#include "capture.h"
 
+// Every export returns a promise; the CoreAudio work runs off the JS thread
 Napi::Object Init(Napi::Env env, Napi::Object exports)
 {
     exports.Set("isDriverInstalled",
@@ -17,6 +19,10 @@ Napi::Object Init(Napi::Env env, Napi::Object exports)
         Napi::Function::New(env, CreateAggregateDevice));
     exports.Set("destroyAggregateDevice",
         Napi::Function::New(env, DestroyAggregateDevice));
+    exports.Set("startCapture",
+        Napi::Function::New(env, StartCapture));
+    exports.Set("stopCapture",
+        Napi::Function::New(env, StopCapture));
 
     return exports;
 }
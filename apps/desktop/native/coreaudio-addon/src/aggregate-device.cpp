@@ -1,28 +1,46 @@
 #include "aggregate-device.h"
+#include "device-worker.h"
 #include <CoreAudio/CoreAudio.h>
 #include <AudioToolbox/AudioToolbox.h>
 #include <CoreFoundation/CoreFoundation.h>
+#include <utility>
 
 static const CFStringRef kAggregateUID  = CFSTR("com.pulse.aggregate.screenshare");
 static const CFStringRef kAggregateName = CFSTR("Pulse Screen Share");
 
-Napi::Value CreateAggregateDevice(const Napi::CallbackInfo& info)
-{
-    Napi::Env env = info.Env();
+class CreateAggregateWorker : public DeviceWorker {
+public:
+    CreateAggregateWorker(Napi::Env env, std::string realOutputUID, std::string pulseAudioUID)
+        : DeviceWorker(env)
+        , mRealOutputUID(std::move(realOutputUID))
+        , mPulseAudioUID(std::move(pulseAudioUID))
+        , mDeviceId(kAudioObjectUnknown)
+    {
+    }
 
-    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
-        Napi::TypeError::New(env, "Expected (realOutputUID: string, pulseAudioUID: string)")
-            .ThrowAsJavaScriptException();
-        return env.Null();
+protected:
+    void Run() override;
+
+    Napi::Value Result(Napi::Env env) override
+    {
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("id", Napi::Number::New(env, static_cast<double>(mDeviceId)));
+        result.Set("uid", Napi::String::New(env, "com.pulse.aggregate.screenshare"));
+        return result;
     }
 
-    std::string realOutputUIDStr = info[0].As<Napi::String>().Utf8Value();
-    std::string pulseAudioUIDStr = info[1].As<Napi::String>().Utf8Value();
+private:
+    std::string   mRealOutputUID;
+    std::string   mPulseAudioUID;
+    AudioObjectID mDeviceId;
+};
 
+void CreateAggregateWorker::Run()
+{
     CFStringRef realOutputUID = CFStringCreateWithCString(kCFAllocatorDefault,
-        realOutputUIDStr.c_str(), kCFStringEncodingUTF8);
+        mRealOutputUID.c_str(), kCFStringEncodingUTF8);
     CFStringRef pulseAudioUID = CFStringCreateWithCString(kCFAllocatorDefault,
-        pulseAudioUIDStr.c_str(), kCFStringEncodingUTF8);
+        mPulseAudioUID.c_str(), kCFStringEncodingUTF8);
 
     // Build the sub-device list
     // Real output device — this is where audio actually plays
@@ -62,8 +80,7 @@ Napi::Value CreateAggregateDevice(const Napi::CallbackInfo& info)
     CFDictionarySetValue(aggDesc, CFSTR(kAudioAggregateDeviceMainSubDeviceKey), realOutputUID);
 
     // Create the aggregate device
-    AudioObjectID aggregateDeviceID = kAudioObjectUnknown;
-    OSStatus status = AudioHardwareCreateAggregateDevice(aggDesc, &aggregateDeviceID);
+    OSStatus status = AudioHardwareCreateAggregateDevice(aggDesc, &mDeviceId);
 
     // Cleanup CF objects
     CFRelease(aggDesc);
@@ -76,31 +93,30 @@ Napi::Value CreateAggregateDevice(const Napi::CallbackInfo& info)
     CFRelease(pulseAudioUID);
 
     if (status != noErr) {
-        Napi::Error::New(env, "Failed to create aggregate device (OSStatus: " +
-            std::to_string(status) + ")").ThrowAsJavaScriptException();
-        return env.Null();
+        Fail("Failed to create aggregate device", status);
     }
-
-    Napi::Object result = Napi::Object::New(env);
-    result.Set("id", Napi::Number::New(env, static_cast<double>(aggregateDeviceID)));
-    result.Set("uid", Napi::String::New(env, "com.pulse.aggregate.screenshare"));
-    return result;
 }
 
-Napi::Value DestroyAggregateDevice(const Napi::CallbackInfo& info)
-{
-    Napi::Env env = info.Env();
-
-    if (info.Length() < 1 || !info[0].IsString()) {
-        Napi::TypeError::New(env, "Expected (aggregateUID: string)")
-            .ThrowAsJavaScriptException();
-        return env.Undefined();
+class DestroyAggregateWorker : public DeviceWorker {
+public:
+    DestroyAggregateWorker(Napi::Env env, std::string aggregateUID)
+        : DeviceWorker(env)
+        , mAggregateUID(std::move(aggregateUID))
+    {
     }
 
+protected:
+    void Run() override;
+
+private:
+    std::string mAggregateUID;
+};
+
+void DestroyAggregateWorker::Run()
+{
     // Find the aggregate device by UID
-    std::string uidStr = info[0].As<Napi::String>().Utf8Value();
     CFStringRef uid = CFStringCreateWithCString(kCFAllocatorDefault,
-        uidStr.c_str(), kCFStringEncodingUTF8);
+        mAggregateUID.c_str(), kCFStringEncodingUTF8);
 
     AudioObjectPropertyAddress translateProp = {
         kAudioHardwarePropertyTranslateUIDToDevice,
@@ -118,14 +134,39 @@ Napi::Value DestroyAggregateDevice(const Napi::CallbackInfo& info)
 
     if (status != noErr || deviceId == kAudioObjectUnknown) {
         // Device may already be destroyed — not an error
-        return env.Undefined();
+        return;
     }
 
     status = AudioHardwareDestroyAggregateDevice(deviceId);
     if (status != noErr) {
-        Napi::Error::New(env, "Failed to destroy aggregate device (OSStatus: " +
-            std::to_string(status) + ")").ThrowAsJavaScriptException();
+        Fail("Failed to destroy aggregate device", status);
+    }
+}
+
+Napi::Value CreateAggregateDevice(const Napi::CallbackInfo& info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected (realOutputUID: string, pulseAudioUID: string)")
+            .ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    return (new CreateAggregateWorker(env,
+        info[0].As<Napi::String>().Utf8Value(),
+        info[1].As<Napi::String>().Utf8Value()))->Start();
+}
+
+Napi::Value DestroyAggregateDevice(const Napi::CallbackInfo& info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected (aggregateUID: string)")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
     }
 
-    return env.Undefined();
+    return (new DestroyAggregateWorker(env, info[0].As<Napi::String>().Utf8Value()))->Start();
 }
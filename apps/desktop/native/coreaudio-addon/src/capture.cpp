@@ -0,0 +1,85 @@
+#include "capture.h"
+#include "device-worker.h"
+#include "device-service.h"
+
+class StartCaptureWorker : public DeviceWorker {
+public:
+    explicit StartCaptureWorker(Napi::Env env)
+        : DeviceWorker(env)
+        , mSession()
+    {
+    }
+
+protected:
+    void Run() override
+    {
+        OSStatus status = DeviceService().StartCapture(&mSession);
+        if (status != noErr) {
+            Fail("Failed to start capture", status);
+        }
+    }
+
+    Napi::Value Result(Napi::Env env) override
+    {
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("savedDeviceId", Napi::Number::New(env, static_cast<double>(mSession.savedDeviceId)));
+        result.Set("savedUID", Napi::String::New(env, mSession.savedUID));
+        result.Set("savedName", Napi::String::New(env, mSession.savedName));
+        result.Set("aggregateId", Napi::Number::New(env, static_cast<double>(mSession.aggregateId)));
+        result.Set("pulseDeviceUID", Napi::String::New(env, kPulseDeviceUID));
+        return result;
+    }
+
+private:
+    CaptureSession mSession;
+};
+
+class StopCaptureWorker : public DeviceWorker {
+public:
+    explicit StopCaptureWorker(Napi::Env env)
+        : DeviceWorker(env)
+        , mRestoredId(kAudioObjectUnknown)
+    {
+    }
+
+protected:
+    void Run() override
+    {
+        HelperService& service = DeviceService();
+        const CaptureSession* session = service.ActiveSession();
+
+        OSStatus status;
+        if (session) {
+            status = service.StopCapture(session->savedDeviceId, session->savedUID, &mRestoredId);
+        } else {
+            status = service.DestroyAggregate();
+        }
+        if (status != noErr) {
+            Fail("Failed to stop capture", status);
+        }
+    }
+
+    Napi::Value Result(Napi::Env env) override
+    {
+        Napi::Object result = Napi::Object::New(env);
+        if (mRestoredId == kAudioObjectUnknown) {
+            result.Set("restoredDeviceId", env.Null());
+        } else {
+            result.Set("restoredDeviceId", Napi::Number::New(env, static_cast<double>(mRestoredId)));
+        }
+        return result;
+    }
+
+private:
+    AudioObjectID mRestoredId;
+};
+
+Napi::Value StartCapture(const Napi::CallbackInfo& info)
+{
+    return (new StartCaptureWorker(info.Env()))->Start();
+}
+
+Napi::Value StopCapture(const Napi::CallbackInfo& info)
+{
+    return (new StopCaptureWorker(info.Env()))->Start();
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <napi.h>
+
+// Start system audio capture in-process: save the default output, replace
+// any leftover aggregate with a multi-output one over it and the Pulse
+// device, and make that the default. Same flow as pulse-audio-helper's
+// start-capture (it runs the helper's HelperService), so the two can't
+// drift apart.
+// Returns: Promise<{ savedDeviceId: number, savedUID: string, savedName: string,
+//                    aggregateId: number, pulseDeviceUID: string }>
+Napi::Value StartCapture(const Napi::CallbackInfo& info);
+
+// Stop capture: destroy the aggregate and restore the output device saved
+// by startCapture(), found again by UID. Without a running capture it only
+// removes a leftover aggregate.
+// Returns: Promise<{ restoredDeviceId: number | null }>
+Napi::Value StopCapture(const Napi::CallbackInfo& info);
@@ -1,4 +1,5 @@
 #include "default-device.h"
+#include "device-worker.h"
 #include <CoreAudio/CoreAudio.h>
 #include <CoreFoundation/CoreFoundation.h>
 #include <string>
@@ -26,35 +27,77 @@ static std::string GetCFStringProperty(AudioObjectID objectId,
     return ok ? std::string(buf) : "";
 }
 
-Napi::Value GetDefaultOutputDevice(const Napi::CallbackInfo& info)
-{
-    Napi::Env env = info.Env();
+static const AudioObjectPropertyAddress kDefaultOutputProp = {
+    kAudioHardwarePropertyDefaultOutputDevice,
+    kAudioObjectPropertyScopeGlobal,
+    kAudioObjectPropertyElementMain
+};
+
+class GetDefaultOutputWorker : public DeviceWorker {
+public:
+    explicit GetDefaultOutputWorker(Napi::Env env)
+        : DeviceWorker(env)
+        , mDeviceId(kAudioObjectUnknown)
+    {
+    }
 
-    AudioObjectPropertyAddress prop = {
-        kAudioHardwarePropertyDefaultOutputDevice,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
+protected:
+    void Run() override
+    {
+        UInt32 dataSize = sizeof(AudioObjectID);
+        OSStatus status = AudioObjectGetPropertyData(
+            kAudioObjectSystemObject, &kDefaultOutputProp, 0, nullptr, &dataSize, &mDeviceId);
+
+        if (status != noErr || mDeviceId == kAudioObjectUnknown) {
+            Fail("Failed to get default output device", status);
+            return;
+        }
 
-    AudioObjectID deviceId = kAudioObjectUnknown;
-    UInt32 dataSize = sizeof(AudioObjectID);
+        mUID  = GetCFStringProperty(mDeviceId, kAudioDevicePropertyDeviceUID);
+        mName = GetCFStringProperty(mDeviceId, kAudioObjectPropertyName);
+    }
 
-    OSStatus status = AudioObjectGetPropertyData(
-        kAudioObjectSystemObject, &prop, 0, nullptr, &dataSize, &deviceId);
+    Napi::Value Result(Napi::Env env) override
+    {
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("id", Napi::Number::New(env, static_cast<double>(mDeviceId)));
+        result.Set("uid", Napi::String::New(env, mUID));
+        result.Set("name", Napi::String::New(env, mName));
+        return result;
+    }
 
-    if (status != noErr || deviceId == kAudioObjectUnknown) {
-        Napi::Error::New(env, "Failed to get default output device").ThrowAsJavaScriptException();
-        return env.Null();
+private:
+    AudioObjectID mDeviceId;
+    std::string   mUID;
+    std::string   mName;
+};
+
+class SetDefaultOutputWorker : public DeviceWorker {
+public:
+    SetDefaultOutputWorker(Napi::Env env, AudioObjectID deviceId)
+        : DeviceWorker(env)
+        , mDeviceId(deviceId)
+    {
     }
 
-    std::string uid  = GetCFStringProperty(deviceId, kAudioDevicePropertyDeviceUID);
-    std::string name = GetCFStringProperty(deviceId, kAudioObjectPropertyName);
+protected:
+    void Run() override
+    {
+        OSStatus status = AudioObjectSetPropertyData(
+            kAudioObjectSystemObject, &kDefaultOutputProp, 0, nullptr, sizeof(AudioObjectID), &mDeviceId);
+
+        if (status != noErr) {
+            Fail("Failed to set default output device", status);
+        }
+    }
 
-    Napi::Object result = Napi::Object::New(env);
-    result.Set("id", Napi::Number::New(env, static_cast<double>(deviceId)));
-    result.Set("uid", Napi::String::New(env, uid));
-    result.Set("name", Napi::String::New(env, name));
-    return result;
+private:
+    AudioObjectID mDeviceId;
+};
+
+Napi::Value GetDefaultOutputDevice(const Napi::CallbackInfo& info)
+{
+    return (new GetDefaultOutputWorker(info.Env()))->Start();
 }
 
 Napi::Value SetDefaultOutputDevice(const Napi::CallbackInfo& info)
@@ -68,20 +111,5 @@ Napi::Value SetDefaultOutputDevice(const Napi::CallbackInfo& info)
     }
 
     AudioObjectID deviceId = static_cast<AudioObjectID>(info[0].As<Napi::Number>().Uint32Value());
-
-    AudioObjectPropertyAddress prop = {
-        kAudioHardwarePropertyDefaultOutputDevice,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
-
-    OSStatus status = AudioObjectSetPropertyData(
-        kAudioObjectSystemObject, &prop, 0, nullptr, sizeof(AudioObjectID), &deviceId);
-
-    if (status != noErr) {
-        Napi::Error::New(env, "Failed to set default output device (OSStatus: " +
-            std::to_string(status) + ")").ThrowAsJavaScriptException();
-    }
-
-    return env.Undefined();
+    return (new SetDefaultOutputWorker(env, deviceId))->Start();
 }
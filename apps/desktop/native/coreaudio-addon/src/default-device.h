@@ -3,9 +3,10 @@
 #include <napi.h>
 
 // Get the current default output audio device.
-// Returns: { id: number, uid: string, name: string }
+// Returns: Promise<{ id: number, uid: string, name: string }>
 Napi::Value GetDefaultOutputDevice(const Napi::CallbackInfo& info);
 
 // Set the default output audio device by AudioObjectID.
 // Args: deviceId (number)
+// Returns: Promise<void>
 Napi::Value SetDefaultOutputDevice(const Napi::CallbackInfo& info);
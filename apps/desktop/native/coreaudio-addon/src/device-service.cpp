@@ -0,0 +1,9 @@
+#include "device-service.h"
+#include "coreaudio-device-backend.h"
+
+HelperService& DeviceService()
+{
+    static CoreAudioDeviceBackend backend;
+    static HelperService service(backend);
+    return service;
+}
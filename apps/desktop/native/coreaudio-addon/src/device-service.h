@@ -0,0 +1,8 @@
+#pragma once
+
+#include "helper-service.h"
+
+// The addon's one HelperService over CoreAudio, shared by every export so
+// the device registry and the capture session live for the whole process.
+// Only call from DeviceWorker::Run(), which holds the device mutex.
+HelperService& DeviceService();
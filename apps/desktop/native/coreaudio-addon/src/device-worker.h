@@ -0,0 +1,59 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <CoreAudio/CoreAudio.h>
+#include <napi.h>
+
+// Base for the addon's exports: the CoreAudio calls run in Execute() on a
+// libuv worker thread and the export returns a promise, so device changes
+// (which can take the HAL hundreds of milliseconds) never block the JS
+// thread. Workers are serialized on one mutex, as a create/set-default/
+// destroy sequence from JS must not interleave with another.
+class DeviceWorker : public Napi::AsyncWorker {
+public:
+    explicit DeviceWorker(Napi::Env env)
+        : Napi::AsyncWorker(env)
+        , mDeferred(Napi::Promise::Deferred::New(env))
+    {
+    }
+
+    // Queue the worker and hand its promise back to JS. The worker deletes
+    // itself once the promise settles.
+    Napi::Promise Start()
+    {
+        Napi::Promise promise = mDeferred.Promise();
+        Queue();
+        return promise;
+    }
+
+protected:
+    // Device work, on the worker thread. Report failure with Fail().
+    virtual void Run() = 0;
+
+    // Value the promise resolves with, on the JS thread
+    virtual Napi::Value Result(Napi::Env env) { return env.Undefined(); }
+
+    void Fail(const std::string& message, OSStatus status)
+    {
+        SetError(message + " (OSStatus: " + std::to_string(status) + ")");
+    }
+
+private:
+    void Execute() override
+    {
+        std::lock_guard<std::mutex> lock(DeviceMutex());
+        Run();
+    }
+
+    void OnOK() override { mDeferred.Resolve(Result(Env())); }
+    void OnError(const Napi::Error& error) override { mDeferred.Reject(error.Value()); }
+
+    static std::mutex& DeviceMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    Napi::Promise::Deferred mDeferred;
+};
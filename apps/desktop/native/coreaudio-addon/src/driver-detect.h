@@ -3,7 +3,9 @@
 #include <napi.h>
 
 // Check if the Pulse Audio virtual device is active in CoreAudio
+// Returns: Promise<boolean>
 Napi::Value IsDriverInstalled(const Napi::CallbackInfo& info);
 
 // Get the AudioObjectID of the Pulse Audio device, or null if not found
+// Returns: Promise<number | null>
 Napi::Value GetPulseDeviceId(const Napi::CallbackInfo& info);
@@ -1,10 +1,13 @@
-import { execSync } from 'child_process';
 import { existsSync } from 'fs';
 import { app } from 'electron';
 import path from 'path';
+import { HelperProcess } from './helper-process';
 
-// State for the current capture session
-let savedDefaultDeviceId: string | null = null;
+// Resident helper, started on first use
+let helper: HelperProcess | null = null;
+
+// Whether this app started the current capture session
+let captureActive = false;
 
 /** Locate the pulse-audio-helper binary */
 function getHelperPath(): string {
@@ -19,73 +22,68 @@ function getHelperPath(): string {
   return '';
 }
 
-/** Run the helper binary and return stdout, or null on failure */
-function runHelper(...args: string[]): string | null {
+/** The resident helper, or null if the binary is missing */
+function getHelper(): HelperProcess | null {
+  if (helper) return helper;
+
   const helperPath = getHelperPath();
   if (!helperPath) {
     console.warn('[audio-capture] pulse-audio-helper not found');
     return null;
   }
-
-  try {
-    const result = execSync(`"${helperPath}" ${args.join(' ')}`, {
-      timeout: 10000,
-      encoding: 'utf-8',
-    });
-    return result.trim();
-  } catch (err) {
-    console.error('[audio-capture] helper command failed:', args.join(' '), err);
-    return null;
-  }
+  helper = new HelperProcess(helperPath);
+  return helper;
 }
 
 /** Check if system audio capture is available (macOS + driver active) */
-export function canCaptureSystemAudio(): boolean {
+export async function canCaptureSystemAudio(): Promise<boolean> {
   if (process.platform !== 'darwin') return false;
 
-  const helperPath = getHelperPath();
-  if (!helperPath) return false;
+  const client = getHelper();
+  if (!client) return false;
 
   try {
-    execSync(`"${helperPath}" detect`, { timeout: 5000 });
-    return true; // exit code 0 = driver found
-  } catch {
-    return false; // exit code 1 = not found
+    const { present } = await client.request<{ present: boolean }>('detect', {}, 5000);
+    return present;
+  } catch (err) {
+    console.error('[audio-capture] detect failed:', err);
+    return false;
   }
 }
 
 /**
  * Start system audio capture for screen sharing.
  *
- * Uses the `start-capture` command which performs the full flow in a single
- * process to avoid device ID staleness between separate CLI invocations:
+ * The helper's `start-capture` performs the full flow in one request, so
+ * device IDs can't go stale between steps:
  * 1. Save the current default output device
  * 2. Destroy any leftover aggregate
  * 3. Create a multi-output aggregate device (real output + Pulse Audio)
  * 4. Set the aggregate as default output
- * 5. Return the saved device ID and name
+ * 5. Return the saved device and its name
+ * The helper keeps the saved device for `stop-capture`.
  */
-export function startSystemAudioCapture(): { pulseDeviceUID: string; realOutputDeviceName: string } | null {
-  try {
-    const result = runHelper('start-capture');
-    if (!result) {
-      console.error('[audio-capture] start-capture failed');
-      return null;
-    }
+export async function startSystemAudioCapture(): Promise<{ pulseDeviceUID: string; realOutputDeviceName: string } | null> {
+  const client = getHelper();
+  if (!client) return null;
 
-    // Output format: "savedDeviceId|realOutputName"
-    const [deviceIdStr, deviceName] = result.split('|');
-    savedDefaultDeviceId = deviceIdStr;
+  try {
+    const result = await client.request<{
+      savedDeviceId: number;
+      savedName: string;
+      pulseDeviceUID: string;
+    }>('start-capture');
+    captureActive = true;
 
-    console.log(`[audio-capture] Capture started, saved device: ${deviceName} (ID: ${deviceIdStr})`);
+    console.log(`[audio-capture] Capture started, saved device: ${result.savedName} (ID: ${result.savedDeviceId})`);
 
     return {
-      pulseDeviceUID: 'com.pulse.audio.device',
-      realOutputDeviceName: deviceName,
+      pulseDeviceUID: result.pulseDeviceUID,
+      realOutputDeviceName: result.savedName,
     };
   } catch (err) {
     console.error('[audio-capture] Failed to start capture:', err);
-    stopSystemAudioCapture();
+    await stopSystemAudioCapture();
     return null;
   }
 }
@@ -93,21 +91,35 @@ export function startSystemAudioCapture(): { pulseDeviceUID: string; realOutputD
 /**
  * Stop system audio capture and restore the original output device.
  *
- * Uses the `stop-capture` command which destroys the aggregate device
- * and restores the saved default output device.
+ * `stop-capture` destroys the aggregate device and restores the output
+ * device saved by `start-capture`; with no capture running it just removes
+ * any leftover aggregate.
  */
-export function stopSystemAudioCapture(): void {
+export async function stopSystemAudioCapture(): Promise<void> {
+  const client = getHelper();
+  if (!client) return;
+
   try {
-    if (savedDefaultDeviceId !== null) {
-      console.log(`[audio-capture] Stopping capture, restoring device ID: ${savedDefaultDeviceId}`);
-      runHelper('stop-capture', savedDefaultDeviceId);
-      savedDefaultDeviceId = null;
+    if (captureActive) {
+      console.log('[audio-capture] Stopping capture, restoring saved output device');
+      await client.request('stop-capture');
     } else {
-      // No saved device — just destroy the aggregate
-      runHelper('destroy-aggregate');
+      await client.request('destroy-aggregate');
     }
   } catch (err) {
     console.error('[audio-capture] Error during cleanup:', err);
-    savedDefaultDeviceId = null;
+  } finally {
+    captureActive = false;
   }
 }
+
+/**
+ * Shut the helper down on quit. It stops a running capture itself once its
+ * stdin closes, so the default output is restored even though the app
+ * doesn't wait for it.
+ */
+export function closeAudioCaptureHelper(): void {
+  helper?.close();
+  helper = null;
+  captureActive = false;
+}
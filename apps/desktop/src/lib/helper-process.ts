@@ -0,0 +1,99 @@
+import { spawn, ChildProcessWithoutNullStreams } from 'child_process';
+import { createInterface } from 'readline';
+
+type HelperArgs = Record<string, string | number | boolean>;
+
+interface PendingRequest {
+  resolve: (result: unknown) => void;
+  reject: (err: Error) => void;
+  timer: NodeJS.Timeout;
+}
+
+/**
+ * A resident `pulse-audio-helper serve` process.
+ *
+ * Requests are newline-delimited JSON on the helper's stdin, answered in
+ * order on its stdout (see helper-service.h for the protocol). The process
+ * is spawned on the first request and respawned after it exits, so nothing
+ * here blocks the main thread. Closing stdin makes the helper stop any
+ * capture it started before exiting.
+ */
+export class HelperProcess {
+  private child: ChildProcessWithoutNullStreams | null = null;
+  private nextId = 1;
+  private readonly pending = new Map<number, PendingRequest>();
+
+  constructor(private readonly helperPath: string) {}
+
+  /** Send one command; resolves with its result object, rejects with the helper's error */
+  request<T>(cmd: string, args: HelperArgs = {}, timeoutMs = 10000): Promise<T> {
+    const child = this.ensureStarted();
+    const id = this.nextId++;
+
+    return new Promise<T>((resolve, reject) => {
+      const timer = setTimeout(() => {
+        // A late answer for this id is ignored
+        this.pending.delete(id);
+        reject(new Error(`pulse-audio-helper ${cmd} timed out`));
+      }, timeoutMs);
+      this.pending.set(id, { resolve: resolve as (result: unknown) => void, reject, timer });
+      child.stdin.write(`${JSON.stringify({ ...args, id, cmd })}\n`);
+    });
+  }
+
+  /** Close the helper's stdin; it finishes queued requests and exits */
+  close(): void {
+    if (!this.child) return;
+    this.child.stdin.end();
+    this.child = null;
+  }
+
+  private ensureStarted(): ChildProcessWithoutNullStreams {
+    if (this.child) return this.child;
+
+    const child = spawn(this.helperPath, ['serve'], { stdio: ['pipe', 'pipe', 'pipe'] });
+    createInterface({ input: child.stdout }).on('line', (line) => this.onResponse(line));
+    createInterface({ input: child.stderr }).on('line', (line) => console.log(line));
+
+    const onGone = (reason: string) => {
+      if (this.child === child) this.child = null;
+      this.failAll(new Error(`pulse-audio-helper ${reason}`));
+    };
+    child.on('exit', (code, signal) => onGone(`exited (${signal ?? code})`));
+    child.on('error', (err) => onGone(`failed: ${err.message}`));
+    // A write after the helper died surfaces as 'exit'; don't let EPIPE throw
+    child.stdin.on('error', () => {});
+
+    this.child = child;
+    return child;
+  }
+
+  private onResponse(line: string): void {
+    let response: { id?: unknown; ok?: boolean; result?: unknown; error?: string };
+    try {
+      response = JSON.parse(line);
+    } catch {
+      console.error('[audio-capture] unreadable helper response:', line);
+      return;
+    }
+
+    const request = typeof response.id === 'number' ? this.pending.get(response.id) : undefined;
+    if (!request) return;
+    this.pending.delete(response.id as number);
+    clearTimeout(request.timer);
+
+    if (response.ok) {
+      request.resolve(response.result ?? {});
+    } else {
+      request.reject(new Error(response.error ?? 'pulse-audio-helper request failed'));
+    }
+  }
+
+  private failAll(err: Error): void {
+    for (const request of this.pending.values()) {
+      clearTimeout(request.timer);
+      request.reject(err);
+    }
+    this.pending.clear();
+  }
+}
@@ -7,7 +7,7 @@ import { setupPermissions, requestMediaAccess, consumePendingProcessAudioSourceI
 import { createTray, destroyTray, setTrayIcon } from './lib/tray';
 import { APP_NAME, PRELOAD_PATH, SERVER_SELECTOR_PATH } from './lib/constants';
 import { getDriverStatus, installDriver, uninstallDriver } from './lib/audio-driver';
-import { canCaptureSystemAudio, startSystemAudioCapture, stopSystemAudioCapture } from './lib/audio-capture';
+import { canCaptureSystemAudio, closeAudioCaptureHelper, startSystemAudioCapture, stopSystemAudioCapture } from './lib/audio-capture';
 import { canCaptureProcessAudio, startProcessAudioCapture, stopProcessAudioCapture } from './lib/win-process-audio';
 
 const store = new Store();
@@ -329,9 +329,7 @@ function setupIpcHandlers(): void {
   // Audio capture lifecycle (macOS)
   ipcMain.handle('audio-capture:available', () => canCaptureSystemAudio());
   ipcMain.handle('audio-capture:start', () => startSystemAudioCapture());
-  ipcMain.handle('audio-capture:stop', () => {
-    stopSystemAudioCapture();
-  });
+  ipcMain.handle('audio-capture:stop', () => stopSystemAudioCapture());
 
   // Windows process-loopback audio capture (Win10 build 20348 / Win11+)
   ipcMain.handle('win-process-audio:can-capture', () => canCaptureProcessAudio());
@@ -433,7 +431,7 @@ function setupIpcHandlers(): void {
 app.on('before-quit', () => {
   isQuitting = true;
   destroyTray();
-  stopSystemAudioCapture();
+  closeAudioCaptureHelper();
   stopProcessAudioCapture();
   globalShortcut.unregisterAll();
   if (uIOhook) try { uIOhook.uIOhook.stop(); } catch {}